@@ -20,12 +20,50 @@ void AddHeader(std::stringstream& ss, const std::string& header_name,
   }
   ss << "header = \"" << header_name << ": " << header_value << "\"\n";
 }
+
+/// A stream buffer that appends what is written to it to a string.
+class StringAppendBuf : public std::streambuf {
+ public:
+  explicit StringAppendBuf(std::string& out) : m_out{out} {}
+
+ protected:
+  int_type overflow(int_type ch) override {
+    if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+      m_out.push_back(traits_type::to_char_type(ch));
+    }
+    return traits_type::not_eof(ch);
+  }
+
+  std::streamsize xsputn(const char* s, std::streamsize n) override {
+    m_out.append(s, static_cast<size_t>(n));
+    return n;
+  }
+
+ private:
+  std::string& m_out;
+};
 }  // namespace
 
 std::unique_ptr<BuildCommandResult> Curl::BuildRequestCommand(
     const std::string& path, const httplib::Headers& headers,
     const std::string& content_type, std::optional<std::string> payload) {
-  // Create the request file.
+  if (!payload.has_value()) {
+    return BuildRequestCommand(path, headers, content_type,
+                               PayloadWriter{nullptr});
+  }
+  return BuildRequestCommand(
+      path, headers, content_type, [&payload](std::ostream& os) {
+        os.write(payload.value().data(), payload.value().size());
+      });
+}
+
+std::unique_ptr<BuildCommandResult> Curl::BuildRequestCommand(
+    const std::string& path, const httplib::Headers& headers,
+    const std::string& content_type, const PayloadWriter& payload_writer) {
+  // The config is piped into curl's stdin and the payload into its fd 3 (a
+  // temporary file on Windows): the headers (API keys) do not show up in the
+  // process list. A config value is limited to 100 KB, so the payload can not
+  // be part of the config.
   auto result = std::make_unique<BuildCommandResult>();
   std::stringstream request_data;
   request_data << "url = " << getServerURL() << path << "\n";
@@ -37,48 +75,71 @@ std::unique_ptr<BuildCommandResult> Curl::BuildRequestCommand(
   for (const auto& [h_name, h_value] : headers) {
     AddHeader(request_data, h_name, h_value);
   }
+  result->command = {m_curl, "--config", "-"};
 
-  if (payload.has_value()) {
-    auto file = assistant::WriteStringToRandomFile(payload.value());
+  if (payload_writer) {
+#ifdef _WIN32
+    auto file = assistant::WriteToRandomFile(payload_writer);
     if (!file.has_value()) {
       result->ok = false;
       return result;
     }
-    request_data << "data = @" << file.value() << "\n";
+    request_data << "data-binary = @" << file.value() << "\n";
     result->data_path = file.value();
+#else
+    StringAppendBuf buf{result->data};
+    std::ostream os{&buf};
+    payload_writer(os);
+    request_data << "data-binary = @/dev/fd/3\n";
+#endif
   }
-
-  auto request_path = assistant::WriteStringToRandomFile(request_data.str());
-  result->request_path = request_path.value_or("");
-  result->command = {m_curl, "--config", request_path.value_or("")};
+  result->config = request_data.str();
   return result;
 }
 
-bool Curl::chat_raw_output(assistant::request& request,
-                           on_raw_respons_callback on_receive_token,
-                           void* user_data) {
-  assistant::response response;
+namespace {
+std::vector<std::string_view> CommandInputs(const BuildCommandResult& command) {
+#ifdef _WIN32
+  return {command.config};
+#else
+  return {command.config, command.data};
+#endif
+}
+}  // namespace
+
+int Curl::RunCommand(const BuildCommandResult& command,
+                     on_output_callback output_cb) {
+  return Process::RunProcessWithInput(command.command, CommandInputs(command),
+                                      std::move(output_cb));
+}
+
+ProcessOutput Curl::RunCommand(const BuildCommandResult& command) {
+  return Process::RunProcessWithInput(command.command, CommandInputs(command));
+}
+
+bool Curl::RunChatRequest(
+    assistant::request& request,
+    const std::function<bool(const std::string&)>& on_out) {
   request["stream"] = true;
 
-  std::string request_string = request.dump();
-  if (assistant::log_requests) std::cout << request_string << std::endl;
+  if (assistant::log_requests) {
+    std::cout << request.serialize() << std::endl;
+  }
 
-  std::stringstream errstream;
-  auto stream_callback = [&errstream, on_receive_token, user_data](
-                             const std::string& out,
-                             const std::string& err) -> bool {
-    errstream << err;
-    return on_receive_token(out, user_data);
-  };
-
-  auto result = BuildRequestCommand(GetChatPath(), headers_, kApplicationJson,
-                                    request_string);
+  auto result = BuildRequestCommand(
+      GetChatPath(), headers_, kApplicationJson,
+      [&request](std::ostream& os) { request.write(os); });
   if (!result->ok) {
     return false;
   }
 
-  int exit_code =
-      Process::RunProcessAndWait(result->command, stream_callback, false);
+  std::stringstream errstream;
+  int exit_code = RunCommand(
+      *result, [&errstream, &on_out](const std::string& out,
+                                     const std::string& err) -> bool {
+        errstream << err;
+        return on_out(out);
+      });
   if (exit_code == 0) {
     return true;
   }
@@ -90,83 +151,27 @@ bool Curl::chat_raw_output(assistant::request& request,
   return false;
 }
 
+bool Curl::chat_raw_output(assistant::request& request,
+                           on_raw_respons_callback on_receive_token,
+                           void* user_data) {
+  return RunChatRequest(
+      request, [on_receive_token, user_data](const std::string& out) {
+        return on_receive_token(out, user_data);
+      });
+}
+
 bool Curl::chat(assistant::request& request,
                 on_respons_callback on_receive_token, void* user_data) {
-  assistant::response response;
-  request["stream"] = true;
-
-  std::string request_string = request.dump();
-  if (assistant::log_requests) {
-    std::cout << request_string << std::endl;
-  }
-
-  std::string partial_responses;
-  std::stringstream errstream;
-  auto stream_callback = [&errstream, on_receive_token, user_data,
-                          &partial_responses](const std::string& out,
-                                              const std::string& err) -> bool {
-    std::string message = out;
-    errstream << err;
+  assistant::JsonStreamDecoder decoder;
+  assistant::chat_chunk_decoder chunk_decoder;
+  return RunChatRequest(request, [on_receive_token, user_data, &decoder,
+                                  &chunk_decoder](const std::string& out) {
     if (Process::IsExecLogEnabled()) {
-      std::cout << "<== " << message << std::endl;
-    }
-
-    partial_responses.append(message);
-
-    auto result = assistant::try_read_jsons_from_string(partial_responses);
-    if (result.first.empty()) {
-      // no complete jsons
-      return true;
+      std::cout << "<== " << out << std::endl;
     }
-
-    // "second" holds the remainder
-    partial_responses = result.second;
-
-    // Process the jsons
-    for (const auto& j : result.first) {
-      try {
-        assistant::response response(j.dump(), assistant::message_type::chat);
-        if (response.has_error()) {
-          if (assistant::use_exceptions)
-            throw assistant::exception("Server response returned error: " +
-                                       response.get_error());
-        }
-        if (!on_receive_token(response, user_data)) {
-          return false;
-        }
-      } catch (const assistant::invalid_json_exception& e) {
-        // Could not parse a response object.
-        if (assistant::use_exceptions) {
-          std::stringstream ss;
-          ss << "Could not parse response." << e.what() << "\n"
-             << "Response JSON:\n"
-             << j.dump(2) << "\n";
-          throw assistant::exception(ss.str());
-        }
-        // Abort the stream.
-        return false;
-      }
-    }
-    return true;
-  };
-
-  auto result = BuildRequestCommand(GetChatPath(), headers_, kApplicationJson,
-                                    request_string);
-  if (!result->ok) {
-    return false;
-  }
-
-  int exit_code =
-      Process::RunProcessAndWait(result->command, stream_callback, false);
-  if (exit_code == 0) {
-    return true;
-  }
-
-  if (assistant::use_exceptions) {
-    throw assistant::exception("Server responded with an error. " +
-                               errstream.str());
-  }
-  return false;
+    return assistant::feed_chat_stream(decoder, chunk_decoder, out,
+                                       on_receive_token, user_data);
+  });
 }
 
 json Curl::list_model_json() {
@@ -177,7 +182,7 @@ json Curl::list_model_json() {
     return models;
   }
 
-  auto res = Process::RunProcessAndWait(result->command);
+  auto res = RunCommand(*result);
   if (res.ok) {
     models = json::parse(res.out);
   }
@@ -192,6 +197,7 @@ void Curl::setConnectTimeout([[maybe_unused]] const int secs,
                              [[maybe_unused]] const int usecs) {}
 
 void Curl::interrupt() {
+  interrupted_.store(true);
   if (m_runningProcessId == -1) {
     return;
   }
@@ -217,7 +223,7 @@ json Curl::show_model_info(const std::string& model, bool verbose) {
     return response;
   }
 
-  auto res = Process::RunProcessAndWait(result->command);
+  auto res = RunCommand(*result);
   if (res.ok) {
     if (Process::IsExecLogEnabled()) {
       std::cout << "<== " << res.out << std::endl;
@@ -246,7 +252,7 @@ bool Curl::is_running() {
   if (!res->ok) {
     return false;
   }
-  return Process::RunProcessAndWait(res->command).ok;
+  return RunCommand(*res).ok;
 }
 
 #if CPPHTTPLIB_OPENSSL_SUPPORT
@@ -2,18 +2,26 @@
 
 #include <optional>
 
+#include "assistant/Process.hpp"
 #include "assistant/assistantlib.hpp"
 
 namespace assistant {
 struct BuildCommandResult {
   bool ok{true};
-  std::string request_path;
+  /// The curl config, fed to curl's stdin (`--config -`): the URL and the
+  /// headers.
+  std::string config;
+  /// The payload, read by curl from its fd 3.
+  std::string data;
+  /// The payload file, where curl can not read the payload from a pipe
+  /// (Windows).
   std::string data_path;
   std::vector<std::string> command;
-  
+
   ~BuildCommandResult() {
-    assistant::DeleteFileFromDisk(request_path);
-    assistant::DeleteFileFromDisk(data_path);
+    if (!data_path.empty()) {
+      assistant::DeleteFileFromDisk(data_path);
+    }
   }
 };
 
@@ -44,7 +52,24 @@ class Curl : public ITransport {
       const std::string& path, const httplib::Headers& headers,
       const std::string& content_type, std::optional<std::string> payload);
 
+  /// Writes the request payload.
+  using PayloadWriter = std::function<void(std::ostream& os)>;
+  std::unique_ptr<BuildCommandResult> BuildRequestCommand(
+      const std::string& path, const httplib::Headers& headers,
+      const std::string& content_type, const PayloadWriter& payload_writer);
+
  private:
+  /// Runs curl with the config and the payload of `command` on its input
+  /// pipes.
+  int RunCommand(const BuildCommandResult& command,
+                 on_output_callback output_cb);
+  ProcessOutput RunCommand(const BuildCommandResult& command);
+  /// Streams `request` to the chat endpoint and passes curl's output to
+  /// `on_out`. On failure, throws with curl's stderr if exceptions are
+  /// enabled, otherwise returns false.
+  bool RunChatRequest(assistant::request& request,
+                      const std::function<bool(const std::string&)>& on_out);
+
   int m_runningProcessId{-1};
   std::string m_curl;
 };
@@ -10,127 +10,140 @@ extern char** environ;
 
 namespace assistant {
 
+namespace {
+void AppendError(std::string& errors, const std::string& var_name) {
+  if (!errors.empty()) {
+    errors += "; ";
+  }
+  errors += "Failed to expand variable: ";
+  errors += var_name;
+}
+}  // namespace
+
 json EnvExpander::Expand(json input_json, std::optional<EnvMap> map) const {
   // Use the new method and return just the JSON value for backward
   // compatibility
-  ExpandResult result = ExpandWithResult(input_json, map);
-  return result.GetJson();
+  ExpandResult result = ExpandWithResult(std::move(input_json), std::move(map));
+  return std::move(result.GetJson());
 }
 
 ExpandResult EnvExpander::ExpandWithResult(json input_json,
                                            std::optional<EnvMap> map) const {
   // Build environment map if not provided
-  EnvMap env_map = map.has_value() ? map.value() : BuildEnvMap();
+  if (map.has_value()) {
+    return ExpandWithResult(std::move(input_json), map.value());
+  }
+  return ExpandWithResult(std::move(input_json), BuildEnvMap());
+}
 
-  ExpandResult result(true);
+ExpandResult EnvExpander::ExpandWithResult(json input_json,
+                                           const EnvMap& env_map) const {
+  std::string errors;
+  bool success = ExpandInPlace(input_json, env_map, errors);
+  ExpandResult result(success);
+  result.GetJson() = std::move(input_json);
+  result.SetErrorMessage(std::move(errors));
+  return result;
+}
 
-  // Recursively traverse and expand the JSON
-  if (input_json.is_string()) {
-    // Expand string values
-    std::string str = input_json.get<std::string>();
-    ExpandResult str_result = ExpandWithResult(str, env_map);
-    result.GetJson() = str_result.GetString();
-    if (!str_result.IsSuccess()) {
-      if (!str_result.GetErrorMessage().empty()) {
-        result.SetErrorMessage(str_result.GetErrorMessage());
-      }
-      result.SetSuccess(false);
+bool EnvExpander::ExpandInPlace(json& node, const EnvMap& env_map,
+                                std::string& errors) const {
+  bool success = true;
+  if (node.is_string()) {
+    auto& str = node.get_ref<std::string&>();
+    if (str.find('$') == std::string::npos) {
+      return true;
     }
-  } else if (input_json.is_object()) {
-    // Recursively expand object members (both keys and values)
-    json expanded_obj = json::object();
-    for (auto& [key, value] : input_json.items()) {
-      // Expand the key
-      ExpandResult key_result = ExpandWithResult(key, env_map);
-      std::string expanded_key = key_result.GetString();
-      if (!key_result.IsSuccess()) {
-        if (!key_result.GetErrorMessage().empty()) {
-          result.SetErrorMessage(result.GetErrorMessage().empty()
-                                     ? key_result.GetErrorMessage()
-                                     : result.GetErrorMessage() + "; " +
-                                           key_result.GetErrorMessage());
-        }
-        result.SetSuccess(false);
+    std::string expanded;
+    expanded.reserve(str.size());
+    success = ExpandString(str, env_map, expanded, errors);
+    str = std::move(expanded);
+  } else if (node.is_object()) {
+    // The values are expanded in place. The object is only rebuilt when one of
+    // its keys references a variable.
+    bool expand_keys = false;
+    for (auto iter = node.begin(); iter != node.end(); ++iter) {
+      if (iter.key().find('$') != std::string::npos) {
+        expand_keys = true;
+        break;
       }
-
-      // Expand the value
-      ExpandResult sub_result = ExpandWithResult(value, env_map);
-      if (!sub_result.IsSuccess()) {
-        if (!sub_result.GetErrorMessage().empty()) {
-          result.SetErrorMessage(result.GetErrorMessage().empty()
-                                     ? sub_result.GetErrorMessage()
-                                     : result.GetErrorMessage() + "; " +
-                                           sub_result.GetErrorMessage());
-        }
-        result.SetSuccess(false);
+    }
+    if (!expand_keys) {
+      for (auto& value : node) {
+        success = ExpandInPlace(value, env_map, errors) && success;
       }
+      return success;
+    }
 
-      expanded_obj[expanded_key] = sub_result.GetJson();
+    json expanded_obj = json::object();
+    for (auto iter = node.begin(); iter != node.end(); ++iter) {
+      std::string expanded_key;
+      success = ExpandString(iter.key(), env_map, expanded_key, errors) &&
+                success;
+      success = ExpandInPlace(iter.value(), env_map, errors) && success;
+      expanded_obj[expanded_key] = std::move(iter.value());
     }
-    result.GetJson() = expanded_obj;
-  } else if (input_json.is_array()) {
-    // Recursively expand array elements
-    for (auto& element : input_json) {
-      ExpandResult sub_result = ExpandWithResult(element, env_map);
-      element = sub_result.GetJson();
-      if (!sub_result.IsSuccess()) {
-        if (!sub_result.GetErrorMessage().empty()) {
-          result.SetErrorMessage(result.GetErrorMessage().empty()
-                                     ? sub_result.GetErrorMessage()
-                                     : result.GetErrorMessage() + "; " +
-                                           sub_result.GetErrorMessage());
-        }
-        result.SetSuccess(false);
-      }
+    node = std::move(expanded_obj);
+  } else if (node.is_array()) {
+    for (auto& element : node) {
+      success = ExpandInPlace(element, env_map, errors) && success;
     }
-    result.GetJson() = input_json;
-  } else {
-    // For other types (numbers, booleans, null), return as-is
-    result.GetJson() = input_json;
   }
-
-  return result;
+  // Other types (numbers, booleans, null) are left as-is
+  return success;
 }
 
 std::string EnvExpander::Expand(const std::string& str,
                                 std::optional<EnvMap> map) const {
   // Use the new method and return just the string value for backward
   // compatibility
-  ExpandResult result = ExpandWithResult(str, map);
-  return result.GetString();
+  ExpandResult result = ExpandWithResult(str, std::move(map));
+  return std::move(result.GetString());
 }
 
 ExpandResult EnvExpander::ExpandWithResult(const std::string& str,
                                            std::optional<EnvMap> map) const {
   // Build environment map if not provided
-  EnvMap env_map = map.has_value() ? map.value() : BuildEnvMap();
+  if (map.has_value()) {
+    return ExpandWithResult(str, map.value());
+  }
+  return ExpandWithResult(str, BuildEnvMap());
+}
 
+ExpandResult EnvExpander::ExpandWithResult(const std::string& str,
+                                           const EnvMap& env_map) const {
+  std::string errors;
   ExpandResult result(true);
   result.GetString().reserve(str.size());
+  result.SetSuccess(ExpandString(str, env_map, result.GetString(), errors));
+  result.SetErrorMessage(std::move(errors));
+  return result;
+}
 
+bool EnvExpander::ExpandString(std::string_view str, const EnvMap& env_map,
+                               std::string& expanded_str,
+                               std::string& errors) const {
+  bool success = true;
   size_t pos = 0;
   while (pos < str.size()) {
-    // Look for '$' character
-    if (str[pos] == '$') {
-      std::string var_name;
-      bool found = true;
-      pos = ExpandVariableWithResult(str, pos, env_map, result.GetString(),
-                                     found, var_name);
-      if (!found) {
-        std::string error_msg = "Failed to expand variable: " + var_name;
-        result.SetErrorMessage(result.GetErrorMessage().empty()
-                                   ? error_msg
-                                   : result.GetErrorMessage() + "; " +
-                                         error_msg);
-        result.SetSuccess(false);
-      }
-    } else {
-      result.GetString() += str[pos];
-      ++pos;
+    // Copy everything up to the next '$' at once
+    size_t dollar = str.find('$', pos);
+    if (dollar == std::string_view::npos) {
+      expanded_str.append(str.substr(pos));
+      break;
     }
-  }
+    expanded_str.append(str.substr(pos, dollar - pos));
 
-  return result;
+    std::string var_name;
+    bool found = true;
+    pos = ExpandVariableWithResult(str, dollar, env_map, expanded_str, found,
+                                   var_name);
+    if (!found) {
+      AppendError(errors, var_name);
+      success = false;
+    }
+  }
+  return success;
 }
 
 EnvMap EnvExpander::BuildEnvMap() const {
@@ -171,16 +184,7 @@ EnvMap EnvExpander::BuildEnvMap() const {
   return env_map;
 }
 
-size_t EnvExpander::ExpandVariable(const std::string& str, size_t pos,
-                                   const EnvMap& env_map,
-                                   std::string& expanded_str) const {
-  bool found = true;
-  std::string var_name;
-  return ExpandVariableWithResult(str, pos, env_map, expanded_str, found,
-                                  var_name);
-}
-
-size_t EnvExpander::ExpandVariableWithResult(const std::string& str, size_t pos,
+size_t EnvExpander::ExpandVariableWithResult(std::string_view str, size_t pos,
                                              const EnvMap& env_map,
                                              std::string& expanded_str,
                                              bool& found,
@@ -201,10 +205,10 @@ size_t EnvExpander::ExpandVariableWithResult(const std::string& str, size_t pos,
     has_braces = true;
     ++start_pos;
     size_t end_pos = str.find('}', start_pos);
-    if (end_pos == std::string::npos) {
+    if (end_pos == std::string_view::npos) {
       // No closing brace found, treat as literal
-      expanded_str += str.substr(pos, 2);  // Add "${"
-      found = true;                        // Not a valid variable reference
+      expanded_str.append(str.substr(pos, 2));  // Add "${"
+      found = true;  // Not a valid variable reference
       return start_pos;
     }
     var_name = str.substr(start_pos, end_pos - start_pos);
@@ -2,6 +2,7 @@
 
 #include <optional>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 
 #include "assistant/common/json.hpp"
@@ -103,6 +104,15 @@ class EnvExpander {
   ExpandResult ExpandWithResult(json input_json,
                                 std::optional<EnvMap> map = std::nullopt) const;
 
+  /**
+   * @brief Expand environment variables in a JSON with the given map.
+   *
+   * The map is borrowed for the whole traversal and the JSON is expanded in
+   * place: strings without a '$' are left untouched. Every variable that
+   * could not be resolved is reported in the error message.
+   */
+  ExpandResult ExpandWithResult(json input_json, const EnvMap& env_map) const;
+
   /**
    * @brief Expand environment variables in a string.
    *
@@ -133,6 +143,12 @@ class EnvExpander {
   ExpandResult ExpandWithResult(const std::string& str,
                                 std::optional<EnvMap> map = std::nullopt) const;
 
+  /**
+   * @brief Expand environment variables in a string with the given map.
+   */
+  ExpandResult ExpandWithResult(const std::string& str,
+                                const EnvMap& env_map) const;
+
  private:
   /**
    * @brief Build an environment variable map from the system environment.
@@ -142,16 +158,23 @@ class EnvExpander {
   EnvMap BuildEnvMap() const;
 
   /**
-   * @brief Expand a single environment variable reference.
+   * @brief Expand the strings (and the object keys) of a JSON in place.
    *
-   * @param str The input string.
-   * @param pos The starting position of the variable reference.
+   * @param node The JSON to expand.
    * @param env_map The environment variable map to use for lookup.
-   * @param expanded_str The output string to append expanded content to.
-   * @return The position in the input string after the variable reference.
+   * @param errors The errors are appended to it, separated by "; ".
+   * @return true if all environment variables were successfully resolved.
+   */
+  bool ExpandInPlace(json& node, const EnvMap& env_map,
+                     std::string& errors) const;
+
+  /**
+   * @brief Append the expansion of a string to `expanded_str`.
+   *
+   * @return true if all environment variables were successfully resolved.
    */
-  size_t ExpandVariable(const std::string& str, size_t pos,
-                        const EnvMap& env_map, std::string& expanded_str) const;
+  bool ExpandString(std::string_view str, const EnvMap& env_map,
+                    std::string& expanded_str, std::string& errors) const;
 
   /**
    * @brief Expand a single environment variable reference (with result status).
@@ -165,7 +188,7 @@ class EnvExpander {
    * expanded.
    * @return The position in the input string after the variable reference.
    */
-  size_t ExpandVariableWithResult(const std::string& str, size_t pos,
+  size_t ExpandVariableWithResult(std::string_view str, size_t pos,
                                   const EnvMap& env_map,
                                   std::string& expanded_str, bool& found,
                                   std::string& var_name) const;
@@ -1,6 +1,8 @@
 #include "assistant/Process.hpp"
 
 #include <algorithm>
+#include <chrono>
+#include <condition_variable>
 #include <cstring>
 #include <memory>
 #include <thread>
@@ -16,11 +18,16 @@
 #else
 #include <fcntl.h>
 #include <signal.h>
+#include <spawn.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <unistd.h>
 
 #include <cerrno>
+
+#include "assistant/process_pump.hpp"
+
+extern char** environ;
 #endif
 
 namespace assistant {
@@ -201,21 +208,48 @@ std::optional<SpawnedProcess> SpawnProcess(const std::vector<std::string>& argv,
 
 int Process::RunProcessAndWait(const std::vector<std::string>& argv,
                                on_output_callback output_cb, bool use_shell) {
+  return RunProcessWithInput(argv, {}, output_cb, use_shell);
+}
+
+int Process::RunProcessWithInput(const std::vector<std::string>& argv,
+                                 const std::vector<std::string_view>& inputs,
+                                 on_output_callback output_cb,
+                                 bool use_shell) {
   if (use_shell) {
     std::vector<std::string> shell_argv = {"cmd.exe", "/c"};
     shell_argv.insert(shell_argv.end(), argv.begin(), argv.end());
-    return RunProcessAndWait(shell_argv, output_cb, false);
+    return RunProcessWithInput(shell_argv, inputs, output_cb, false);
   }
 
-  if (argv.empty()) {
+  // Only stdin can be handed to the child here.
+  if (argv.empty() || inputs.size() > 1) {
     return -1;
   }
 
-  auto spawned = SpawnProcess(argv, false);
+  std::string_view input = inputs.empty() ? std::string_view{} : inputs[0];
+  auto spawned = SpawnProcess(argv, !input.empty());
   if (!spawned.has_value()) {
     return -1;
   }
 
+  if (spawned->stdin_write != nullptr) {
+    // The pipe writes block: the child is expected to read its whole input
+    // before it produces more output than the pipe buffers.
+    size_t offset = 0;
+    while (offset < input.size()) {
+      DWORD written = 0;
+      DWORD chunk = static_cast<DWORD>(
+          std::min<size_t>(input.size() - offset, kMaxChunkSize));
+      if (!WriteFile(spawned->stdin_write, input.data() + offset, chunk,
+                     &written, nullptr)) {
+        break;
+      }
+      offset += written;
+    }
+    CloseHandle(spawned->stdin_write);
+    spawned->stdin_write = nullptr;
+  }
+
   // Poll for output while process is running
   while (true) {
     std::string new_out = ReadAvailableFromPipe(spawned->stdout_read);
@@ -354,70 +388,139 @@ struct SpawnedProcess {
   int stdin_write_fd{-1};
   int stdout_read_fd{-1};
   int stderr_read_fd{-1};
+  /// The write ends of the pipes read by the child at fds 3, 4, ...
+  std::vector<int> extra_input_fds;
   pid_t pid{-1};
 };
 
+/// Creates a pipe whose ends are closed on exec: they must not leak into the
+/// other children, where they would keep the pipe open.
+bool MakePipe(int fds[2]) {
+#ifdef __linux__
+  return ::pipe2(fds, O_CLOEXEC) == 0;
+#else
+  if (::pipe(fds) != 0) {
+    return false;
+  }
+  ::fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+  ::fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+  return true;
+#endif
+}
+
+void ClosePipe(int fds[2]) {
+  ::close(fds[0]);
+  ::close(fds[1]);
+}
+
 /// Spawn a child process with stdin/stdout/stderr pipes.
 /// When interactive is false, stdin is closed immediately (child gets EOF).
+/// `extra_inputs` more pipes are handed to the child as fds 3, 4, ...
 /// Returns nullopt on failure. On success the caller owns all fds.
+///
+/// The child is started with posix_spawn, which does not copy the address
+/// space of this (possibly large, multithreaded) process the way fork does:
+/// glibc implements it with clone(CLONE_VM | CLONE_VFORK).
 std::optional<SpawnedProcess> SpawnProcess(const std::vector<std::string>& argv,
-                                           bool interactive) {
+                                           bool interactive,
+                                           size_t extra_inputs = 0) {
   int stdin_pipe[2];
   int stdout_pipe[2];
   int stderr_pipe[2];
 
-  if (::pipe(stdin_pipe) != 0) {
+  if (!MakePipe(stdin_pipe)) {
     return std::nullopt;
   }
-  if (::pipe(stdout_pipe) != 0) {
-    ::close(stdin_pipe[0]);
-    ::close(stdin_pipe[1]);
+  if (!MakePipe(stdout_pipe)) {
+    ClosePipe(stdin_pipe);
     return std::nullopt;
   }
-  if (::pipe(stderr_pipe) != 0) {
-    ::close(stdin_pipe[0]);
-    ::close(stdin_pipe[1]);
-    ::close(stdout_pipe[0]);
-    ::close(stdout_pipe[1]);
+  if (!MakePipe(stderr_pipe)) {
+    ClosePipe(stdin_pipe);
+    ClosePipe(stdout_pipe);
     return std::nullopt;
   }
 
+  // The read ends are moved above the fds they are duplicated to in the
+  // child, so that no dup2() there overwrites a pipe not yet duplicated.
+  std::vector<int> extra_read_fds;
+  std::vector<int> extra_write_fds;
+  auto close_extra_pipes = [&extra_read_fds, &extra_write_fds]() {
+    for (int fd : extra_read_fds) {
+      ::close(fd);
+    }
+    for (int fd : extra_write_fds) {
+      ::close(fd);
+    }
+    extra_read_fds.clear();
+    extra_write_fds.clear();
+  };
+  bool extra_pipes_ok = true;
+  for (size_t i = 0; i < extra_inputs; ++i) {
+    int extra_pipe[2];
+    if (!MakePipe(extra_pipe)) {
+      extra_pipes_ok = false;
+      break;
+    }
+    int read_fd =
+        ::fcntl(extra_pipe[0], F_DUPFD_CLOEXEC,
+                STDERR_FILENO + 1 + static_cast<int>(extra_inputs));
+    ::close(extra_pipe[0]);
+    extra_write_fds.push_back(extra_pipe[1]);
+    if (read_fd < 0) {
+      extra_pipes_ok = false;
+      break;
+    }
+    extra_read_fds.push_back(read_fd);
+  }
+
+  // dup2 clears the close-on-exec flag of the fds the child inherits.
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+  posix_spawn_file_actions_adddup2(&actions, stdin_pipe[0], STDIN_FILENO);
+  posix_spawn_file_actions_adddup2(&actions, stdout_pipe[1], STDOUT_FILENO);
+  posix_spawn_file_actions_adddup2(&actions, stderr_pipe[1], STDERR_FILENO);
+  for (size_t i = 0; i < extra_read_fds.size(); ++i) {
+    posix_spawn_file_actions_adddup2(
+        &actions, extra_read_fds[i], STDERR_FILENO + 1 + static_cast<int>(i));
+  }
+
+  // The child starts with no blocked signal and the default SIGPIPE action,
+  // whatever the spawning thread has.
+  posix_spawnattr_t attr;
+  posix_spawnattr_init(&attr);
+  sigset_t signals;
+  sigemptyset(&signals);
+  posix_spawnattr_setsigmask(&attr, &signals);
+  sigaddset(&signals, SIGPIPE);
+  posix_spawnattr_setsigdefault(&attr, &signals);
+  posix_spawnattr_setflags(&attr,
+                           POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF);
+
   Argv exec_argv{argv};
-  pid_t pid = fork();
+  pid_t pid = -1;
+  int rc = extra_pipes_ok ? ::posix_spawnp(&pid, exec_argv.get()[0], &actions,
+                                           &attr, exec_argv.get(), environ)
+                          : -1;
+  posix_spawn_file_actions_destroy(&actions);
+  posix_spawnattr_destroy(&attr);
 
-  if (pid < 0) {
-    ::close(stdin_pipe[0]);
-    ::close(stdin_pipe[1]);
-    ::close(stdout_pipe[0]);
-    ::close(stdout_pipe[1]);
-    ::close(stderr_pipe[0]);
-    ::close(stderr_pipe[1]);
-    return std::nullopt;
+  ::close(stdin_pipe[0]);
+  ::close(stdout_pipe[1]);
+  ::close(stderr_pipe[1]);
+  for (int fd : extra_read_fds) {
+    ::close(fd);
   }
+  extra_read_fds.clear();
 
-  if (pid == 0) {
-    // Child process
+  if (rc != 0) {
     ::close(stdin_pipe[1]);
     ::close(stdout_pipe[0]);
     ::close(stderr_pipe[0]);
-
-    ::dup2(stdin_pipe[0], STDIN_FILENO);
-    ::dup2(stdout_pipe[1], STDOUT_FILENO);
-    ::dup2(stderr_pipe[1], STDERR_FILENO);
-
-    ::close(stdin_pipe[0]);
-    ::close(stdout_pipe[1]);
-    ::close(stderr_pipe[1]);
-
-    ::execvp(exec_argv.get()[0], exec_argv.get());
-    ::_exit(127);
+    close_extra_pipes();
+    return std::nullopt;
   }
 
-  // Parent process
-  ::close(stdin_pipe[0]);
-  ::close(stdout_pipe[1]);
-  ::close(stderr_pipe[1]);
-
   int stdin_fd = stdin_pipe[1];
   if (!interactive) {
     ::close(stdin_fd);
@@ -428,6 +531,7 @@ std::optional<SpawnedProcess> SpawnProcess(const std::vector<std::string>& argv,
       .stdin_write_fd = stdin_fd,
       .stdout_read_fd = stdout_pipe[0],
       .stderr_read_fd = stderr_pipe[0],
+      .extra_input_fds = std::move(extra_write_fds),
       .pid = pid,
   };
 }
@@ -448,33 +552,202 @@ std::string ReadFromFdUntilEOF(int fd) {
   return result;
 }
 
+/// Writes as much of `input`, starting at `offset`, as the non-blocking `fd`
+/// accepts and advances `offset`. Returns false when the child closed its end
+/// of the pipe. A SIGPIPE raised by the write is swallowed.
+bool WriteAvailableInput(int fd, std::string_view input, size_t& offset) {
+  sigset_t pipe_set;
+  sigset_t old_set;
+  sigemptyset(&pipe_set);
+  sigaddset(&pipe_set, SIGPIPE);
+  ::pthread_sigmask(SIG_BLOCK, &pipe_set, &old_set);
+
+  int write_errno = 0;
+  while (offset < input.size()) {
+    ssize_t n = ::write(fd, input.data() + offset, input.size() - offset);
+    if (n > 0) {
+      offset += static_cast<size_t>(n);
+    } else if (n < 0 && errno == EINTR) {
+      continue;
+    } else {
+      write_errno = n < 0 ? errno : EPIPE;
+      break;
+    }
+  }
+
+  if (write_errno == EPIPE) {
+    sigset_t pending;
+    sigpending(&pending);
+    if (sigismember(&pending, SIGPIPE)) {
+      int sig = 0;
+      sigwait(&pipe_set, &sig);
+    }
+  }
+  ::pthread_sigmask(SIG_SETMASK, &old_set, nullptr);
+  return write_errno == 0 || write_errno == EAGAIN ||
+         write_errno == EWOULDBLOCK;
+}
+
+#ifdef __linux__
+/// Runs the spawned child on the process pump. The pump thread does the I/O.
+/// It passes the output over to this thread, where the callback runs: this
+/// thread sleeps until there is output or the child exited.
+int RunWithPump(const SpawnedProcess& spawned,
+                const std::vector<std::string_view>& inputs, bool has_stdin,
+                size_t extra_inputs, const on_output_callback& output_cb) {
+  struct RunState {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::string out;
+    std::string err;
+    bool exited{false};
+    int exit_code{-1};
+  };
+  auto state = std::make_shared<RunState>();
+  auto stopped = std::make_shared<std::atomic_bool>(false);
+
+  ProcessPump::Child child{.pid = spawned.pid,
+                           .stdout_fd = spawned.stdout_read_fd,
+                           .stderr_fd = spawned.stderr_read_fd};
+  if (has_stdin) {
+    child.inputs.push_back({spawned.stdin_write_fd, inputs[0]});
+  }
+  for (size_t i = 0; i < extra_inputs; ++i) {
+    child.inputs.push_back({spawned.extra_input_fds[i], inputs[i + 1]});
+  }
+
+  // Called once before any output, so that the caller may cancel right away.
+  bool keep_going = !output_cb || output_cb("", "");
+  if (!keep_going) {
+    stopped->store(true);
+    ::kill(spawned.pid, SIGKILL);
+  }
+
+  ProcessPump::Instance().Add(
+      std::move(child),
+      [state, stopped](std::string_view out, std::string_view err) {
+        if (stopped->load()) {
+          return false;
+        }
+        {
+          std::scoped_lock lk{state->mutex};
+          state->out.append(out);
+          state->err.append(err);
+        }
+        state->cv.notify_one();
+        return true;
+      },
+      [state](int exit_code) {
+        {
+          std::scoped_lock lk{state->mutex};
+          state->exited = true;
+          state->exit_code = exit_code;
+        }
+        state->cv.notify_one();
+      });
+
+  std::string out;
+  std::string err;
+  while (true) {
+    bool exited = false;
+    {
+      std::unique_lock lk{state->mutex};
+      state->cv.wait(lk, [&state]() {
+        return state->exited || !state->out.empty() || !state->err.empty();
+      });
+      out.swap(state->out);
+      err.swap(state->err);
+      exited = state->exited;
+    }
+    if (exited) {
+      break;
+    }
+    if (keep_going && output_cb && !output_cb(out, err)) {
+      // The pump kills the child on its next output: do it now.
+      keep_going = false;
+      stopped->store(true);
+      ProcessPump::Instance().Signal(spawned.pid, SIGKILL);
+    }
+    out.clear();
+    err.clear();
+  }
+
+  // The output received with the exit, or after a cancellation.
+  if (output_cb) {
+    output_cb(out, err);
+  }
+  return state->exit_code;
+}
+#endif
+
 }  // namespace
 
 int Process::RunProcessAndWait(const std::vector<std::string>& argv,
                                on_output_callback output_cb, bool use_shell) {
+  return RunProcessWithInput(argv, {}, output_cb, use_shell);
+}
+
+int Process::RunProcessWithInput(const std::vector<std::string>& argv,
+                                 const std::vector<std::string_view>& inputs,
+                                 on_output_callback output_cb,
+                                 bool use_shell) {
   if (use_shell) {
     std::vector<std::string> shell_argv = {"/bin/bash", "-c"};
     shell_argv.push_back(JoinArguments(argv));
-    return RunProcessAndWait(shell_argv, output_cb, false);
+    return RunProcessWithInput(shell_argv, inputs, output_cb, false);
   }
 
   if (argv.empty()) {
     return -1;
   }
 
-  auto spawned = SpawnProcess(argv, false);
+  bool has_stdin = !inputs.empty() && !inputs[0].empty();
+  size_t extra_inputs = inputs.empty() ? 0 : inputs.size() - 1;
+  auto spawned = SpawnProcess(argv, has_stdin, extra_inputs);
   if (!spawned.has_value()) {
     return -1;
   }
 
+#ifdef __linux__
+  if (ProcessPump::Instance().IsAvailable()) {
+    return RunWithPump(*spawned, inputs, has_stdin, extra_inputs, output_cb);
+  }
+#endif
   int process_out_fd = spawned->stdout_read_fd;
   int process_err_fd = spawned->stderr_read_fd;
   bool stdout_open = true;
   bool stderr_open = true;
 
+  // The inputs still being written, fd is -1 once written.
+  struct PendingInput {
+    int fd{-1};
+    std::string_view data;
+    size_t offset{0};
+  };
+  std::vector<PendingInput> pending_inputs;
+  if (has_stdin) {
+    pending_inputs.push_back({spawned->stdin_write_fd, inputs[0]});
+  }
+  for (size_t i = 0; i < extra_inputs; ++i) {
+    pending_inputs.push_back({spawned->extra_input_fds[i], inputs[i + 1]});
+  }
+  for (auto& input : pending_inputs) {
+    if (input.data.empty()) {
+      ::close(input.fd);
+      input.fd = -1;
+      continue;
+    }
+    int flags = fcntl(input.fd, F_GETFL, 0);
+    if (flags != -1) {
+      fcntl(input.fd, F_SETFL, flags | O_NONBLOCK);
+    }
+  }
+
   while (stdout_open || stderr_open) {
     fd_set read_set;
+    fd_set write_set;
     FD_ZERO(&read_set);
+    FD_ZERO(&write_set);
 
     int max_fd = -1;
     if (stdout_open) {
@@ -485,6 +758,12 @@ int Process::RunProcessAndWait(const std::vector<std::string>& argv,
       FD_SET(process_err_fd, &read_set);
       max_fd = std::max(max_fd, process_err_fd);
     }
+    for (const auto& input : pending_inputs) {
+      if (input.fd >= 0) {
+        FD_SET(input.fd, &write_set);
+        max_fd = std::max(max_fd, input.fd);
+      }
+    }
 
     if (max_fd == -1) {
       break;
@@ -494,8 +773,19 @@ int Process::RunProcessAndWait(const std::vector<std::string>& argv,
     tv.tv_sec = 0;
     tv.tv_usec = 10000;
 
-    int rc = ::select(max_fd + 1, &read_set, nullptr, nullptr, &tv);
+    int rc = ::select(max_fd + 1, &read_set, &write_set, nullptr, &tv);
     if (rc > 0) {
+      for (auto& input : pending_inputs) {
+        if (input.fd < 0 || !FD_ISSET(input.fd, &write_set)) {
+          continue;
+        }
+        if (!WriteAvailableInput(input.fd, input.data, input.offset) ||
+            input.offset == input.data.size()) {
+          ::close(input.fd);
+          input.fd = -1;
+        }
+      }
+
       std::string new_out;
       std::string new_err;
 
@@ -529,6 +819,11 @@ int Process::RunProcessAndWait(const std::vector<std::string>& argv,
     }
   }
 
+  for (const auto& input : pending_inputs) {
+    if (input.fd >= 0) {
+      ::close(input.fd);
+    }
+  }
   if (stderr_open || stdout_open) {
     ::kill(spawned->pid, SIGKILL);
   }
@@ -573,6 +868,29 @@ bool Process::RunProcessAsync(const std::vector<std::string>& argv,
   if (argv.empty() || !completion_cb) {
     return false;
   }
+#ifdef __linux__
+  if (ProcessPump::Instance().IsAvailable()) {
+    auto spawned = SpawnProcess(argv, false);
+    if (!spawned.has_value()) {
+      return false;
+    }
+
+    bool keep_going = !output_cb || output_cb("", "");
+    if (!keep_going) {
+      ::kill(spawned->pid, SIGKILL);
+    }
+    ProcessPump::Instance().Add(
+        ProcessPump::Child{.pid = spawned->pid,
+                           .stdout_fd = spawned->stdout_read_fd,
+                           .stderr_fd = spawned->stderr_read_fd},
+        [output_cb, keep_going](std::string_view out, std::string_view err) {
+          return keep_going &&
+                 (!output_cb || output_cb(std::string{out}, std::string{err}));
+        },
+        std::move(completion_cb));
+    return true;
+  }
+#endif
   std::thread([argv, output_cb, completion_cb]() {
     int exit_code = RunProcessAndWait(argv, output_cb, false);
     completion_cb(exit_code);
@@ -604,6 +922,22 @@ bool Process::IsAlive(int process_id) {
 /// Interactive (bidirectional) process API
 ///===-------------------------------------------
 
+#ifdef __linux__
+/// How long Stop() waits for an interactive process to exit after SIGTERM,
+/// then after SIGKILL.
+constexpr std::chrono::seconds kStopGracePeriod{3};
+#endif
+
+#ifndef _WIN32
+/// The exit of an interactive process, reported by the process pump.
+struct Process::ExitState {
+  std::mutex mutex;
+  std::condition_variable cv;
+  bool exited{false};
+  int exit_code{-1};
+};
+#endif
+
 Process::~Process() { Stop(); }
 
 bool Process::IsRunning() const {
@@ -763,11 +1097,43 @@ std::shared_ptr<Process> Process::StartInteractive(
 
   auto proc = std::shared_ptr<Process>(new Process());
   proc->m_stdin_write_fd = spawned->stdin_write_fd;
-  proc->m_stdout_read_fd = spawned->stdout_read_fd;
-  proc->m_stderr_read_fd = spawned->stderr_read_fd;
   proc->m_child_pid.store(static_cast<int>(spawned->pid));
   proc->m_running.store(true);
 
+#ifdef __linux__
+  if (ProcessPump::Instance().IsAvailable()) {
+    // The pump reads the output and reports the exit: nothing runs while the
+    // child is idle.
+    auto exit_state = std::make_shared<ExitState>();
+    proc->m_exit_state = exit_state;
+    std::weak_ptr<Process> weak_proc = proc;
+    ProcessPump::Instance().Add(
+        ProcessPump::Child{.pid = spawned->pid,
+                           .stdout_fd = spawned->stdout_read_fd,
+                           .stderr_fd = spawned->stderr_read_fd},
+        [output_cb](std::string_view out, std::string_view err) {
+          if (output_cb) {
+            output_cb(std::string{out}, std::string{err});
+          }
+          return true;
+        },
+        [weak_proc, exit_state](int exit_code) {
+          {
+            std::scoped_lock lk{exit_state->mutex};
+            exit_state->exited = true;
+            exit_state->exit_code = exit_code;
+          }
+          exit_state->cv.notify_all();
+          if (auto proc = weak_proc.lock()) {
+            proc->m_running.store(false);
+          }
+        });
+    return proc;
+  }
+#endif
+  proc->m_stdout_read_fd = spawned->stdout_read_fd;
+  proc->m_stderr_read_fd = spawned->stderr_read_fd;
+
   std::weak_ptr<Process> weak_proc = proc;
   std::thread([weak_proc, output_cb]() {
     bool stdout_open = true;
@@ -866,6 +1232,12 @@ bool Process::WriteLine(const std::string& data) { return Write(data + "\n"); }
 void Process::SendInterrupt() {
   int pid = m_child_pid.load();
   if (pid > 0 && m_running.load()) {
+#ifdef __linux__
+    if (m_exit_state) {
+      ProcessPump::Instance().Signal(static_cast<pid_t>(pid), SIGINT);
+      return;
+    }
+#endif
     ::kill(static_cast<pid_t>(pid), SIGINT);
   }
 }
@@ -886,6 +1258,23 @@ int Process::Stop() {
     m_stdin_write_fd = -1;
   }
 
+#ifdef __linux__
+  if (m_exit_state) {
+    // The pump reaps the child: wait for its exit report instead of polling.
+    auto& pump = ProcessPump::Instance();
+    auto exited = [this]() { return m_exit_state->exited; };
+    pump.Signal(static_cast<pid_t>(pid), SIGTERM);
+    std::unique_lock lk{m_exit_state->mutex};
+    if (!m_exit_state->cv.wait_for(lk, kStopGracePeriod, exited)) {
+      pump.Signal(static_cast<pid_t>(pid), SIGKILL);
+      // The report also waits for the output to be closed, which a grandchild
+      // may keep open.
+      m_exit_state->cv.wait_for(lk, kStopGracePeriod, exited);
+    }
+    m_child_pid.store(-1);
+    return m_exit_state->exited ? m_exit_state->exit_code : -1;
+  }
+#endif
   ::kill(static_cast<pid_t>(pid), SIGTERM);
 
   int status = 0;
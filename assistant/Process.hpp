@@ -6,6 +6,7 @@
 #include <mutex>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace assistant {
@@ -44,8 +45,10 @@ class Process {
    * If use_shell is true, the command will be executed through a shell,
    * allowing the use of shell features like pipes (|), redirections, etc.
    *
-   * The output callback is invoked periodically with the captured stdout and
-   * stderr. If the callback returns false, the process will be terminated.
+   * The output callback is invoked with empty strings once the process
+   * started, then with the captured stdout and stderr (on Linux only when
+   * there is output, elsewhere also periodically). If the callback returns
+   * false, the process will be terminated.
    *
    * @param argv Command and arguments to execute. argv[0] is the command.
    * @param output_cb Callback invoked with stdout and stderr output.
@@ -57,6 +60,50 @@ class Process {
                                on_output_callback output_cb,
                                bool use_shell = false);
 
+  /**
+   * @brief Run process, feed `inputs` to it and wait for completion.
+   *
+   * Same as `RunProcessAndWait` except that the child reads its input from
+   * pipes: `inputs[0]` is written to its stdin and `inputs[n]`, n >= 1, to
+   * its file descriptor `2 + n` (readable as `/dev/fd/<2 + n>`, not supported
+   * on Windows). The inputs are written while the output is being read, each
+   * pipe is closed once its input was written (the child then reads EOF).
+   *
+   * @param argv Command and arguments to execute. argv[0] is the command.
+   * @param inputs The bytes to write to the child's input pipes.
+   * @param output_cb Callback invoked with stdout and stderr output.
+   * @param use_shell If true, run command through shell.
+   * @return The process exit code, or -1 on failure.
+   */
+  static int RunProcessWithInput(const std::vector<std::string>& argv,
+                                 const std::vector<std::string_view>& inputs,
+                                 on_output_callback output_cb,
+                                 bool use_shell = false);
+
+  /**
+   * @brief Run process with `inputs` on its input pipes and capture its
+   * output. See `RunProcessWithInput` above.
+   */
+  static ProcessOutput RunProcessWithInput(
+      const std::vector<std::string>& argv,
+      const std::vector<std::string_view>& inputs) {
+    std::stringstream out_stream;
+    std::stringstream err_stream;
+    auto output_cb = [&out_stream, &err_stream](
+                         const std::string& out,
+                         const std::string& err) -> bool {
+      out_stream << out;
+      err_stream << err;
+      return true;
+    };
+
+    ProcessOutput result{
+        .ok = RunProcessWithInput(argv, inputs, output_cb) == 0,
+        .out = out_stream.str(),
+        .err = err_stream.str()};
+    return result;
+  }
+
   /**
    * @brief Executes a process and waits for it to complete, capturing its
    * output.
@@ -99,10 +146,11 @@ class Process {
    *
    * If use_shell is true, the command will be executed through a shell.
    *
-   * The output callback is invoked periodically with the captured stdout and
-   * stderr. If the callback returns false, the process will be terminated.
-   * When the process exits, the completion callback is invoked with the exit
-   * code from a worker thread.
+   * The output callback is invoked as for `RunProcessAndWait`. If the callback
+   * returns false, the process will be terminated. When the process exits,
+   * the completion callback is invoked with the exit code from a worker
+   * thread. On Linux, that thread is the process pump shared by all the
+   * children: the callbacks must not block.
    *
    * @param argv Command and arguments to execute. argv[0] is the command.
    * @param output_cb Callback invoked with stdout and stderr output.
@@ -144,8 +192,9 @@ class Process {
    * @brief Start a long-lived child process with stdin kept open for writing.
    *
    * The child's stdout/stderr are read via the output callback on a background
-   * thread. The process remains alive until explicitly stopped, the child
-   * exits, or the returned object is destroyed.
+   * thread (on Linux, the process pump shared by all the children: the
+   * callback must not block). The process remains alive until explicitly
+   * stopped, the child exits, or the returned object is destroyed.
    *
    * @param argv Command and arguments. argv[0] is the executable.
    * @param output_cb Callback invoked with stdout/stderr chunks.
@@ -202,9 +251,12 @@ class Process {
   void* m_stderr_read{nullptr};     // HANDLE
   void* m_process_handle{nullptr};  // HANDLE
 #else
+  struct ExitState;
+
   int m_stdin_write_fd{-1};
   int m_stdout_read_fd{-1};
   int m_stderr_read_fd{-1};
+  std::shared_ptr<ExitState> m_exit_state;
 #endif
   std::atomic<int> m_child_pid{-1};
   std::atomic_bool m_running{false};
@@ -59,6 +59,8 @@
    License. For more details visit:
     https://gist.github.com/tomykaira/f0fd86b6c73063283afe550bc5d77594
 */
+#include <algorithm>
+#include <atomic>
 #include <exception>
 #include <fstream>
 #include <functional>
@@ -66,7 +68,9 @@
 #include <iostream>
 #include <memory>
 #include <numeric>
+#include <sstream>
 #include <string>
+#include <vector>
 
 #include "assistant/common/base64.hpp"
 #include "assistant/helpers.hpp"
@@ -331,54 +335,140 @@ class request : public json {
 
   const message_type& get_type() const { return type; }
 
+  /// Writes the JSON value of a streamed member.
+  using member_writer = std::function<void(std::ostream& os)>;
+
+  /// Set `key` to a value that is not stored in this object, but written by
+  /// `writer` straight into the request body (see `write`). Use it for the
+  /// large members (history, tools), so they are not copied into the request.
+  void set_streamed(const std::string& key, member_writer writer) {
+    if (is_object()) {
+      erase(key);
+    }
+    for (auto& [name, w] : streamed_) {
+      if (name == key) {
+        w = std::move(writer);
+        return;
+      }
+    }
+    streamed_.push_back({key, std::move(writer)});
+  }
+
+  /// Whether `key` is set, either in this object or as a streamed member.
+  bool has_member(const std::string& key) const {
+    return contains(key) ||
+           std::any_of(streamed_.begin(), streamed_.end(),
+                       [&key](const auto& m) { return m.first == key; });
+  }
+
+  /// Remove `key`, either from this object or from the streamed members.
+  void erase_member(const std::string& key) {
+    if (is_object()) {
+      erase(key);
+    }
+    std::erase_if(streamed_,
+                  [&key](const auto& m) { return m.first == key; });
+  }
+
+  /// Write the request as compact JSON: the members of this object, followed
+  /// by the streamed members. Same output as `dump()` would produce if the
+  /// streamed members were regular members.
+  void write(std::ostream& os) const {
+    if (streamed_.empty()) {
+      os << static_cast<const json&>(*this);
+      return;
+    }
+
+    os << '{';
+    bool first = true;
+    for (const auto& [key, value] : items()) {
+      os << (first ? "" : ",") << json(key) << ':' << value;
+      first = false;
+    }
+    for (const auto& [key, writer] : streamed_) {
+      os << (first ? "" : ",") << json(key) << ':';
+      writer(os);
+      first = false;
+    }
+    os << '}';
+  }
+
+  /// The complete request body as a string. Prefer `write` for sending it.
+  std::string serialize() const {
+    std::ostringstream ss;
+    write(ss);
+    return ss.str();
+  }
+
  private:
   message_type type;
+  std::vector<std::pair<std::string, member_writer>> streamed_;
+};
+
+/// Decodes the common "/api/chat" stream chunk without building a DOM:
+/// {"model":"m","created_at":"t","message":{"role":"assistant","content":"Hi"},"done":false}
+/// Chunks with an error, tool calls or in the OpenAI format are rejected.
+class chat_chunk_decoder : public assistant::JsonPathSax {
+ public:
+  /// Moves the message content into `content` and returns true if `data`
+  /// has the common shape.
+  bool decode(std::string_view data, std::string& content, bool& done) {
+    content_ = &content;
+    done_ = &done;
+    has_content_ = false;
+    bool ok = Decode(data) && has_content_;
+    content_ = nullptr;
+    done_ = nullptr;
+    return ok;
+  }
+
+ protected:
+  bool OnString(std::string& value) override {
+    if (PathIs({"message", "content"})) {
+      *content_ = std::move(value);
+      has_content_ = true;
+    }
+    return true;
+  }
+
+  bool OnBool(bool value) override {
+    if (PathIs({"done"})) {
+      *done_ = value;
+    }
+    return true;
+  }
+
+  bool OnKey() override {
+    switch (Depth()) {
+      case 1:
+        return PathAt(0) != "error" && PathAt(0) != "choices";
+      case 2:
+        return PathAt(0) != "message" || PathAt(1) != "tool_calls";
+      default:
+        return true;
+    }
+  }
+
+ private:
+  std::string* content_{nullptr};
+  bool* done_{nullptr};
+  bool has_content_{false};
 };
 
 class response {
  public:
+  /// What `from_chat_chunk` decoded without building a DOM.
+  struct chat_chunk {
+    bool done{false};
+  };
+
   response(const std::string& json_string,
            message_type type = message_type::generation)
       : type(type), valid(true) {
     this->json_string = json_string;
     try {
       json_data = json::parse(json_string);
-
-      if (type == message_type::generation && json_data.contains("response"))
-        simple_string = json_data["response"].get<std::string>();
-      else if (type == message_type::embedding &&
-               json_data.contains("embeddings"))
-        simple_string = json_data["embeddings"].get<std::string>();
-      else if (type == message_type::chat && json_data.contains("message")) {
-        // Ollama format: {"message":{"content":"text"}}
-        simple_string = json_data["message"]["content"].get<std::string>();
-      } else if (type == message_type::chat && json_data.contains("choices") &&
-                 json_data["choices"].is_array() &&
-                 !json_data["choices"].empty()) {
-        // OpenAI format (streaming): {"choices":[{"delta":{"content":"text"}}]}
-        // OpenAI format (non-streaming):
-        // {"choices":[{"message":{"content":"text"}}]}
-        const auto& choice = json_data["choices"][0];
-        if (choice.contains("delta") && choice["delta"].is_object() &&
-            choice["delta"].contains("content")) {
-          simple_string = choice["delta"]["content"].get<std::string>();
-        } else if (choice.contains("message") &&
-                   choice["message"].is_object() &&
-                   choice["message"].contains("content")) {
-          simple_string = choice["message"]["content"].get<std::string>();
-        }
-      }
-
-      if (json_data.contains("error") && json_data["error"].is_string()) {
-        // Ollama error message
-        error_string = json_data["error"].get<std::string>();
-      } else if (json_data.contains("error") &&
-                 json_data["error"].is_object() &&
-                 json_data["error"].contains("message") &&
-                 json_data["error"]["message"].is_string()) {
-        // OpenAI error message
-        error_string = json_data["error"]["message"].get<std::string>();
-      }
+      load();
     } catch (const std::exception& e) {
       if (assistant::use_exceptions) {
         std::stringstream ss;
@@ -390,6 +480,48 @@ class response {
     }
   }
 
+  /// Build a response from an already parsed JSON object. Use this when the
+  /// caller has the DOM at hand (e.g. the streaming decoder), to avoid a
+  /// dump() + parse() round trip per message.
+  static response from_json(json j,
+                            message_type type = message_type::generation) {
+    response r;
+    r.type = type;
+    r.valid = true;
+    r.json_data = std::move(j);
+    try {
+      r.load();
+    } catch (const std::exception& e) {
+      if (assistant::use_exceptions) {
+        std::stringstream ss;
+        ss << "Unable to parse JSON string: " << e.what() << ". Input string:\n"
+           << r.json_data.dump();
+        throw assistant::invalid_json_exception(ss.str());
+      }
+      r.valid = false;
+    }
+    return r;
+  }
+
+  /// Build a response from a raw "/api/chat" stream chunk. The common
+  /// shape is decoded by `decoder` in a single SAX pass: the content is in
+  /// `as_simple_string()` and the DOM is only built if `as_json()` is called.
+  /// Any other chunk is parsed into a DOM, as in `from_json`. Throws
+  /// `json::exception` if `frame` is not valid JSON.
+  static response from_chat_chunk(std::string_view frame,
+                                  chat_chunk_decoder& decoder) {
+    response r;
+    chat_chunk chunk;
+    if (!decoder.decode(frame, r.simple_string, chunk.done)) {
+      return from_json(json::parse(frame), message_type::chat);
+    }
+    r.type = message_type::chat;
+    r.valid = true;
+    r.json_string.assign(frame.data(), frame.size());
+    r.chunk_ = chunk;
+    return r;
+  }
+
   response() {
     json_string = "";
     valid = false;
@@ -398,13 +530,32 @@ class response {
 
   bool is_valid() const { return valid; };
 
-  const std::string& as_json_string() const { return json_string; }
+  const std::string& as_json_string() const {
+    if (json_string.empty() && !json_data.is_null()) {
+      // Built from a DOM (see "from_json"), serialize on demand.
+      json_string = json_data.dump();
+    }
+    return json_string;
+  }
 
-  const json& as_json() const { return json_data; }
+  const json& as_json() const {
+    if (chunk_.has_value() && json_data.is_null()) {
+      // Decoded by "from_chat_chunk", parse on demand.
+      json_data = json::parse(json_string);
+    }
+    return json_data;
+  }
 
   const std::string& as_simple_string() const { return simple_string; }
 
+  /// Set if the response was decoded without a DOM (see "from_chat_chunk").
+  const std::optional<chat_chunk>& get_chat_chunk() const { return chunk_; }
+
   bool has_error() const {
+    if (chunk_.has_value()) {
+      // The decoder rejects chunks with an "error".
+      return false;
+    }
     if (json_data.contains("error")) return true;
     return false;
   }
@@ -424,11 +575,48 @@ class response {
   // const operator std::string() const { return this->as_simple_string(); }
 
  private:
-  std::string json_string;
+  void load() {
+    if (type == message_type::generation && json_data.contains("response"))
+      simple_string = json_data["response"].get<std::string>();
+    else if (type == message_type::embedding &&
+             json_data.contains("embeddings"))
+      simple_string = json_data["embeddings"].get<std::string>();
+    else if (type == message_type::chat && json_data.contains("message")) {
+      // Ollama format: {"message":{"content":"text"}}
+      simple_string = json_data["message"]["content"].get<std::string>();
+    } else if (type == message_type::chat && json_data.contains("choices") &&
+               json_data["choices"].is_array() &&
+               !json_data["choices"].empty()) {
+      // OpenAI format (streaming): {"choices":[{"delta":{"content":"text"}}]}
+      // OpenAI format (non-streaming):
+      // {"choices":[{"message":{"content":"text"}}]}
+      const auto& choice = json_data["choices"][0];
+      if (choice.contains("delta") && choice["delta"].is_object() &&
+          choice["delta"].contains("content")) {
+        simple_string = choice["delta"]["content"].get<std::string>();
+      } else if (choice.contains("message") && choice["message"].is_object() &&
+                 choice["message"].contains("content")) {
+        simple_string = choice["message"]["content"].get<std::string>();
+      }
+    }
+
+    if (json_data.contains("error") && json_data["error"].is_string()) {
+      // Ollama error message
+      error_string = json_data["error"].get<std::string>();
+    } else if (json_data.contains("error") && json_data["error"].is_object() &&
+               json_data["error"].contains("message") &&
+               json_data["error"]["message"].is_string()) {
+      // OpenAI error message
+      error_string = json_data["error"]["message"].get<std::string>();
+    }
+  }
+
+  mutable std::string json_string;
   std::string simple_string;
   std::string error_string;
 
-  json json_data;
+  mutable json json_data;
+  std::optional<chat_chunk> chunk_;
   message_type type;
   bool valid;
 };
@@ -438,6 +626,44 @@ using on_respons_callback =
 
 using on_raw_respons_callback = std::function<bool(const std::string&, void*)>;
 
+/// Feeds `data` of a streamed "/api/chat" reply to `decoder` and passes every
+/// complete chunk to `on_receive_token`. Shared by the streaming transports.
+/// Returns false to abort the stream.
+inline bool feed_chat_stream(assistant::JsonStreamDecoder& decoder,
+                             chat_chunk_decoder& chunk_decoder,
+                             std::string_view data,
+                             const on_respons_callback& on_receive_token,
+                             void* user_data) {
+  using FrameAction = assistant::JsonStreamDecoder::FrameAction;
+  return decoder.FeedFrames(data, [&](std::string_view frame) -> FrameAction {
+    assistant::response response;
+    try {
+      response = assistant::response::from_chat_chunk(frame, chunk_decoder);
+    } catch (const json::exception&) {
+      // Balanced, but not valid JSON. Kept by the decoder for error
+      // reporting.
+      return FrameAction::kInvalid;
+    } catch (const assistant::invalid_json_exception& e) {
+      // Could not parse a response object.
+      if (assistant::use_exceptions) {
+        std::stringstream ss;
+        ss << "Could not parse response." << e.what() << "\n";
+        throw assistant::exception(ss.str());
+      }
+      // Abort the stream.
+      return FrameAction::kStop;
+    }
+
+    if (response.has_error()) {
+      if (assistant::use_exceptions)
+        throw assistant::exception("Server response returned error: " +
+                                   response.get_error());
+    }
+    return on_receive_token(response, user_data) ? FrameAction::kContinue
+                                                 : FrameAction::kStop;
+  });
+}
+
 class ITransport {
  public:
   ITransport() = default;
@@ -524,6 +750,17 @@ class ITransport {
   void setEndpointKind(EndpointKind kind) { endpoint_kind_ = kind; }
   EndpointKind getEndpointKind() const { return endpoint_kind_; }
 
+  /// Register a callback that is invoked every time the transport opens a new
+  /// connection to the server. Transports that do not keep connections open
+  /// between requests may ignore it.
+  virtual void setOnNewConnection(
+      [[maybe_unused]] std::function<void()> on_new_connection) {}
+
+  /// Return true if "interrupt()" was called on this transport. An
+  /// interrupted transport has its connection torn down and must not be
+  /// re-used.
+  bool wasInterrupted() const { return interrupted_.load(); }
+
  protected:
   virtual std::string GetGeneratePath() const { return "/api/generate"; }
   virtual std::string GetShowPath() const { return "/api/show"; }
@@ -559,6 +796,7 @@ class ITransport {
   EndpointKind endpoint_kind_{EndpointKind::ollama};
   std::string server_url;
   httplib::Headers headers_;
+  std::atomic_bool interrupted_{false};
 };
 
 class ClientImpl : public ITransport {
@@ -744,69 +982,33 @@ class ClientImpl : public ITransport {
     assistant::response response;
     request["stream"] = true;
 
-    std::string request_string = request.dump();
-    if (assistant::log_requests) std::cout << request_string << std::endl;
-
-    std::string partial_messages;
-    auto stream_callback = [on_receive_token, user_data, &partial_messages](
-                               const char* data, size_t data_length) -> bool {
-      std::string message(data, data_length);
+    if (assistant::log_requests) std::cout << request.serialize() << std::endl;
 
+    assistant::JsonStreamDecoder decoder;
+    chat_chunk_decoder chunk_decoder;
+    auto stream_callback = [on_receive_token, user_data, &decoder,
+                            &chunk_decoder](const char* data,
+                                            size_t data_length) -> bool {
       if (assistant::log_transport) {
-        std::cout << message << std::endl;
-      }
-
-      partial_messages.append(message);
-
-      auto result = assistant::try_read_jsons_from_string(partial_messages);
-      if (result.first.empty()) {
-        // no complete jsons
-        return true;
+        std::cout << std::string_view{data, data_length} << std::endl;
       }
 
-      // "second" holds the remainder
-      partial_messages.swap(result.second);
-
-      // Process the jsons
-      for (const auto& j : result.first) {
-        try {
-          assistant::response response(j.dump(), assistant::message_type::chat);
-          if (response.has_error()) {
-            if (assistant::use_exceptions)
-              throw assistant::exception("Server response returned error: " +
-                                         response.get_error());
-          }
-          if (!on_receive_token(response, user_data)) {
-            return false;
-          }
-        } catch (const assistant::invalid_json_exception& e) {
-          // Could not parse a response object.
-          if (assistant::use_exceptions) {
-            std::stringstream ss;
-            ss << "Could not parse response." << e.what() << "\n"
-               << "Response JSON:\n"
-               << j.dump(2) << "\n";
-            throw assistant::exception(ss.str());
-          }
-          // Abort the stream.
-          return false;
-        }
-      }
-      return true;
+      return assistant::feed_chat_stream(
+          decoder, chunk_decoder, std::string_view{data, data_length},
+          on_receive_token, user_data);
     };
 
     OLOG_TRACE() << "Sending request to: " << GetChatPath();
-    OLOG_TRACE() << "Request string: " << request_string;
+    OLOG_TRACE() << "Request string: " << request.serialize();
 
-    if (auto res = this->cli->Post(GetChatPath(), headers_, request_string,
-                                   kApplicationJson, stream_callback)) {
+    if (auto res = post_streamed(GetChatPath(), request, stream_callback)) {
       if (res.value().status >= 400) {
         // error code.
         std::stringstream errmsg;
         errmsg << "Server responded with an error. " << res.value().reason
                << " (" << std::to_string(res.value().status) << ").";
         errmsg << "\nResponse body:\n" << res.value().body;
-        errmsg << "\nPartial buffer:\n" << partial_messages;
+        errmsg << "\nPartial buffer:\n" << decoder.Pending();
         OLOG(LogLevel::kError) << errmsg.str();
         if (assistant::use_exceptions) {
           throw assistant::exception(errmsg.str());
@@ -834,8 +1036,7 @@ class ClientImpl : public ITransport {
     assistant::response response;
     request["stream"] = true;
 
-    std::string request_string = request.dump();
-    if (assistant::log_requests) std::cout << request_string << std::endl;
+    if (assistant::log_requests) std::cout << request.serialize() << std::endl;
 
     std::string accumlated_buffer;
     auto stream_callback = [&accumlated_buffer, on_receive_token, user_data](
@@ -846,9 +1047,8 @@ class ClientImpl : public ITransport {
     };
 
     OLOG_TRACE() << "Sending request to: " << GetChatPath();
-    OLOG_TRACE() << "Request string: " << request_string;
-    if (auto res = this->cli->Post(GetChatPath(), headers_, request_string,
-                                   kApplicationJson, stream_callback)) {
+    OLOG_TRACE() << "Request string: " << request.serialize();
+    if (auto res = post_streamed(GetChatPath(), request, stream_callback)) {
       if (res.value().status >= 400) {
         // error code.
         std::stringstream errmsg;
@@ -1285,7 +1485,23 @@ class ClientImpl : public ITransport {
     return true;
   }
 
+  void setOnNewConnection(std::function<void()> on_new_connection) override {
+    if (this->cli == nullptr) {
+      return;
+    }
+    // httplib invokes the socket options callback once per socket it creates,
+    // which makes it a reliable "new connection" hook.
+    this->cli->set_socket_options(
+        [on_new_connection = std::move(on_new_connection)](
+            [[maybe_unused]] socket_t sock) {
+          if (on_new_connection) {
+            on_new_connection();
+          }
+        });
+  }
+
   void interrupt() override {
+    interrupted_.store(true);
     httplib::detail::shutdown_socket(this->cli->socket());
     httplib::detail::close_socket(this->cli->socket());
   }
@@ -1321,6 +1537,41 @@ class ClientImpl : public ITransport {
 #endif
 
  private:
+  /// POST `request` to `path` and pass the response body to `receiver`.
+  ///
+  /// The body is sent with chunked transfer encoding and serialized while it
+  /// is written to the socket (see `request::write`), so the request is never
+  /// held in memory as a whole string.
+  httplib::Result post_streamed(const std::string& path,
+                                const assistant::request& request,
+                                httplib::ContentReceiver receiver) {
+    httplib::Request req;
+    req.method = "POST";
+    req.path = path;
+    req.headers = headers_;
+    req.set_header("Content-Type", kApplicationJson);
+    req.set_header("Transfer-Encoding", "chunked");
+    req.is_chunked_content_provider_ = true;
+    req.content_provider_ = httplib::detail::ContentProviderAdapter(
+        [&request](size_t, httplib::DataSink& sink) {
+          {
+            assistant::CallbackStreamBuf buffer(
+                [&sink](const char* data, size_t len) {
+                  return sink.write(data, len);
+                });
+            std::ostream os(&buffer);
+            request.write(os);
+          }
+          // A failed write is reported by httplib as `Error::Write`.
+          sink.done();
+          return true;
+        });
+    req.content_receiver = [receiver = std::move(receiver)](
+                               const char* data, size_t len, uint64_t,
+                               uint64_t) { return receiver(data, len); };
+    return cli->send(req);
+  }
+
   httplib::Client* cli;
 };
 
@@ -7,26 +7,57 @@
 
 namespace assistant::chat_completions {
 
+bool ChunkDecoder::DecodeInto(std::string_view data, ParseResult& result,
+                              std::string& finish_reason) {
+  m_result = &result;
+  m_finish_reason = &finish_reason;
+  bool ok = Decode(data);
+  m_result = nullptr;
+  m_finish_reason = nullptr;
+  return ok;
+}
+
+bool ChunkDecoder::OnString(std::string& value) {
+  if (Depth() < 3 || PathAt(0) != "choices") {
+    return true;
+  }
+  if (PathIs({"choices", "0", "delta", "content"})) {
+    m_result->content = std::move(value);
+  } else if (PathIs({"choices", "0", "finish_reason"})) {
+    *m_finish_reason = std::move(value);
+  }
+  return true;
+}
+
+bool ChunkDecoder::OnKey() {
+  switch (Depth()) {
+    case 1:
+      return PathAt(0) != "error";
+    case 3:
+      // Only the first choice is read, see `ProcessChunk`.
+      return PathAt(0) != "choices" ||
+             (PathAt(1) == "0" && PathAt(2) != "usage");
+    case 4:
+      return PathAt(0) != "choices" || PathAt(2) != "delta" ||
+             PathAt(3) != "tool_calls";
+    default:
+      return true;
+  }
+}
+
 void ResponseParser::Parse(const std::string& text,
                            std::function<void(ParseResult)> cb) {
-  AppendText(text);
+  m_framer.Append(text);
 
   while (true) {
-    auto line_opt = PopLine();
-    if (!line_opt.has_value()) {
+    auto event = m_framer.Next();
+    if (!event.has_value()) {
       cb(std::move(ParseResult{.need_more_data = true}));
       return;
     }
 
-    std::string line = line_opt.value();
-
     // Handle SSE format: "data: {...}"
-    if (line.find("data: ") != 0) {
-      // Skip non-data lines (e.g., "event: message", empty lines)
-      continue;
-    }
-
-    std::string data_content = line.substr(6);  // Remove "data: " prefix
+    std::string_view data_content = assistant::trim(event->data);
 
     // Check for stream end marker
     if (data_content == "[DONE]") {
@@ -35,10 +66,25 @@ void ResponseParser::Parse(const std::string& text,
       return;
     }
 
+    // Common content chunks are decoded without building a DOM.
+    ParseResult chunk_result;
+    m_finish_reason.clear();
+    if (m_chunk_decoder.DecodeInto(data_content, chunk_result,
+                                   m_finish_reason)) {
+      ApplyFinishReason(m_finish_reason, chunk_result);
+      bool is_done = chunk_result.is_done;
+      cb(std::move(chunk_result));
+      if (is_done) {
+        Reset();
+        return;
+      }
+      continue;
+    }
+
     // Try to parse as JSON
     auto json_opt = TryJson(data_content);
     if (!json_opt.has_value()) {
-      // Invalid JSON, skip this line
+      // Invalid JSON, skip this event
       continue;
     }
 
@@ -52,43 +98,10 @@ void ResponseParser::Parse(const std::string& text,
   }
 }
 
-std::optional<std::string> ResponseParser::PopLine() {
-  std::string current_line;
-  enum class State { kStart, kCollect } state = State::kStart;
-
-  for (size_t pos = 0; pos < m_content.size(); ++pos) {
-    char c = m_content[pos];
-    switch (state) {
-      case State::kStart:
-        if (c != '\n') {
-          current_line += c;
-          state = State::kCollect;
-        } else {
-          // Skip leading newlines
-        }
-        break;
-      case State::kCollect:
-        if (c == '\n') {
-          state = State::kStart;
-          m_content.erase(0, pos + 1);  // Consume the \n as well
-          return current_line;
-        } else {
-          current_line += c;
-        }
-        break;
-    }
-  }
-  return std::nullopt;
-}
-
-void ResponseParser::AppendText(const std::string& text) {
-  m_content.append(text);
-}
-
 std::optional<json> ResponseParser::TryJson(std::string_view text) {
   try {
     auto trimmed = assistant::trim(text);
-    auto _json = json::parse(std::string(trimmed));
+    auto _json = json::parse(trimmed);
     return _json;
   } catch (...) {
     return std::nullopt;
@@ -190,38 +203,9 @@ ParseResult ResponseParser::ProcessChunk(const json& data) {
     }
 
     // Check for finish_reason (indicates completion)
-    if (choice.contains("finish_reason")) {
-      auto fr = choice["finish_reason"];
-      if (!fr.is_null() && fr.is_string()) {
-        std::string finish_reason_str = fr.get<std::string>();
-
-        if (finish_reason_str == "stop") {
-          result.finish_reason = FinishReason::stop;
-          result.is_done = true;
-        } else if (finish_reason_str == "length") {
-          result.finish_reason = FinishReason::length;
-          result.is_done = true;
-        } else if (finish_reason_str == "tool_calls") {
-          result.finish_reason = FinishReason::tool_calls;
-          result.is_done = true;
-
-          // Add accumulated tool_calls to result
-          for (const auto& [idx, tc] : m_tool_calls) {
-            result.tool_calls.push_back(tc);
-          }
-        } else if (finish_reason_str == "content_filter") {
-          result.finish_reason = FinishReason::content_filter;
-          result.is_done = true;
-        } else if (finish_reason_str == "function_call") {
-          result.finish_reason = FinishReason::function_call;
-          result.is_done = true;
-
-          // Add accumulated tool_calls to result
-          for (const auto& [idx, tc] : m_tool_calls) {
-            result.tool_calls.push_back(tc);
-          }
-        }
-      }
+    auto fr = choice.find("finish_reason");
+    if (fr != choice.end() && fr->is_string()) {
+      ApplyFinishReason(fr->get_ref<const std::string&>(), result);
     }
 
     // Extract usage if present
@@ -266,6 +250,36 @@ ParseResult ResponseParser::ProcessChunk(const json& data) {
   return result;
 }
 
+void ResponseParser::ApplyFinishReason(std::string_view finish_reason,
+                                       ParseResult& result) {
+  if (finish_reason == "stop") {
+    result.finish_reason = FinishReason::stop;
+    result.is_done = true;
+  } else if (finish_reason == "length") {
+    result.finish_reason = FinishReason::length;
+    result.is_done = true;
+  } else if (finish_reason == "tool_calls") {
+    result.finish_reason = FinishReason::tool_calls;
+    result.is_done = true;
+
+    // Add accumulated tool_calls to result
+    for (const auto& [idx, tc] : m_tool_calls) {
+      result.tool_calls.push_back(tc);
+    }
+  } else if (finish_reason == "content_filter") {
+    result.finish_reason = FinishReason::content_filter;
+    result.is_done = true;
+  } else if (finish_reason == "function_call") {
+    result.finish_reason = FinishReason::function_call;
+    result.is_done = true;
+
+    // Add accumulated tool_calls to result
+    for (const auto& [idx, tc] : m_tool_calls) {
+      result.tool_calls.push_back(tc);
+    }
+  }
+}
+
 std::optional<std::string> ResponseParser::GetErrorMessage(
     const std::string& response) {
   try {
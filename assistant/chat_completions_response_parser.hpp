@@ -5,6 +5,7 @@
 
 #include "assistant/client/client_base.hpp"
 #include "assistant/common/json.hpp"
+#include "assistant/helpers.hpp"
 
 namespace assistant::chat_completions {
 
@@ -80,6 +81,27 @@ inline std::ostream& operator<<(std::ostream& os, const ParseResult& res) {
   return os;
 }
 
+/// Decodes a chunk that only carries `choices[0].delta.content` and/or
+/// `choices[0].finish_reason` without building a DOM:
+/// {"id":"1","object":"chat.completion.chunk","choices":[{"index":0,"delta":{"content":"Hi"},"finish_reason":null}]}
+/// Chunks with an error, tool calls, usage or more than one choice are
+/// rejected.
+class ChunkDecoder : public JsonPathSax {
+ public:
+  /// Moves the content into `result.content` and the finish reason into
+  /// `finish_reason`. Returns false if `data` has another shape.
+  bool DecodeInto(std::string_view data, ParseResult& result,
+                  std::string& finish_reason);
+
+ protected:
+  bool OnString(std::string& value) override;
+  bool OnKey() override;
+
+ private:
+  ParseResult* m_result{nullptr};
+  std::string* m_finish_reason{nullptr};
+};
+
 /// A stateful Chat Completions response parser for SSE format.
 class ResponseParser {
  public:
@@ -89,7 +111,7 @@ class ResponseParser {
   void Parse(const std::string& text, std::function<void(ParseResult)> cb);
 
   inline void Reset() {
-    m_content.clear();
+    m_framer.Reset();
     m_tool_calls.clear();
   }
 
@@ -97,13 +119,17 @@ class ResponseParser {
       const std::string& response);
 
  private:
-  void AppendText(const std::string& text);
-  std::optional<std::string> PopLine();
   std::optional<json> TryJson(std::string_view text);
 
   ParseResult ProcessChunk(const json& data);
-
-  std::string m_content;
+  /// Sets the finish reason (and the accumulated tool calls) of `result`.
+  void ApplyFinishReason(std::string_view finish_reason, ParseResult& result);
+
+  /// Splits the stream into events. The chunks are "data:" lines separated
+  /// by blank lines, lenient framing also accepts them without.
+  SseFramer m_framer{SseFraming::kLenient};
+  ChunkDecoder m_chunk_decoder;
+  std::string m_finish_reason;
   std::map<int, ToolCall> m_tool_calls;  // index -> ToolCall (for accumulating
                                          // streaming tool calls)
 };
@@ -6,9 +6,57 @@
 
 namespace assistant::claude {
 
+std::optional<std::string> ContentBlockDeltaDecoder::DecodeContent(
+    std::string_view data) {
+  m_type = std::nullopt;
+  m_content.clear();
+  m_has_content = false;
+  if (!Decode(data) || !m_type.has_value()) {
+    return std::nullopt;
+  }
+  switch (m_type.value()) {
+    case DeltaType::text_delta:
+    case DeltaType::input_json_delta:
+    case DeltaType::thinking_delta:
+      if (!m_has_content) {
+        return std::nullopt;
+      }
+      return std::move(m_content);
+    case DeltaType::signature_delta:
+      // we don't care (for now) about the signature.
+      return std::string{};
+    case DeltaType::compaction_delta:
+      // Rare, and its content may be null: use the DOM.
+      return std::nullopt;
+  }
+  return std::nullopt;
+}
+
+bool ContentBlockDeltaDecoder::OnString(std::string& value) {
+  if (!InDelta()) {
+    return true;
+  }
+  if (PathAt(1) == "type") {
+    m_type = magic_enum::enum_cast<DeltaType>(value);
+    return m_type.has_value();
+  }
+  m_content = std::move(value);
+  m_has_content = true;
+  return true;
+}
+
+bool ContentBlockDeltaDecoder::OnKey() {
+  if (!InDelta()) {
+    return true;
+  }
+  auto key = PathAt(1);
+  return key == "type" || key == "text" || key == "partial_json" ||
+         key == "thinking" || key == "signature";
+}
+
 void ResponseParser::Parse(const std::string& text,
                            std::function<void(ParseResult)> cb) {
-  AppendText(text);
+  m_framer.Append(text);
 
   while (true) {
     auto event_message_opt = NextMessage();
@@ -22,7 +70,7 @@ void ResponseParser::Parse(const std::string& text,
                                   event_message_opt.value().event);
     OLOG(LogLevel::kDebug) << "Data: " << event_message_opt.value().data;
 
-    auto event_message = event_message_opt.value();
+    auto event_message = std::move(event_message_opt.value());
     switch (m_state) {
       case ParserState::initial: {
         switch (event_message.event) {
@@ -30,7 +78,7 @@ void ResponseParser::Parse(const std::string& text,
           case Event::ping:
             break;
           case Event::message_delta: {
-            auto stop_reason = GetStopReason(event_message);
+            auto stop_reason = GetStopReason(event_message.data);
             bool is_done{false};
             if (stop_reason.has_value() &&
                 (stop_reason.value() == StopReason::max_tokens ||
@@ -39,15 +87,15 @@ void ResponseParser::Parse(const std::string& text,
             }
             cb(std::move(ParseResult{
                 .is_done = is_done,
-                .stop_reason = GetStopReason(event_message),
-                .usage = GetUsage(event_message),
+                .stop_reason = stop_reason,
+                .usage = GetUsage(event_message.data),
             }));
           } break;
           case Event::message_stop:
             cb(std::move(
                 ParseResult{.is_done = true,
-                            .stop_reason = GetStopReason(event_message),
-                            .usage = GetUsage(event_message)}));
+                            .stop_reason = GetStopReason(event_message.data),
+                            .usage = GetUsage(event_message.data)}));
             Reset();
             return;
           case Event::error:
@@ -59,7 +107,7 @@ void ResponseParser::Parse(const std::string& text,
             Reset();
             return;
           case Event::content_block_start: {
-            auto content_block_type = GetContentBlock(event_message);
+            auto content_block_type = GetContentBlock(event_message.data);
             switch (content_block_type) {
               case ContentType::text:
                 m_state = ParserState::collect_text;
@@ -73,8 +121,9 @@ void ResponseParser::Parse(const std::string& text,
               case ContentType::tool_use: {
                 // get the toolname
                 m_tool_call.Reset();
-                m_tool_call.name = GetToolName(event_message);  // might throw
-                m_tool_call.id = GetToolId(event_message);      // might throw
+                // might throw
+                m_tool_call.name = GetToolName(event_message.data);
+                m_tool_call.id = GetToolId(event_message.data);
                 m_state = ParserState::collect_tool_use_json;
               } break;
             }
@@ -101,8 +150,8 @@ void ResponseParser::Parse(const std::string& text,
             case Event::message_stop:
               cb(std::move(
                   ParseResult{.is_done = true,
-                              .stop_reason = GetStopReason(event_message),
-                              .usage = GetUsage(event_message)}));
+                              .stop_reason = GetStopReason(event_message.data),
+                              .usage = GetUsage(event_message.data)}));
               Reset();
               return;
             case Event::content_block_delta: {
@@ -150,8 +199,8 @@ void ResponseParser::Parse(const std::string& text,
             case Event::message_stop:
               cb(std::move(
                   ParseResult{.is_done = true,
-                              .stop_reason = GetStopReason(event_message),
-                              .usage = GetUsage(event_message)}));
+                              .stop_reason = GetStopReason(event_message.data),
+                              .usage = GetUsage(event_message.data)}));
               Reset();
               return;
             case Event::content_block_start:
@@ -172,8 +221,8 @@ void ResponseParser::Parse(const std::string& text,
             case Event::message_stop:
               cb(std::move(
                   ParseResult{.is_done = true,
-                              .stop_reason = GetStopReason(event_message),
-                              .usage = GetUsage(event_message)}));
+                              .stop_reason = GetStopReason(event_message.data),
+                              .usage = GetUsage(event_message.data)}));
               Reset();
               return;
             case Event::error:
@@ -209,8 +258,8 @@ void ResponseParser::Parse(const std::string& text,
             case Event::message_stop:
               cb(std::move(
                   ParseResult{.is_done = true,
-                              .stop_reason = GetStopReason(event_message),
-                              .usage = GetUsage(event_message)}));
+                              .stop_reason = GetStopReason(event_message.data),
+                              .usage = GetUsage(event_message.data)}));
               Reset();
               return;
             case Event::error:
@@ -233,91 +282,53 @@ void ResponseParser::Parse(const std::string& text,
   }
 }
 
-std::optional<std::string> ResponseParser::PopLine() {
-  std::string current_line;
-  enum class State { kStart, kCollect } state = State::kStart;
-  for (size_t pos = 0; pos < m_content.size(); ++pos) {
-    char c = m_content[pos];
-    switch (state) {
-      case State::kStart:
-        if (c != '\n') {
-          current_line += c;
-          state = State::kCollect;
-        } else {
-          // found "\n", skip it.
-        }
-        break;
-      case State::kCollect:
-        if (c == '\n') {
-          state = State::kStart;
-          m_content.erase(0, pos + 1);  // consume the \n as well.
-          return current_line;
-        } else {
-          current_line += c;
-        }
-        break;
-    }
-  }
-  return std::nullopt;
-}
-
-void ResponseParser::PushLineFront(const std::string& line) {
-  std::string line_to_restore = line;
-  if (!line_to_restore.ends_with("\n")) {
-    line_to_restore += "\n";
-  }
-
-  auto new_content = line_to_restore + m_content;
-  m_content.swap(new_content);
-}
-
 std::optional<EventMessage> ResponseParser::NextMessage() {
-  auto event_str_opt = PopLine();
-  if (!event_str_opt.has_value()) {
-    return std::nullopt;
-  }
-
-  auto data_str_opt = PopLine();
-  if (!data_str_opt.has_value()) {
-    PushLineFront(event_str_opt.value());
+  auto sse_event = m_framer.Next();
+  if (!sse_event.has_value()) {
     return std::nullopt;
   }
 
-  std::string event_str = event_str_opt.value();
-  std::string data_str = data_str_opt.value();
-
-  auto event_type_str = assistant::after_first(event_str, ":");
+  auto event_type_str = assistant::trim(sse_event->event);
   if (event_type_str.empty()) {
     std::stringstream ss;
-    ss << "Invalid input line. Line must start with 'event:'. Actual line "
-          "is: '"
-       << event_str << "'";
+    ss << "Invalid input. Event must start with 'event:'. Actual data is: '"
+       << sse_event->data << "'";
     throw std::runtime_error(ss.str());
   }
 
-  auto event_type =
-      magic_enum::enum_cast<Event>(assistant::trim(event_type_str));
+  auto event_type = magic_enum::enum_cast<Event>(event_type_str);
   if (!event_type.has_value()) {
     std::stringstream ss;
     ss << "Invalid event type: " << event_type_str;
     throw std::runtime_error(ss.str());
   }
 
-  // Make sure the data_line is a complete json.
-  data_str = assistant::after_first(data_str, ":");
-  data_str = assistant::trim(data_str);
+  std::string_view data_str = assistant::trim(sse_event->data);
+  if (event_type.value() == Event::content_block_delta) {
+    // The bulk of the stream: decode it without building a DOM.
+    auto content = m_delta_decoder.DecodeContent(data_str);
+    if (content.has_value()) {
+      return EventMessage{.event = Event::content_block_delta,
+                          .delta_content = std::move(content)};
+    }
+  }
 
-  auto result = assistant::try_read_jsons_from_string(data_str);
-  if (result.first.empty()) {
+  // Parse the data once, every accessor below reads this DOM.
+  auto data = json::parse(data_str, nullptr, false);
+  if (data.is_discarded()) {
     return std::nullopt;
   }
 
-  EventMessage em{.event = event_type.value(), .data = data_str};
+  EventMessage em{.event = event_type.value(), .data = std::move(data)};
   return em;
 }
 
 std::string ResponseParser::GetContentBlockDeltaContent(
-    const EventMessage& event_message) {
+    EventMessage& event_message) {
+  if (event_message.delta_content.has_value()) {
+    return std::move(event_message.delta_content.value());
+  }
+
   // data:
   // {"type":"content_block_delta","index":1,"delta":{"type":"input_json_delta","partial_json":""}}
   // data:
@@ -328,8 +339,8 @@ std::string ResponseParser::GetContentBlockDeltaContent(
   // data: {"type": "content_block_delta", "index": 0, "delta": {"type":
   // "signature_delta", "signature":
   // "EqQBCgIYAhIM1gbcDa9GJwZA2b3hGgxBdjrkzLoky3dl1pkiMOYds..."}}
-  auto j = json::parse(event_message.data);
-  std::string type = j["delta"]["type"].get<std::string>();
+  const auto& delta = event_message.data.at("delta");
+  const auto& type = delta.at("type").get_ref<const std::string&>();
   auto res = magic_enum::enum_cast<DeltaType>(type);
   if (!res.has_value()) {
     std::stringstream ss;
@@ -339,18 +350,20 @@ std::string ResponseParser::GetContentBlockDeltaContent(
 
   switch (res.value()) {
     case DeltaType::text_delta:
-      return j["delta"]["text"].get<std::string>();
+      return delta.at("text").get<std::string>();
     case DeltaType::input_json_delta:
-      return j["delta"]["partial_json"].get<std::string>();
+      return delta.at("partial_json").get<std::string>();
     case DeltaType::thinking_delta:
-      return j["delta"]["thinking"].get<std::string>();
-    case DeltaType::compaction_delta:
+      return delta.at("thinking").get<std::string>();
+    case DeltaType::compaction_delta: {
       // Compaction deltas carry the full summary in `delta.content`, which
       // may legitimately be null/missing for a no-op repeat.
-      if (j["delta"].contains("content") && j["delta"]["content"].is_string()) {
-        return j["delta"]["content"].get<std::string>();
+      auto content = delta.find("content");
+      if (content != delta.end() && content->is_string()) {
+        return content->get<std::string>();
       }
       return "";
+    }
     case DeltaType::signature_delta:
       // we don't care (for now) about the signature.
       return "";
@@ -358,29 +371,26 @@ std::string ResponseParser::GetContentBlockDeltaContent(
   return "";
 }
 
-std::optional<StopReason> ResponseParser::GetStopReason(
-    const EventMessage& event_message) {
-  auto j = json::parse(event_message.data);
-  try {
-    if (j["delta"]["stop_reason"].is_null()) {
-      return std::nullopt;
-    }
-    std::string stop_reason = j["delta"]["stop_reason"].get<std::string>();
-    return magic_enum::enum_cast<StopReason>(stop_reason);
-  } catch (...) {
+std::optional<StopReason> ResponseParser::GetStopReason(const json& data) {
+  auto delta = data.find("delta");
+  if (delta == data.end() || !delta->is_object()) {
+    return std::nullopt;
+  }
+  auto stop_reason = delta->find("stop_reason");
+  if (stop_reason == delta->end() || !stop_reason->is_string()) {
     return std::nullopt;
   }
+  return magic_enum::enum_cast<StopReason>(
+      stop_reason->get_ref<const std::string&>());
 }
 
-std::optional<Usage> ResponseParser::GetUsage(
-    const EventMessage& event_message) {
-  auto j = json::parse(event_message.data);
+std::optional<Usage> ResponseParser::GetUsage(const json& data) {
+  auto usage = data.find("usage");
+  if (usage == data.end() || !usage->is_object()) {
+    return std::nullopt;
+  }
   try {
-    if (!j.contains("usage") || !j["usage"].is_object()) {
-      return std::nullopt;
-    }
-    return Usage::FromClaudeJson(j["usage"]);
-
+    return Usage::FromClaudeJson(*usage);
   } catch (...) {
     return std::nullopt;
   }
@@ -388,14 +398,21 @@ std::optional<Usage> ResponseParser::GetUsage(
 
 std::optional<std::string> ResponseParser::GetErrorMessage(
     const std::string& event_message) {
+  auto data = json::parse(event_message, nullptr, false);
+  if (data.is_discarded()) {
+    return std::nullopt;
+  }
+  return GetErrorMessage(data);
+}
+
+std::optional<std::string> ResponseParser::GetErrorMessage(const json& data) {
   // data example incase of an error:
   // {"type":"error","error":{"details":null,"type":"overloaded_error","message":"Overloaded"},"request_id":"req_011CXnsFdbuV3b51g7bRNngu"
   // }
-  auto j = json::parse(event_message);
   try {
-    std::string error_str = j["error"]["type"].get<std::string>();
-    auto ec = magic_enum::enum_cast<ErrorCode>(
-        std::string_view{error_str.c_str(), error_str.length()});
+    const auto& error_str =
+        data.at("error").at("type").get_ref<const std::string&>();
+    auto ec = magic_enum::enum_cast<ErrorCode>(error_str);
     return std::string{
         ErrorCodeToString(ec.value_or(ErrorCode::general_error))};
   } catch (...) {
@@ -403,23 +420,21 @@ std::optional<std::string> ResponseParser::GetErrorMessage(
   }
 }
 
-std::string ResponseParser::GetToolName(const EventMessage& event_message) {
-  auto j = json::parse(event_message.data);
-  return j["content_block"]["name"].get<std::string>();
+std::string ResponseParser::GetToolName(const json& data) {
+  return data.at("content_block").at("name").get<std::string>();
 }
 
-std::string ResponseParser::GetToolId(const EventMessage& event_message) {
-  auto j = json::parse(event_message.data);
-  return j["content_block"]["id"].get<std::string>();
+std::string ResponseParser::GetToolId(const json& data) {
+  return data.at("content_block").at("id").get<std::string>();
 }
 
-ContentType ResponseParser::GetContentBlock(const EventMessage& event_message) {
+ContentType ResponseParser::GetContentBlock(const json& data) {
   // Check the type of the content
   // data:
   // {"type":"content_block_start","index":0,"content_block":{"type":"text","text":""}}
-  auto j = json::parse(event_message.data);
   // might throw here
-  std::string type = j["content_block"]["type"].get<std::string>();
+  const auto& type =
+      data.at("content_block").at("type").get_ref<const std::string&>();
   auto res = magic_enum::enum_cast<ContentType>(type);
   if (!res.has_value()) {
     std::stringstream ss;
@@ -429,11 +444,6 @@ ContentType ResponseParser::GetContentBlock(const EventMessage& event_message) {
   return res.value();
 }
 
-void ResponseParser::AppendText(
-    const std::string& text) {  // Split the message into lines.
-  m_content.append(text);
-}
-
 std::optional<json> ResponseParser::TryJson(std::string_view text) {
   try {
     auto _json = json::parse(trim(text));
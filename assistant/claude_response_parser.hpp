@@ -5,6 +5,7 @@
 
 #include "assistant/client/client_base.hpp"
 #include "assistant/common/json.hpp"
+#include "assistant/helpers.hpp"
 
 namespace assistant::claude {
 
@@ -125,7 +126,11 @@ inline std::string_view ErrorCodeToString(ErrorCode ec) {
 
 struct EventMessage {
   Event event;
-  std::string data;
+  /// The "data:" payload, parsed once when the event is framed. Null if the
+  /// event was decoded into `delta_content` instead.
+  json data;
+  /// The content of a `content_block_delta`, decoded without a DOM.
+  std::optional<std::string> delta_content{std::nullopt};
 };
 
 struct ToolCall {
@@ -224,6 +229,26 @@ inline std::ostream& operator<<(std::ostream& os, const ParseResult& res) {
   return os;
 }
 
+/// Decodes the common `content_block_delta` shapes without building a DOM:
+/// {"type":"content_block_delta","index":0,"delta":{"type":"text_delta","text":"Hi"}}
+/// An unknown member under "delta" rejects the event.
+class ContentBlockDeltaDecoder : public JsonPathSax {
+ public:
+  /// Returns the delta content, or nullopt if `data` has another shape.
+  std::optional<std::string> DecodeContent(std::string_view data);
+
+ protected:
+  bool OnString(std::string& value) override;
+  bool OnKey() override;
+
+ private:
+  inline bool InDelta() const { return Depth() == 2 && PathAt(0) == "delta"; }
+
+  std::optional<DeltaType> m_type;
+  std::string m_content;
+  bool m_has_content{false};
+};
+
 /// A state-ful claude response parser.
 class ResponseParser {
  public:
@@ -231,36 +256,37 @@ class ResponseParser {
   ~ResponseParser() = default;
   void Parse(const std::string& text, std::function<void(ParseResult)> cb);
   inline void Reset() {
-    m_content.clear();
+    m_framer.Reset();
     m_state = ParserState::initial;
     m_tool_call.Reset();
   }
 
   static std::optional<std::string> GetErrorMessage(
       const std::string& event_message);
+  static std::optional<std::string> GetErrorMessage(const json& data);
 
  private:
-  void AppendText(const std::string& text);
   std::optional<json> TryJson(std::string_view text);
 
   /// This function might throw.
   std::optional<EventMessage> NextMessage();
 
-  std::optional<std::string> PopLine();
-  void PushLineFront(const std::string& line);
-
   /// This function might throw.
-  ContentType GetContentBlock(const EventMessage& event_message);
+  ContentType GetContentBlock(const json& data);
   /// This function might throw.
-  std::string GetToolName(const EventMessage& event_message);
+  std::string GetToolName(const json& data);
   /// This function might throw.
-  std::string GetToolId(const EventMessage& event_message);
-  std::optional<StopReason> GetStopReason(const EventMessage& event_message);
-  std::optional<Usage> GetUsage(const EventMessage& event_message);
+  std::string GetToolId(const json& data);
+  std::optional<StopReason> GetStopReason(const json& data);
+  std::optional<Usage> GetUsage(const json& data);
 
+  /// Moves out the decoded `delta_content`, or reads it from the DOM.
   /// This function might throw.
-  std::string GetContentBlockDeltaContent(const EventMessage& event_message);
-  std::string m_content;
+  std::string GetContentBlockDeltaContent(EventMessage& event_message);
+  /// Anthropic always separates the events with a blank line, but lenient
+  /// framing also accepts "event:"/"data:" pairs without it.
+  SseFramer m_framer{SseFraming::kLenient};
+  ContentBlockDeltaDecoder m_delta_decoder;
   ParserState m_state{ParserState::initial};
   ToolCall m_tool_call;
 };
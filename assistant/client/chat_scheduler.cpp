@@ -0,0 +1,188 @@
+#include "assistant/client/chat_scheduler.hpp"
+
+#include <algorithm>
+#include <iterator>
+
+#include "assistant/logger.hpp"
+
+namespace assistant {
+
+ChatScheduler::ChatScheduler(std::shared_ptr<ClientBase> client,
+                             size_t max_in_flight)
+    : m_client{std::move(client)} {
+  max_in_flight = std::max<size_t>(max_in_flight, 1);
+  m_workers.reserve(max_in_flight);
+  for (size_t i = 0; i < max_in_flight; ++i) {
+    m_workers.emplace_back([this]() { WorkerMain(); });
+  }
+}
+
+ChatScheduler::~ChatScheduler() {
+  std::deque<Turn> cancelled;
+  std::vector<std::shared_ptr<ChatSession>> running;
+  {
+    std::scoped_lock lk{m_mutex};
+    m_shutdown = true;
+    for (auto& [_, session_turns] : m_sessions) {
+      auto turns = TakePendingTurns(session_turns);
+      std::move(turns.begin(), turns.end(), std::back_inserter(cancelled));
+      if (session_turns.running) {
+        running.push_back(session_turns.session);
+      }
+    }
+    m_ready.clear();
+  }
+  m_cv.notify_all();
+  CancelTurns(std::move(cancelled));
+  for (const auto& session : running) {
+    session->Interrupt();
+  }
+  for (auto& worker : m_workers) {
+    worker.join();
+  }
+}
+
+std::future<void> ChatScheduler::Submit(std::shared_ptr<ChatSession> session,
+                                        std::string msg, ResponseCallback cb,
+                                        ChatOptions chat_options) {
+  Turn turn{.msg = std::move(msg),
+            .cb = std::move(cb),
+            .chat_options = chat_options,
+            .done = {}};
+  auto future = turn.done.get_future();
+  {
+    std::unique_lock lk{m_mutex};
+    if (m_shutdown) {
+      lk.unlock();
+      std::deque<Turn> cancelled;
+      cancelled.push_back(std::move(turn));
+      CancelTurns(std::move(cancelled));
+      return future;
+    }
+    auto& session_turns = m_sessions[session.get()];
+    if (session_turns.session == nullptr) {
+      session_turns.session = session;
+    }
+    session_turns.turns.push_back(std::move(turn));
+    // A running session is re-queued by its worker once its turn is done.
+    if (!session_turns.running && session_turns.turns.size() == 1) {
+      m_ready.push_back(session.get());
+    }
+  }
+  m_cv.notify_one();
+  return future;
+}
+
+void ChatScheduler::Cancel(const std::shared_ptr<ChatSession>& session) {
+  std::deque<Turn> cancelled;
+  bool running{false};
+  {
+    std::scoped_lock lk{m_mutex};
+    auto iter = m_sessions.find(session.get());
+    if (iter == m_sessions.end()) {
+      return;
+    }
+    cancelled = TakePendingTurns(iter->second);
+    running = iter->second.running;
+    if (running) {
+      // Interrupt the session while holding the lock, so the interrupt flag
+      // can not leak into the next turn of this session (it is reset when a
+      // worker picks the turn, under the same lock).
+      session->Interrupt();
+    } else {
+      m_sessions.erase(iter);
+    }
+  }
+  OLOG(LogLevel::kInfo) << "Cancelled " << cancelled.size()
+                        << " pending turn(s) of session: "
+                        << session->GetId();
+  CancelTurns(std::move(cancelled));
+}
+
+size_t ChatScheduler::GetInFlight() const {
+  std::scoped_lock lk{m_mutex};
+  return m_in_flight;
+}
+
+size_t ChatScheduler::GetPending() const {
+  std::scoped_lock lk{m_mutex};
+  size_t count{0};
+  for (const auto& [_, session_turns] : m_sessions) {
+    count += session_turns.turns.size();
+  }
+  return count;
+}
+
+std::deque<ChatScheduler::Turn> ChatScheduler::TakePendingTurns(
+    SessionTurns& session_turns) {
+  std::deque<Turn> turns = std::move(session_turns.turns);
+  session_turns.turns.clear();
+  auto iter = std::find(m_ready.begin(), m_ready.end(),
+                        session_turns.session.get());
+  if (iter != m_ready.end()) {
+    m_ready.erase(iter);
+  }
+  return turns;
+}
+
+void ChatScheduler::CancelTurns(std::deque<Turn> turns) {
+  for (auto& turn : turns) {
+    if (turn.cb) {
+      turn.cb("Request cancelled by user", Reason::kCancelled, false);
+    }
+    turn.done.set_value();
+  }
+}
+
+void ChatScheduler::WorkerMain() {
+  while (true) {
+    std::shared_ptr<ChatSession> session;
+    Turn turn;
+    {
+      std::unique_lock lk{m_mutex};
+      m_cv.wait(lk, [this]() { return m_shutdown || !m_ready.empty(); });
+      if (m_shutdown) {
+        return;
+      }
+      auto& session_turns = m_sessions[m_ready.front()];
+      m_ready.pop_front();
+      session_turns.running = true;
+      session = session_turns.session;
+      turn = std::move(session_turns.turns.front());
+      session_turns.turns.pop_front();
+      session->ResetInterrupt();
+      ++m_in_flight;
+    }
+
+    try {
+      m_client->ChatInSession(session, std::move(turn.msg), std::move(turn.cb),
+                              turn.chat_options);
+    } catch (const std::exception& e) {
+      OLOG(LogLevel::kError)
+          << "Chat turn of session '" << session->GetId()
+          << "' failed. " << e.what();
+    }
+
+    bool notify{false};
+    {
+      std::scoped_lock lk{m_mutex};
+      --m_in_flight;
+      auto iter = m_sessions.find(session.get());
+      if (iter != m_sessions.end()) {
+        iter->second.running = false;
+        if (iter->second.turns.empty()) {
+          m_sessions.erase(iter);
+        } else if (!m_shutdown) {
+          m_ready.push_back(session.get());
+          notify = true;
+        }
+      }
+    }
+    if (notify) {
+      m_cv.notify_one();
+    }
+    turn.done.set_value();
+  }
+}
+
+}  // namespace assistant
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "assistant/attributes.hpp"
+#include "assistant/client/client_base.hpp"
+
+namespace assistant {
+
+/**
+ * @brief Runs the chat turns of many sessions on a single client.
+ *
+ * All the sessions share the client's function table, endpoint and transport
+ * pool. Turns are submitted per session and run on a pool of worker threads:
+ * turns of different sessions run concurrently (up to the in-flight limit),
+ * turns of the same session run in submission order, one at a time. Sessions
+ * are served in the order they became ready, so a busy session does not
+ * starve the others.
+ */
+class ChatScheduler {
+ public:
+  /// `max_in_flight` is the maximum number of turns running at the same time.
+  ChatScheduler(std::shared_ptr<ClientBase> client, size_t max_in_flight);
+  /// Cancels the pending turns and waits for the running ones.
+  ~ChatScheduler();
+
+  ChatScheduler(const ChatScheduler&) = delete;
+  ChatScheduler& operator=(const ChatScheduler&) = delete;
+
+  /// Create a new session, with an empty history.
+  std::shared_ptr<ChatSession> CreateSession(std::string id = {}) const {
+    return std::make_shared<ChatSession>(std::move(id));
+  }
+
+  /// Queue a turn of `session`. `cb` is called from a worker thread. The
+  /// returned future is ready once the turn completed or was cancelled.
+  std::future<void> Submit(std::shared_ptr<ChatSession> session,
+                           std::string msg, ResponseCallback cb,
+                           ChatOptions chat_options = ChatOptions::kDefault)
+      FUNCTION_LOCKS(m_mutex);
+
+  /// Cancel the running turn of `session` and drop its pending turns (their
+  /// callback is called with `Reason::kCancelled`). Turns submitted after
+  /// this call run normally.
+  void Cancel(const std::shared_ptr<ChatSession>& session)
+      FUNCTION_LOCKS(m_mutex);
+
+  /// Return the number of turns running right now.
+  size_t GetInFlight() const FUNCTION_LOCKS(m_mutex);
+
+  /// Return the number of turns waiting for a worker.
+  size_t GetPending() const FUNCTION_LOCKS(m_mutex);
+
+  inline size_t GetMaxInFlight() const { return m_workers.size(); }
+
+ private:
+  struct Turn {
+    std::string msg;
+    ResponseCallback cb;
+    ChatOptions chat_options;
+    std::promise<void> done;
+  };
+
+  struct SessionTurns {
+    std::shared_ptr<ChatSession> session;
+    std::deque<Turn> turns;
+    bool running{false};
+  };
+
+  void WorkerMain() FUNCTION_LOCKS(m_mutex);
+  /// Drop the pending turns of `turns`, and return them.
+  std::deque<Turn> TakePendingTurns(SessionTurns& turns)
+      CALLER_MUST_LOCK(m_mutex);
+  static void CancelTurns(std::deque<Turn> turns);
+
+  std::shared_ptr<ClientBase> m_client;
+  mutable std::mutex m_mutex;
+  std::condition_variable m_cv;
+  std::unordered_map<ChatSession*, SessionTurns> m_sessions GUARDED_BY(m_mutex);
+  /// Sessions with pending turns and no running turn, in FIFO order.
+  std::deque<ChatSession*> m_ready GUARDED_BY(m_mutex);
+  size_t m_in_flight GUARDED_BY(m_mutex){0};
+  bool m_shutdown GUARDED_BY(m_mutex){false};
+  std::vector<std::thread> m_workers;
+};
+
+}  // namespace assistant
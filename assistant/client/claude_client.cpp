@@ -39,15 +39,15 @@ json BuildCompactionEdit(const ServerCompaction& sc) {
 }  // namespace
 
 ClaudeClient::ClaudeClient(const Endpoint& endpoint)
-    : OllamaClient(endpoint),
-      m_responseParser(std::make_shared<claude::ResponseParser>()) {
+    : OllamaClient(endpoint) {
   m_multi_tool_reply_as_array = true;
 }
 
 std::unordered_map<std::string, std::string> ClaudeClient::GetHttpHeaders()
     const {
-  auto headers = m_endpoint.get_value().headers_;
-  if (m_endpoint.get_value().server_compaction_.enabled) {
+  auto endpoint = m_endpoint.load();
+  auto headers = endpoint->headers_;
+  if (endpoint->server_compaction_.enabled) {
     // anthropic-beta is comma-separated; preserve any value the operator
     // configured by appending rather than overwriting.
     auto it = headers.find("anthropic-beta");
@@ -83,15 +83,15 @@ std::optional<ModelCapabilities> ClaudeClient::GetModelCapabilities(
 }
 
 void ClaudeClient::CreateAndPushChatRequest(
-    std::optional<assistant::message> msg, OnResponseCallback cb,
+    std::optional<assistant::message> msg, ResponseCallback cb,
     std::string model, ChatOptions chat_options,
     std::shared_ptr<ChatRequestFinaliser> finaliser) {
   assistant::options opts;
 
-  assistant::messages history;
+  MessagesSnapshot history;
   if (IsFlagSet(chat_options, ChatOptions::kNoHistory)) {
     if (msg.has_value()) {
-      history = {msg.value()};
+      history.push_back(std::move(msg.value()));
     }
   } else {
     AddMessage(msg, MessageType::kNormal);
@@ -107,22 +107,23 @@ void ClaudeClient::CreateAndPushChatRequest(
     OLOG(LogLevel::kInfo) << "The 'tools' are disabled for the model: '"
                           << model << "' (per user request).";
   } else if (!m_function_table.IsEmpty()) {
-    req["tools"] =
-        m_function_table.ToJSON(EndpointKind::anthropic, GetCachingPolicy());
+    m_function_table.AddToolsToRequest(req, EndpointKind::anthropic,
+                                       GetCachingPolicy());
   }
 
   // System message: unlike Ollama, Claude accepts a single top level
   // "system" property in the request.
   std::vector<json> system_messages;
   m_system_messages.with(
-      [&system_messages, this](const assistant::messages& sys_messages) {
+      [&system_messages, this](const MessagesSnapshot& sys_messages) {
         if (sys_messages.empty()) {
           return;
         }
         for (const auto& msg : sys_messages) {
-          if (msg.contains("content") && msg["content"].is_string()) {
-            system_messages.push_back(json{
-                {"type", "text"}, {"text", msg["content"].get<std::string>()}});
+          if (msg->contains("content") && (*msg)["content"].is_string()) {
+            system_messages.push_back(
+                json{{"type", "text"},
+                     {"text", (*msg)["content"].get<std::string>()}});
           }
         }
 
@@ -148,7 +149,8 @@ void ClaudeClient::CreateAndPushChatRequest(
   // is added by GetHttpHeaders() when the underlying transport is
   // constructed in OllamaClient::CreateClient().
   {
-    const auto& sc = m_endpoint.get_value().server_compaction_;
+    auto endpoint = m_endpoint.load();
+    const auto& sc = endpoint->server_compaction_;
     if (sc.enabled) {
       req["context_management"] = BuildCompactionEdit(sc);
     }
@@ -156,34 +158,34 @@ void ClaudeClient::CreateAndPushChatRequest(
 
   req["model"] = model;
   req["stream"] = m_stream.load();
-  req["messages"] = history.to_json();
   req["max_tokens"] = GetMaxTokens();
 
   ChatRequest ctx = {
       .callback_ = cb,
-      .request_ = req,
+      .request_ = std::move(req),
       .model_ = std::move(model),
       .finaliser_ = finaliser,
+      .func_calls_ = {},
+      .messages_ = std::move(history),
   };
-  m_queue.push_back(std::make_shared<ChatRequest>(ctx));
+  CurrentQueue().push_back(std::make_shared<ChatRequest>(std::move(ctx)));
 }
 
 void ClaudeClient::ProcessChatRequest(
     std::shared_ptr<ChatRequest> chat_request) {
   try {
-    m_responseParser->Reset();
+    chat_request->AttachMessages();
     std::string model_name = chat_request->request_["model"].get<std::string>();
 
     // Prepare chat user data.
-    ChatContext user_data{
-        .client = this,
-        .model = model_name,
-        .model_can_think = true,
-        .chat_context = chat_request,
-    };
+    ClaudeChatContext user_data;
+    user_data.client = this;
+    user_data.model = model_name;
+    user_data.model_can_think = true;
+    user_data.chat_context = chat_request;
 
     {
-      auto client = CreateClient();
+      auto client = AcquireClient();
       SetInterruptClientLocker locker{this, client.get()};
       client->chat_raw_output(chat_request->request_,
                               &ClaudeClient::OnRawResponse,
@@ -194,8 +196,7 @@ void ClaudeClient::ProcessChatRequest(
       InvokeTools(chat_request);
     }
   } catch (std::exception& e) {
-    chat_request->callback_(e.what(), Reason::kFatalError, false);
-    Shutdown();
+    FailTurn(*chat_request, e.what());
   }
 }
 
@@ -204,17 +205,18 @@ void ClaudeClient::ProcessChatRequestQueue() {
 }
 
 bool ClaudeClient::OnRawResponse(const std::string& resp, void* user_data) {
-  ChatContext* chat_context = reinterpret_cast<ChatContext*>(user_data);
+  ClaudeChatContext* chat_context =
+      reinterpret_cast<ClaudeChatContext*>(user_data);
   ClaudeClient* client = dynamic_cast<ClaudeClient*>(chat_context->client);
   return client->HandleResponse(resp, chat_context);
 }
 
 bool ClaudeClient::HandleResponse(const std::string& resp,
-                                  ChatContext* chat_context) {
+                                  ClaudeChatContext* chat_context) {
   std::shared_ptr<ChatRequest> req = chat_context->chat_context;
   try {
     std::vector<claude::ParseResult> tokens;
-    m_responseParser->Parse(resp, [&tokens](claude::ParseResult token) {
+    chat_context->parser.Parse(resp, [&tokens](claude::ParseResult token) {
       tokens.push_back(std::move(token));
     });
 
@@ -340,7 +342,7 @@ bool ClaudeClient::HandleResponse(const std::string& resp,
     OLOG(LogLevel::kWarning)
         << claude::ResponseParser::GetErrorMessage(resp).value_or("");
     req->callback_(e.what(), Reason::kFatalError, false);
-    m_responseParser->Reset();
+    chat_context->parser.Reset();
     return false;  // close the current session.
   }
 }
@@ -361,7 +363,7 @@ void ClaudeClient::AddToolsResult(
 
     auto p = BuildToolResponseContent(fcall, reply);
     if (!p.second.empty()) {
-      m_pendingMessages.push_back(p.second);
+      CurrentPendingMessages().push_back(p.second);
     }
 
     res["content"] = p.first;
@@ -374,14 +376,15 @@ void ClaudeClient::AddToolsResult(
 }
 
 size_t ClaudeClient::Compact(size_t responses_to_keep) {
-  return m_history.Compact(
+  return CurrentHistory().Compact(
       [this](assistant::message& msg) {
         size_t tokens_trimmed{0};
         if (msg.contains("content") && msg["content"].is_array()) {
           auto& j_array = msg["content"];
           for (auto& element : j_array) {
             if (element.contains("content") && element["content"].is_string()) {
-              size_t count = CountTokens(element["content"].get<std::string>());
+              size_t count = CountTokens(
+                  element["content"].get_ref<const std::string&>());
               if (count > kTrimMessageTokensCount) {
                 element["content"] = kTrimMessage;
                 tokens_trimmed += (count - kTrimMessageTokensCount);
@@ -394,8 +397,8 @@ size_t ClaudeClient::Compact(size_t responses_to_keep) {
       responses_to_keep);
 }
 
-assistant::messages ClaudeClient::GetMessages() const {
-  return m_history.GetMessages();
+MessagesSnapshot ClaudeClient::GetMessages() const {
+  return CurrentHistory().GetSnapshot();
 }
 
 }  // namespace assistant
@@ -4,6 +4,12 @@
 #include "assistant/client/ollama_client.hpp"
 
 namespace assistant {
+/// The state of a Claude response stream. Each turn has its own, so the turns
+/// of different sessions can be streamed concurrently.
+struct ClaudeChatContext : public ChatContext {
+  claude::ResponseParser parser;
+};
+
 class ClaudeClient : public OllamaClient {
  public:
   ClaudeClient(const Endpoint& endpoint = AnthropicEndpoint{});
@@ -24,7 +30,7 @@ class ClaudeClient : public OllamaClient {
   std::unordered_map<std::string, std::string> GetHttpHeaders() const override;
 
   void CreateAndPushChatRequest(
-      std::optional<assistant::message> msg, OnResponseCallback cb,
+      std::optional<assistant::message> msg, ResponseCallback cb,
       std::string model, ChatOptions chat_options,
       std::shared_ptr<ChatRequestFinaliser> finaliser) override;
 
@@ -38,10 +44,10 @@ class ClaudeClient : public OllamaClient {
 
   // Claude does not support system messages as normal messages with a role of
   // "system"
-  assistant::messages GetMessages() const override;
+  MessagesSnapshot GetMessages() const override;
 
   static bool OnRawResponse(const std::string& resp, void* user_data);
-  bool HandleResponse(const std::string& resp, ChatContext* chat_context);
-  std::shared_ptr<claude::ResponseParser> m_responseParser{nullptr};
+  bool HandleResponse(const std::string& resp,
+                      ClaudeChatContext* chat_context);
 };
 }  // namespace assistant
@@ -1,14 +1,83 @@
 #include "assistant/client/client_base.hpp"
 
 #include "assistant/logger.hpp"
+#include "assistant/parallel.hpp"
 #include "assistant/tool.hpp"
 
 namespace assistant {
 
+namespace {
+/// The session of the turn running on the calling thread.
+struct ActiveSession {
+  const ClientBase* client{nullptr};
+  std::shared_ptr<ChatSession> session{nullptr};
+};
+thread_local ActiveSession t_active_session;
+}  // namespace
+
+std::shared_ptr<ChatSession> ClientBase::CurrentSessionPtr() const {
+  if (t_active_session.client == this) {
+    return t_active_session.session;
+  }
+  return m_default_session;
+}
+
+void ClientBase::ChatInSession(std::shared_ptr<ChatSession> session,
+                               std::string msg, ResponseCallback cb,
+                               ChatOptions chat_options) {
+  m_running_sessions.with_mut(
+      [&session](std::vector<std::shared_ptr<ChatSession>>& sessions) {
+        sessions.push_back(session);
+      });
+  ActiveSession previous =
+      std::exchange(t_active_session, ActiveSession{this, session});
+  ChatRequestFinaliser restore{[this, &previous, &session]() {
+    t_active_session = std::move(previous);
+    m_running_sessions.with_mut(
+        [&session](std::vector<std::shared_ptr<ChatSession>>& sessions) {
+          auto iter = std::find(sessions.begin(), sessions.end(), session);
+          if (iter != sessions.end()) {
+            sessions.erase(iter);
+          }
+        });
+  }};
+  Chat(std::move(msg), std::move(cb), chat_options);
+}
+
+void ClientBase::Interrupt() {
+  m_interrupt.store(true);
+  m_default_session->InterruptTransport();
+  m_running_sessions.with(
+      [](const std::vector<std::shared_ptr<ChatSession>>& sessions) {
+        for (const auto& session : sessions) {
+          session->InterruptTransport();
+        }
+      });
+}
+
+void ClientBase::FailTurn(const ChatRequest& request, std::string_view error) {
+  OLOG(LogLevel::kError) << "Chat request failed. " << error;
+  auto& session = CurrentSession();
+  session.m_failed.store(true);
+  session.m_queue.clear();
+  request.callback_(error, Reason::kFatalError, false);
+}
+
+bool ClientBase::HasRequestInFlight() const {
+  bool busy = m_default_session->IsBusy();
+  m_running_sessions.with(
+      [&busy](const std::vector<std::shared_ptr<ChatSession>>& sessions) {
+        for (const auto& session : sessions) {
+          busy = busy || session->IsBusy();
+        }
+      });
+  return busy;
+}
+
 bool ClientBase::HandleResponse(const assistant::response& resp,
                                 ChatContext& chat_user_data) {
   std::shared_ptr<ChatRequest> req = chat_user_data.chat_context;
-  if (m_interrupt.load()) {
+  if (IsInterrupted()) {
     req->callback_("Request cancelled by user", assistant::Reason::kCancelled,
                    false);
     return false;
@@ -24,7 +93,7 @@ bool ClientBase::HandleResponse(const assistant::response& resp,
           {ai_message_opt.value(), std::move(calls.value())});
     }
   } else {
-    auto content = ResponseParser::GetContent(resp);
+    auto content = ResponseParser::GetContentView(resp);
     auto reason = (is_done && req->func_calls_.empty())
                       ? Reason::kDone
                       : Reason::kPartialResult;
@@ -50,7 +119,8 @@ bool ClientBase::HandleResponse(const assistant::response& resp,
       cb_result = req->callback_(content.value(), reason,
                                  token_is_part_of_thinking_process);
     } else if (is_done) {
-      cb_result = req->callback_({}, reason, token_is_part_of_thinking_process);
+      cb_result = req->callback_(std::string_view{}, reason,
+                                 token_is_part_of_thinking_process);
     }
 
     if (content.has_value()) {
@@ -92,22 +162,13 @@ bool ClientBase::OnResponse(const assistant::response& resp, void* user_data) {
 
 void ClientBase::AddMessage(std::optional<assistant::message> msg,
                             MessageType mt) {
-  m_history.AddMessage(msg, mt);
+  CurrentHistory().AddMessage(msg, mt);
 }
 
-assistant::messages ClientBase::GetMessages() const {
-  assistant::messages msgs;
-  // First place the system messages
-  m_system_messages.with([&msgs](const assistant::messages& sys_msgs) {
-    if (sys_msgs.empty()) {
-      return;
-    }
-    msgs.insert(msgs.end(), sys_msgs.begin(), sys_msgs.end());
-  });
-
-  // Following by the user messages
-  auto user_messages = m_history.GetMessages();
-  msgs.insert(msgs.end(), user_messages.begin(), user_messages.end());
+MessagesSnapshot ClientBase::GetMessages() const {
+  // First place the system messages, followed by the user messages
+  MessagesSnapshot msgs = m_system_messages.get_value();
+  msgs.append(CurrentHistory().GetSnapshot());
   return msgs;
 }
 
@@ -127,7 +188,11 @@ void ClientBase::ApplyConfig(const assistant::Config* conf) {
   m_server_timeout.set_value(conf->GetServerTimeoutSettings());
   m_keep_alive.set_value(conf->GetKeepAlive());
   m_auto_compact_threshold = conf->GetEndpoint()->auto_compact_threshold_;
+  m_client_compact_threshold = endpoint->client_compact_threshold_;
   m_stream = conf->IsStream();
+  SetMaxParallelToolCalls(conf->GetMaxParallelToolCalls());
+  m_model_capabilities.SetTTL(conf->GetModelCacheSettings().ttl_);
+  m_model_capabilities.SetFile(conf->GetModelCacheSettings().file_);
 }
 
 void ClientBase::InvokeTools(std::shared_ptr<ChatRequest> request) {
@@ -135,16 +200,42 @@ void ClientBase::InvokeTools(std::shared_ptr<ChatRequest> request) {
     return;
   }
 
-  std::vector<std::pair<FunctionCall, FunctionResult>> tool_call_results;
-  for (auto [msg, calls] : request->func_calls_) {
-    if (m_interrupt.load()) {
-      return;
+  auto results = RunToolCalls(request);
+  if (!results.has_value()) {
+    return;
+  }
+
+  ToolCallResults tool_call_results;
+  for (size_t i = 0; i < request->func_calls_.size(); ++i) {
+    AddMessage(request->func_calls_[i].first, MessageType::kToolRequest);
+    for (auto& call_result : results.value()[i]) {
+      tool_call_results.push_back(std::move(call_result));
     }
-    AddMessage(std::move(msg), MessageType::kToolRequest);
-    for (auto func_call : calls) {
+  }
+
+  if (!tool_call_results.empty()) {
+    AddToolsResult(std::move(tool_call_results));
+  }
+
+  CreateAndPushChatRequest(std::nullopt, request->callback_, request->model_,
+                           ChatOptions::kDefault, request->finaliser_);
+}
+
+std::optional<std::vector<ClientBase::ToolCallResults>>
+ClientBase::RunToolCalls(std::shared_ptr<ChatRequest> request) {
+  std::vector<ToolCallResults> results;
+  results.reserve(request->func_calls_.size());
+  // The calls that were granted permission to run.
+  std::vector<std::pair<FunctionCall, FunctionResult>*> permitted;
+
+  for (const auto& [_, calls] : request->func_calls_) {
+    auto& message_results = results.emplace_back();
+    // Reserve upfront: `permitted` points into this vector.
+    message_results.reserve(calls.size());
+    for (const auto& func_call : calls) {
       if (IsInterrupted()) {
         OLOG(LogLevel::kWarning) << "User interrupted.";
-        return;
+        return std::nullopt;
       }
       std::stringstream ss;
       ss << "Invoking tool: '" << func_call.name << "', args:\n";
@@ -153,9 +244,10 @@ void ClientBase::InvokeTools(std::shared_ptr<ChatRequest> request) {
         ss << std::setw(2) << "  " << name << " => " << value << "\n";
       }
 
-      request->callback_(ss.str(), Reason::kLogNotice, false);
+      request->callback_(ss.view(), Reason::kLogNotice, false);
 
-      FunctionResult result;
+      auto& call_result =
+          message_results.emplace_back(func_call, FunctionResult{});
 
       CanInvokeToolResult can_run_tool{.can_invoke = true};
       auto res = GetFunctionTable().CanRunTool(func_call.name, func_call.args);
@@ -168,50 +260,68 @@ void ClientBase::InvokeTools(std::shared_ptr<ChatRequest> request) {
       }
 
       if (!can_run_tool.IsAllowed()) {
-        result.isError = true;
-        result.text = can_run_tool.reason;
+        call_result.second.isError = true;
+        call_result.second.text = can_run_tool.reason;
         ss = {};
         ss << "Failed to run tool: '" << func_call.name << "'.";
-        request->callback_(ss.str(), Reason::kToolDenied, false);
+        request->callback_(ss.view(), Reason::kToolDenied, false);
 
       } else {
         ss = {};
         ss << "Permission to run tool: '" << func_call.name << "' is granted.";
-        request->callback_(ss.str(), Reason::kToolAllowed, false);
-        result = GetFunctionTable().Call(func_call);
+        request->callback_(ss.view(), Reason::kToolAllowed, false);
+        permitted.push_back(&call_result);
       }
-      ss = {};
-      ss << "Tool output: " << result;
-      request->callback_(ss.str(), Reason::kLogDebug, false);
-      tool_call_results.push_back({func_call, result});
     }
   }
 
-  if (!tool_call_results.empty()) {
-    AddToolsResult(std::move(tool_call_results));
+  // The calls are independent of each other: run them concurrently. Each
+  // worker only writes its own result slot, so the order is preserved.
+  // The workers do not run in the session of this thread: capture it.
+  auto session = CurrentSessionPtr();
+  ParallelFor(permitted.size(), GetMaxParallelToolCalls(),
+              [this, &session, &permitted](size_t i) {
+                if (m_interrupt.load() || session->IsInterrupted()) {
+                  return;
+                }
+                auto& [func_call, result] = *permitted[i];
+                result = GetFunctionTable().Call(func_call);
+              });
+
+  if (IsInterrupted()) {
+    OLOG(LogLevel::kWarning) << "User interrupted.";
+    return std::nullopt;
   }
 
-  CreateAndPushChatRequest(std::nullopt, request->callback_, request->model_,
-                           ChatOptions::kDefault, request->finaliser_);
+  for (const auto& message_results : results) {
+    for (const auto& [_, result] : message_results) {
+      std::stringstream ss;
+      ss << "Tool output: " << result;
+      request->callback_(ss.view(), Reason::kLogDebug, false);
+    }
+  }
+  return results;
 }
 
 bool ClientBase::ModelHasCapability(const std::string& model_name,
                                     ModelCapabilities c) {
-  bool found{false};
-  m_model_capabilities.with_mut([&found, &model_name, c, this](auto& map) {
-    if (map.count(model_name) == 0) {
-      // Load the model capabilities
-      auto capabilities = GetModelCapabilities(model_name);
-      if (capabilities.has_value()) {
-        map.insert({model_name, capabilities.value()});
-      } else {
-        map.insert({model_name, ModelCapabilities::kNone});
-      }
+  auto flags = m_model_capabilities.Get(
+      GetUrl(), model_name,
+      [this](const std::string& model) { return GetModelCapabilities(model); });
+  return IsFlagSet(flags, c);
+}
+
+void ClientBase::WarmUpModelCapabilities(
+    ModelCapabilitiesCache::Fetcher fetch) {
+  auto endpoint = m_endpoint.load();
+  std::vector<std::string> models{endpoint->model_};
+  for (const auto& model : endpoint->models_) {
+    if (model != endpoint->model_) {
+      models.push_back(model);
     }
-    auto flags = map.find(model_name)->second;
-    found = IsFlagSet(flags, c);
-  });
-  return found;
+  }
+  m_model_capabilities.WarmUp(endpoint->url_, std::move(models),
+                              std::move(fetch));
 }
 
 std::optional<TokenUsageStats> ClientBase::GetTokenUsageStats() const {
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
 #include <atomic>
 #include <functional>
 #include <memory>
@@ -11,11 +13,84 @@
 #include "assistant/common.hpp"
 #include "assistant/common/tokens.hpp"
 #include "assistant/config.hpp"
+#include "assistant/model_cache.hpp"
 
 namespace assistant {
 
 constexpr std::string_view kAssistantRole = "assistant";
 
+/// A message stored in the history. Messages are immutable once added, so a
+/// node can be shared between the history and any number of snapshots.
+using MessageNode = std::shared_ptr<const assistant::message>;
+
+/// An immutable list of messages that shares its nodes with the history it was
+/// taken from. Copying a snapshot only copies pointers, never the messages.
+class MessagesSnapshot {
+ public:
+  MessagesSnapshot() = default;
+  explicit MessagesSnapshot(std::vector<MessageNode> nodes)
+      : nodes_(std::move(nodes)) {}
+  explicit MessagesSnapshot(assistant::message msg) {
+    push_back(std::move(msg));
+  }
+
+  inline void push_back(MessageNode node) { nodes_.push_back(std::move(node)); }
+  inline void push_back(assistant::message msg) {
+    nodes_.push_back(
+        std::make_shared<const assistant::message>(std::move(msg)));
+  }
+
+  /// Append the nodes of `other`.
+  inline void append(const MessagesSnapshot& other) {
+    nodes_.insert(nodes_.end(), other.nodes_.begin(), other.nodes_.end());
+  }
+
+  inline bool empty() const { return nodes_.empty(); }
+  inline size_t size() const { return nodes_.size(); }
+  inline const assistant::message& operator[](size_t i) const {
+    return *nodes_[i];
+  }
+  inline std::vector<MessageNode>::const_iterator begin() const {
+    return nodes_.begin();
+  }
+  inline std::vector<MessageNode>::const_iterator end() const {
+    return nodes_.end();
+  }
+
+  /// Build the JSON array of the messages. This is where the messages are
+  /// copied, so it should be done once, when the request is sent.
+  json to_json() const {
+    json arr = json::array();
+    arr.get_ref<json::array_t&>().reserve(nodes_.size());
+    for (const auto& node : nodes_) {
+      arr.push_back(static_cast<const json&>(*node));
+    }
+    return arr;
+  }
+
+  /// Write the messages as a JSON array, without copying them.
+  void write_json(std::ostream& os) const {
+    os << '[';
+    for (size_t i = 0; i < nodes_.size(); ++i) {
+      os << (i == 0 ? "" : ",") << static_cast<const json&>(*nodes_[i]);
+    }
+    os << ']';
+  }
+
+  /// Return a (deep) copy of the messages.
+  assistant::messages to_messages() const {
+    assistant::messages msgs;
+    msgs.reserve(nodes_.size());
+    for (const auto& node : nodes_) {
+      msgs.push_back(*node);
+    }
+    return msgs;
+  }
+
+ private:
+  std::vector<MessageNode> nodes_;
+};
+
 class ClientBase;
 class ChatRequestFinaliser {
  public:
@@ -32,7 +107,7 @@ class ChatRequestFinaliser {
 };
 
 struct ChatRequest {
-  OnResponseCallback callback_;
+  ResponseCallback callback_;
   assistant::request request_;
   std::string model_;
   std::shared_ptr<ChatRequestFinaliser> finaliser_{nullptr};
@@ -43,6 +118,19 @@ struct ChatRequest {
   std::vector<
       std::pair<std::optional<assistant::message>, std::vector<FunctionCall>>>
       func_calls_;
+
+  /// The conversation sent with this request. It shares the messages with the
+  /// history, and is serialized straight into the request body (see
+  /// `AttachMessages`).
+  MessagesSnapshot messages_;
+
+  /// Set `request_[key]` to `messages_`. The messages are not copied: they
+  /// are written directly into the body when the request is sent.
+  void AttachMessages(const std::string& key = "messages") {
+    request_.set_streamed(key, [messages = messages_](std::ostream& os) {
+      messages.write_json(os);
+    });
+  }
 };
 
 /// We pass this struct to provide context in the callback.
@@ -103,27 +191,76 @@ enum class MessageType {
   kToolResponse,
 };
 
+/// Estimate the tokens of a message: the sum of the tokens of its strings.
+inline size_t CountMessageTokens(const json& j) {
+  switch (j.type()) {
+    case json::value_t::string:
+      return CountTokens(j.get_ref<const std::string&>());
+    case json::value_t::object:
+    case json::value_t::array: {
+      size_t count{0};
+      for (const auto& item : j) {
+        count += CountMessageTokens(item);
+      }
+      return count;
+    }
+    default:
+      return 0;
+  }
+}
+
 struct Messages {
-  assistant::messages messages_;
+  std::vector<MessageNode> messages_;
   std::vector<MessageType> message_type_;
+  /// The estimated tokens of each message, counted once when it is added.
+  std::vector<size_t> tokens_;
+  /// The estimated tokens of the messages, by MessageType.
+  std::array<size_t, 3> type_tokens_{};
+  /// The positions of the tool responses, in order.
+  std::vector<size_t> tool_responses_;
+  /// The tool responses before this one in `tool_responses_` were compacted.
+  size_t compacted_responses_{0};
 
   void push_back(assistant::message msg, MessageType mt) {
-    messages_.push_back(std::move(msg));
+    size_t tokens = CountMessageTokens(msg);
+    if (mt == MessageType::kToolResponse) {
+      tool_responses_.push_back(messages_.size());
+    }
+    messages_.push_back(
+        std::make_shared<const assistant::message>(std::move(msg)));
     message_type_.push_back(mt);
+    tokens_.push_back(tokens);
+    type_tokens_[static_cast<size_t>(mt)] += tokens;
+  }
+
+  /// Replace the message at `pos`, keeping its type.
+  void replace(size_t pos, assistant::message msg) {
+    size_t tokens = CountMessageTokens(msg);
+    auto& type_tokens = type_tokens_[static_cast<size_t>(message_type_[pos])];
+    type_tokens = type_tokens - tokens_[pos] + tokens;
+    tokens_[pos] = tokens;
+    messages_[pos] = std::make_shared<const assistant::message>(std::move(msg));
   }
 
   inline void clear() {
     messages_.clear();
     message_type_.clear();
+    tokens_.clear();
+    type_tokens_ = {};
+    tool_responses_.clear();
+    compacted_responses_ = 0;
   }
 
   inline bool empty() const { return messages_.empty(); }
   inline size_t size() const { return messages_.size(); }
 
-  void set(const Messages& other) {
-    messages_ = other.messages_;
-    message_type_ = other.message_type_;
+  /// The estimated tokens of all the messages.
+  inline size_t tokens() const {
+    return type_tokens_[0] + type_tokens_[1] + type_tokens_[2];
   }
+
+  /// Share the messages of `other`.
+  void set(const Messages& other) { *this = other; }
 };
 
 inline constexpr const char kTrimMessage[] =
@@ -232,26 +369,40 @@ struct History {
    */
   size_t GetToolResponseCount() const {
     std::scoped_lock lock{mutex_};
-    if (active_history_ == &temp_messages_ || active_history_->empty()) {
+    if (active_history_ == &temp_messages_) {
       return 0;
     }
+    return active_history_->tool_responses_.size();
+  }
 
-    size_t count{0};
-    for (const auto& msg_type : active_history_->message_type_) {
-      if (msg_type == MessageType::kToolResponse) {
-        count++;
-      }
-    }
-    return count;
+  /**
+   * @brief Returns the estimated number of tokens of the active history.
+   *
+   * The tokens of a message are counted once, when it is added (or trimmed),
+   * so this method does not depend on the size of the history.
+   */
+  size_t GetTokenCount() const {
+    std::scoped_lock lock{mutex_};
+    return active_history_->tokens();
+  }
+
+  /**
+   * @brief Returns the estimated number of tokens of the messages of type `mt`
+   * in the active history.
+   */
+  size_t GetTokenCount(MessageType mt) const {
+    std::scoped_lock lock{mutex_};
+    return active_history_->type_tokens_[static_cast<size_t>(mt)];
   }
 
   /**
    * @brief Trims older tool response messages in the active history.
    *
    * Locks the history mutex, skips compaction when the active history is
-   * temporary or empty, and then walks the history backward to apply the
-   * provided trimming function to all but the most recent tool response
-   * messages.
+   * temporary or empty, and then applies the provided trimming function to
+   * all but the most recent tool response messages. Tool responses trimmed by
+   * a previous call are not visited again, so a call only costs the messages
+   * it trims.
    *
    * @param msg_trim_func std::function<void(assistant::message&)> Function
    * invoked for each tool response message that should be trimmed. The callback
@@ -271,22 +422,21 @@ struct History {
     }
 
     // Remove tool responses. Note that we keep the last 3 tool responses
-    size_t responses_found{0};
+    const auto& tool_responses = active_history_->tool_responses_;
+    if (tool_responses.size() <= responses_to_keep) {
+      return 0;
+    }
+    size_t end = tool_responses.size() - responses_to_keep;
     size_t tokens_trimmed{0};
-    for (int i = static_cast<int>(active_history_->size()) - 1; i >= 0; --i) {
-      auto msg_type = active_history_->message_type_[i];
-      if (msg_type != MessageType::kToolResponse) {
-        continue;
-      }
-
-      if (responses_found < responses_to_keep) {
-        responses_found++;
-        continue;
-      }
-
-      auto& msg = active_history_->messages_[i];
+    for (size_t i = active_history_->compacted_responses_; i < end; ++i) {
+      size_t pos = tool_responses[i];
+      // The node may be shared with a snapshot: trim a copy of it.
+      assistant::message msg = *active_history_->messages_[pos];
       tokens_trimmed += msg_trim_func(msg);
+      active_history_->replace(pos, std::move(msg));
     }
+    active_history_->compacted_responses_ =
+        std::max(active_history_->compacted_responses_, end);
     return tokens_trimmed;
   }
 
@@ -311,8 +461,19 @@ struct History {
    * @return A copy of the active message container. Thread-safe.
    */
   assistant::messages GetMessages() const {
+    return GetSnapshot().to_messages();
+  }
+
+  /**
+   * @brief Retrieves the messages of the currently active history without
+   * copying them.
+   *
+   * @return A snapshot sharing the messages with the history. Messages added
+   * later are not part of it. Thread-safe.
+   */
+  MessagesSnapshot GetSnapshot() const {
     std::scoped_lock lock{mutex_};
-    return active_history_->messages_;
+    return MessagesSnapshot{active_history_->messages_};
   }
 
   /**
@@ -335,10 +496,11 @@ struct History {
    * clearing it).
    */
   void SetMessages(const assistant::messages& msgs) {
-    std::scoped_lock lock{mutex_};
     Messages m;
-    m.messages_ = msgs;
-    m.message_type_ = {msgs.size(), MessageType::kNormal};
+    for (const auto& msg : msgs) {
+      m.push_back(msg, MessageType::kNormal);
+    }
+    std::scoped_lock lock{mutex_};
     active_history_->set(m);
   }
 
@@ -383,6 +545,75 @@ struct History {
   size_t swap_count_ GUARDED_BY(mutex_){0};
 };
 
+/**
+ * @brief The state of a single conversation.
+ *
+ * The sessions of a client share its function table, endpoint, transports and
+ * system messages, but each session has its own history, request queue and
+ * interrupt flag. Turns of different sessions may run concurrently (see
+ * `ClientBase::ChatInSession` and `ChatScheduler`), the turns of a session
+ * run one after the other.
+ */
+class ChatSession {
+ public:
+  explicit ChatSession(std::string id = {}) : m_id{std::move(id)} {}
+
+  inline const std::string& GetId() const { return m_id; }
+  inline History& GetHistory() { return m_history; }
+  inline const History& GetHistory() const { return m_history; }
+
+  /// Interrupt the turn running in this session, if any. The session remains
+  /// interrupted until `ResetInterrupt()` is called.
+  void Interrupt() {
+    m_interrupt.store(true);
+    InterruptTransport();
+  }
+  inline bool IsInterrupted() const { return m_interrupt.load(); }
+  inline void ResetInterrupt() { m_interrupt.store(false); }
+
+  /// Return true if the last turn of this session was aborted by a fatal
+  /// error. The error was reported to the callback of the turn.
+  inline bool IsFailed() const { return m_failed.load(); }
+
+  /// Return true while a request of this session is being sent.
+  inline bool IsBusy() const {
+    std::scoped_lock lk{m_transport_mutex};
+    return m_transport != nullptr;
+  }
+
+ private:
+  /// Interrupt the request being sent, if any.
+  void InterruptTransport() {
+    std::scoped_lock lk{m_transport_mutex};
+    if (m_transport == nullptr) {
+      return;
+    }
+    try {
+      m_transport->interrupt();
+    } catch (std::exception& e) {
+      OLOG(LogLevel::kWarning)
+          << "an error occurred while interrupting client. " << e.what();
+    }
+  }
+
+  inline void SetTransport(ITransport* transport) {
+    std::scoped_lock lk{m_transport_mutex};
+    m_transport = transport;
+  }
+
+  std::string m_id;
+  History m_history;
+  ChatRequestQueue m_queue;
+  std::atomic_bool m_interrupt{false};
+  std::atomic_bool m_failed{false};
+  /// Messages to send once the current turn is complete. Only accessed by the
+  /// thread running the turn.
+  std::vector<std::string> m_pending_messages;
+  mutable std::mutex m_transport_mutex;
+  ITransport* m_transport GUARDED_BY(m_transport_mutex){nullptr};
+  friend class ClientBase;
+};
+
 class ClientBase {
  public:
   ClientBase() = default;
@@ -394,7 +625,7 @@ class ClientBase {
   /// Start a chat. Some options of the chat can be controlled via the
   /// ChatOptions flags. For example, user may disable "tools" even though the
   /// model support them.
-  virtual void Chat(std::string msg, OnResponseCallback cb,
+  virtual void Chat(std::string msg, ResponseCallback cb,
                     ChatOptions chat_options) = 0;
 
   /// Return true if the server is running.
@@ -412,7 +643,7 @@ class ClientBase {
       const std::string& model) = 0;
 
   virtual void CreateAndPushChatRequest(
-      std::optional<assistant::message> msg, OnResponseCallback cb,
+      std::optional<assistant::message> msg, ResponseCallback cb,
       std::string model, ChatOptions chat_options,
       std::shared_ptr<ChatRequestFinaliser> finaliser) = 0;
 
@@ -430,67 +661,106 @@ class ClientBase {
 
   virtual void InvokeTools(std::shared_ptr<ChatRequest> request);
 
+  /// Run a chat turn in `session`, on the calling thread. While the turn runs,
+  /// the history API of the client (`GetHistory`, `Compact`, ...) operates on
+  /// the history of `session` when called from this thread. Turns of different
+  /// sessions may run concurrently, the turns of a session must not.
+  void ChatInSession(std::shared_ptr<ChatSession> session, std::string msg,
+                     ResponseCallback cb, ChatOptions chat_options);
+
   virtual void ApplyConfig(const assistant::Config* conf);
-  virtual void Startup() { m_interrupt.store(false); }
+  virtual void Startup() {
+    m_interrupt.store(false);
+    m_default_session->ResetInterrupt();
+  }
   virtual void Shutdown() {
     Interrupt();
+    m_model_capabilities.CancelWarmUp();
     ClearMessageQueue();
     ClearSystemMessages();
     ClearHistoryMessages();
     ClearFunctionTable();
   }
 
-  virtual void Interrupt() { m_interrupt.store(true); }
+  /// Interrupt the turns of all the sessions. This method should be called
+  /// from another thread.
+  virtual void Interrupt();
   inline size_t GetAutoCompactThreshold() {
     return m_auto_compact_threshold.load();
   }
-  inline bool IsInterrupted() const { return m_interrupt.load(); }
+  inline size_t GetClientCompactThreshold() {
+    return m_client_compact_threshold.load();
+  }
+  /// Return true if the client, or the session of the calling thread, was
+  /// interrupted.
+  inline bool IsInterrupted() const {
+    return m_interrupt.load() || CurrentSession().IsInterrupted();
+  }
 
   const FunctionTable& GetFunctionTable() const { return m_function_table; }
   FunctionTable& GetFunctionTable() { return m_function_table; }
 
   void ClearFunctionTable() { m_function_table.Clear(); }
-  void ClearMessageQueue() { m_queue.clear(); }
+  void ClearMessageQueue() { CurrentSession().m_queue.clear(); }
 
   /// Add system message to the prompt. System messages are always sent as part
   /// of the prompt
   void AddSystemMessage(const std::string& msg) {
-    m_system_messages.with_mut([&msg](assistant::messages& msgs) {
+    m_system_messages.with_mut([&msg](MessagesSnapshot& msgs) {
       msgs.push_back(assistant::message{"system", msg});
     });
   }
 
   /// Clear all system messages.
   void ClearSystemMessages() {
-    m_system_messages.with_mut([](assistant::messages& msgs) { msgs.clear(); });
+    m_system_messages.with_mut([](MessagesSnapshot& msgs) { msgs = {}; });
   }
 
   /// Clear all history messages.
-  void ClearHistoryMessages() { m_history.Clear(); }
+  void ClearHistoryMessages() { CurrentHistory().Clear(); }
 
   /// Return the history messages.
   inline assistant::messages GetHistory() const {
-    return m_history.GetMessages();
+    return CurrentHistory().GetMessages();
   }
 
   inline size_t GetToolResponseCount() const {
-    return m_history.GetToolResponseCount();
+    return CurrentHistory().GetToolResponseCount();
+  }
+
+  /// The estimated number of tokens of the history.
+  inline size_t GetHistoryTokenCount() const {
+    return CurrentHistory().GetTokenCount();
+  }
+
+  /// Compact the history when its estimated tokens exceed the
+  /// `client_compact_threshold` of the endpoint (0, the default, disables it).
+  /// Called at the start of every chat turn. Returns the number of tokens
+  /// trimmed.
+  inline size_t CompactIfNeeded(size_t responses_to_keep = 3) {
+    size_t threshold = GetClientCompactThreshold();
+    if (threshold == 0 || GetHistoryTokenCount() <= threshold) {
+      return 0;
+    }
+    return Compact(responses_to_keep);
   }
 
   /// Replace the history.
-  inline void SetHistory(const Messages& msgs) { m_history.SetMessages(msgs); }
+  inline void SetHistory(const Messages& msgs) {
+    CurrentHistory().SetMessages(msgs);
+  }
   inline void SetHistory(const assistant::messages& msgs) {
-    m_history.SetMessages(msgs);
+    CurrentHistory().SetMessages(msgs);
   }
 
-  inline std::string GetUrl() const { return m_endpoint.get_value().url_; }
+  inline std::string GetUrl() const { return m_endpoint.load()->url_; }
   /// HTTP headers sent on every request to the provider. Subclasses may
   /// override to inject additional headers (e.g. Anthropic beta headers).
   virtual std::unordered_map<std::string, std::string> GetHttpHeaders() const {
-    return m_endpoint.get_value().headers_;
+    return m_endpoint.load()->headers_;
   }
   inline EndpointKind GetEndpointKind() const {
-    return m_endpoint.get_value().type_;
+    return m_endpoint.load()->type_;
   }
 
   inline void SetEndpointKind(EndpointKind kind) {
@@ -498,11 +768,11 @@ class ClientBase {
   }
 
   virtual inline size_t GetMaxTokens() const {
-    return m_endpoint.get_value().max_tokens_.value_or(kMaxTokensDefault);
+    return m_endpoint.load()->max_tokens_.value_or(kMaxTokensDefault);
   }
 
   virtual inline size_t GetContextSize() const {
-    return m_endpoint.get_value().context_size_.value_or(kDefaultContextSize);
+    return m_endpoint.load()->context_size_.value_or(kDefaultContextSize);
   }
 
   inline void SetMaxTokens(size_t count) {
@@ -510,14 +780,14 @@ class ClientBase {
   }
 
   inline void SetEndpoint(const Endpoint& ep) {
-    m_endpoint.with_mut([ep](Endpoint& endpoint) { endpoint = ep; });
+    m_endpoint.set_value(ep);
   }
 
   inline std::optional<bool> IsThinking() const {
-    return m_endpoint.get_value().thinking_;
+    return m_endpoint.load()->thinking_;
   }
 
-  inline std::string GetModel() const { return m_endpoint.get_value().model_; }
+  inline std::string GetModel() const { return m_endpoint.load()->model_; }
 
   inline std::optional<Pricing> GetPricing() const {
     return m_cost.get_value();
@@ -604,7 +874,27 @@ class ClientBase {
 
   virtual inline bool IsStreaming() const { return m_stream.load(); }
 
+  /// Set the maximum number of tool calls of a single turn that may run at the
+  /// same time. 1 (the default) runs them one after the other.
+  inline void SetMaxParallelToolCalls(size_t count) {
+    m_max_parallel_tool_calls = std::max<size_t>(count, 1);
+  }
+
+  inline size_t GetMaxParallelToolCalls() const {
+    return m_max_parallel_tool_calls.load();
+  }
+
  protected:
+  using ToolCallResults = std::vector<std::pair<FunctionCall, FunctionResult>>;
+
+  /// Run the tool calls of `request`. Permissions are checked one call at a
+  /// time (they may prompt the user), the permitted calls then run on up to
+  /// `GetMaxParallelToolCalls()` threads. Returns the results of each tool
+  /// request message, in the order of `request->func_calls_`, or nullopt if
+  /// the client was interrupted.
+  std::optional<std::vector<ToolCallResults>> RunToolCalls(
+      std::shared_ptr<ChatRequest> request);
+
   static bool OnResponse(const assistant::response& resp, void* user_data);
   static bool OnResponseRaw(const std::string& resp, void* user_data);
   void ProcessChatRequestQueue();
@@ -612,21 +902,63 @@ class ClientBase {
                       ChatContext& chat_user_data);
   virtual void AddMessage(std::optional<assistant::message> msg,
                           MessageType mt);
-  virtual assistant::messages GetMessages() const;
+  /// Return the messages to send: the system messages followed by the
+  /// history. The messages are shared, not copied.
+  virtual MessagesSnapshot GetMessages() const;
   bool ModelHasCapability(const std::string& model_name, ModelCapabilities c);
+  /// Fetch the capabilities of the models of the endpoint in the background,
+  /// so that the first chat turn does not wait for them. `fetch` runs on the
+  /// warm-up thread, which may still run while the client is destroyed: it
+  /// must not use the client.
+  void WarmUpModelCapabilities(ModelCapabilitiesCache::Fetcher fetch);
+
+  /// Mark the start of a turn in the session of the calling thread.
+  inline void BeginTurn() { CurrentSession().m_failed.store(false); }
+  /// Report `error` to the callback of `request` and mark the session of the
+  /// calling thread as failed: the rest of its turn is dropped. The other
+  /// sessions and the client state are not affected.
+  void FailTurn(const ChatRequest& request, std::string_view error);
+  /// Return true if the turn running on the calling thread was interrupted
+  /// or failed.
+  inline bool IsTurnStopped() const {
+    return IsInterrupted() || CurrentSession().IsFailed();
+  }
+
+  /// The session of the turn running on the calling thread, or the default
+  /// session.
+  std::shared_ptr<ChatSession> CurrentSessionPtr() const;
+  inline ChatSession& CurrentSession() const { return *CurrentSessionPtr(); }
+  /// Messages that were sent to the AI, will be placed here
+  inline History& CurrentHistory() const { return CurrentSession().m_history; }
+  inline ChatRequestQueue& CurrentQueue() const {
+    return CurrentSession().m_queue;
+  }
+  inline std::vector<std::string>& CurrentPendingMessages() const {
+    return CurrentSession().m_pending_messages;
+  }
+  /// Set the transport used by the request being sent by the current session,
+  /// so `Interrupt()` can reach it. Pass nullptr once the request completes.
+  inline void SetCurrentTransport(ITransport* transport) {
+    CurrentSession().SetTransport(transport);
+  }
+  /// Return true if a request of any session is being sent.
+  bool HasRequestInFlight() const;
 
   FunctionTable m_function_table;
-  ChatRequestQueue m_queue;
-  Locker<Endpoint> m_endpoint;
-  /// Messages that were sent to the AI, will be placed here
-  History m_history;
-  Locker<assistant::messages> m_system_messages;
+  SnapshotLocker<Endpoint> m_endpoint;
+  /// Used outside of `ChatInSession`.
+  std::shared_ptr<ChatSession> m_default_session{
+      std::make_shared<ChatSession>()};
+  /// The sessions running a turn via `ChatInSession`.
+  Locker<std::vector<std::shared_ptr<ChatSession>>> m_running_sessions;
+  Locker<MessagesSnapshot> m_system_messages;
   Locker<ServerTimeout> m_server_timeout;
-  Locker<std::unordered_map<std::string, ModelCapabilities>>
-      m_model_capabilities;
+  ModelCapabilitiesCache m_model_capabilities;
   std::atomic_bool m_interrupt{false};
   std::atomic_bool m_stream{true};
   std::atomic_size_t m_auto_compact_threshold{kDefaultAutoCompactThreshold};
+  std::atomic_size_t m_client_compact_threshold{0};
+  std::atomic_size_t m_max_parallel_tool_calls{1};
   Locker<std::string> m_keep_alive{"5m"};
   OnToolInvokeCallback m_on_invoke_tool_cb{nullptr};
   Locker<std::optional<Pricing>> m_cost;
@@ -637,7 +969,6 @@ class ClientBase {
   std::atomic_bool m_multi_tool_reply_as_array{false};
   Locker<CachePolicy> m_caching_policy{CachePolicy::kNone};
   Locker<TransportType> m_transport_type{TransportType::httplib};
-  std::vector<std::string> m_pendingMessages;
   friend struct ChatRequest;
 };
 }  // namespace assistant
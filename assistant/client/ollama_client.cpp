@@ -1,5 +1,8 @@
 #include "assistant/client/ollama_client.hpp"
 
+#include <algorithm>
+#include <vector>
+
 #include "assistant/Curl.hpp"
 #include "assistant/assistant.hpp"
 #include "assistant/assistantlib.hpp"
@@ -11,8 +14,40 @@
 
 namespace assistant {
 
+namespace {
+/// Read the capabilities from the `show` reply of Ollama.
+std::optional<ModelCapabilities> ParseOllamaModelCapabilities(json j) {
+  OLOG(LogLevel::kTrace) << "Model info:";
+  OLOG(LogLevel::kTrace) << std::setw(2) << j["capabilities"];
+  OLOG(LogLevel::kTrace) << std::setw(2) << j["model_info"];
+
+  ModelCapabilities flags{ModelCapabilities::kNone};
+  try {
+    auto capabilities = j["capabilities"].get<std::vector<std::string>>();
+    for (const auto& c : capabilities) {
+      if (c == "completion") {
+        AddFlagSet(flags, ModelCapabilities::kCompletion);
+      } else if (c == "tools") {
+        AddFlagSet(flags, ModelCapabilities::kTools);
+      } else if (c == "thinking") {
+        AddFlagSet(flags, ModelCapabilities::kThinking);
+      } else if (c == "insert") {
+        AddFlagSet(flags, ModelCapabilities::kInsert);
+      } else if (c == "vision") {
+        AddFlagSet(flags, ModelCapabilities::kVision);
+      } else {
+        std::cerr << "unknown capability: " << c << std::endl;
+      }
+    }
+    return flags;
+  } catch (...) {
+    return std::nullopt;
+  }
+}
+}  // namespace
+
 OllamaClient::OllamaClient(const Endpoint& ep) {
-  m_endpoint.with_mut([ep](Endpoint& endpoint) { endpoint = ep; });
+  m_endpoint.set_value(ep);
   assistant::allow_exceptions(true);
   mcp::set_log_level(mcp::log_level::error);
   Startup();
@@ -42,9 +77,14 @@ std::unique_ptr<ITransport> OllamaClient::CreateClient() {
                           server_timeout_settings.GetWriteTimeout().second);
   client->setEndpointKind(GetEndpointKind());
   client->setServerURL(GetUrl());
+  if (auto impl = dynamic_cast<ClientImpl*>(client.get()); impl != nullptr) {
+    // Keep the connection open so the transport can be pooled and re-used
+    // by the next request to the same endpoint.
+    impl->setKeepAlive(true);
+  }
 
 #if CPPHTTPLIB_OPENSSL_SUPPORT
-  client->verifySSLCertificate(m_endpoint.get_value().verify_server_ssl_);
+  client->verifySSLCertificate(m_endpoint.load()->verify_server_ssl_);
 #endif
 
   auto headers = GetHttpHeaders();
@@ -56,29 +96,80 @@ std::unique_ptr<ITransport> OllamaClient::CreateClient() {
   return client;
 }
 
-OllamaClient::~OllamaClient() { Shutdown(); }
-
-void OllamaClient::Interrupt() {
-  ClientBase::Interrupt();
-  std::scoped_lock lk{m_client_impl_ptr_mutex};
-  if (m_client_impl_ptr == nullptr) {
-    return;
+std::string OllamaClient::GetTransportKey() const {
+  auto endpoint = m_endpoint.load();
+  auto timeouts = m_server_timeout.get_value();
+  std::stringstream ss;
+  ss << static_cast<int>(endpoint->type_) << "|" << endpoint->url_ << "|"
+     << endpoint->verify_server_ssl_ << "|"
+     << timeouts.GetConnectTimeout().first << "."
+     << timeouts.GetConnectTimeout().second << "|"
+     << timeouts.GetReadTimeout().first << "."
+     << timeouts.GetReadTimeout().second << "|"
+     << timeouts.GetWriteTimeout().first << "."
+     << timeouts.GetWriteTimeout().second;
+
+  // Sort the headers so the key does not depend on the hash map ordering.
+  auto headers = GetHttpHeaders();
+  std::vector<const std::pair<const std::string, std::string>*> sorted_headers;
+  sorted_headers.reserve(headers.size());
+  for (const auto& header : headers) {
+    sorted_headers.push_back(&header);
   }
-  try {
-    m_client_impl_ptr->interrupt();
-  } catch (std::exception& e) {
-    OLOG(LogLevel::kWarning)
-        << "an error occurred while interrupting client. " << e.what();
+  std::sort(sorted_headers.begin(), sorted_headers.end(),
+            [](const auto* a, const auto* b) { return a->first < b->first; });
+  for (const auto* header : sorted_headers) {
+    ss << "|" << header->first << ":" << header->second;
+  }
+  return ss.str();
+}
+
+TransportPool::Lease OllamaClient::AcquireClient() {
+  if (GetTransportType() != TransportType::httplib) {
+    // Curl spawns a process per request, there is no connection to re-use.
+    return TransportPool::Unpooled(CreateClient());
   }
+  return m_transport_pool->Acquire(GetTransportKey(),
+                                   [this]() { return CreateClient(); });
 }
 
+OllamaClient::~OllamaClient() { Shutdown(); }
+
 void OllamaClient::ApplyConfig(const assistant::Config* conf) {
   ClientBase::ApplyConfig(conf);
+  // The endpoint may have changed, drop connections to the previous one.
+  m_transport_pool->Clear();
+  // Asking Ollama for the capabilities is a round trip to the server: do it
+  // now, not on the first chat turn. The other endpoints report them without
+  // asking the server.
+  if (GetEndpointKind() != EndpointKind::ollama) {
+    return;
+  }
+  // The warm-up gets a transport of its own, not the client: it may still run
+  // while the client is destroyed.
+  std::shared_ptr<ITransport> transport;
+  try {
+    transport = CreateClient();
+  } catch (const std::exception& e) {
+    OLOG(LogLevel::kWarning) << "Skipping the model capabilities warm-up. "
+                             << e.what();
+    return;
+  }
+  auto fetch = [transport](const std::string& model)
+      -> std::optional<ModelCapabilities> {
+    try {
+      OLOG(LogLevel::kInfo) << "Fetching info for model: " << model;
+      return ParseOllamaModelCapabilities(transport->show_model_info(model));
+    } catch (...) {
+      return std::nullopt;
+    }
+  };
+  WarmUpModelCapabilities(std::move(fetch));
 }
 
 std::vector<std::string> OllamaClient::List() {
   try {
-    auto client = CreateClient();
+    auto client = AcquireClient();
     return client->list_models();
   } catch (...) {
     return {};
@@ -87,7 +178,7 @@ std::vector<std::string> OllamaClient::List() {
 
 json OllamaClient::ListJSON() {
   try {
-    auto client = CreateClient();
+    auto client = AcquireClient();
     return client->list_model_json();
   } catch (...) {
     return {};
@@ -96,7 +187,7 @@ json OllamaClient::ListJSON() {
 
 std::optional<json> OllamaClient::GetModelInfo(const std::string& model) {
   try {
-    auto client = CreateClient();
+    auto client = AcquireClient();
     OLOG(LogLevel::kInfo) << "Fetching info for model: " << model;
     return client->show_model_info(model);
   } catch (std::exception& e) {
@@ -110,34 +201,7 @@ std::optional<ModelCapabilities> OllamaClient::GetOllamaModelCapabilities(
   if (!opt.has_value()) {
     return std::nullopt;
   }
-
-  auto& j = opt.value();
-  OLOG(LogLevel::kTrace) << "Model info:";
-  OLOG(LogLevel::kTrace) << std::setw(2) << j["capabilities"];
-  OLOG(LogLevel::kTrace) << std::setw(2) << j["model_info"];
-
-  ModelCapabilities flags{ModelCapabilities::kNone};
-  try {
-    auto capabilities = j["capabilities"].get<std::vector<std::string>>();
-    for (const auto& c : capabilities) {
-      if (c == "completion") {
-        AddFlagSet(flags, ModelCapabilities::kCompletion);
-      } else if (c == "tools") {
-        AddFlagSet(flags, ModelCapabilities::kTools);
-      } else if (c == "thinking") {
-        AddFlagSet(flags, ModelCapabilities::kThinking);
-      } else if (c == "insert") {
-        AddFlagSet(flags, ModelCapabilities::kInsert);
-      } else if (c == "vision") {
-        AddFlagSet(flags, ModelCapabilities::kVision);
-      } else {
-        std::cerr << "unknown capability: " << c << std::endl;
-      }
-    }
-    return flags;
-  } catch (...) {
-    return std::nullopt;
-  }
+  return ParseOllamaModelCapabilities(std::move(opt.value()));
 }
 
 std::optional<ModelCapabilities> OllamaClient::GetModelCapabilities(
@@ -147,7 +211,7 @@ std::optional<ModelCapabilities> OllamaClient::GetModelCapabilities(
 
 bool OllamaClient::IsRunning() {
   try {
-    auto client = CreateClient();
+    auto client = AcquireClient();
     return client->is_running();
   } catch ([[maybe_unused]] const std::exception& e) {
     return false;
@@ -157,6 +221,7 @@ bool OllamaClient::IsRunning() {
 void OllamaClient::ProcessChatRequest(
     std::shared_ptr<ChatRequest> chat_request) {
   try {
+    chat_request->AttachMessages();
     std::string model_name = chat_request->request_["model"].get<std::string>();
 
     // Prepare chat user data.
@@ -168,9 +233,9 @@ void OllamaClient::ProcessChatRequest(
     user_data.thinking_end_tag = "</think>";
 
     {
-      auto client = CreateClient();
+      auto client = AcquireClient();
       SetInterruptClientLocker locker{this, client.get()};
-      OLOG_DEBUG() << "Sending:" << chat_request->request_.dump(1);
+      OLOG_DEBUG() << "Sending:" << chat_request->request_.serialize();
       client->chat(chat_request->request_, &OllamaClient::OnResponse,
                    static_cast<void*>(&user_data));
     }
@@ -179,52 +244,64 @@ void OllamaClient::ProcessChatRequest(
       InvokeTools(chat_request);
     }
   } catch (std::exception& e) {
-    chat_request->callback_(e.what(), Reason::kFatalError, false);
-    Shutdown();
+    FailTurn(*chat_request, e.what());
   }
 }
 
-void OllamaClient::Chat(std::string msg, OnResponseCallback cb,
+void OllamaClient::Chat(std::string msg, ResponseCallback cb,
                         ChatOptions chat_options) {
-  auto DoChat = [this](const std::string& msg, OnResponseCallback& cb,
+  auto DoChat = [this](const std::string& msg, ResponseCallback& cb,
                        ChatOptions chat_options) {
     assistant::message json_message{"user", msg};
     std::shared_ptr<ChatRequestFinaliser> finaliser{nullptr};
     if (assistant::IsFlagSet(chat_options, ChatOptions::kNoHistory)) {
-      m_history.SwapToTempHistory();
+      auto session = CurrentSessionPtr();
+      session->GetHistory().SwapToTempHistory();
       finaliser = std::make_shared<ChatRequestFinaliser>(
-          [this]() { m_history.SwapToMainHistory(); });
+          [session]() { session->GetHistory().SwapToMainHistory(); });
     }
     CreateAndPushChatRequest(json_message, cb, GetModel(), chat_options,
                              finaliser);
     ProcessChatRequestQueue();
   };
 
+  BeginTurn();
+  // Trim the history before it is sent, if the endpoint opted in and it grew
+  // above the threshold.
+  if (size_t trimmed = CompactIfNeeded(); trimmed > 0) {
+    OLOG(LogLevel::kInfo) << "History compacted, " << trimmed
+                          << " tokens trimmed.";
+  }
   DoChat(msg, cb, chat_options);
   // Drain all pending messages that were created during this chat request
-  for (const auto& pending_msg : m_pendingMessages) {
+  auto& pending_messages = CurrentPendingMessages();
+  for (const auto& pending_msg : pending_messages) {
+    if (IsTurnStopped()) {
+      break;
+    }
     DoChat(pending_msg, cb, chat_options);
   }
-  m_pendingMessages.clear();
+  pending_messages.clear();
 }
 
 void OllamaClient::ProcessChatRequestQueue() {
-  while (!m_queue.empty()) {
-    if (m_interrupt.load()) {
+  auto& queue = CurrentQueue();
+  while (!queue.empty()) {
+    if (IsTurnStopped()) {
       break;
     }
-    ProcessChatRequest(m_queue.pop_front_and_return());
+    ProcessChatRequest(queue.pop_front_and_return());
   }
 }
 
 void OllamaClient::CreateAndPushChatRequest(
-    std::optional<assistant::message> msg, OnResponseCallback cb,
+    std::optional<assistant::message> msg, ResponseCallback cb,
     std::string model, ChatOptions chat_options,
     std::shared_ptr<ChatRequestFinaliser> finaliser) {
-  assistant::messages history;
+  MessagesSnapshot history;
   if (IsFlagSet(chat_options, ChatOptions::kNoHistory)) {
     if (msg.has_value()) {
-      history = {msg.value()};
+      history.push_back(std::move(msg.value()));
     }
   } else {
     AddMessage(msg, MessageType::kNormal);
@@ -238,13 +315,12 @@ void OllamaClient::CreateAndPushChatRequest(
                           << model << "' (per user request).";
   } else if (ModelHasCapability(model, ModelCapabilities::kTools) &&
              !m_function_table.IsEmpty()) {
-    req["tools"] =
-        m_function_table.ToJSON(EndpointKind::ollama, GetCachingPolicy());
+    m_function_table.AddToolsToRequest(req, EndpointKind::ollama,
+                                       GetCachingPolicy());
   } else {
     OLOG(LogLevel::kWarning)
         << "The selected model: " << model << " does not support 'tools'";
   }
-  req["messages"] = history.to_json();
   req["model"] = model;
   req["stream"] = IsStreaming();
   auto keep_alive_duration = m_keep_alive.get_value();
@@ -256,11 +332,13 @@ void OllamaClient::CreateAndPushChatRequest(
   req["options"]["num_predict"] = GetMaxTokens();
   ChatRequest ctx = {
       .callback_ = cb,
-      .request_ = req,
+      .request_ = std::move(req),
       .model_ = std::move(model),
       .finaliser_ = finaliser,
+      .func_calls_ = {},
+      .messages_ = std::move(history),
   };
-  m_queue.push_back(std::make_shared<ChatRequest>(ctx));
+  CurrentQueue().push_back(std::make_shared<ChatRequest>(std::move(ctx)));
 }
 
 void OllamaClient::AddToolsResult(
@@ -280,17 +358,18 @@ void OllamaClient::AddToolsResult(
     msg["tool_name"] = fcall.name;
     AddMessage(std::move(msg), MessageType::kToolResponse);
     if (!p.second.empty()) {
-      m_pendingMessages.push_back(p.second);
+      CurrentPendingMessages().push_back(p.second);
     }
   }
 }
 
 size_t OllamaClient::Compact(size_t responses_to_keep) {
-  return m_history.Compact(
+  return CurrentHistory().Compact(
       [this](assistant::message& msg) {
         size_t tokens_trimmed{0};
         if (msg.contains("content") && msg["content"].is_string()) {
-          size_t count = CountTokens(msg["content"].get<std::string>());
+          size_t count =
+              CountTokens(msg["content"].get_ref<const std::string&>());
           if (count > kTrimMessageTokensCount) {
             msg["content"] = kTrimMessage;
             tokens_trimmed += (count - kTrimMessageTokensCount);
@@ -3,6 +3,7 @@
 #include <unordered_map>
 
 #include "assistant/client/client_base.hpp"
+#include "assistant/transport_pool.hpp"
 
 namespace assistant {
 
@@ -27,10 +28,7 @@ class OllamaClient : public ClientBase {
   bool IsRunning() override;
 
   /// Return if the server is busy processing a request.
-  inline bool IsBusy() const {
-    std::scoped_lock lk{m_client_impl_ptr_mutex};
-    return m_client_impl_ptr != nullptr;
-  }
+  inline bool IsBusy() const { return HasRequestInFlight(); }
 
   /// Return list of models available.
   std::vector<std::string> List() override;
@@ -47,14 +45,12 @@ class OllamaClient : public ClientBase {
   void AddToolsResult(
       std::vector<std::pair<FunctionCall, FunctionResult>> result) override;
   size_t Compact(size_t responses_to_keep = 3) override;
-  /// This method should be called from another thread.
-  void Interrupt() override;
 
-  void Chat(std::string msg, OnResponseCallback cb,
+  void Chat(std::string msg, ResponseCallback cb,
             ChatOptions chat_options) override;
 
   void CreateAndPushChatRequest(
-      std::optional<assistant::message> msg, OnResponseCallback cb,
+      std::optional<assistant::message> msg, ResponseCallback cb,
       std::string model, ChatOptions chat_options,
       std::shared_ptr<ChatRequestFinaliser> finaliser) override;
 
@@ -62,21 +58,31 @@ class OllamaClient : public ClientBase {
   /// Client interface implementation ends here.
   ///===---------------------------------------
 
+  /// Return the connection reuse counters of the transport pool.
+  inline TransportPoolStats GetTransportPoolStats() const {
+    return m_transport_pool->GetStats();
+  }
+
+  /// Close all idle (keep-alive) connections held by this client.
+  inline void ClearTransportPool() { m_transport_pool->Clear(); }
+
  protected:
   virtual void ProcessChatRequest(std::shared_ptr<ChatRequest> chat_request);
   virtual void ProcessChatRequestQueue();
-  void SetClientForInterrupt(ITransport* c) {
-    std::scoped_lock lk{m_client_impl_ptr_mutex};
-    m_client_impl_ptr = c;
-  }
+  void SetClientForInterrupt(ITransport* c) { SetCurrentTransport(c); }
   virtual std::unique_ptr<ITransport> CreateClient();
+  /// Return a transport for the current endpoint. For "httplib" transports,
+  /// an idle transport with a warm connection is re-used when available.
+  TransportPool::Lease AcquireClient();
+  /// A key that uniquely identifies the current endpoint settings. Transports
+  /// are only re-used for requests with the same key.
+  std::string GetTransportKey() const;
   std::pair<std::string, std::string> BuildToolResponseContent(
       const FunctionCall& fcall, const FunctionResult& reply) const;
   std::optional<ModelCapabilities> GetOllamaModelCapabilities(
       const std::string& model);
 
-  mutable std::mutex m_client_impl_ptr_mutex;
-  ITransport* m_client_impl_ptr GUARDED_BY(m_client_impl_ptr_mutex) = nullptr;
+  std::shared_ptr<TransportPool> m_transport_pool{TransportPool::Create()};
   friend class ClaudeClient;
   friend struct SetInterruptClientLocker;
 };
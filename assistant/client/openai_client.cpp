@@ -19,10 +19,7 @@ std::optional<ModelCapabilities> OpenAIClient::GetModelCapabilities(
 void OpenAIClient::ProcessChatRequest(
     std::shared_ptr<ChatRequest> chat_request) {
   // /v1/responses uses "input" instead of "messages"
-  if (chat_request->request_.contains("messages")) {
-    chat_request->request_["input"] = chat_request->request_["messages"];
-    chat_request->request_.erase("messages");
-  }
+  chat_request->AttachMessages("input");
   chat_request->request_["max_output_tokens"] = GetMaxTokens();
 
   // Server-side auto-compaction via OpenAI's context_management API.
@@ -36,27 +33,26 @@ void OpenAIClient::ProcessChatRequest(
 
   // Re-serialize tools in /v1/responses format (flat, not nested under
   // "function")
-  if (!m_function_table.IsEmpty() && chat_request->request_.contains("tools")) {
-    chat_request->request_["tools"] =
-        m_function_table.ToJSON(EndpointKind::openai, GetCachingPolicy());
+  if (!m_function_table.IsEmpty() &&
+      chat_request->request_.has_member("tools")) {
+    m_function_table.AddToolsToRequest(
+        chat_request->request_, EndpointKind::openai, GetCachingPolicy());
   }
   // Remove parameters unsupported by /v1/responses
   chat_request->request_.erase("keep_alive");
   chat_request->request_.erase("options");
   try {
-    m_responseParser = std::make_unique<OpenAIResponseParser>();
     std::string model_name = chat_request->request_["model"].get<std::string>();
 
     // Prepare chat user data.
-    ChatContext user_data{
-        .client = this,
-        .model = model_name,
-        .model_can_think = true,
-        .chat_context = chat_request,
-    };
+    OpenAIChatContext user_data;
+    user_data.client = this;
+    user_data.model = model_name;
+    user_data.model_can_think = true;
+    user_data.chat_context = chat_request;
 
     {
-      auto client = CreateClient();
+      auto client = AcquireClient();
       SetInterruptClientLocker locker{this, client.get()};
       client->chat_raw_output(chat_request->request_,
                               &OpenAIClient::OnRawResponse,
@@ -67,26 +63,26 @@ void OpenAIClient::ProcessChatRequest(
       InvokeTools(chat_request);
     }
   } catch (std::exception& e) {
-    chat_request->callback_(e.what(), Reason::kFatalError, false);
-    Shutdown();
+    FailTurn(*chat_request, e.what());
   }
 }
 
 bool OpenAIClient::OnRawResponse(const std::string& resp, void* user_data) {
-  ChatContext* chat_context = reinterpret_cast<ChatContext*>(user_data);
+  OpenAIChatContext* chat_context =
+      reinterpret_cast<OpenAIChatContext*>(user_data);
   OpenAIClient* client = dynamic_cast<OpenAIClient*>(chat_context->client);
   return client->HandleResponse(resp, chat_context);
 }
 
 bool OpenAIClient::HandleResponse(const std::string& resp,
-                                  ChatContext* chat_context) {
+                                  OpenAIChatContext* chat_context) {
   std::shared_ptr<ChatRequest> req = chat_context->chat_context;
   try {
     std::vector<OpenAIResponseParser::ParseResult> tokens;
-    m_responseParser->Parse(resp,
-                            [&tokens](OpenAIResponseParser::ParseResult token) {
-                              tokens.push_back(std::move(token));
-                            });
+    chat_context->parser.Parse(
+        resp, [&tokens](OpenAIResponseParser::ParseResult token) {
+          tokens.push_back(std::move(token));
+        });
 
     bool cb_result{true};
     bool is_done{false};
@@ -119,7 +115,7 @@ bool OpenAIClient::HandleResponse(const std::string& resp,
         OLOG_INFO() << "Replacing history with compaction result!";
         // Replace the history with the compaction output
         auto output = token.GetCompactionOutput().value();
-        m_history.ClearAll();
+        CurrentHistory().ClearAll();
         assistant::message msg{output};
         AddMessage(std::move(msg), MessageType::kNormal);
         req->callback_(
@@ -171,7 +167,7 @@ bool OpenAIClient::HandleResponse(const std::string& resp,
     OLOG(LogLevel::kWarning)
         << "OpenAIClient::HandleResponse: got an exception. " << e.what();
     req->callback_(e.what(), Reason::kFatalError, false);
-    m_responseParser = std::make_unique<OpenAIResponseParser>();
+    chat_context->parser = OpenAIResponseParser();
     return false;  // close the current session.
   }
 }
@@ -190,7 +186,7 @@ void OpenAIClient::AddToolsResult(
 
     auto p = BuildToolResponseContent(fcall, reply);
     if (!p.second.empty()) {
-      m_pendingMessages.push_back(p.second);
+      CurrentPendingMessages().push_back(p.second);
     }
     tool_response["output"] = p.first;
     AddMessage(std::move(tool_response), MessageType::kToolResponse);
@@ -198,12 +194,12 @@ void OpenAIClient::AddToolsResult(
 }
 
 size_t OpenAIClient::Compact(size_t responses_to_keep) {
-  return m_history.Compact(
+  return CurrentHistory().Compact(
       [this](assistant::message& msg) {
         size_t tokens_trimmed{0};
         if (msg.contains("output") && msg["output"].is_string()) {
           size_t count =
-              assistant::CountTokens(msg["output"].get<std::string>());
+              CountTokens(msg["output"].get_ref<const std::string&>());
           if (count > kTrimMessageTokensCount) {
             msg["output"] = kTrimMessage;
             tokens_trimmed += (count - kTrimMessageTokensCount);
@@ -5,6 +5,11 @@
 
 namespace assistant {
 
+/// The state of a /v1/responses stream, one per turn.
+struct OpenAIChatContext : public ChatContext {
+  OpenAIResponseParser parser;
+};
+
 class OpenAIClient : public OllamaClient {
  public:
   OpenAIClient(const Endpoint& ep = OpenAIEndpoint{});
@@ -23,9 +28,7 @@ class OpenAIClient : public OllamaClient {
   static bool OnRawResponse(const std::string& resp, void* user_data);
   void ProcessChatRequest(std::shared_ptr<ChatRequest> chat_request) override;
   virtual bool HandleResponse(const std::string& resp,
-                              ChatContext* chat_context);
-
-  std::unique_ptr<OpenAIResponseParser> m_responseParser;
+                              OpenAIChatContext* chat_context);
 };
 
 }  // namespace assistant
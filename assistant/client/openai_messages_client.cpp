@@ -21,13 +21,14 @@ std::optional<ModelCapabilities> OpenAIMessagesClient::GetModelCapabilities(
 void OpenAIMessagesClient::ProcessChatRequest(
     std::shared_ptr<ChatRequest> chat_request) {
   // /v1/chat/completions uses standard "messages" format
-  // No conversion needed - messages stay as "messages"
+  chat_request->AttachMessages();
 
   // Tools are in standard OpenAI format for /v1/chat/completions
   // They should have the structure: {type: "function", function: {...}}
-  if (!m_function_table.IsEmpty() && chat_request->request_.contains("tools")) {
-    chat_request->request_["tools"] =
-        m_function_table.ToJSON(EndpointKind::moonshotai, GetCachingPolicy());
+  if (!m_function_table.IsEmpty() &&
+      chat_request->request_.has_member("tools")) {
+    m_function_table.AddToolsToRequest(
+        chat_request->request_, EndpointKind::moonshotai, GetCachingPolicy());
   }
 
   // Remove parameters unsupported by /v1/chat/completions
@@ -43,19 +44,17 @@ void OpenAIMessagesClient::ProcessChatRequest(
   }
 
   try {
-    m_responseParser = std::make_unique<chat_completions::ResponseParser>();
     std::string model_name = chat_request->request_["model"].get<std::string>();
 
     // Prepare chat user data.
-    ChatContext user_data{
-        .client = this,
-        .model = model_name,
-        .model_can_think = true,
-        .chat_context = chat_request,
-    };
+    ChatCompletionsContext user_data;
+    user_data.client = this;
+    user_data.model = model_name;
+    user_data.model_can_think = true;
+    user_data.chat_context = chat_request;
 
     {
-      auto client = CreateClient();
+      auto client = AcquireClient();
       SetInterruptClientLocker locker{this, client.get()};
       client->chat_raw_output(chat_request->request_,
                               &OpenAIMessagesClient::OnRawResponse,
@@ -67,28 +66,28 @@ void OpenAIMessagesClient::ProcessChatRequest(
       chat_request->func_calls_.clear();
     }
   } catch (std::exception& e) {
-    chat_request->callback_(e.what(), Reason::kFatalError, false);
-    Shutdown();
+    FailTurn(*chat_request, e.what());
   }
 }
 
 bool OpenAIMessagesClient::OnRawResponse(const std::string& resp,
                                          void* user_data) {
-  ChatContext* chat_context = reinterpret_cast<ChatContext*>(user_data);
+  ChatCompletionsContext* chat_context =
+      reinterpret_cast<ChatCompletionsContext*>(user_data);
   OpenAIMessagesClient* client =
       dynamic_cast<OpenAIMessagesClient*>(chat_context->client);
   return client->HandleResponse(resp, chat_context);
 }
 
-bool OpenAIMessagesClient::HandleResponse(const std::string& resp,
-                                          ChatContext* chat_context) {
+bool OpenAIMessagesClient::HandleResponse(
+    const std::string& resp, ChatCompletionsContext* chat_context) {
   std::shared_ptr<ChatRequest> req = chat_context->chat_context;
   try {
     std::vector<chat_completions::ParseResult> tokens;
-    m_responseParser->Parse(resp,
-                            [&tokens](chat_completions::ParseResult token) {
-                              tokens.push_back(std::move(token));
-                            });
+    chat_context->parser.Parse(
+        resp, [&tokens](chat_completions::ParseResult token) {
+          tokens.push_back(std::move(token));
+        });
 
     bool cb_result{true};
     bool is_done{false};
@@ -186,7 +185,7 @@ bool OpenAIMessagesClient::HandleResponse(const std::string& resp,
         << "OpenAIMessagesClient::HandleResponse: got an exception. "
         << e.what();
     req->callback_(e.what(), Reason::kFatalError, false);
-    m_responseParser = std::make_unique<chat_completions::ResponseParser>();
+    chat_context->parser = chat_completions::ResponseParser();
     return false;  // close the current session.
   }
 }
@@ -204,7 +203,7 @@ void OpenAIMessagesClient::AddToolsResult(
     assistant::message tool_response;
     auto p = BuildToolResponseContent(fcall, reply);
     if (!p.second.empty()) {
-      m_pendingMessages.push_back(p.second);
+      CurrentPendingMessages().push_back(p.second);
     }
     tool_response["role"] = "tool";
     tool_response["tool_call_id"] = fcall.invocation_id.value_or("");
@@ -214,12 +213,12 @@ void OpenAIMessagesClient::AddToolsResult(
 }
 
 size_t OpenAIMessagesClient::Compact(size_t responses_to_keep) {
-  return m_history.Compact(
+  return CurrentHistory().Compact(
       [this](assistant::message& msg) {
         size_t tokens_trimmed{0};
         if (msg.contains("content") && msg["content"].is_string()) {
           size_t count =
-              assistant::CountTokens(msg["content"].get<std::string>());
+              CountTokens(msg["content"].get_ref<const std::string&>());
           if (count > kTrimMessageTokensCount) {
             msg["content"] = kTrimMessage;
             tokens_trimmed += (count - kTrimMessageTokensCount);
@@ -235,55 +234,16 @@ void OpenAIMessagesClient::InvokeTools(std::shared_ptr<ChatRequest> request) {
     return;
   }
 
-  std::vector<std::string> extra_requests;
-  for (auto [msg, calls] : request->func_calls_) {
-    if (m_interrupt.load()) {
-      return;
-    }
-    AddMessage(std::move(msg), MessageType::kToolRequest);
-    for (auto func_call : calls) {
-      if (IsInterrupted()) {
-        OLOG(LogLevel::kWarning) << "User interrupted.";
-        return;
-      }
-      std::stringstream ss;
-      ss << "Invoking tool: '" << func_call.name << "', args:\n";
-      auto args = func_call.args.items();
-      for (const auto& [name, value] : args) {
-        ss << std::setw(2) << "  " << name << " => " << value << "\n";
-      }
-
-      request->callback_(ss.str(), Reason::kLogNotice, false);
-
-      FunctionResult result;
-
-      CanInvokeToolResult can_run_tool{.can_invoke = true};
-      auto res = GetFunctionTable().CanRunTool(func_call.name, func_call.args);
-      if (res.has_value()) {
-        can_run_tool = res.value();
-      } else if (m_on_invoke_tool_cb) {
-        // No function level human-in-the-loop method was registered,
-        // try the global method (client level)
-        can_run_tool = m_on_invoke_tool_cb(func_call.name, func_call.args);
-      }
-
-      if (!can_run_tool.IsAllowed()) {
-        result.isError = true;
-        result.text = can_run_tool.reason;
-        ss = {};
-        ss << "Failed to run tool: '" << func_call.name << "'.";
-        request->callback_(ss.str(), Reason::kToolDenied, false);
+  auto results = RunToolCalls(request);
+  if (!results.has_value()) {
+    return;
+  }
 
-      } else {
-        ss = {};
-        ss << "Permission to run tool: " << func_call.name << " is granted.";
-        request->callback_(ss.str(), Reason::kToolAllowed, false);
-        result = GetFunctionTable().Call(func_call);
-      }
-      ss = {};
-      ss << "Tool output: " << result;
-      request->callback_(ss.str(), Reason::kLogDebug, false);
-      AddToolsResult({{func_call, result}});
+  // Each tool request message must be followed by its own tool responses.
+  for (size_t i = 0; i < request->func_calls_.size(); ++i) {
+    AddMessage(request->func_calls_[i].first, MessageType::kToolRequest);
+    for (auto& call_result : results.value()[i]) {
+      AddToolsResult({std::move(call_result)});
     }
   }
   CreateAndPushChatRequest(std::nullopt, request->callback_, request->model_,
@@ -5,6 +5,11 @@
 
 namespace assistant {
 
+/// The state of a /v1/chat/completions stream, one per turn.
+struct ChatCompletionsContext : public ChatContext {
+  chat_completions::ResponseParser parser;
+};
+
 /**
  * OpenAI client that uses the /v1/chat/completions endpoint (Messages API)
  * instead of the /v1/responses endpoint.
@@ -29,9 +34,7 @@ class OpenAIMessagesClient : public OllamaClient {
   void InvokeTools(std::shared_ptr<ChatRequest> request) override;
   void ProcessChatRequest(std::shared_ptr<ChatRequest> chat_request) override;
   virtual bool HandleResponse(const std::string& resp,
-                              ChatContext* chat_context);
-
-  std::unique_ptr<chat_completions::ResponseParser> m_responseParser;
+                              ChatCompletionsContext* chat_context);
 };
 
 }  // namespace assistant
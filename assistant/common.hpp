@@ -1,9 +1,14 @@
 #pragma once
 
 #include <functional>
+#include <memory>
 #include <mutex>
 #include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
 #include <unordered_map>
+#include <utility>
 
 #include "assistant/attributes.hpp"
 #include "common/json.hpp"
@@ -35,16 +40,20 @@ class Locker {
   Locker(const Locker& other) = delete;
   Locker& operator=(const Locker& other) = delete;
 
-  /// Provide a write access to the underlying type.
-  void with_mut(std::function<void(ValueType&)> cb) {
+  /// Provide a write access to the underlying type. Returns the value
+  /// returned by `cb`.
+  template <typename Callback>
+  auto with_mut(Callback&& cb) {
     std::scoped_lock lk{m_mutex};
-    cb(m_value);
+    return std::forward<Callback>(cb)(m_value);
   }
 
-  /// Provide a read-only access to the underlying type.
-  void with(std::function<void(const ValueType&)> cb) const {
+  /// Provide a read-only access to the underlying type. Returns the value
+  /// returned by `cb`.
+  template <typename Callback>
+  auto with(Callback&& cb) const {
     std::scoped_lock lk{m_mutex};
-    cb(m_value);
+    return std::forward<Callback>(cb)(std::as_const(m_value));
   }
 
   /// Return a **copy of the value**
@@ -64,6 +73,75 @@ class Locker {
   ValueType m_value GUARDED_BY(m_mutex);
 };
 
+/// A Locker for values that are read on every request and rarely written
+/// (e.g. the endpoint). The value is an immutable snapshot: readers only hold
+/// the lock to copy the pointer and keep the snapshot alive for as long as
+/// they hold it, writers copy it, modify the copy and publish it.
+template <typename ValueType>
+class SnapshotLocker {
+ public:
+  template <typename... Args>
+  explicit SnapshotLocker(Args&&... args)
+      : m_value(
+            std::make_shared<const ValueType>(std::forward<Args>(args)...)) {}
+
+  SnapshotLocker(const SnapshotLocker& other) = delete;
+  SnapshotLocker& operator=(const SnapshotLocker& other) = delete;
+
+  /// Return the current snapshot of the value.
+  std::shared_ptr<const ValueType> load() const {
+    std::scoped_lock lk{m_mutex};
+    return m_value;
+  }
+
+  /// Modify a copy of the value, then publish it. Readers holding the
+  /// previous snapshot keep seeing it; nothing is published if `cb` throws.
+  /// Returns the value returned by `cb`.
+  template <typename Callback>
+  auto with_mut(Callback&& cb) {
+    std::scoped_lock lk{m_write_mutex};
+    auto value = std::make_shared<ValueType>(*load());
+    if constexpr (std::is_void_v<std::invoke_result_t<Callback, ValueType&>>) {
+      std::forward<Callback>(cb)(*value);
+      store(std::move(value));
+    } else {
+      auto result = std::forward<Callback>(cb)(*value);
+      store(std::move(value));
+      return result;
+    }
+  }
+
+  /// Provide a read-only access to the current snapshot. Returns the value
+  /// returned by `cb`.
+  template <typename Callback>
+  auto with(Callback&& cb) const {
+    auto value = load();
+    return std::forward<Callback>(cb)(*value);
+  }
+
+  /// Return a **copy of the value**
+  ValueType get_value() const { return *load(); }
+
+  /// set the value.
+  void set_value(ValueType value) {
+    std::scoped_lock lk{m_write_mutex};
+    store(std::make_shared<const ValueType>(std::move(value)));
+  }
+
+ private:
+  void store(std::shared_ptr<const ValueType> value) {
+    std::scoped_lock lk{m_mutex};
+    m_value.swap(value);
+    // The previous snapshot is released outside of the lock.
+  }
+
+  /// Serializes the writers.
+  std::mutex m_write_mutex;
+  /// Only held to copy or swap the pointer.
+  mutable std::mutex m_mutex;
+  std::shared_ptr<const ValueType> m_value GUARDED_BY(m_mutex);
+};
+
 enum class Reason {
   /// The current reason completed successfully.
   kDone,
@@ -120,6 +198,64 @@ enum class CachePolicy {
 using OnResponseCallback = std::function<bool(
     const std::string& text, Reason call_reason, bool thinking)>;
 
+/// Zero-copy variant of OnResponseCallback: `text` refers to the buffer of
+/// the streamed delta (or of the message) and is only valid during the call.
+using OnResponseViewCallback = std::function<bool(
+    std::string_view text, Reason call_reason, bool thinking)>;
+
+/// The response callback of a chat. Holds either an OnResponseViewCallback
+/// (any callable accepting a std::string_view) or an OnResponseCallback, so
+/// both can be passed to `Chat()`.
+///
+/// Invoking it with a std::string passes the string as is to both kinds of
+/// callbacks. Invoking it with a view only copies the text for an
+/// OnResponseCallback.
+class ResponseCallback {
+ public:
+  ResponseCallback() = default;
+
+  template <typename Callback,
+            typename = std::enable_if_t<
+                !std::is_same_v<std::decay_t<Callback>, ResponseCallback>>>
+  ResponseCallback(Callback&& cb) {
+    if constexpr (std::is_invocable_r_v<bool, Callback&, std::string_view,
+                                        Reason, bool>) {
+      m_view_callback = std::forward<Callback>(cb);
+    } else {
+      m_string_callback = std::forward<Callback>(cb);
+    }
+  }
+
+  bool operator()(const std::string& text, Reason call_reason,
+                  bool thinking) const {
+    if (m_view_callback) {
+      return m_view_callback(text, call_reason, thinking);
+    }
+    return !m_string_callback || m_string_callback(text, call_reason, thinking);
+  }
+
+  bool operator()(std::string_view text, Reason call_reason,
+                  bool thinking) const {
+    if (m_view_callback) {
+      return m_view_callback(text, call_reason, thinking);
+    }
+    return !m_string_callback ||
+           m_string_callback(std::string{text}, call_reason, thinking);
+  }
+
+  bool operator()(const char* text, Reason call_reason, bool thinking) const {
+    return (*this)(std::string_view{text}, call_reason, thinking);
+  }
+
+  explicit operator bool() const {
+    return m_view_callback || m_string_callback;
+  }
+
+ private:
+  OnResponseViewCallback m_view_callback;
+  OnResponseCallback m_string_callback;
+};
+
 /// Called when a tool is about to be invoked.
 struct CanInvokeToolResult {
   bool can_invoke{true};
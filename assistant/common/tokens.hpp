@@ -1,8 +1,21 @@
 #pragma once
 
 #include <algorithm>
+#include <bit>
 #include <cmath>
+#include <cstdint>
+#include <span>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define ASSISTANT_TOKENS_X86 1
+#endif
+
+#include "assistant/parallel.hpp"
 
 namespace assistant {
 // ---------------------------------------------------------------------------
@@ -18,8 +31,22 @@ namespace assistant {
 //   3. Add a fixed overhead for leading whitespace tokens.
 //
 // Typical accuracy: ±5% vs tiktoken on English prose, ±10% on mixed code.
+//
+// CountTokensScalar() is the reference implementation, one byte at a time.
+// CountTokens() gives the same results: it classifies 64 bytes at a time with
+// SIMD instructions (when available) and sums the tokens of the runs from
+// their boundaries.
 // ---------------------------------------------------------------------------
-inline size_t CountTokens(std::string_view text) {
+namespace detail {
+/// Apply a small empirical correction factor (tiktoken merges some pairs)
+/// Multiply by 0.85 to account for BPE merges that our heuristic misses.
+inline size_t ApplyMergeCorrection(size_t tokens) {
+  tokens = static_cast<size_t>(std::ceil(tokens * 0.85));
+  return tokens == 0 ? 1 : tokens;
+}
+}  // namespace detail
+
+inline size_t CountTokensScalar(std::string_view text) {
   if (text.empty()) return 0;
 
   size_t tokens = 0;
@@ -82,9 +109,269 @@ inline size_t CountTokens(std::string_view text) {
     ++i;
   }
 
-  // Apply a small empirical correction factor (tiktoken merges some pairs)
-  // Multiply by 0.85 to account for BPE merges that our heuristic misses.
-  tokens = static_cast<size_t>(std::ceil(tokens * 0.85));
-  return tokens == 0 ? 1 : tokens;
+  return detail::ApplyMergeCorrection(tokens);
+}
+
+namespace detail {
+
+/// The classes of the bytes of a block of (at most) 64 bytes, one bit per byte.
+/// The bytes that are in none of them are punctuation.
+struct ByteClasses {
+  /// ' ', '\t', '\n' and '\r'
+  uint64_t space{0};
+  /// '0' to '9'
+  uint64_t digit{0};
+  /// 'a' to 'z', 'A' to 'Z' and '_'
+  uint64_t alpha{0};
+  /// Bytes >= 0x80
+  uint64_t non_ascii{0};
+};
+
+inline ByteClasses ClassifyBytes(const char* data, size_t len) {
+  ByteClasses classes;
+  for (size_t i = 0; i < len; ++i) {
+    unsigned char c = static_cast<unsigned char>(data[i]);
+    uint64_t bit = uint64_t{1} << i;
+    if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+      classes.space |= bit;
+    } else if (c >= '0' && c <= '9') {
+      classes.digit |= bit;
+    } else if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_') {
+      classes.alpha |= bit;
+    } else if (c >= 0x80) {
+      classes.non_ascii |= bit;
+    }
+  }
+  return classes;
+}
+
+#ifdef ASSISTANT_TOKENS_X86
+/// Classify 64 bytes, 16 at a time (SSE2 is part of x86-64).
+inline ByteClasses ClassifyBytesSse2(const char* data) {
+  const __m128i space = _mm_set1_epi8(' ');
+  const __m128i tab = _mm_set1_epi8('\t');
+  const __m128i lf = _mm_set1_epi8('\n');
+  const __m128i cr = _mm_set1_epi8('\r');
+  const __m128i zero_char = _mm_set1_epi8('0');
+  const __m128i nine = _mm_set1_epi8(9);
+  const __m128i lower_bit = _mm_set1_epi8(0x20);
+  const __m128i a_char = _mm_set1_epi8('a');
+  const __m128i twenty_five = _mm_set1_epi8(25);
+  const __m128i underscore = _mm_set1_epi8('_');
+
+  ByteClasses classes;
+  for (size_t i = 0; i < 64; i += 16) {
+    __m128i c =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+    __m128i is_space = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(c, space), _mm_cmpeq_epi8(c, tab)),
+        _mm_or_si128(_mm_cmpeq_epi8(c, lf), _mm_cmpeq_epi8(c, cr)));
+    // Unsigned range checks: x <= max  <=>  max(x, max) == max
+    __m128i digit = _mm_sub_epi8(c, zero_char);
+    __m128i is_digit = _mm_cmpeq_epi8(_mm_max_epu8(digit, nine), nine);
+    __m128i letter = _mm_sub_epi8(_mm_or_si128(c, lower_bit), a_char);
+    __m128i is_alpha =
+        _mm_or_si128(_mm_cmpeq_epi8(_mm_max_epu8(letter, twenty_five),
+                                    twenty_five),
+                     _mm_cmpeq_epi8(c, underscore));
+    auto mask = [](__m128i m) {
+      return static_cast<uint64_t>(
+          static_cast<uint16_t>(_mm_movemask_epi8(m)));
+    };
+    classes.space |= mask(is_space) << i;
+    classes.digit |= mask(is_digit) << i;
+    classes.alpha |= mask(is_alpha) << i;
+    classes.non_ascii |= mask(c) << i;
+  }
+  return classes;
+}
+
+/// Classify 64 bytes, 32 at a time.
+__attribute__((target("avx2"))) inline ByteClasses ClassifyBytesAvx2(
+    const char* data) {
+  const __m256i space = _mm256_set1_epi8(' ');
+  const __m256i tab = _mm256_set1_epi8('\t');
+  const __m256i lf = _mm256_set1_epi8('\n');
+  const __m256i cr = _mm256_set1_epi8('\r');
+  const __m256i zero_char = _mm256_set1_epi8('0');
+  const __m256i nine = _mm256_set1_epi8(9);
+  const __m256i lower_bit = _mm256_set1_epi8(0x20);
+  const __m256i a_char = _mm256_set1_epi8('a');
+  const __m256i twenty_five = _mm256_set1_epi8(25);
+  const __m256i underscore = _mm256_set1_epi8('_');
+
+  ByteClasses classes;
+  for (size_t i = 0; i < 64; i += 32) {
+    __m256i c =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+    __m256i is_space = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(c, space),
+                        _mm256_cmpeq_epi8(c, tab)),
+        _mm256_or_si256(_mm256_cmpeq_epi8(c, lf), _mm256_cmpeq_epi8(c, cr)));
+    __m256i digit = _mm256_sub_epi8(c, zero_char);
+    __m256i is_digit = _mm256_cmpeq_epi8(_mm256_max_epu8(digit, nine), nine);
+    __m256i letter =
+        _mm256_sub_epi8(_mm256_or_si256(c, lower_bit), a_char);
+    __m256i is_alpha = _mm256_or_si256(
+        _mm256_cmpeq_epi8(_mm256_max_epu8(letter, twenty_five), twenty_five),
+        _mm256_cmpeq_epi8(c, underscore));
+    classes.space |= static_cast<uint64_t>(static_cast<uint32_t>(
+                         _mm256_movemask_epi8(is_space)))
+                     << i;
+    classes.digit |= static_cast<uint64_t>(static_cast<uint32_t>(
+                         _mm256_movemask_epi8(is_digit)))
+                     << i;
+    classes.alpha |= static_cast<uint64_t>(static_cast<uint32_t>(
+                         _mm256_movemask_epi8(is_alpha)))
+                     << i;
+    classes.non_ascii |=
+        static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(c)))
+        << i;
+  }
+  return classes;
+}
+#endif
+
+/// Extend every bit of `seeds` to the following bits of its run of ones in
+/// `runs` (`seeds` is a subset of `runs`).
+inline uint64_t FillRuns(uint64_t seeds, uint64_t runs) {
+  seeds |= (seeds << 1) & runs;
+  runs &= runs << 1;
+  seeds |= (seeds << 2) & runs;
+  runs &= runs << 2;
+  seeds |= (seeds << 4) & runs;
+  runs &= runs << 4;
+  seeds |= (seeds << 8) & runs;
+  runs &= runs << 8;
+  seeds |= (seeds << 16) & runs;
+  runs &= runs << 16;
+  seeds |= (seeds << 32) & runs;
+  return seeds;
+}
+
+/// Sums ceil(length / kBytesPerToken) over the runs of a class, which may
+/// span several blocks.
+template <size_t kBytesPerToken>
+struct RunTokens {
+  size_t tokens{0};
+  bool open{false};
+  size_t start{0};
+  /// The last byte of the previous block belongs to the class.
+  uint64_t carry{0};
+
+  void Add(uint64_t mask, size_t offset) {
+    uint64_t previous = (mask << 1) | carry;
+    uint64_t starts = mask & ~previous;
+    uint64_t stops = ~mask & previous;
+    carry = mask >> 63;
+    // Starts and stops alternate
+    while (starts | stops) {
+      if (!open) {
+        start = offset + std::countr_zero(starts);
+        starts &= starts - 1;
+        open = true;
+      } else {
+        size_t stop = offset + std::countr_zero(stops);
+        stops &= stops - 1;
+        tokens += (stop - start + kBytesPerToken - 1) / kBytesPerToken;
+        open = false;
+      }
+    }
+  }
+
+  void Finish(size_t end) {
+    if (open) {
+      tokens += (end - start + kBytesPerToken - 1) / kBytesPerToken;
+      open = false;
+    }
+  }
+};
+
+/// The heuristic of CountTokensScalar(), on blocks of 64 bytes classified by
+/// `classify`.
+template <typename Classify>
+inline size_t CountTokensInBlocks(std::string_view text, Classify classify) {
+  size_t tokens{0};
+  uint64_t space_carry{0};
+  RunTokens<2> non_ascii;
+  RunTokens<3> digits;
+  RunTokens<4> words;
+  const size_t n = text.size();
+  for (size_t offset = 0; offset < n; offset += 64) {
+    size_t len = std::min<size_t>(64, n - offset);
+    ByteClasses classes = len == 64
+                              ? classify(text.data() + offset)
+                              : ClassifyBytes(text.data() + offset, len);
+    uint64_t valid = len == 64 ? ~uint64_t{0} : (uint64_t{1} << len) - 1;
+
+    // A word starts with a letter and goes on with letters and digits. The
+    // digits before the first letter are a numeric run.
+    uint64_t word_chars = classes.alpha | classes.digit;
+    uint64_t word = FillRuns(classes.alpha | (word_chars & words.carry),
+                             word_chars);
+    uint64_t number = word_chars & ~word;
+    uint64_t punctuation =
+        valid & ~(classes.space | word_chars | classes.non_ascii);
+
+    tokens += std::popcount(punctuation);
+    tokens += std::popcount(classes.space &
+                            ~((classes.space << 1) | space_carry));
+    space_carry = classes.space >> 63;
+    non_ascii.Add(classes.non_ascii, offset);
+    digits.Add(number, offset);
+    words.Add(word, offset);
+  }
+  non_ascii.Finish(n);
+  digits.Finish(n);
+  words.Finish(n);
+  return tokens + non_ascii.tokens + digits.tokens + words.tokens;
+}
+
+#ifdef ASSISTANT_TOKENS_X86
+__attribute__((target("avx2"))) inline size_t CountTokensAvx2(
+    std::string_view text) {
+  return CountTokensInBlocks(
+      text, [](const char* data) { return ClassifyBytesAvx2(data); });
+}
+
+inline size_t CountTokensSse2(std::string_view text) {
+  return CountTokensInBlocks(
+      text, [](const char* data) { return ClassifyBytesSse2(data); });
+}
+#endif
+}  // namespace detail
+
+/// Estimate the number of tokens of `text`, see above.
+inline size_t CountTokens(std::string_view text) {
+  if (text.empty()) return 0;
+  // Short texts are not worth the setup of the blocks.
+  if (text.size() < 64) return CountTokensScalar(text);
+#ifdef ASSISTANT_TOKENS_X86
+  static const bool kHasAvx2 = __builtin_cpu_supports("avx2");
+  return detail::ApplyMergeCorrection(kHasAvx2 ? detail::CountTokensAvx2(text)
+                                               : detail::CountTokensSse2(text));
+#else
+  return detail::ApplyMergeCorrection(detail::CountTokensInBlocks(
+      text, [](const char* data) { return detail::ClassifyBytes(data, 64); }));
+#endif
+}
+
+/// Estimate the number of tokens of each of `texts`. Batches of more than 1MB
+/// are counted on several threads.
+inline std::vector<size_t> CountTokens(
+    std::span<const std::string_view> texts,
+    size_t max_workers = std::thread::hardware_concurrency()) {
+  constexpr size_t kBytesPerWorker = 512 * 1024;
+  size_t total_bytes{0};
+  for (auto text : texts) {
+    total_bytes += text.size();
+  }
+
+  std::vector<size_t> counts(texts.size());
+  size_t workers = std::min(max_workers, total_bytes / kBytesPerWorker);
+  ParallelFor(texts.size(), workers, [&texts, &counts](size_t i) {
+    counts[i] = CountTokens(texts[i]);
+  });
+  return counts;
 }
 }  // namespace assistant
@@ -83,8 +83,8 @@ ParseResult ConfigBuilder::FromContent(const std::string& content,
     Config config;
 
     EnvExpander expander;
-    json parsed_data = json::parse(content);
-    auto result = expander.ExpandWithResult(parsed_data, map);
+    auto result =
+        expander.ExpandWithResult(json::parse(content), std::move(map));
     if (!result.IsSuccess()) {
       std::ostringstream errmsg;
       errmsg << "Failed to resolve environment variables from input json. "
@@ -92,7 +92,7 @@ ParseResult ConfigBuilder::FromContent(const std::string& content,
       // Log an error and continue
       OLOG_WARN() << errmsg.str();
     }
-    parsed_data = result.GetJson();
+    json& parsed_data = result.GetJson();
     if (parsed_data.contains("mcp_servers")) {
       // MCP servers
       auto mcp_servers = parsed_data["mcp_servers"];
@@ -106,6 +106,12 @@ ParseResult ConfigBuilder::FromContent(const std::string& content,
             GetValueFromJsonOneOf<std::string>(
                 server, "type", {kServerKindStdio, kServerKindSse})
                 .value_or(std::string{kServerKindStdio});
+        auto startup_timeout =
+            GetValueFromJson<int>(server, "startup_timeout_msecs");
+        if (startup_timeout.has_value() && startup_timeout.value() > 0) {
+          server_config.startup_timeout =
+              std::chrono::milliseconds(startup_timeout.value());
+        }
 
         // Read config per type
         if (type == kServerKindStdio) {
@@ -238,6 +244,12 @@ ParseResult ConfigBuilder::FromContent(const std::string& content,
               endpoint->context_size_.value() / 2;
         }  // else use kDefaultAutoCompactThreshold
 
+        if (endpoint_json.contains("client_compact_threshold") &&
+            endpoint_json["client_compact_threshold"].is_number_unsigned()) {
+          endpoint->client_compact_threshold_ =
+              endpoint_json["client_compact_threshold"].get<size_t>();
+        }
+
         if (endpoint_json.contains("thinking") &&
             endpoint_json["thinking"].is_boolean()) {
           endpoint->thinking_ = endpoint_json["thinking"].get<bool>();
@@ -312,6 +324,19 @@ ParseResult ConfigBuilder::FromContent(const std::string& content,
 
     OLOG(LogLevel::kInfo) << "Timeout settings:" << config.m_server_timeout;
 
+    if (parsed_data.contains("model_cache") &&
+        parsed_data["model_cache"].is_object()) {
+      auto model_cache = parsed_data["model_cache"];
+      if (model_cache.contains("file") && model_cache["file"].is_string()) {
+        config.m_model_cache.file_ = model_cache["file"].get<std::string>();
+      }
+      if (model_cache.contains("ttl_secs") &&
+          model_cache["ttl_secs"].is_number_unsigned()) {
+        config.m_model_cache.ttl_ =
+            std::chrono::seconds{model_cache["ttl_secs"].get<int64_t>()};
+      }
+    }
+
     // Make sure we have exactly 1 active endpoint.
     bool found_active{false};
     for (auto endpoint : config.endpoints_) {
@@ -347,6 +372,11 @@ ParseResult ConfigBuilder::FromContent(const std::string& content,
     if (parsed_data.contains("stream") && parsed_data["stream"].is_boolean()) {
       config.m_stream = parsed_data["stream"].get<bool>();
     }
+    if (parsed_data.contains("max_parallel_tool_calls") &&
+        parsed_data["max_parallel_tool_calls"].is_number_unsigned()) {
+      config.m_max_parallel_tool_calls =
+          parsed_data["max_parallel_tool_calls"].get<size_t>();
+    }
 
     for (const auto& mcp_server : config.m_servers) {
       OLOG(OLogLevel::kInfo) << "Loaded MCP server: " << mcp_server;
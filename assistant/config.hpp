@@ -7,6 +7,7 @@
 #include "assistant/EnvExpander.hpp"
 #include "assistant/helpers.hpp"
 #include "assistant/mcp.hpp"
+#include "assistant/model_cache.hpp"
 #include "common/magic_enum.hpp"
 
 namespace assistant {
@@ -33,6 +34,8 @@ struct MCPServerConfig {
   bool enabled{true};
   std::optional<StdioParams> stdio_params;
   std::optional<SseParams> sse_params;
+  /// How long the server may take to start and list its tools.
+  std::chrono::milliseconds startup_timeout{kMCPStartupTimeoutDefault};
   inline bool IsStdio() const { return stdio_params.has_value(); }
   inline bool IsSse() const { return sse_params.has_value(); }
 };
@@ -41,7 +44,8 @@ inline std::ostream& operator<<(std::ostream& os, const MCPServerConfig& mcp) {
   if (mcp.stdio_params.has_value()) {
     const auto& params = mcp.stdio_params.value();
     os << "MCPServerConfig(STDIO) {name: " << mcp.name
-       << ", enabled: " << mcp.enabled << ", command: " << params.args;
+       << ", enabled: " << mcp.enabled << ", command: " << params.args
+       << ", startup_timeout: " << mcp.startup_timeout.count() << "ms";
     if (params.env.has_value()) {
       os << ", env: " << params.env.value().dump(2);
     }
@@ -50,7 +54,8 @@ inline std::ostream& operator<<(std::ostream& os, const MCPServerConfig& mcp) {
     const auto& params = mcp.sse_params.value();
     os << "MCPServerConfig(SSE) {name: " << mcp.name
        << ", enabled: " << mcp.enabled << ", baseurl: " << params.baseurl
-       << ", endpoint: " << params.endpoint;
+       << ", endpoint: " << params.endpoint
+       << ", startup_timeout: " << mcp.startup_timeout.count() << "ms";
     if (params.headers.has_value()) {
       os << ", headers: " << params.headers.value().dump(2);
     }
@@ -112,11 +117,13 @@ struct Endpoint {
   std::optional<size_t> context_size_{kDefaultContextSize};
   bool verify_server_ssl_{true};
   TransportType transport_{TransportType::httplib};
-  /// Client-side auto-compaction threshold (in estimated tokens). When the
-  /// accumulated token count across messages exceeds this value,
-  /// CompactIfNeeded() trims old tool-response messages from the local history.
-  /// Set to 0 to disable client-side auto-compaction entirely.
+  /// Server-side compaction threshold (in input tokens), sent as the OpenAI
+  /// `context_management.compact_threshold`. Set to 0 to disable it.
   size_t auto_compact_threshold_{kDefaultAutoCompactThreshold};
+  /// Client-side compaction threshold (in estimated tokens). When the history
+  /// exceeds it, a chat turn first replaces the older tool responses of the
+  /// local history with a trim message. 0 (the default) disables it.
+  size_t client_compact_threshold_{0};
   /// Anthropic/OpenAI: server-side compaction settings. Disabled by default.
   ServerCompaction server_compaction_;
 };
@@ -207,6 +214,15 @@ inline std::ostream& operator<<(std::ostream& os, const ServerTimeout& t) {
   return os;
 }
 
+/// Settings of the model capabilities cache ("model_cache").
+struct ModelCacheSettings {
+  /// The file where the capabilities are kept between runs. Empty: the
+  /// capabilities are only cached in memory.
+  std::string file_;
+  /// How long the capabilities of a model are trusted.
+  std::chrono::seconds ttl_{kModelCacheTTLDefault};
+};
+
 class Config {
  public:
   ~Config() = default;
@@ -235,7 +251,11 @@ class Config {
   }
 
   const std::string& GetKeepAlive() const { return m_keep_alive; }
+  const ModelCacheSettings& GetModelCacheSettings() const {
+    return m_model_cache;
+  }
   bool IsStream() const { return m_stream; }
+  size_t GetMaxParallelToolCalls() const { return m_max_parallel_tool_calls; }
   inline ServerTimeout GetServerTimeoutSettings() const {
     return m_server_timeout;
   }
@@ -250,7 +270,9 @@ class Config {
   LogLevel m_logLevel{LogLevel::kInfo};
   std::string m_keep_alive{"5m"};
   bool m_stream{true};
+  size_t m_max_parallel_tool_calls{1};
   ServerTimeout m_server_timeout;
+  ModelCacheSettings m_model_cache;
   std::vector<std::shared_ptr<Endpoint>> endpoints_;
   friend class ConfigBuilder;
 };
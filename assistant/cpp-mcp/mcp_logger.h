@@ -65,8 +65,26 @@ class logger {
     log_impl(ss, std::forward<Args>(args)...);
   }
 
+  static assistant::LogLevel to_assistant_level(log_level level) {
+    switch (level) {
+      case log_level::debug:
+        return assistant::LogLevel::kDebug;
+      case log_level::info:
+        return assistant::LogLevel::kInfo;
+      case log_level::warning:
+        return assistant::LogLevel::kWarning;
+      case log_level::error:
+        break;
+    }
+    return assistant::LogLevel::kError;
+  }
+
   template <typename... Args>
   void log(log_level level, Args&&... args) {
+    // Do not format messages that the assistant logger would drop.
+    if (!assistant::IsLogEnabled(to_assistant_level(level))) {
+      return;
+    }
     std::stringstream ss;
 
     // Add log content
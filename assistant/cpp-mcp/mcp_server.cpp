@@ -10,6 +10,82 @@
 
 namespace mcp {
 
+namespace {
+// Runs every HTTP connection on its own worker, like httplib::ThreadPool, but
+// starts the workers on demand and lets the idle ones exit. An SSE session
+// holds its worker for as long as it is connected: with a fixed pool, the
+// pool size would cap the number of sessions.
+class connection_task_queue : public httplib::TaskQueue {
+ public:
+  connection_task_queue(size_t min_workers, size_t max_workers,
+                        std::chrono::seconds idle_timeout)
+      : min_workers_(min_workers),
+        max_workers_(max_workers),
+        idle_timeout_(idle_timeout) {}
+
+  bool enqueue(std::function<void()> fn) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (shutdown_) {
+      return false;
+    }
+
+    jobs_.push_back(std::move(fn));
+    if (jobs_.size() > idle_ && workers_ < max_workers_) {
+      ++workers_;
+      std::thread(&connection_task_queue::work, this).detach();
+    }
+    cv_.notify_one();
+    return true;
+  }
+
+  void shutdown() override {
+    std::unique_lock<std::mutex> lock(mutex_);
+    shutdown_ = true;
+    cv_.notify_all();
+    done_cv_.wait(lock, [this] { return workers_ == 0; });
+  }
+
+ private:
+  void work() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      ++idle_;
+      bool woken = cv_.wait_for(lock, idle_timeout_, [this] {
+        return shutdown_ || !jobs_.empty();
+      });
+      --idle_;
+
+      if (jobs_.empty()) {
+        if (shutdown_ || (!woken && workers_ > min_workers_)) {
+          break;
+        }
+        continue;
+      }
+
+      auto job = std::move(jobs_.front());
+      jobs_.pop_front();
+      lock.unlock();
+      job();
+      lock.lock();
+    }
+
+    --workers_;
+    done_cv_.notify_all();
+  }
+
+  const size_t min_workers_;
+  const size_t max_workers_;
+  const std::chrono::seconds idle_timeout_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::condition_variable done_cv_;
+  std::deque<std::function<void()>> jobs_;
+  size_t workers_ = 0;
+  size_t idle_ = 0;
+  bool shutdown_ = false;
+};
+}  // namespace
+
 server::server(const std::string& host, int port, const std::string& name,
                const std::string& version, const std::string& sse_endpoint,
                const std::string& msg_endpoint)
@@ -20,6 +96,10 @@ server::server(const std::string& host, int port, const std::string& name,
       sse_endpoint_(sse_endpoint),
       msg_endpoint_(msg_endpoint) {
   http_server_ = std::make_unique<httplib::Server>();
+  http_server_->new_task_queue = [] {
+    return new connection_task_queue(CPPHTTPLIB_THREAD_POOL_COUNT, 4096,
+                                     std::chrono::seconds(30));
+  };
 }
 
 server::~server() { stop(); }
@@ -56,23 +136,12 @@ bool server::start(bool blocking) {
                  " HTTP/1.1\" ", res.status);
   });
 
-  // Start resource check thread (only start in non-blocking mode)
-  if (!blocking) {
-    maintenance_thread_ = std::make_unique<std::thread>([this]() {
-      while (running_) {
-        // Check inactive sessions every 60 seconds
-        std::this_thread::sleep_for(std::chrono::seconds(60));
-        if (running_) {
-          try {
-            check_inactive_sessions();
-          } catch (const std::exception& e) {
-            MCP_LOG_ERROR("Exception in maintenance thread: ", e.what());
-          } catch (...) {
-            MCP_LOG_ERROR("Unknown exception in maintenance thread");
-          }
-        }
-      }
-    });
+  // Check the inactive sessions every 60 seconds. The timers may have been
+  // stopped by a previous stop().
+  timers_.start();
+  if (!schedule_inactive_check()) {
+    MCP_LOG_ERROR("Failed to schedule the inactive sessions check");
+    return false;
   }
 
   // Start server
@@ -108,124 +177,32 @@ void server::stop() {
   MCP_LOG_INFO("Stopping MCP server on ", host_, ":", port_);
   running_ = false;
 
-  // Close maintenance thread
-  if (maintenance_thread_ && maintenance_thread_->joinable()) {
-    try {
-      maintenance_thread_->join();
-    } catch (...) {
-      maintenance_thread_->detach();
-    }
-  }
+  // No heartbeat or session check runs after this
+  timers_.stop();
 
-  // Copy all dispatchers and threads to avoid holding the lock for too long
   std::vector<std::shared_ptr<event_dispatcher>> dispatchers_to_close;
-  std::vector<std::unique_ptr<std::thread>> threads_to_join;
-
   {
     std::lock_guard<std::mutex> lock(mutex_);
-
-    // Copy all dispatchers
     dispatchers_to_close.reserve(session_dispatchers_.size());
     for (const auto& [_, dispatcher] : session_dispatchers_) {
       dispatchers_to_close.push_back(dispatcher);
     }
-
-    // Copy all threads
-    threads_to_join.reserve(sse_threads_.size());
-    for (auto& [_, thread] : sse_threads_) {
-      if (thread && thread->joinable()) {
-        threads_to_join.push_back(std::move(thread));
-      }
-    }
-
-    // Clear the maps
     session_dispatchers_.clear();
-    sse_threads_.clear();
     session_initialized_.clear();
   }
 
-  // Close all sessions
-  for (const auto& [session_id, _] : session_dispatchers_) {
-    close_session(session_id);
-  }
-
-  // Give threads some time to handle close events
-  std::this_thread::sleep_for(std::chrono::milliseconds(300));
-
-  // Wait for threads to finish outside the lock (with timeout limit)
-  const auto timeout_point =
-      std::chrono::steady_clock::now() + std::chrono::seconds(2);
-
-  for (auto& thread : threads_to_join) {
-    if (!thread || !thread->joinable()) {
-      continue;
-    }
-
-    if (std::chrono::steady_clock::now() >= timeout_point) {
-      // If timeout reached, detach remaining threads
-      MCP_LOG_WARN("Thread join timeout reached, detaching remaining threads");
-      thread->detach();
-      continue;
-    }
-
-    // Try using timeout join
-    bool joined = false;
-    try {
-      // Create future and promise for timeout join
-      std::promise<void> thread_done;
-      auto future = thread_done.get_future();
-
-      // Try join in another thread
-      std::thread join_helper([&thread, &thread_done]() {
-        try {
-          thread->join();
-          thread_done.set_value();
-        } catch (...) {
-          try {
-            thread_done.set_exception(std::current_exception());
-          } catch (...) {
-          }
-        }
-      });
-
-      // Wait for join to complete or timeout
-      if (future.wait_for(std::chrono::milliseconds(100)) ==
-          std::future_status::ready) {
-        future.get();  // Get possible exception
-        joined = true;
-      }
-
-      // Process join_helper thread
-      if (join_helper.joinable()) {
-        if (joined) {
-          join_helper.join();
-        } else {
-          join_helper.detach();
-        }
-      }
-    } catch (...) {
-      joined = false;
-    }
-
-    // If join fails, then detach
-    if (!joined) {
-      try {
-        thread->detach();
-      } catch (...) {
-        // Ignore exceptions
-      }
-    }
+  // Close all sessions: this ends their SSE responses
+  for (const auto& dispatcher : dispatchers_to_close) {
+    dispatcher->close();
   }
 
+  http_server_->stop();
   if (server_thread_ && server_thread_->joinable()) {
-    http_server_->stop();
     try {
       server_thread_->join();
     } catch (...) {
       server_thread_->detach();
     }
-  } else {
-    http_server_->stop();
   }
 
   MCP_LOG_INFO("MCP server stopped");
@@ -435,65 +412,14 @@ void server::handle_sse(const httplib::Request& req, httplib::Response& res) {
     session_dispatchers_[session_id] = session_dispatcher;
   }
 
-  // Create session thread
-  auto thread = std::make_unique<std::thread>([this, res, session_id,
-                                               session_uri,
-                                               session_dispatcher]() {
-    try {
-      // Send initial session URI
-      std::this_thread::sleep_for(std::chrono::milliseconds(500));
-      std::stringstream ss;
-      ss << "event: endpoint\r\ndata: " << session_uri << "\r\n\r\n";
-      session_dispatcher->send_event(ss.str());
-
-      // Update activity time (after sending message)
-      session_dispatcher->update_activity();
-
-      // Send periodic heartbeats to detect connection status
-      int heartbeat_count = 0;
-      while (running_ && !session_dispatcher->is_closed()) {
-        std::this_thread::sleep_for(
-            std::chrono::seconds(5) +
-            std::chrono::milliseconds(rand() %
-                                      500));  // NOTE: DO NOT set it the same as
-                                              // the timeout of wait_event
-
-        if (session_dispatcher->is_closed() || !running_) {
-          break;
-        }
-
-        std::stringstream heartbeat;
-        heartbeat << "event: heartbeat\r\ndata: " << heartbeat_count++
-                  << "\r\n\r\n";
-
-        try {
-          bool sent = session_dispatcher->send_event(heartbeat.str());
-          if (!sent) {
-            MCP_LOG_WARN(
-                "Failed to send heartbeat, client may have closed connection: ",
-                session_id);
-            break;
-          }
-
-          // Update activity time (heartbeat successful)
-          session_dispatcher->update_activity();
-        } catch (const std::exception& e) {
-          MCP_LOG_ERROR("Failed to send heartbeat: ", e.what());
-          break;
-        }
-      }
-    } catch (const std::exception& e) {
-      MCP_LOG_ERROR("SSE session thread exception: ", session_id, ", ",
-                    e.what());
-    }
-
-    close_session(session_id);
-  });
+  // Send the session URI. It is queued until the content provider starts.
+  std::stringstream ss;
+  ss << "event: endpoint\r\ndata: " << session_uri << "\r\n\r\n";
+  session_dispatcher->send_event(ss.str());
 
-  // Store thread
-  {
-    std::lock_guard<std::mutex> lock(mutex_);
-    sse_threads_[session_id] = std::move(thread);
+  // Send periodic heartbeats to detect connection status
+  if (!schedule_heartbeat(session_id, session_dispatcher, 0)) {
+    MCP_LOG_WARN("Failed to schedule the heartbeats of session: ", session_id);
   }
 
   // Setup chunked content provider
@@ -513,8 +439,10 @@ void server::handle_sse(const httplib::Request& req, httplib::Response& res) {
           // Wait for event
           bool result = session_dispatcher->wait_event(&sink);
           if (!result) {
-            MCP_LOG_WARN("Failed to wait for event, closing connection: ",
-                         session_id);
+            if (!session_dispatcher->is_closed()) {
+              MCP_LOG_WARN("Failed to wait for event, closing connection: ",
+                           session_id);
+            }
 
             close_session(session_id);
 
@@ -532,6 +460,13 @@ void server::handle_sse(const httplib::Request& req, httplib::Response& res) {
 
           return false;
         }
+      },
+      [this, session_id, session_dispatcher](bool /* success */) {
+        // The response ended, e.g. the client disconnected: close the
+        // session unless that is already done
+        if (!session_dispatcher->is_closed()) {
+          close_session(session_id);
+        }
       });
 }
 
@@ -623,7 +558,7 @@ void server::handle_jsonrpc(const httplib::Request& req,
   // code
   if (mcp_req.is_notification()) {
     // Process it asynchronously in the thread pool
-    thread_pool_.enqueue([this, mcp_req, session_id]() {
+    dispatch(mcp_req.method, [this, mcp_req, session_id]() {
       process_request(mcp_req, session_id);
     });
 
@@ -635,7 +570,7 @@ void server::handle_jsonrpc(const httplib::Request& req,
 
   // For requests with ID, process it asynchronously in the thread pool and
   // return the result via SSE
-  thread_pool_.enqueue([this, mcp_req, session_id, dispatcher]() {
+  dispatch(mcp_req.method, [this, mcp_req, session_id, dispatcher]() {
     // Process the request
     json response_json = process_request(mcp_req, session_id);
 
@@ -645,7 +580,9 @@ void server::handle_jsonrpc(const httplib::Request& req,
     bool result = dispatcher->send_event(ss.str());
 
     if (!result) {
-      MCP_LOG_ERROR("Failed to send response via SSE: session_id=", session_id);
+      MCP_LOG_ERROR("Failed to send response via SSE: session_id=", session_id,
+                    ", closed=", dispatcher->is_closed(),
+                    ", dropped=", dispatcher->dropped_events());
     }
   });
 
@@ -654,6 +591,65 @@ void server::handle_jsonrpc(const httplib::Request& req,
   res.set_content("Accepted", "text/plain");
 }
 
+void server::set_method_concurrency(const std::string& method, size_t limit) {
+  std::lock_guard<std::mutex> lock(gates_mutex_);
+  method_gates_[method].limit = limit;
+}
+
+void server::dispatch(const std::string& method, std::function<void()> task) {
+  bool gated = false;
+  {
+    std::lock_guard<std::mutex> lock(gates_mutex_);
+    auto it = method_gates_.find(method);
+    if (it != method_gates_.end() && it->second.limit > 0) {
+      auto& gate = it->second;
+      if (gate.running >= gate.limit) {
+        // Wait for a running request of this method to hand over its slot
+        gate.waiting.push_back(std::move(task));
+        return;
+      }
+      ++gate.running;
+      gated = true;
+    }
+  }
+
+  if (!gated) {
+    thread_pool_.enqueue(std::move(task));
+    return;
+  }
+  thread_pool_.enqueue([this, method, task = std::move(task)]() {
+    run_gated(method, task);
+  });
+}
+
+void server::run_gated(const std::string& method,
+                       const std::function<void()>& task) {
+  try {
+    task();
+  } catch (const std::exception& e) {
+    MCP_LOG_ERROR("Exception in request task: ", e.what());
+  } catch (...) {
+    MCP_LOG_ERROR("Unknown exception in request task");
+  }
+
+  std::function<void()> next;
+  {
+    std::lock_guard<std::mutex> lock(gates_mutex_);
+    auto& gate = method_gates_[method];
+    if (gate.waiting.empty()) {
+      --gate.running;
+      return;
+    }
+    next = std::move(gate.waiting.front());
+    gate.waiting.pop_front();
+  }
+
+  // The slot passes to the next waiting request as a continuation
+  thread_pool_.enqueue([this, method, next = std::move(next)]() {
+    run_gated(method, next);
+  });
+}
+
 json server::process_request(const request& req,
                              const std::string& session_id) {
   // Check if it is a notification
@@ -693,13 +689,11 @@ json server::process_request(const request& req,
     }
 
     if (handler) {
-      // Call handler
+      // Call handler. This already runs on a worker of the thread pool:
+      // queueing the handler and waiting for it would block this worker, and
+      // deadlock once every worker waits.
       MCP_LOG_INFO("Calling method handler: ", req.method);
-      auto future = thread_pool_.enqueue(
-          [handler, params = req.params, session_id]() -> json {
-            return handler(params, session_id);
-          });
-      json result = future.get();
+      json result = handler(req.params, session_id);
 
       // Create success response
       MCP_LOG_INFO("Method call successful: ", req.method);
@@ -902,6 +896,46 @@ std::string server::generate_session_id() const {
   return ss.str();
 }
 
+bool server::schedule_heartbeat(const std::string& session_id,
+                                std::weak_ptr<event_dispatcher> dispatcher,
+                                int heartbeat_count) {
+  // NOTE: DO NOT set it the same as the timeout of wait_event
+  auto delay = std::chrono::seconds(5) + std::chrono::milliseconds(rand() % 500);
+  auto send_heartbeat = [this, session_id, dispatcher, heartbeat_count]() {
+    auto session_dispatcher = dispatcher.lock();
+    if (!running_ || !session_dispatcher || session_dispatcher->is_closed()) {
+      return;
+    }
+
+    // Pending events keep the connection alive on their own
+    if (session_dispatcher->pending_events() == 0) {
+      std::stringstream heartbeat;
+      heartbeat << "event: heartbeat\r\ndata: " << heartbeat_count
+                << "\r\n\r\n";
+      if (!session_dispatcher->send_event(heartbeat.str())) {
+        MCP_LOG_WARN(
+            "Failed to send heartbeat, client may have closed connection: ",
+            session_id);
+        close_session(session_id);
+        return;
+      }
+
+      // Update activity time (heartbeat successful)
+      session_dispatcher->update_activity();
+    }
+
+    schedule_heartbeat(session_id, dispatcher, heartbeat_count + 1);
+  };
+  return timers_.schedule(delay, std::move(send_heartbeat));
+}
+
+bool server::schedule_inactive_check() {
+  return timers_.schedule(std::chrono::seconds(60), [this]() {
+    check_inactive_sessions();
+    schedule_inactive_check();
+  });
+}
+
 void server::check_inactive_sessions() {
   if (!running_) return;
 
@@ -942,7 +976,6 @@ void server::close_session(const std::string& session_id) {
 
     // Copy resources to be processed
     std::shared_ptr<event_dispatcher> dispatcher_to_close;
-    std::unique_ptr<std::thread> thread_to_release;
 
     {
       std::lock_guard<std::mutex> lock(mutex_);
@@ -954,13 +987,6 @@ void server::close_session(const std::string& session_id) {
         session_dispatchers_.erase(dispatcher_it);
       }
 
-      // Get thread pointer
-      auto thread_it = sse_threads_.find(session_id);
-      if (thread_it != sse_threads_.end()) {
-        thread_to_release = std::move(thread_it->second);
-        sse_threads_.erase(thread_it);
-      }
-
       // Clean up initialization status
       session_initialized_.erase(session_id);
     }
@@ -969,11 +995,6 @@ void server::close_session(const std::string& session_id) {
     if (dispatcher_to_close && !dispatcher_to_close->is_closed()) {
       dispatcher_to_close->close();
     }
-
-    // Release thread resources
-    if (thread_to_release) {
-      thread_to_release.release();
-    }
   } catch (const std::exception& e) {
     MCP_LOG_WARN("Exception while cleaning up session resources: ", session_id,
                  ", ", e.what());
@@ -13,6 +13,7 @@
 #include "mcp_resource.h"
 #include "mcp_tool.h"
 #include "mcp_thread_pool.h"
+#include "mcp_timer_wheel.h"
 #include "mcp_logger.h"
 
 // Include the HTTP library
@@ -29,6 +30,7 @@
 #include <condition_variable>
 #include <future>
 #include <atomic>
+#include <deque>
 
 
 namespace mcp {
@@ -39,57 +41,71 @@ using notification_handler = std::function<void(const json&, const std::string&)
 using auth_handler = std::function<bool(const std::string&, const std::string&)>;
 using session_cleanup_handler = std::function<void(const std::string&)>;
 
+/**
+ * @class event_dispatcher
+ * @brief Bounded queue of the SSE events of one session
+ *
+ * Any thread may send events (the request workers, the heartbeat thread);
+ * a single consumer, the SSE content provider, drains them. The events are
+ * kept in a ring of `capacity` slots, and `wait_event` writes every pending
+ * event with one `sink->write`, so a burst of responses costs one wake-up
+ * and one write instead of one of each per event.
+ *
+ * When the ring is full, `send_event` waits up to `send_timeout` for the
+ * consumer to make room. If it does not, the event is dropped and counted
+ * in `dropped_events()`: this is the backpressure signal of a session whose
+ * client does not keep up.
+ */
 class event_dispatcher {
 public:
-    event_dispatcher() {
-        message_.reserve(128); // Pre-allocate space for messages
+    explicit event_dispatcher(size_t capacity = 1024,
+                              std::chrono::milliseconds send_timeout = std::chrono::milliseconds(5000))
+        : ring_(capacity > 0 ? capacity : 1), send_timeout_(send_timeout) {
     }
     
     ~event_dispatcher() {
         close();
     }
 
+    /**
+     * @brief Wait for events and write all the pending ones to `sink`
+     * @param sink The sink of the SSE response
+     * @param timeout How long to wait for an event
+     * @return False if the dispatcher is closed, the wait timed out or the
+     * write failed
+     */
     bool wait_event(httplib::DataSink* sink, const std::chrono::milliseconds& timeout = std::chrono::milliseconds(10000)) {
         if (!sink || closed_.load(std::memory_order_acquire)) {
             return false;
         }
         
-        std::string message_copy;
+        batch_.clear();
         {
             std::unique_lock<std::mutex> lk(m_);
             
-            if (closed_.load(std::memory_order_acquire)) {
-                return false;
-            }
-            
-            int id = id_.load(std::memory_order_relaxed);
-            
             bool result = cv_.wait_for(lk, timeout, [&] { 
-                return cid_.load(std::memory_order_relaxed) == id || closed_.load(std::memory_order_acquire); 
+                return count_ > 0 || closed_.load(std::memory_order_acquire); 
             });
             
-            if (closed_.load(std::memory_order_acquire)) {
+            if (closed_.load(std::memory_order_acquire) || !result) {
                 return false;
             }
             
-            if (!result) {
-                return false;
-            }
-            
-            // Only copy the message if there is one
-            if (!message_.empty()) {
-                message_copy.swap(message_);
-            } else {
-                return true; // No message but condition satisfied
+            // Take every pending event: they are written as one batch.
+            while (count_ > 0) {
+                std::string& slot = ring_[head_];
+                batch_.append(slot);
+                slot = std::string();
+                head_ = (head_ + 1) % ring_.size();
+                --count_;
             }
         }
+        space_cv_.notify_all();
         
         try {
-            if (!message_copy.empty()) {
-                if (!sink->write(message_copy.data(), message_copy.size())) {
-                    close();
-                    return false;
-                }
+            if (!sink->write(batch_.data(), batch_.size())) {
+                close();
+                return false;
             }
             return true;
         } catch (...) {
@@ -98,26 +114,37 @@ public:
         }
     }
 
-    bool send_event(const std::string& message) {
+    /**
+     * @brief Queue an event
+     * @param message The complete SSE event ("event: ...\r\ndata: ...\r\n\r\n")
+     * @return False if the dispatcher is closed, or if the queue stayed full
+     * for `send_timeout` (the event is then dropped)
+     */
+    bool send_event(std::string message) {
         if (closed_.load(std::memory_order_acquire) || message.empty()) {
             return false;
         }
         
         try {
-            std::lock_guard<std::mutex> lk(m_);
+            std::unique_lock<std::mutex> lk(m_);
+            
+            bool has_room = space_cv_.wait_for(lk, send_timeout_, [&] {
+                return count_ < ring_.size() || closed_.load(std::memory_order_acquire);
+            });
             
             if (closed_.load(std::memory_order_acquire)) {
                 return false;
             }
             
-            // Efficiently set the message and allocate space as needed
-            if (message.size() > message_.capacity()) {
-                message_.reserve(message.size() + 64); // Pre-allocate extra space to avoid frequent reallocations
+            if (!has_room) {
+                ++dropped_;
+                return false;
             }
-            message_ = message;
             
-            cid_.store(id_.fetch_add(1, std::memory_order_relaxed), std::memory_order_relaxed);
-            cv_.notify_one(); // Notify waiting threads
+            ring_[(head_ + count_) % ring_.size()] = std::move(message);
+            ++count_;
+            lk.unlock();
+            cv_.notify_one(); // Notify the consumer
             return true;
         } catch (...) {
             return false;
@@ -131,7 +158,11 @@ public:
         }
         
         try {
+            // Take the lock so a waiter cannot miss the notification.
+            std::lock_guard<std::mutex> lk(m_);
             cv_.notify_all();
+            space_cv_.notify_all();
+            closed_cv_.notify_all();
         } catch (...) {
             // Ignore exceptions
         }
@@ -140,6 +171,30 @@ public:
     bool is_closed() const {
         return closed_.load(std::memory_order_acquire);
     }
+
+    /**
+     * @brief Wait until the dispatcher is closed
+     * @param timeout How long to wait
+     * @return True if the dispatcher is closed
+     */
+    bool wait_closed(const std::chrono::milliseconds& timeout) {
+        std::unique_lock<std::mutex> lk(m_);
+        return closed_cv_.wait_for(lk, timeout, [&] {
+            return closed_.load(std::memory_order_acquire);
+        });
+    }
+
+    // Get the number of events waiting to be written
+    size_t pending_events() const {
+        std::lock_guard<std::mutex> lk(m_);
+        return count_;
+    }
+
+    // Get the number of events dropped because the queue was full
+    size_t dropped_events() const {
+        std::lock_guard<std::mutex> lk(m_);
+        return dropped_;
+    }
     
     // Get the last activity time
     std::chrono::steady_clock::time_point last_activity() const {
@@ -155,10 +210,20 @@ public:
 
 private:
     mutable std::mutex m_;
+    // Signaled when an event is queued
     std::condition_variable cv_;
-    std::atomic<int> id_{0};
-    std::atomic<int> cid_{-1};
-    std::string message_;
+    // Signaled when the consumer made room
+    std::condition_variable space_cv_;
+    // Signaled when the dispatcher is closed
+    std::condition_variable closed_cv_;
+    std::vector<std::string> ring_;
+    // Index of the oldest pending event
+    size_t head_ = 0;
+    size_t count_ = 0;
+    size_t dropped_ = 0;
+    std::chrono::milliseconds send_timeout_;
+    // The batch being written, only used by the consumer
+    std::string batch_;
     std::atomic<bool> closed_{false};
     std::chrono::steady_clock::time_point last_activity_{std::chrono::steady_clock::now()};
 };
@@ -252,6 +317,15 @@ public:
      */
     void register_tool(const tool& tool, tool_handler handler);
 
+    /**
+     * @brief Limit how many requests of a method run at the same time
+     * @param method The method name (e.g. "tools/call")
+     * @param limit The maximum number of concurrent requests, 0 for no limit
+     * @note Requests over the limit wait in a per-method queue instead of
+     * the thread pool, so they neither hold a worker nor delay other methods
+     */
+    void set_method_concurrency(const std::string& method, size_t limit);
+
     /**
      * @brief Register a session cleanup handler
      * @param key Tool or resource name to be cleaned up
@@ -302,9 +376,6 @@ private:
     // Server thread (for non-blocking mode)
     std::unique_ptr<std::thread> server_thread_;
 
-    // SSE thread
-    std::map<std::string, std::unique_ptr<std::thread>> sse_threads_;
-
     // Event dispatcher for server-sent events
     event_dispatcher sse_dispatcher_;
     
@@ -366,15 +437,22 @@ private:
     // Generate a random session ID
     std::string generate_session_id() const;
     
-    // Auxiliary function to create an async handler from a regular handler
-    template<typename F>
-    std::function<std::future<json>(const json&, const std::string&)> make_async_handler(F&& handler) {
-        return [handler = std::forward<F>(handler)](const json& params, const std::string& session_id) -> std::future<json> {
-            return std::async(std::launch::async, [handler, params, session_id]() -> json {
-                return handler(params, session_id);
-            });
-        };
-    }
+    // Concurrency limit of a method and the requests waiting for a slot
+    struct method_gate {
+        size_t limit = 0;
+        size_t running = 0;
+        std::deque<std::function<void()>> waiting;
+    };
+
+    // Method gates (method -> gate), guarded by gates_mutex_
+    std::map<std::string, method_gate> method_gates_;
+    std::mutex gates_mutex_;
+
+    // Run a request task on the thread pool, within the limit of its method
+    void dispatch(const std::string& method, std::function<void()> task);
+
+    // Run a gated task, then hand its slot to the next waiting request
+    void run_gated(const std::string& method, const std::function<void()>& task);
 
     // Helper class to simplify lock management
     class auto_lock {
@@ -391,7 +469,17 @@ private:
 
     // Session management and maintenance
     void check_inactive_sessions();
-    std::unique_ptr<std::thread> maintenance_thread_;
+
+    // Timers of the sessions (heartbeats, inactive session checks)
+    timer_wheel timers_;
+
+    // Send a heartbeat to the session every 5 seconds. Returns false if the
+    // timers are stopped.
+    bool schedule_heartbeat(const std::string& session_id, std::weak_ptr<event_dispatcher> dispatcher, int heartbeat_count);
+
+    // Check the inactive sessions every 60 seconds. Returns false if the
+    // timers are stopped.
+    bool schedule_inactive_check();
 
     // Session cleanup handler
     std::map<std::string, session_cleanup_handler> session_cleanup_handler_;
@@ -69,6 +69,10 @@ bool stdio_client::initialize(const std::string& client_name,
   }
 }
 
+void stdio_client::set_request_timeout(std::chrono::milliseconds timeout) {
+  request_timeout_ms_ = timeout.count();
+}
+
 bool stdio_client::ping() {
   if (!running_) {
     return false;
@@ -420,10 +424,6 @@ bool stdio_client::start_server_process() {
                  WEXITSTATUS(status));
     running_ = false;
 
-    if (read_thread_ && read_thread_->joinable()) {
-      read_thread_->join();
-    }
-
     close(stdin_pipe_[1]);
     close(stdout_pipe_[0]);
 
@@ -432,10 +432,6 @@ bool stdio_client::start_server_process() {
     MCP_LOG_INFO("Failed to check process status: ", strerror(errno));
     running_ = false;
 
-    if (read_thread_ && read_thread_->joinable()) {
-      read_thread_->join();
-    }
-
     close(stdin_pipe_[1]);
     close(stdout_pipe_[0]);
 
@@ -445,9 +441,22 @@ bool stdio_client::start_server_process() {
 
   running_ = true;
 
+#if defined(_WIN32)
   // Start read thread
   read_thread_ =
       std::make_unique<std::thread>(&stdio_client::read_thread_func, this);
+#else
+  // The server output is read by the reactor thread shared by all the clients,
+  // as soon as it is available.
+  stdio_reactor::instance().add(
+      stdout_pipe_[0],
+      [this](const char* data, size_t len) { on_server_data(data, len); },
+      [this]() {
+        if (running_) {
+          MCP_LOG_WARN("Pipe closed by server");
+        }
+      });
+#endif
 
   // Wait for a while to ensure process starts
   std::this_thread::sleep_for(std::chrono::milliseconds(500));
@@ -533,15 +542,12 @@ void stdio_client::stop_server_process() {
   }
 
   if (stdout_pipe_[0] != -1) {
+    // Stop reading before closing: the descriptor may be reused right away.
+    stdio_reactor::instance().remove(stdout_pipe_[0]);
     close(stdout_pipe_[0]);
     stdout_pipe_[0] = -1;
   }
 
-  // Wait for read thread to finish
-  if (read_thread_ && read_thread_->joinable()) {
-    read_thread_->join();
-  }
-
   // Terminate process
   if (process_id_ > 0) {
     MCP_LOG_INFO("Sending SIGTERM to process: ", process_id_);
@@ -552,10 +558,15 @@ void stdio_client::stop_server_process() {
     pid_t result = waitpid(process_id_, &status, WNOHANG);
 
     if (result == 0) {
-      // Process is still running, wait for a while
-      std::this_thread::sleep_for(std::chrono::seconds(2));
-
-      result = waitpid(process_id_, &status, WNOHANG);
+      // Process is still running, wait for a while (most servers exit
+      // right away on SIGTERM, so poll instead of sleeping the full grace
+      // period)
+      auto deadline =
+          std::chrono::steady_clock::now() + std::chrono::seconds(2);
+      while (result == 0 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        result = waitpid(process_id_, &status, WNOHANG);
+      }
 
       if (result == 0) {
         // Process is still running, force termination
@@ -572,15 +583,13 @@ void stdio_client::stop_server_process() {
   MCP_LOG_INFO("Server process stopped");
 }
 
+#if defined(_WIN32)
 void stdio_client::read_thread_func() {
   MCP_LOG_INFO("Read thread started");
 
   const int buffer_size = 4096;
   char buffer[buffer_size];
-  std::string data_buffer;
 
-#if defined(_WIN32)
-  // Windows implementation
   DWORD bytes_read;
   int retry_count = 0;
 
@@ -595,55 +604,7 @@ void stdio_client::read_thread_func() {
     if (success && bytes_read > 0) {
       // Successfully read data
       retry_count = 0;  // Reset retry count
-      buffer[bytes_read] = '\0';
-      data_buffer.append(buffer, bytes_read);
-
-      // Process complete JSON-RPC message
-      size_t pos = 0;
-      while ((pos = data_buffer.find('\n')) != std::string::npos) {
-        std::string line = data_buffer.substr(0, pos);
-        data_buffer.erase(0, pos + 1);
-
-        if (!line.empty()) {
-          try {
-            json message = json::parse(line);
-
-            if (message.contains("jsonrpc") && message["jsonrpc"] == "2.0") {
-              if (message.contains("id") && !message["id"].is_null()) {
-                // This is a response
-                json id = message["id"];
-
-                std::lock_guard<std::mutex> lock(response_mutex_);
-                auto it = pending_requests_.find(id);
-
-                if (it != pending_requests_.end()) {
-                  if (message.contains("result")) {
-                    it->second.set_value(message["result"]);
-                  } else if (message.contains("error")) {
-                    json error_result = {{"isError", true},
-                                         {"error", message["error"]}};
-                    it->second.set_value(error_result);
-                  } else {
-                    it->second.set_value(json::object());
-                  }
-
-                  pending_requests_.erase(it);
-                } else {
-                  MCP_LOG_WARN("Received response for unknown request ID: ",
-                               id);
-                }
-              } else if (message.contains("method")) {
-                // This is a request or notification
-                MCP_LOG_INFO("Received request/notification: ",
-                             message["method"]);
-                // Currently not handling requests from the server
-              }
-            }
-          } catch (const json::exception& e) {
-            MCP_LOG_INFO("message: ", line);
-          }
-        }
-      }
+      on_server_data(buffer, bytes_read);
     } else if (!success) {
       DWORD error = GetLastError();
 
@@ -708,79 +669,55 @@ void stdio_client::read_thread_func() {
       }
     }
   }
-#else
-  // POSIX implementation
-  while (running_) {
-    // Read data
-    ssize_t bytes_read = read(stdout_pipe_[0], buffer, buffer_size - 1);
-
-    if (bytes_read > 0) {
-      buffer[bytes_read] = '\0';
-      data_buffer.append(buffer, bytes_read);
-
-      // Process complete JSON-RPC message
-      size_t pos = 0;
-      while ((pos = data_buffer.find('\n')) != std::string::npos) {
-        std::string line = data_buffer.substr(0, pos);
-        data_buffer.erase(0, pos + 1);
-
-        if (!line.empty()) {
-          try {
-            json message = json::parse(line);
-
-            if (message.contains("jsonrpc") && message["jsonrpc"] == "2.0") {
-              if (message.contains("id") && !message["id"].is_null()) {
-                // This is a response
-                json id = message["id"];
-
-                std::lock_guard<std::mutex> lock(response_mutex_);
-                auto it = pending_requests_.find(id);
-
-                if (it != pending_requests_.end()) {
-                  if (message.contains("result")) {
-                    it->second.set_value(message["result"]);
-                  } else if (message.contains("error")) {
-                    json error_result = {{"isError", true},
-                                         {"error", message["error"]}};
-                    it->second.set_value(error_result);
-                  } else {
-                    it->second.set_value(json::object());
-                  }
-
-                  pending_requests_.erase(it);
-                } else {
-                  MCP_LOG_WARN("Received response for unknown request ID: ",
-                               id);
-                }
-              } else if (message.contains("method")) {
-                // This is a request or notification
-                MCP_LOG_INFO("Received request/notification: ",
-                             message["method"]);
-                // Currently not handling requests from the server
-              }
-            }
-          } catch (const json::exception& e) {
-            MCP_LOG_INFO("message: ", line);
+
+  MCP_LOG_INFO("Read thread stopped");
+}
+#endif
+
+void stdio_client::on_server_data(const char* data, size_t len) {
+  line_splitter_.feed(data, len, [this](std::string_view line) {
+    if (!line.empty()) {
+      handle_message(line);
+    }
+  });
+}
+
+void stdio_client::handle_message(std::string_view line) {
+  try {
+    json message = json::parse(line);
+
+    if (message.contains("jsonrpc") && message["jsonrpc"] == "2.0") {
+      if (message.contains("id") && !message["id"].is_null()) {
+        // This is a response
+        json id = message["id"];
+
+        std::lock_guard<std::mutex> lock(response_mutex_);
+        auto it = pending_requests_.find(id);
+
+        if (it != pending_requests_.end()) {
+          if (message.contains("result")) {
+            it->second.set_value(std::move(message["result"]));
+          } else if (message.contains("error")) {
+            json error_result = {{"isError", true},
+                                 {"error", message["error"]}};
+            it->second.set_value(error_result);
+          } else {
+            it->second.set_value(json::object());
           }
+
+          pending_requests_.erase(it);
+        } else {
+          MCP_LOG_WARN("Received response for unknown request ID: ", id);
         }
-      }
-    } else if (bytes_read == 0) {
-      // Pipe is closed
-      MCP_LOG_WARN("Pipe closed by server");
-      break;
-    } else if (bytes_read == -1) {
-      if (errno == EAGAIN || errno == EWOULDBLOCK) {
-        // No data to read in non-blocking mode
-        std::this_thread::sleep_for(std::chrono::milliseconds(10));
-      } else {
-        MCP_LOG_INFO("Error reading from pipe: ", strerror(errno));
-        break;
+      } else if (message.contains("method")) {
+        // This is a request or notification
+        MCP_LOG_INFO("Received request/notification: ", message["method"]);
+        // Currently not handling requests from the server
       }
     }
+  } catch (const json::exception& e) {
+    MCP_LOG_INFO("message: ", line);
   }
-#endif
-
-  MCP_LOG_INFO("Read thread stopped");
 }
 
 json stdio_client::send_jsonrpc(const request& req) {
@@ -792,6 +729,24 @@ json stdio_client::send_jsonrpc(const request& req) {
   json req_json = req.to_json();
   std::string req_str = req_json.dump() + "\n";
 
+  // Register the pending request before writing it: the response may be read
+  // by the read thread before this thread gets to wait for it.
+  std::future<json> response_future;
+  if (!req.is_notification()) {
+    std::promise<json> response_promise;
+    response_future = response_promise.get_future();
+    std::lock_guard<std::mutex> lock(response_mutex_);
+    pending_requests_[req.id] = std::move(response_promise);
+  }
+
+  auto forget_request = [this, &req]() {
+    if (!req.is_notification()) {
+      std::lock_guard<std::mutex> lock(response_mutex_);
+      pending_requests_.erase(req.id);
+    }
+  };
+
+  std::unique_lock<std::mutex> write_lock(write_mutex_);
 #if defined(_WIN32)
   // Windows implementation
   DWORD bytes_written;
@@ -801,6 +756,8 @@ json stdio_client::send_jsonrpc(const request& req) {
 
   if (!success || bytes_written != static_cast<DWORD>(req_str.size())) {
     MCP_LOG_INFO("Failed to write complete request: ", GetLastError());
+    write_lock.unlock();
+    forget_request();
     throw mcp_exception(error_code::internal_error, "Failed to write to pipe");
   }
 #else
@@ -810,26 +767,20 @@ json stdio_client::send_jsonrpc(const request& req) {
 
   if (bytes_written != static_cast<ssize_t>(req_str.size())) {
     MCP_LOG_ERROR("Failed to write complete request: ", strerror(errno));
+    write_lock.unlock();
+    forget_request();
     throw mcp_exception(error_code::internal_error, "Failed to write to pipe");
   }
 #endif
+  write_lock.unlock();
 
   // If this is a notification, no need to wait for a response
   if (req.is_notification()) {
     return json::object();
   }
 
-  // Create Promise and Future
-  std::promise<json> response_promise;
-  std::future<json> response_future = response_promise.get_future();
-
-  {
-    std::lock_guard<std::mutex> lock(response_mutex_);
-    pending_requests_[req.id] = std::move(response_promise);
-  }
-
   // Wait for response, set timeout
-  const auto timeout = std::chrono::seconds(60);
+  const auto timeout = std::chrono::milliseconds(request_timeout_ms_.load());
   auto status = response_future.wait_for(timeout);
 
   if (status == std::future_status::ready) {
@@ -850,11 +801,7 @@ json stdio_client::send_jsonrpc(const request& req) {
 
     return response;
   } else {
-    {
-      std::lock_guard<std::mutex> lock(response_mutex_);
-      pending_requests_.erase(req.id);
-    }
-
+    forget_request();
     throw mcp_exception(error_code::internal_error,
                         "Timeout waiting for response");
   }
@@ -11,6 +11,7 @@
 #define MCP_STDIO_CLIENT_H
 
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <future>
 #include <map>
@@ -22,6 +23,7 @@
 
 #include "mcp_client.h"
 #include "mcp_message.h"
+#include "mcp_stdio_reactor.h"
 #include "mcp_tool.h"
 
 #if defined(_WIN32)
@@ -134,6 +136,12 @@ class stdio_client : public client {
    */
   json get_capabilities() override;
 
+  /**
+   * @brief Set how long a request waits for its response
+   * @param timeout The timeout (60 seconds by default)
+   */
+  void set_request_timeout(std::chrono::milliseconds timeout);
+
   /**
    * @brief List available resources
    * @param cursor Optional cursor for pagination
@@ -174,8 +182,16 @@ class stdio_client : public client {
   // Stop server process
   void stop_server_process();
 
+#if defined(_WIN32)
   // Read thread function
   void read_thread_func();
+#endif
+
+  // Dispatch the data received from the server
+  void on_server_data(const char* data, size_t len);
+
+  // Handle a single JSON-RPC message received from the server
+  void handle_message(std::string_view line);
 
   // Send JSON-RPC request
   json send_jsonrpc(const request& req);
@@ -201,12 +217,20 @@ class stdio_client : public client {
   int stdout_pipe_[2] = {-1, -1};
 #endif
 
+#if defined(_WIN32)
   // Read thread
   std::unique_ptr<std::thread> read_thread_;
+#endif
+
+  // Splits the server output into JSON-RPC messages
+  line_splitter line_splitter_;
 
   // Running status
   std::atomic<bool> running_{false};
 
+  // How long a request waits for its response, in milliseconds
+  std::atomic<int64_t> request_timeout_ms_{60000};
+
   // Client capabilities
   json capabilities_;
 
@@ -222,6 +246,10 @@ class stdio_client : public client {
   // Response processing mutex
   std::mutex response_mutex_;
 
+  // Serializes writes to the server's stdin, so concurrent requests are not
+  // interleaved on the pipe
+  std::mutex write_mutex_;
+
   // Initialization status
   std::atomic<bool> initialized_{false};
 
@@ -0,0 +1,168 @@
+/**
+ * @file mcp_stdio_reactor.cpp
+ * @brief Implementation of the reactor shared by the stdio MCP clients
+ */
+
+#include "mcp_stdio_reactor.h"
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include <cerrno>
+
+#include "mcp_logger.h"
+
+namespace mcp {
+
+stdio_reactor& stdio_reactor::instance() {
+  // Never destroyed: clients owned by static objects may still unregister
+  // during the process shutdown.
+  static stdio_reactor* reactor = new stdio_reactor();
+  return *reactor;
+}
+
+stdio_reactor::stdio_reactor() : read_buffer_(64 * 1024) {
+  if (pipe(wakeup_pipe_) == -1) {
+    MCP_LOG_ERROR("Failed to create the reactor wakeup pipe: ",
+                  strerror(errno));
+    return;
+  }
+  for (int fd : wakeup_pipe_) {
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+  }
+}
+
+bool stdio_reactor::add(int fd, data_callback on_data,
+                        close_callback on_close) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto h = std::make_shared<handler>();
+  h->on_data = std::move(on_data);
+  h->on_close = std::move(on_close);
+  if (!handlers_.insert({fd, std::move(h)}).second) {
+    return false;
+  }
+
+  if (!thread_) {
+    thread_ = std::make_unique<std::thread>(&stdio_reactor::run, this);
+    thread_id_ = thread_->get_id();
+    thread_->detach();
+  }
+  wakeup();
+  return true;
+}
+
+void stdio_reactor::remove(int fd) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  handlers_.erase(fd);
+  if (!thread_ || std::this_thread::get_id() == thread_id_) {
+    // Called from a callback: nothing else runs concurrently.
+    return;
+  }
+
+  // A callback of `fd` may be running right now. It completes before the
+  // current iteration of the loop does.
+  uint64_t iteration = iteration_;
+  wakeup();
+  cv_.wait(lock, [this, iteration]() { return iteration_ != iteration; });
+}
+
+size_t stdio_reactor::size() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return handlers_.size();
+}
+
+void stdio_reactor::wakeup() {
+  char c = 0;
+  // If the pipe is full, the reactor is already going to wake up.
+  [[maybe_unused]] auto res = write(wakeup_pipe_[1], &c, 1);
+}
+
+bool stdio_reactor::drain(int fd, handler& h) {
+  while (true) {
+    ssize_t bytes_read = read(fd, read_buffer_.data(), read_buffer_.size());
+    if (bytes_read > 0) {
+      h.on_data(read_buffer_.data(), static_cast<size_t>(bytes_read));
+      continue;
+    }
+    if (bytes_read == 0) {
+      return false;
+    }
+    if (errno == EINTR) {
+      continue;
+    }
+    if (errno == EAGAIN || errno == EWOULDBLOCK) {
+      return true;
+    }
+    MCP_LOG_INFO("Error reading from pipe: ", strerror(errno));
+    return false;
+  }
+}
+
+void stdio_reactor::run() {
+  MCP_LOG_INFO("stdio reactor started");
+  std::vector<pollfd> fds;
+  while (true) {
+    fds.clear();
+    fds.push_back({wakeup_pipe_[0], POLLIN, 0});
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      for (const auto& [fd, _] : handlers_) {
+        fds.push_back({fd, POLLIN, 0});
+      }
+    }
+
+    int res = poll(fds.data(), fds.size(), -1);
+    if (res == -1 && errno != EINTR) {
+      MCP_LOG_ERROR("poll failed: ", strerror(errno));
+    }
+
+    if (res > 0) {
+      if (fds[0].revents != 0) {
+        char drain_buffer[64];
+        while (read(wakeup_pipe_[0], drain_buffer, sizeof(drain_buffer)) > 0) {
+        }
+      }
+
+      for (size_t i = 1; i < fds.size(); ++i) {
+        if (fds[i].revents == 0) {
+          continue;
+        }
+        std::shared_ptr<handler> h;
+        {
+          std::lock_guard<std::mutex> lock(mutex_);
+          auto iter = handlers_.find(fds[i].fd);
+          if (iter == handlers_.end()) {
+            // Removed while we were waiting.
+            continue;
+          }
+          h = iter->second;
+        }
+
+        if (!drain(fds[i].fd, *h)) {
+          {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto iter = handlers_.find(fds[i].fd);
+            if (iter != handlers_.end() && iter->second == h) {
+              handlers_.erase(iter);
+            }
+          }
+          if (h->on_close) {
+            h->on_close();
+          }
+        }
+      }
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      ++iteration_;
+    }
+    cv_.notify_all();
+  }
+}
+
+}  // namespace mcp
+#endif
@@ -0,0 +1,154 @@
+/**
+ * @file mcp_stdio_reactor.h
+ * @brief Event-driven reading of the stdio MCP servers output
+ *
+ * A single reactor thread waits (with poll) on the stdout pipes of all the
+ * stdio MCP servers and dispatches their data as soon as it arrives.
+ */
+
+#ifndef MCP_STDIO_REACTOR_H
+#define MCP_STDIO_REACTOR_H
+
+#include <condition_variable>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace mcp {
+
+/**
+ * @brief Splits a byte stream into '\n' terminated lines
+ *
+ * Complete lines are passed to the callback as views into the internal
+ * buffer, without copying them. The consumed prefix is dropped lazily (only
+ * when it is at least half of the buffer), so splitting many small messages
+ * does not move the rest of the buffer for every line.
+ */
+class line_splitter {
+ public:
+  /**
+   * @brief Append data and call `on_line` for every complete line
+   * @param data The received data
+   * @param on_line Called with each line, without the trailing '\n'
+   */
+  template <typename Callback>
+  void feed(const char* data, size_t len, Callback&& on_line) {
+    buffer_.append(data, len);
+    while (scan_pos_ < buffer_.size()) {
+      const char* start = buffer_.data() + scan_pos_;
+      const void* nl = std::memchr(start, '\n', buffer_.size() - scan_pos_);
+      if (nl == nullptr) {
+        scan_pos_ = buffer_.size();
+        break;
+      }
+      size_t end = static_cast<const char*>(nl) - buffer_.data();
+      on_line(std::string_view{buffer_.data() + begin_, end - begin_});
+      begin_ = scan_pos_ = end + 1;
+    }
+    compact();
+  }
+
+  /**
+   * @brief Get the data of the incomplete line
+   */
+  std::string_view pending() const {
+    return std::string_view{buffer_}.substr(begin_);
+  }
+
+ private:
+  void compact() {
+    if (begin_ == buffer_.size()) {
+      buffer_.clear();
+      begin_ = scan_pos_ = 0;
+    } else if (begin_ > 0 && begin_ >= buffer_.size() / 2) {
+      buffer_.erase(0, begin_);
+      scan_pos_ -= begin_;
+      begin_ = 0;
+    }
+  }
+
+  std::string buffer_;
+  // Start of the first incomplete line
+  size_t begin_ = 0;
+  // Where the search for the next '\n' resumes
+  size_t scan_pos_ = 0;
+};
+
+#if !defined(_WIN32)
+/**
+ * @brief A reactor thread shared by all the stdio MCP clients
+ *
+ * File descriptors must be non-blocking. The callbacks are invoked from the
+ * reactor thread and must not block.
+ */
+class stdio_reactor {
+ public:
+  using data_callback = std::function<void(const char* data, size_t len)>;
+  using close_callback = std::function<void()>;
+
+  /**
+   * @brief Get the process wide reactor
+   */
+  static stdio_reactor& instance();
+
+  /**
+   * @brief Start watching `fd`
+   * @param on_data Called with every chunk read from `fd`
+   * @param on_close Called once when `fd` reaches EOF or fails. `fd` is no
+   * longer watched after that, but it is not closed
+   * @return False if `fd` is already watched
+   */
+  bool add(int fd, data_callback on_data, close_callback on_close);
+
+  /**
+   * @brief Stop watching `fd`
+   *
+   * When this method returns, no callback of `fd` is running and none will
+   * run anymore, so it is safe to close `fd` and to release the objects used
+   * by the callbacks.
+   */
+  void remove(int fd);
+
+  /**
+   * @brief Get the number of watched file descriptors
+   */
+  size_t size() const;
+
+  stdio_reactor(const stdio_reactor&) = delete;
+  stdio_reactor& operator=(const stdio_reactor&) = delete;
+
+ private:
+  struct handler {
+    data_callback on_data;
+    close_callback on_close;
+  };
+
+  stdio_reactor();
+  ~stdio_reactor() = default;
+
+  void run();
+  void wakeup();
+  // Read `fd` until it would block. Returns false on EOF or error
+  bool drain(int fd, handler& h);
+
+  mutable std::mutex mutex_;
+  std::condition_variable cv_;
+  std::map<int, std::shared_ptr<handler>> handlers_;
+  // Incremented at the end of every iteration of the reactor loop
+  uint64_t iteration_ = 0;
+  int wakeup_pipe_[2] = {-1, -1};
+  std::vector<char> read_buffer_;
+  std::unique_ptr<std::thread> thread_;
+  std::thread::id thread_id_;
+};
+#endif
+
+}  // namespace mcp
+
+#endif  // MCP_STDIO_REACTOR_H
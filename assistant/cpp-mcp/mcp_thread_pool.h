@@ -6,6 +6,7 @@
 #ifndef MCP_THREAD_POOL_H
 #define MCP_THREAD_POOL_H
 
+#include <algorithm>
 #include <vector>
 #include <queue>
 #include <thread>
@@ -25,6 +26,8 @@ public:
      * @param num_threads Number of threads in the thread pool
      */
     explicit thread_pool(size_t num_threads = std::thread::hardware_concurrency()) : stop_(false) {
+        // hardware_concurrency() may return 0
+        num_threads = std::max<size_t>(num_threads, 1);
         for (size_t i = 0; i < num_threads; ++i) {
             workers_.emplace_back([this] {
                 while (true) {
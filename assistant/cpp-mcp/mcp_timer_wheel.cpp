@@ -0,0 +1,123 @@
+/**
+ * @file mcp_timer_wheel.cpp
+ * @brief Implementation of the timer wheel of the MCP server sessions
+ */
+
+#include "mcp_timer_wheel.h"
+
+#include <algorithm>
+
+#include "mcp_logger.h"
+
+namespace mcp {
+
+timer_wheel::timer_wheel(std::chrono::milliseconds tick, size_t slots)
+    : tick_(std::max(tick, std::chrono::milliseconds(1))),
+      slots_(std::max<size_t>(slots, 1)) {}
+
+timer_wheel::~timer_wheel() { stop(); }
+
+bool timer_wheel::schedule(std::chrono::milliseconds delay, callback cb) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (stopped_) {
+    return false;
+  }
+
+  // A timer expires on the first tick at or after `delay`
+  uint64_t ticks = std::max<uint64_t>(
+      1, static_cast<uint64_t>((delay + tick_ - std::chrono::milliseconds(1)) /
+                               tick_));
+  size_t slot = (cursor_ + ticks) % slots_.size();
+  slots_[slot].push_back({(ticks - 1) / slots_.size(), std::move(cb)});
+  ++size_;
+
+  if (!thread_) {
+    thread_ = std::make_unique<std::thread>(&timer_wheel::run, this);
+  }
+  return true;
+}
+
+void timer_wheel::stop() {
+  std::unique_ptr<std::thread> thread;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stopped_) {
+      return;
+    }
+    stopped_ = true;
+    thread = std::move(thread_);
+    cv_.notify_all();
+  }
+
+  if (thread && thread->joinable()) {
+    thread->join();
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto& slot : slots_) {
+    slot.clear();
+  }
+  size_ = 0;
+}
+
+void timer_wheel::start() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  // The thread starts again with the first timer
+  stopped_ = false;
+}
+
+size_t timer_wheel::size() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return size_;
+}
+
+void timer_wheel::run() {
+  auto next_tick = std::chrono::steady_clock::now() + tick_;
+  std::vector<callback> expired;
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (!stopped_) {
+    if (cv_.wait_until(lock, next_tick, [this] { return stopped_; })) {
+      break;
+    }
+
+    // Catch up with the ticks missed while the callbacks were running
+    auto now = std::chrono::steady_clock::now();
+    while (next_tick <= now) {
+      next_tick += tick_;
+      cursor_ = (cursor_ + 1) % slots_.size();
+
+      auto& slot = slots_[cursor_];
+      auto pending = slot.begin();
+      for (auto& t : slot) {
+        if (t.rounds == 0) {
+          expired.push_back(std::move(t.cb));
+        } else {
+          --t.rounds;
+          if (&*pending != &t) {
+            *pending = std::move(t);
+          }
+          ++pending;
+        }
+      }
+      slot.erase(pending, slot.end());
+    }
+    size_ -= expired.size();
+
+    // The callbacks may schedule new timers
+    lock.unlock();
+    for (auto& cb : expired) {
+      try {
+        cb();
+      } catch (const std::exception& e) {
+        MCP_LOG_ERROR("Exception in timer callback: ", e.what());
+      } catch (...) {
+        MCP_LOG_ERROR("Unknown exception in timer callback");
+      }
+    }
+    expired.clear();
+    lock.lock();
+  }
+}
+
+}  // namespace mcp
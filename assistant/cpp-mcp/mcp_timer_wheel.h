@@ -0,0 +1,92 @@
+/**
+ * @file mcp_timer_wheel.h
+ * @brief Timers of the MCP server sessions
+ *
+ * A single thread runs the delayed callbacks of all the sessions (heartbeats,
+ * idle eviction), instead of one sleeping thread per session.
+ */
+
+#ifndef MCP_TIMER_WHEEL_H
+#define MCP_TIMER_WHEEL_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace mcp {
+
+/**
+ * @brief A hashed timer wheel
+ *
+ * Timers are kept in `slots` buckets of `tick` duration: scheduling and
+ * expiring a timer are O(1), whatever the number of timers, and timers fire
+ * with a resolution of one tick. The thread starts with the first timer.
+ * Callbacks run on the wheel thread and must not block.
+ */
+class timer_wheel {
+ public:
+  using callback = std::function<void()>;
+
+  explicit timer_wheel(
+      std::chrono::milliseconds tick = std::chrono::milliseconds(100),
+      size_t slots = 512);
+  ~timer_wheel();
+
+  /**
+   * @brief Run `cb` once after `delay`
+   * @return False if the wheel is stopped
+   */
+  bool schedule(std::chrono::milliseconds delay, callback cb);
+
+  /**
+   * @brief Stop the wheel and drop the pending timers
+   *
+   * When this method returns, no callback is running and none will run
+   * anymore, until `start()` is called. Must not be called from a callback.
+   */
+  void stop();
+
+  /**
+   * @brief Restart a stopped wheel
+   *
+   * Timers can be scheduled again. Must not be called concurrently with
+   * `stop()`.
+   */
+  void start();
+
+  /**
+   * @brief Get the number of pending timers
+   */
+  size_t size() const;
+
+  timer_wheel(const timer_wheel&) = delete;
+  timer_wheel& operator=(const timer_wheel&) = delete;
+
+ private:
+  struct timer {
+    // Number of full turns of the wheel left before the timer expires
+    uint64_t rounds;
+    callback cb;
+  };
+
+  void run();
+
+  const std::chrono::milliseconds tick_;
+  mutable std::mutex mutex_;
+  std::condition_variable cv_;
+  std::vector<std::vector<timer>> slots_;
+  // The slot of the last tick
+  size_t cursor_ = 0;
+  size_t size_ = 0;
+  bool stopped_ = false;
+  std::unique_ptr<std::thread> thread_;
+};
+
+}  // namespace mcp
+
+#endif  // MCP_TIMER_WHEEL_H
@@ -1,7 +1,11 @@
 #include "assistant/function.hpp"
 
+#include <map>
+#include <set>
+
 #include "assistant/config.hpp"
 #include "assistant/mcp.hpp"
+#include "assistant/parallel.hpp"
 
 namespace assistant {
 void FunctionTable::AddMCPServer(std::shared_ptr<MCPClient> client) {
@@ -11,77 +15,223 @@ void FunctionTable::AddMCPServer(std::shared_ptr<MCPClient> client) {
 
 void FunctionTable::AddMCPServerInternal(std::shared_ptr<MCPClient> client) {
   m_clients.push_back(client);
+  AddMCPFunctions(client);
+}
+
+std::vector<std::string> FunctionTable::AddMCPFunctions(
+    const std::shared_ptr<MCPClient>& client) {
+  InvalidateSchemas();
+  std::vector<std::string> names;
   auto functions = client->GetFunctions();
   for (auto func : functions) {
     if (!m_functions.insert({func->GetName(), func}).second) {
       OLOG(OLogLevel::kWarning)
           << "Duplicate function found: " << func->GetName();
+      continue;
     }
+    names.push_back(func->GetName());
   }
+  return names;
 }
 
-void FunctionTable::ReloadMCPServers(const Config* config) {
-  if (config == nullptr) {
-    return;
+namespace {
+std::shared_ptr<MCPClient> CreateMCPClient(const MCPServerConfig& s) {
+  if (s.IsStdio()) {
+    const auto& params = s.stdio_params.value();
+    if (params.IsRemote()) {
+      return std::make_shared<MCPClient>(params.ssh_login.value(), params.args,
+                                         params.env);
+    }
+    return std::make_shared<MCPClient>(params.args, params.env);
+  } else if (s.IsSse()) {
+    const auto& params = s.sse_params.value();
+    std::vector<std::pair<std::string, std::string>> http_headers;
+    if (params.headers.has_value()) {
+      const auto& headers = params.headers.value();
+      http_headers.reserve(headers.size());
+      for (const auto& [name, value] : headers.items()) {
+        http_headers.push_back(std::make_pair(name, value));
+      }
+    }
+    return std::make_shared<MCPClient>(params.baseurl, params.endpoint,
+                                       params.auth_token.value_or(""),
+                                       http_headers);
   }
+  return nullptr;
+}
 
-  std::scoped_lock lk{m_mutex};
-  // Clear all current MCP servers and their functions.
-  std::vector<std::string> names;
-  for (const auto& [funcname, func] : m_functions) {
-    if (dynamic_cast<ExternalFunction*>(func.get()) != nullptr) {
-      names.push_back(funcname);
+/// The settings of a server that require restarting it when they change. The
+/// name and the startup timeout are not part of them.
+std::string MCPServerIdentity(const MCPServerConfig& s) {
+  // The keys of nlohmann::json are sorted: the order of the environment
+  // variables and of the headers in the config does not matter.
+  nlohmann::json identity;
+  if (s.IsStdio()) {
+    const auto& params = s.stdio_params.value();
+    identity["type"] = "stdio";
+    identity["args"] = params.args;
+    if (params.env.has_value()) {
+      identity["env"] = nlohmann::json::parse(params.env->dump());
+    }
+    if (params.IsRemote()) {
+      const auto& login = params.ssh_login.value();
+      identity["ssh"] = {login.ssh_program, login.ssh_key, login.user,
+                         login.hostname, login.port};
+    }
+  } else if (s.IsSse()) {
+    const auto& params = s.sse_params.value();
+    identity["type"] = "sse";
+    identity["baseurl"] = params.baseurl;
+    identity["endpoint"] = params.endpoint;
+    identity["auth_token"] = params.auth_token.value_or("");
+    if (params.headers.has_value()) {
+      identity["headers"] = nlohmann::json::parse(params.headers->dump());
     }
   }
+  return identity.dump();
+}
+}  // namespace
 
-  for (const auto& funcname : names) {
-    m_functions.erase(funcname);
-    OLOG(LogLevel::kInfo) << "Deleting MCP server function: " << funcname;
+std::vector<MCPServerStartup> FunctionTable::ReloadMCPServers(
+    const Config* config) {
+  if (config == nullptr) {
+    return {};
   }
-  m_clients.clear();
 
+  std::scoped_lock reload_lk{m_reload_mutex};
+
+  std::vector<const MCPServerConfig*> servers;
+  std::vector<std::string> identities;
   for (const auto& s : config->GetServers()) {
-    if (!s.enabled) {
-      continue;
+    if (s.enabled) {
+      servers.push_back(&s);
+      identities.push_back(MCPServerIdentity(s));
     }
-    OLOG(LogLevel::kInfo) << "Starting MCP server: " << s.name;
-    std::shared_ptr<MCPClient> client{nullptr};
-    if (s.IsStdio()) {
-      const auto& params = s.stdio_params.value();
-      if (params.IsRemote()) {
-        client = std::make_shared<MCPClient>(params.ssh_login.value(),
-                                             params.args, params.env);
-      } else {
-        client = std::make_shared<MCPClient>(params.args, params.env);
+  }
+
+  std::vector<MCPServerStartup> report(servers.size());
+  // The index of each server to start, and of the first server of the config
+  // with the same settings (which only starts once).
+  std::vector<size_t> to_start;
+  std::vector<std::pair<size_t, size_t>> duplicates;
+  // Released without the lock: the last reference to a client stops it.
+  std::vector<std::shared_ptr<MCPClient>> stopped;
+  {
+    std::scoped_lock lk{m_mutex};
+    InvalidateSchemas();
+    std::set<std::string> wanted{identities.begin(), identities.end()};
+    std::set<std::string> kept_functions;
+    for (auto iter = m_servers.begin(); iter != m_servers.end();) {
+      if (wanted.contains(iter->first)) {
+        kept_functions.insert(iter->second.functions.begin(),
+                              iter->second.functions.end());
+        ++iter;
+        continue;
+      }
+      stopped.push_back(iter->second.client);
+      iter = m_servers.erase(iter);
+    }
+
+    // Remove the functions of the servers that are not kept
+    std::vector<std::string> names;
+    for (const auto& [funcname, func] : m_functions) {
+      if (dynamic_cast<ExternalFunction*>(func.get()) != nullptr &&
+          !kept_functions.contains(funcname)) {
+        names.push_back(funcname);
       }
-    } else if (s.IsSse()) {
-      const auto& params = s.sse_params.value();
-      std::vector<std::pair<std::string, std::string>> http_headers;
-      if (params.headers.has_value()) {
-        const auto& headers = params.headers.value();
-        http_headers.reserve(headers.size());
-        for (const auto& [name, value] : headers.items()) {
-          http_headers.push_back(std::make_pair(name, value));
+    }
+    for (const auto& funcname : names) {
+      m_functions.erase(funcname);
+      OLOG(LogLevel::kInfo) << "Deleting MCP server function: " << funcname;
+    }
+
+    // A tool of a kept server may have been dropped as a duplicate of a tool
+    // of a server that was just removed: offer their tools again.
+    for (auto& [_, server] : m_servers) {
+      for (const auto& func : server.client->GetFunctions()) {
+        if (m_functions.insert({func->GetName(), func}).second) {
+          server.functions.push_back(func->GetName());
         }
       }
-      client = std::make_shared<MCPClient>(params.baseurl, params.endpoint,
-                                           params.auth_token.value_or(""),
-                                           http_headers);
     }
+    stopped.insert(stopped.end(), m_clients.begin(), m_clients.end());
+    m_clients.clear();
+
+    std::map<std::string, size_t> first_index;
+    for (size_t i = 0; i < servers.size(); ++i) {
+      report[i].name = servers[i]->name;
+      auto [first, inserted] = first_index.insert({identities[i], i});
+      if (!inserted) {
+        duplicates.push_back({i, first->second});
+        continue;
+      }
+      auto iter = m_servers.find(identities[i]);
+      if (iter == m_servers.end()) {
+        to_start.push_back(i);
+        continue;
+      }
+      report[i].ok = true;
+      report[i].reused = true;
+      report[i].tools_count = iter->second.client->GetTools().size();
+      OLOG(LogLevel::kInfo) << "MCP server " << servers[i]->name
+                            << " is unchanged, keeping it";
+    }
+  }
+  stopped.clear();
 
-    if (client && client->Initialise()) {
-      AddMCPServerInternal(client);
-    } else {
+  // Startup is spent waiting on the servers (process spawn, SSH handshake,
+  // round trips), so every server gets its own worker (up to the size of the
+  // worker pool).
+  auto start_time = std::chrono::steady_clock::now();
+  ParallelFor(to_start.size(), to_start.size(), [&](size_t k) {
+    size_t i = to_start[k];
+    const auto& s = *servers[i];
+    auto& result = report[i];
+    OLOG(LogLevel::kInfo) << "Starting MCP server: " << s.name;
+    auto server_start = std::chrono::steady_clock::now();
+    auto client = CreateMCPClient(s);
+    result.ok = client && client->Initialise(s.startup_timeout);
+    result.elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - server_start);
+    if (!result.ok) {
       OLOG(LogLevel::kWarning)
-          << "Failed to initialise client for MCP server: " << s.name;
+          << "Failed to initialise client for MCP server: " << s.name
+          << " (" << result.elapsed.count() << "ms, timeout: "
+          << s.startup_timeout.count() << "ms)";
+      return;
     }
+    result.tools_count = client->GetTools().size();
+    {
+      std::scoped_lock lk{m_mutex};
+      auto functions = AddMCPFunctions(client);
+      m_servers[identities[i]] = {client, std::move(functions)};
+    }
+    OLOG(LogLevel::kInfo) << "MCP server " << s.name << " is ready in "
+                          << result.elapsed.count() << "ms, "
+                          << result.tools_count << " tools";
+  });
+
+  for (auto [i, first] : duplicates) {
+    report[i] = report[first];
+    report[i].name = servers[i]->name;
+  }
+
+  if (!to_start.empty()) {
+    OLOG(LogLevel::kInfo)
+        << "Started " << to_start.size() << " MCP servers in "
+        << std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::steady_clock::now() - start_time)
+               .count()
+        << "ms";
   }
+  return report;
 }
 
 void FunctionTable::Merge(const FunctionTable& other) {
   // Lock both tables.
   std::lock_guard lk1{m_mutex};
   std::lock_guard lk2{other.m_mutex};
+  InvalidateSchemas();
 
   for (auto [name, f] : other.m_functions) {
     if (m_functions.contains(name)) {
@@ -91,9 +241,10 @@ void FunctionTable::Merge(const FunctionTable& other) {
   }
 }
 
-ExternalFunction::ExternalFunction(assistant::MCPClient* client, mcp::tool t)
+ExternalFunction::ExternalFunction(
+    std::shared_ptr<assistant::MCPClient> client, mcp::tool t)
     : FunctionBase(t.name, t.description),
-      m_client(client),
+      m_client(std::move(client)),
       m_tool(std::move(t)) {
   try {
     auto properties = m_tool.parameters_schema["properties"];
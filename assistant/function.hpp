@@ -1,5 +1,6 @@
 #pragma once
 
+#include <chrono>
 #include <vector>
 
 #include "assistant/assistantlib.hpp"
@@ -126,7 +127,16 @@ class FunctionBase {
   inline const std::string& GetName() const { return m_name; }
   inline const std::string& GetDesc() const { return m_desc; }
   inline bool IsEnabled() const { return m_enabled; }
-  inline void SetEnabled(bool b) { m_enabled = b; }
+  inline void SetEnabled(bool b) {
+    if (m_enabled.exchange(b) != b) {
+      ++s_enabled_generation;
+    }
+  }
+
+  /// Incremented whenever a function (of any table) is enabled or disabled.
+  /// A function may be shared by several tables (see
+  /// `FunctionTable::Merge`), this lets their caches notice the change.
+  static uint64_t GetEnabledGeneration() { return s_enabled_generation; }
   virtual inline std::optional<CanInvokeToolResult> CanRun(
       [[maybe_unused]] const json& args) const {
     // return nullopt that no callback was registered
@@ -202,6 +212,7 @@ class FunctionBase {
   std::string m_desc;
   std::vector<Param> m_params;
   std::atomic_bool m_enabled{true};
+  static inline std::atomic_uint64_t s_enabled_generation{0};
   friend class FunctionBuilder;
 };
 
@@ -212,38 +223,84 @@ struct FunctionCall {
   std::optional<std::string> invocation_id;
 };
 
+/// The tools of a `FunctionTable` serialized for one endpoint.
+struct ToolsSchema {
+  /// The JSON array of the enabled tools.
+  json tools;
+  /// `tools.dump()`, ready to be spliced into a request body.
+  std::string serialized;
+  /// The table version this schema was built from.
+  uint64_t version{0};
+};
+
+/// The outcome of starting one MCP server.
+struct MCPServerStartup {
+  std::string name;
+  bool ok{false};
+  /// The number of tools the server exports.
+  size_t tools_count{0};
+  /// Time spent starting the server (spawn, handshake and tools listing).
+  std::chrono::milliseconds elapsed{0};
+  /// The server was already running with the same settings, and was kept.
+  bool reused{false};
+};
+
 class FunctionTable {
  public:
   /**
    * @brief Converts the internal state to a JSON representation containing only
    * enabled functions.
    *
-   * This method acquires a lock on the internal mutex and iterates through all
-   * functions, collecting only those that are enabled into a JSON array.
+   * The result is built from the cached schema, see `GetToolsSchema`.
    *
    * @param kind The endpoint kind to filter or identify the functions
    * @return json A JSON object containing the enabled functions
    */
   json ToJSON(EndpointKind kind, CachePolicy cache_policy) const
       FUNCTION_LOCKS(m_mutex) {
-    std::scoped_lock lk{m_mutex};
-    std::vector<json> v;
-    for (const auto& [_, f] : m_functions) {
-      // Only collect enabled functions.
-      if (!f->IsEnabled()) {
-        continue;
-      }
+    return GetToolsSchema(kind, cache_policy)->tools;
+  }
 
-      v.push_back(f->ToJSON(kind));
+  /**
+   * @brief Returns the enabled functions serialized for `kind`.
+   *
+   * The schema is built once per endpoint kind and cache policy, and reused
+   * until the table changes: adding, removing, enabling or disabling a
+   * function bumps the table version and drops the cached schemas. The
+   * returned schema is immutable and remains valid after that.
+   */
+  std::shared_ptr<const ToolsSchema> GetToolsSchema(
+      EndpointKind kind, CachePolicy cache_policy) const
+      FUNCTION_LOCKS(m_mutex) {
+    std::scoped_lock lk{m_mutex};
+    SyncEnabledGeneration();
+    auto& schema = m_schemas[{kind, cache_policy}];
+    if (schema == nullptr) {
+      schema = BuildToolsSchema(kind, cache_policy);
     }
+    return schema;
+  }
 
-    if (!v.empty() && cache_policy == CachePolicy::kStatic &&
-        kind == assistant::EndpointKind::anthropic) {
-      auto& last_tool = v.back();
-      last_tool["cache_control"] = {{"type", "ephemeral"}};
-    }
-    json j = v;
-    return j;
+  /**
+   * @brief Sets the "tools" member of `request` to the cached schema, which is
+   * spliced into the request body as is when the request is sent.
+   */
+  void AddToolsToRequest(assistant::request& request, EndpointKind kind,
+                         CachePolicy cache_policy) const
+      FUNCTION_LOCKS(m_mutex) {
+    request.set_streamed(
+        "tools", [schema = GetToolsSchema(kind, cache_policy)](
+                     std::ostream& os) { os << schema->serialized; });
+  }
+
+  /**
+   * @brief Returns the table version. It changes every time the set of enabled
+   * functions might have changed.
+   */
+  uint64_t GetVersion() const FUNCTION_LOCKS(m_mutex) {
+    std::scoped_lock lk{m_mutex};
+    SyncEnabledGeneration();
+    return m_version;
   }
 
   /**
@@ -265,23 +322,37 @@ class FunctionTable {
     std::scoped_lock lk{m_mutex};
     if (!m_functions.insert({f->GetName(), f}).second) {
       OLOG(OLogLevel::kWarning) << "Duplicate function found: " << f->GetName();
+      return;
     }
+    InvalidateSchemas();
   }
 
   void AddMCPServer(std::shared_ptr<MCPClient> client) FUNCTION_LOCKS(m_mutex);
 
+  /**
+   * @brief Invokes the function named by `func_call`.
+   *
+   * The lock is only held while looking up the function: the call itself runs
+   * without it, so a slow tool does not block concurrent calls (or any other
+   * access to the table). The function, and the MCP client behind an external
+   * function, is kept alive for the duration of the call.
+   */
   FunctionResult Call(const FunctionCall& func_call) const
       FUNCTION_LOCKS(m_mutex) {
     try {
-      std::scoped_lock lk{m_mutex};
-      auto iter = m_functions.find(func_call.name);
-      if (iter == m_functions.end()) {
-        std::stringstream ss;
-        ss << "could not find tool: '" << func_call.name << "'";
-        FunctionResult result{.isError = true, .text = ss.str()};
-        return result;
+      std::shared_ptr<FunctionBase> func;
+      {
+        std::scoped_lock lk{m_mutex};
+        auto iter = m_functions.find(func_call.name);
+        if (iter == m_functions.end()) {
+          std::stringstream ss;
+          ss << "could not find tool: '" << func_call.name << "'";
+          FunctionResult result{.isError = true, .text = ss.str()};
+          return result;
+        }
+        func = iter->second;
       }
-      return iter->second->Call(func_call.args);
+      return func->Call(func_call.args);
 
     } catch (std::exception& e) {
       FunctionResult result{.isError = true, .text = e.what()};
@@ -293,8 +364,8 @@ class FunctionTable {
    * Checks whether a registered tool can be executed with the given arguments.
    *
    * This method performs a thread-safe lookup of the tool by name and queries
-   * whether it can be run with the provided arguments. The mutex is held during
-   * the entire operation to ensure consistency.
+   * whether it can be run with the provided arguments. The mutex is only held
+   * during the lookup: the human-in-the-loop callback may block on user input.
    *
    * @param tool_name The name of the tool to check.
    * @param args      A JSON object containing the arguments to be passed to the
@@ -307,13 +378,15 @@ class FunctionTable {
   std::optional<CanInvokeToolResult> CanRunTool(const std::string& tool_name,
                                                 json args) const
       FUNCTION_LOCKS(m_mutex) {
-    std::scoped_lock lk{m_mutex};
-    auto iter = m_functions.find(tool_name);
-    if (iter == m_functions.end()) {
-      return std::nullopt;
+    std::shared_ptr<FunctionBase> funcptr;
+    {
+      std::scoped_lock lk{m_mutex};
+      auto iter = m_functions.find(tool_name);
+      if (iter == m_functions.end()) {
+        return std::nullopt;
+      }
+      funcptr = iter->second;
     }
-
-    auto funcptr = iter->second;
     return funcptr->CanRun(args);
   }
 
@@ -321,9 +394,30 @@ class FunctionTable {
     std::scoped_lock lk{m_mutex};
     m_functions.clear();
     m_clients.clear();
+    m_servers.clear();
+    InvalidateSchemas();
   }
 
-  void ReloadMCPServers(const Config* config) FUNCTION_LOCKS(m_mutex);
+  /**
+   * @brief Replaces the MCP servers of the table with the ones of `config`.
+   *
+   * Servers are compared by their settings (command, arguments, environment,
+   * SSH login, URL, headers...): a server that is still in `config` with the
+   * same settings keeps running, with its tools. The other servers (and the
+   * ones added with `AddMCPServer`) are removed; a server is only stopped once
+   * the tool calls it is running return.
+   *
+   * The new and changed servers start concurrently, each within its
+   * `startup_timeout`. A server's tools are registered as soon as it is
+   * ready: the table lock is only taken to remove the old servers and to merge
+   * each new one, so the table stays usable while slow servers start. If
+   * several servers export a tool with the same name, the first one to become
+   * ready wins.
+   *
+   * @return The startup outcome of each enabled server, in config order.
+   */
+  std::vector<MCPServerStartup> ReloadMCPServers(const Config* config)
+      FUNCTION_LOCKS(m_reload_mutex) FUNCTION_LOCKS(m_mutex);
   void Merge(const FunctionTable& other) FUNCTION_LOCKS(m_mutex);
 
   /**
@@ -341,6 +435,7 @@ class FunctionTable {
     for (auto& [name, func] : m_functions) {
       func->SetEnabled(b);
     }
+    InvalidateSchemas();
   }
 
   /**
@@ -385,6 +480,7 @@ class FunctionTable {
       return false;
     }
     iter->second->SetEnabled(b);
+    InvalidateSchemas();
     return true;
   }
 
@@ -416,11 +512,68 @@ class FunctionTable {
  private:
   void AddMCPServerInternal(std::shared_ptr<MCPClient> client)
       CALLER_MUST_LOCK(m_mutex);
+  /// Registers the functions of `client` and returns their names.
+  std::vector<std::string> AddMCPFunctions(
+      const std::shared_ptr<MCPClient>& client) CALLER_MUST_LOCK(m_mutex);
+
+  std::shared_ptr<const ToolsSchema> BuildToolsSchema(
+      EndpointKind kind, CachePolicy cache_policy) const
+      CALLER_MUST_LOCK(m_mutex) {
+    auto schema = std::make_shared<ToolsSchema>();
+    schema->tools = json::array();
+    for (const auto& [_, f] : m_functions) {
+      // Only collect enabled functions.
+      if (!f->IsEnabled()) {
+        continue;
+      }
+      schema->tools.push_back(f->ToJSON(kind));
+    }
+
+    if (!schema->tools.empty() && cache_policy == CachePolicy::kStatic &&
+        kind == assistant::EndpointKind::anthropic) {
+      auto& last_tool = schema->tools.back();
+      last_tool["cache_control"] = {{"type", "ephemeral"}};
+    }
+    schema->serialized = schema->tools.dump();
+    schema->version = m_version;
+    return schema;
+  }
+
+  void InvalidateSchemas() const CALLER_MUST_LOCK(m_mutex) {
+    ++m_version;
+    m_schemas.clear();
+  }
+
+  /// Drops the cached schemas if a function was enabled or disabled directly.
+  void SyncEnabledGeneration() const CALLER_MUST_LOCK(m_mutex) {
+    uint64_t enabled_generation = FunctionBase::GetEnabledGeneration();
+    if (enabled_generation != m_enabled_generation) {
+      InvalidateSchemas();
+      m_enabled_generation = enabled_generation;
+    }
+  }
 
+  /// Serializes `ReloadMCPServers` calls.
+  std::mutex m_reload_mutex;
   mutable std::mutex m_mutex;
   std::map<std::string, std::shared_ptr<FunctionBase>> m_functions
       GUARDED_BY(m_mutex);
   std::vector<std::shared_ptr<MCPClient>> m_clients GUARDED_BY(m_mutex);
+  /// An MCP server started by `ReloadMCPServers`.
+  struct ConfigServer {
+    std::shared_ptr<MCPClient> client;
+    /// The functions it registered.
+    std::vector<std::string> functions;
+  };
+  /// The servers started by `ReloadMCPServers`, by settings.
+  std::map<std::string, ConfigServer> m_servers GUARDED_BY(m_mutex);
+  /// The serialized tools, per endpoint kind and cache policy.
+  mutable std::map<std::pair<EndpointKind, CachePolicy>,
+                   std::shared_ptr<const ToolsSchema>>
+      m_schemas GUARDED_BY(m_mutex);
+  mutable uint64_t m_version GUARDED_BY(m_mutex){0};
+  /// `FunctionBase::GetEnabledGeneration()` when `m_schemas` was last checked.
+  mutable uint64_t m_enabled_generation GUARDED_BY(m_mutex){0};
   friend std::ostream& operator<<(std::ostream& os, const FunctionTable& table);
 };
 
@@ -475,11 +628,11 @@ class InProcessFunction : public FunctionBase {
 
 class ExternalFunction : public FunctionBase {
  public:
-  ExternalFunction(assistant::MCPClient* client, mcp::tool t);
+  ExternalFunction(std::shared_ptr<assistant::MCPClient> client, mcp::tool t);
   FunctionResult Call(const json& args) const override;
 
  protected:
-  assistant::MCPClient* m_client{nullptr};
+  std::shared_ptr<assistant::MCPClient> m_client;
   mcp::tool m_tool;
 };
 
@@ -1,14 +1,18 @@
 #pragma once
 
+#include <charconv>
+#include <cstring>
 #include <filesystem>
 #include <fstream>
 #include <functional>
+#include <initializer_list>
 #include <iostream>
 #include <mutex>
 #include <optional>
 #include <random>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <type_traits>
 #include <vector>
 
@@ -190,6 +194,556 @@ try_read_jsons_from_string(const std::string& instr) {
   return {result, remainder};
 }
 
+/**
+ * @brief Incremental decoder for a stream of concatenated JSON values, such as
+ * the NDJSON stream returned by Ollama's "/api/chat".
+ *
+ * Unlike `try_read_jsons_from_string`, the decoder keeps its scanning state
+ * between calls: every `Feed` only scans the newly received bytes for the end
+ * of the current JSON value (tracking nesting depth and string/escape state)
+ * and parses each complete value exactly once. The cost of decoding a stream
+ * is therefore linear in its size, regardless of how it is chunked.
+ *
+ * If the stream contains something that is not a JSON object or array (for
+ * example, a plain text error body), the decoder stops and keeps the data so
+ * it can be reported by the caller via `Pending()`.
+ */
+class JsonStreamDecoder {
+ public:
+  /// What `FeedFrames` does after a frame was handled.
+  enum class FrameAction {
+    kContinue,
+    kStop,
+    /// The frame is balanced, but not valid JSON: keep it for error
+    /// reporting and stop decoding.
+    kInvalid,
+  };
+
+  /**
+   * @brief Appends `data` and invokes `on_json` for every complete JSON value.
+   *
+   * @param data The newly received bytes.
+   * @param on_json A callable with the signature `bool(nlohmann::ordered_json)`.
+   * Return false to stop decoding.
+   * @return false if `on_json` requested to stop, true otherwise.
+   */
+  template <typename Callback>
+  bool Feed(std::string_view data, Callback&& on_json) {
+    return FeedFrames(data, [&on_json](std::string_view frame) {
+      nlohmann::ordered_json j;
+      try {
+        j = nlohmann::ordered_json::parse(frame);
+      } catch (const nlohmann::json::exception&) {
+        return FrameAction::kInvalid;
+      }
+      return on_json(std::move(j)) ? FrameAction::kContinue
+                                   : FrameAction::kStop;
+    });
+  }
+
+  /**
+   * @brief Like `Feed`, but hands out every complete value as the raw text,
+   * so the caller can decode it without building a DOM.
+   *
+   * @param on_frame A callable with the signature
+   * `FrameAction(std::string_view)`. The view is valid during the call only.
+   * @return false if `on_frame` requested to stop, true otherwise.
+   */
+  template <typename Callback>
+  bool FeedFrames(std::string_view data, Callback&& on_frame) {
+    m_buffer.append(data.data(), data.size());
+    bool keep_going{true};
+    while (keep_going && !m_stalled) {
+      auto frame_end = ScanFrame();
+      if (!frame_end.has_value()) {
+        break;
+      }
+
+      std::string_view frame{m_buffer.data() + m_consumed,
+                             frame_end.value() - m_consumed};
+      FrameAction action = on_frame(frame);
+      if (action == FrameAction::kInvalid) {
+        m_stalled = true;
+        break;
+      }
+      m_consumed = frame_end.value();
+      keep_going = action == FrameAction::kContinue;
+    }
+    Compact();
+    return keep_going;
+  }
+
+  /// Returns the bytes received but not yet decoded.
+  inline std::string_view Pending() const {
+    return std::string_view{m_buffer}.substr(m_consumed);
+  }
+
+  /// Returns true if the decoder found data that is not JSON.
+  inline bool IsStalled() const { return m_stalled; }
+
+  inline void Reset() { *this = JsonStreamDecoder{}; }
+
+ private:
+  /// Scans from the last position. Returns the offset one past the end of
+  /// the first complete JSON value, or nullopt if more data is needed.
+  std::optional<size_t> ScanFrame() {
+    const size_t n = m_buffer.size();
+    size_t pos = m_scan_pos;
+    while (pos < n) {
+      char c = m_buffer[pos];
+      if (m_depth == 0) {
+        if (c == ' ' || c == '\n' || c == '\r' || c == '\t') {
+          // Whitespace between values is consumed as-is.
+          m_consumed = ++pos;
+          continue;
+        }
+        if (c != '{' && c != '[') {
+          m_stalled = true;
+          m_scan_pos = pos;
+          return std::nullopt;
+        }
+        m_consumed = pos;
+        m_depth = 1;
+        ++pos;
+        continue;
+      }
+
+      if (m_in_string) {
+        if (m_escape) {
+          m_escape = false;
+          ++pos;
+          continue;
+        }
+        // Skip quickly over the string body.
+        size_t special = m_buffer.find_first_of("\"\\", pos);
+        if (special == std::string::npos) {
+          pos = n;
+          break;
+        }
+        if (m_buffer[special] == '\\') {
+          m_escape = true;
+        } else {
+          m_in_string = false;
+        }
+        pos = special + 1;
+        continue;
+      }
+
+      switch (c) {
+        case '"':
+          m_in_string = true;
+          break;
+        case '{':
+        case '[':
+          ++m_depth;
+          break;
+        case '}':
+        case ']':
+          if (--m_depth == 0) {
+            m_scan_pos = pos + 1;
+            return m_scan_pos;
+          }
+          break;
+        default:
+          break;
+      }
+      ++pos;
+    }
+    m_scan_pos = pos;
+    return std::nullopt;
+  }
+
+  /// Drops the decoded prefix of the buffer. Only the (partial) value that is
+  /// still pending is moved.
+  void Compact() {
+    if (m_consumed == 0) {
+      return;
+    }
+    m_buffer.erase(0, m_consumed);
+    m_scan_pos -= m_consumed;
+    m_consumed = 0;
+  }
+
+  std::string m_buffer;
+  /// Start of the data that was not decoded yet.
+  size_t m_consumed{0};
+  /// Where the next scan resumes.
+  size_t m_scan_pos{0};
+  size_t m_depth{0};
+  bool m_in_string{false};
+  bool m_escape{false};
+  bool m_stalled{false};
+};
+
+/**
+ * @brief Base class for the SAX decoders of the streamed deltas.
+ *
+ * A streamed delta is a small JSON object of which the client reads one or
+ * two fields (e.g. `delta.text`). Building an `ordered_json` DOM for it
+ * allocates a node per member; a SAX pass only tracks the path of the current
+ * value and lets the derived class pick the values it needs. The strings are
+ * handed out by reference, so they can be moved straight into the result.
+ *
+ * The path is a list of object keys and array indices (as decimal strings),
+ * e.g. `{"choices", "0", "delta", "content"}`. The path entries are reused
+ * between values, so decoding allocates only for the strings themselves.
+ *
+ * A callback returns false to abort the pass: use it to reject a shape the
+ * decoder does not know, and fall back to the DOM.
+ */
+class JsonPathSax : public nlohmann::json_sax<nlohmann::ordered_json> {
+ public:
+  /// Runs a SAX pass over `data`. Returns false if `data` is not valid JSON
+  /// or if the handler rejected it.
+  bool Decode(std::string_view data) {
+    m_depth = 0;
+    return nlohmann::ordered_json::sax_parse(data, this);
+  }
+
+  bool null() override { return Value() && OnNull(); }
+  bool boolean(bool val) override { return Value() && OnBool(val); }
+  bool number_integer(number_integer_t val) override {
+    return Value() && OnNumber(static_cast<double>(val));
+  }
+  bool number_unsigned(number_unsigned_t val) override {
+    return Value() && OnNumber(static_cast<double>(val));
+  }
+  bool number_float(number_float_t val, const string_t&) override {
+    return Value() && OnNumber(val);
+  }
+  bool string(string_t& val) override { return Value() && OnString(val); }
+  bool binary(binary_t&) override { return false; }
+  bool start_object(std::size_t) override {
+    return Value() && OnStartObject() && Push(false);
+  }
+  bool key(string_t& val) override {
+    m_path[m_depth - 1].assign(val);
+    return OnKey();
+  }
+  bool end_object() override {
+    --m_depth;
+    return true;
+  }
+  bool start_array(std::size_t) override { return Value() && Push(true); }
+  bool end_array() override {
+    --m_depth;
+    return true;
+  }
+  bool parse_error(std::size_t, const std::string&,
+                   const nlohmann::detail::exception&) override {
+    return false;
+  }
+
+ protected:
+  /// Returns true if the path of the current value (or of the key just read)
+  /// is `path`.
+  bool PathIs(std::initializer_list<std::string_view> path) const {
+    if (path.size() != m_depth) {
+      return false;
+    }
+    size_t i{0};
+    for (auto part : path) {
+      if (m_path[i++] != part) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /// The depth of the current value: 1 for the members of the root object.
+  inline size_t Depth() const { return m_depth; }
+
+  /// Returns the `i`-th entry of the current path, `i < Depth()`.
+  inline std::string_view PathAt(size_t i) const { return m_path[i]; }
+
+  virtual bool OnNull() { return true; }
+  virtual bool OnBool(bool) { return true; }
+  virtual bool OnNumber(double) { return true; }
+  virtual bool OnString(std::string&) { return true; }
+  /// Called when an object starts, with the path of the object itself.
+  virtual bool OnStartObject() { return true; }
+  /// Called for every key, with the path of the value that follows.
+  virtual bool OnKey() { return true; }
+
+ private:
+  /// Assigns its index to a value that is an element of an array.
+  bool Value() {
+    if (m_depth > 0 && m_is_array[m_depth - 1]) {
+      char buf[24];
+      auto res = std::to_chars(buf, buf + sizeof(buf), m_index[m_depth - 1]++);
+      m_path[m_depth - 1].assign(buf, res.ptr);
+    }
+    return true;
+  }
+
+  bool Push(bool is_array) {
+    if (m_depth == m_path.size()) {
+      m_path.emplace_back();
+      m_is_array.push_back(false);
+      m_index.push_back(0);
+    }
+    m_path[m_depth].clear();
+    m_is_array[m_depth] = is_array;
+    m_index[m_depth] = 0;
+    ++m_depth;
+    return true;
+  }
+
+  std::vector<std::string> m_path;
+  std::vector<bool> m_is_array;
+  std::vector<size_t> m_index;
+  size_t m_depth{0};
+};
+
+/// One event of a Server-Sent Events stream. The views stay valid until the
+/// next call to `SseFramer::Append`, `SseFramer::Next` or `SseFramer::Reset`.
+struct SseEvent {
+  /// The value of the "event:" field, empty if the event has none.
+  std::string_view event;
+  /// The values of the "data:" fields, joined with "\n".
+  std::string_view data;
+};
+
+enum class SseFraming {
+  /// An event ends with a blank line, as per the SSE specification.
+  kStrict,
+  /// An event also ends when a new "event:" field starts, or when no more
+  /// complete lines are buffered. This accepts streams that omit the blank
+  /// line between events, at the cost of splitting a multi-line "data:" that
+  /// arrives in two separate chunks.
+  kLenient,
+};
+
+/**
+ * @brief Incremental framer for a Server-Sent Events (SSE) stream, as
+ * returned by the Anthropic and OpenAI streaming APIs.
+ *
+ * The received chunks are appended to a single buffer, and the lines are
+ * found with `memchr` and handed out as views into it: nothing is copied per
+ * line. The consumed prefix of the buffer is dropped once per `Append`, so
+ * the cost of framing a stream is linear in its size. Lines may end with
+ * "\n" or "\r\n", comments (":...") and unknown fields are skipped, and the
+ * "data:" lines of an event are joined with "\n" (only then is the data
+ * copied).
+ */
+class SseFramer {
+ public:
+  explicit SseFramer(SseFraming framing = SseFraming::kStrict)
+      : m_framing{framing} {}
+
+  /// Appends newly received bytes. Invalidates the last returned event.
+  void Append(std::string_view data) {
+    Compact();
+    m_buffer.append(data.data(), data.size());
+  }
+
+  /// Returns the next complete event, or nullopt if more data is needed.
+  std::optional<SseEvent> Next() {
+    if (m_dispatched) {
+      ClearEvent();
+    }
+
+    const char* base = m_buffer.data();
+    const size_t n = m_buffer.size();
+    while (m_pos < n) {
+      const char* eol = static_cast<const char*>(
+          std::memchr(base + m_pos, '\n', n - m_pos));
+      if (eol == nullptr) {
+        break;
+      }
+      size_t line_end = static_cast<size_t>(eol - base);
+      size_t next_line = line_end + 1;
+      if (line_end > m_pos && base[line_end - 1] == '\r') {
+        --line_end;
+      }
+      std::string_view line{base + m_pos, line_end - m_pos};
+
+      if (line.empty()) {
+        m_pos = next_line;
+        if (m_has_data) {
+          return Dispatch();
+        }
+        // An event without data is dropped.
+        ClearEvent();
+        continue;
+      }
+
+      if (line[0] == ':') {
+        // A comment.
+        m_pos = next_line;
+        continue;
+      }
+
+      size_t colon = line.find(':');
+      std::string_view field = line.substr(0, colon);
+      std::string_view value;
+      if (colon != std::string_view::npos) {
+        value = line.substr(colon + 1);
+        if (!value.empty() && value[0] == ' ') {
+          value.remove_prefix(1);
+        }
+      }
+
+      if (field == "event") {
+        if (m_framing == SseFraming::kLenient && m_has_data) {
+          // A new event starts: the line is processed by the next call.
+          return Dispatch();
+        }
+        m_event.assign(value.data(), value.size());
+      } else if (field == "data") {
+        AddData(static_cast<size_t>(value.data() - base), value.size());
+      }
+      m_pos = next_line;
+    }
+
+    if (m_framing == SseFraming::kLenient && m_has_data) {
+      return Dispatch();
+    }
+    return std::nullopt;
+  }
+
+  /// Returns the number of bytes received but not yet framed.
+  inline size_t GetPendingBytes() const { return m_buffer.size() - m_pos; }
+
+  inline void Reset() {
+    m_buffer.clear();
+    m_pos = 0;
+    ClearEvent();
+  }
+
+ private:
+  void AddData(size_t offset, size_t len) {
+    if (!m_has_data) {
+      // Common case: a single "data:" line, kept as a view into the buffer.
+      m_has_data = true;
+      m_data_offset = offset;
+      m_data_len = len;
+      return;
+    }
+    if (!m_data_owned) {
+      m_data.assign(m_buffer, m_data_offset, m_data_len);
+      m_data_owned = true;
+    }
+    m_data.push_back('\n');
+    m_data.append(m_buffer, offset, len);
+  }
+
+  SseEvent Dispatch() {
+    m_dispatched = true;
+    std::string_view data =
+        m_data_owned ? std::string_view{m_data}
+                     : std::string_view{m_buffer}.substr(m_data_offset,
+                                                         m_data_len);
+    return SseEvent{.event = m_event, .data = data};
+  }
+
+  void ClearEvent() {
+    m_event.clear();
+    m_data.clear();
+    m_has_data = false;
+    m_data_owned = false;
+    m_dispatched = false;
+  }
+
+  /// Drops the framed prefix of the buffer. Only the (partial) line that is
+  /// still pending is moved.
+  void Compact() {
+    if (m_dispatched) {
+      ClearEvent();
+    }
+    if (m_pos == 0) {
+      return;
+    }
+    if (m_has_data && !m_data_owned) {
+      // The event continues in the next chunk: its data can no longer point
+      // into the buffer.
+      m_data.assign(m_buffer, m_data_offset, m_data_len);
+      m_data_owned = true;
+    }
+    m_buffer.erase(0, m_pos);
+    m_pos = 0;
+  }
+
+  SseFraming m_framing{SseFraming::kStrict};
+  std::string m_buffer;
+  /// Start of the first line that was not framed yet.
+  size_t m_pos{0};
+  /// The event being collected.
+  std::string m_event;
+  bool m_has_data{false};
+  /// If true, the data is in `m_data`, otherwise it is
+  /// `m_buffer[m_data_offset, m_data_offset + m_data_len)`.
+  bool m_data_owned{false};
+  size_t m_data_offset{0};
+  size_t m_data_len{0};
+  std::string m_data;
+  /// True if the event was returned by `Next`, and must be cleared.
+  bool m_dispatched{false};
+};
+
+/**
+ * @brief A `std::streambuf` that forwards the written data to a callback, in
+ * chunks of (at most) `chunk_size` bytes.
+ *
+ * Use it to serialize a large JSON value directly into a destination (e.g. an
+ * HTTP body) without building the whole string first. If the callback returns
+ * false, the stream is marked as failed and the rest of the data is dropped.
+ */
+class CallbackStreamBuf : public std::streambuf {
+ public:
+  using Callback = std::function<bool(const char* data, size_t len)>;
+
+  explicit CallbackStreamBuf(Callback cb, size_t chunk_size = 64 * 1024)
+      : m_callback(std::move(cb)), m_buffer(chunk_size) {
+    setp(m_buffer.data(), m_buffer.data() + m_buffer.size());
+  }
+  ~CallbackStreamBuf() override { sync(); }
+
+ protected:
+  int_type overflow(int_type ch) override {
+    if (!Flush()) {
+      return traits_type::eof();
+    }
+    if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+      *pptr() = traits_type::to_char_type(ch);
+      pbump(1);
+    }
+    return traits_type::not_eof(ch);
+  }
+
+  std::streamsize xsputn(const char* s, std::streamsize count) override {
+    // Large writes bypass the buffer.
+    if (static_cast<size_t>(count) >= m_buffer.size()) {
+      if (!Flush() || !Emit(s, static_cast<size_t>(count))) {
+        return 0;
+      }
+      return count;
+    }
+    return std::streambuf::xsputn(s, count);
+  }
+
+  int sync() override { return Flush() ? 0 : -1; }
+
+ private:
+  bool Flush() {
+    size_t len = pptr() - pbase();
+    setp(m_buffer.data(), m_buffer.data() + m_buffer.size());
+    return len == 0 || Emit(m_buffer.data(), len);
+  }
+
+  bool Emit(const char* data, size_t len) {
+    if (m_failed) {
+      return false;
+    }
+    m_failed = !m_callback(data, len);
+    return !m_failed;
+  }
+
+  Callback m_callback;
+  std::vector<char> m_buffer;
+  bool m_failed{false};
+};
+
 /**
  * @brief Writes a string content to a file. The string is not assumed to be
  * null-terminated.
@@ -213,19 +767,17 @@ inline bool WriteStringToFile(const std::string& filepath,
 }
 
 /**
- * @brief Generates a unique random filename and writes the string content to
- * it.
+ * @brief Generates a unique random filename and writes content to it.
  *
  * This function creates a file with a randomly generated name in the system's
- * temporary directory and writes the specified data to it. The string is not
- * assumed to be null-terminated.
+ * temporary directory and lets `writer` write its content directly into it.
  *
- * @param content The string content to write to the file.
+ * @param writer Writes the file content.
  * @return std::optional<std::string> containing the full path to the created
  *         file on success, or std::nullopt on failure.
  */
-inline std::optional<std::string> WriteStringToRandomFile(
-    const std::string& content) {
+inline std::optional<std::string> WriteToRandomFile(
+    const std::function<void(std::ostream& os)>& writer) {
   namespace fs = std::filesystem;
 
   // Get the system's temporary directory
@@ -256,17 +808,32 @@ inline std::optional<std::string> WriteStringToRandomFile(
     }
 
     // Try to write to the file
-    if (WriteStringToFile(filepath.string(), content)) {
-      return filepath.string();
-    } else {
+    std::ofstream file(filepath, std::ios::binary);
+    if (!file.is_open()) {
+      return std::nullopt;
+    }
+    writer(file);
+    if (!file.good()) {
       return std::nullopt;
     }
+    return filepath.string();
   }
 
   // Failed to generate a unique filename after max attempts
   return std::nullopt;
 }
 
+/**
+ * @brief Generates a unique random filename and writes the string content to
+ * it. See `WriteToRandomFile`.
+ */
+inline std::optional<std::string> WriteStringToRandomFile(
+    const std::string& content) {
+  return WriteToRandomFile([&content](std::ostream& os) {
+    os.write(content.data(), content.size());
+  });
+}
+
 /**
  * @brief Deletes a file at the specified path.
  *
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <chrono>
 #include <fstream>
 #include <functional>
@@ -37,7 +38,19 @@ class Logger {
 
   void SetLogLevel(LogLevel level) {
     std::lock_guard lock{mutex_};
-    level_ = level;
+    level_.store(level, std::memory_order_relaxed);
+    UpdateThreshold();
+  }
+
+  LogLevel GetLogLevel() const {
+    return level_.load(std::memory_order_relaxed);
+  }
+
+  /// Return true if a message with the given level will be emitted. This is a
+  /// single relaxed atomic load, so it is cheap enough to be checked before a
+  /// log message is formatted (see the OLOG macro).
+  inline bool IsEnabled(LogLevel level) const {
+    return level >= threshold_.load(std::memory_order_relaxed);
   }
 
   void SetLogFile(const std::string& filepath) {
@@ -48,9 +61,22 @@ class Logger {
     }
   }
 
-  void SetLogSink(std::function<void(LogLevel, std::string)> sink) {
+  /// Forward log messages to `sink` instead of the default logging system.
+  /// The sink receives every message whose level is at least `min_level`.
+  /// The default, kTrace, forwards everything and lets the sink do its own
+  /// filtering; pass a higher level to avoid formatting messages the sink
+  /// would discard anyway. Passing an empty sink restores the default logging
+  /// system.
+  void SetLogSink(std::function<void(LogLevel, std::string)> sink,
+                  LogLevel min_level = LogLevel::kTrace) {
     std::lock_guard lock{mutex_};
-    m_log_sink = std::move(sink);
+    if (sink) {
+      m_log_sink = std::move(sink);
+    } else {
+      m_log_sink.reset();
+    }
+    sink_level_ = min_level;
+    UpdateThreshold();
   }
 
   void trace(const std::stringstream& ss) { log(LogLevel::kTrace, ss); }
@@ -60,9 +86,20 @@ class Logger {
   void error(const std::stringstream& ss) { log(LogLevel::kError, ss); }
 
  private:
-  Logger() : level_(LogLevel::kInfo) {}
+  Logger() = default;
+
+  /// Re-compute the level below which messages are dropped before they are
+  /// formatted. Must be called with `mutex_` held.
+  void UpdateThreshold() {
+    threshold_.store(m_log_sink.has_value() ? sink_level_ : level_.load(),
+                     std::memory_order_relaxed);
+  }
 
   void log(LogLevel level, const std::stringstream& msg) {
+    if (!IsEnabled(level)) {
+      return;
+    }
+
     if (m_log_sink.has_value()) {
       // If the user provided its own sink, use it instead of the default
       // logging system.
@@ -70,10 +107,6 @@ class Logger {
       return;
     }
 
-    if (level < level_) {
-      return;
-    }
-
     // Add timestamp
     std::stringstream ss;
     auto now = std::chrono::system_clock::now();
@@ -138,7 +171,9 @@ class Logger {
     return "";
   }
 
-  LogLevel level_;
+  std::atomic<LogLevel> level_{LogLevel::kInfo};
+  LogLevel sink_level_{LogLevel::kTrace};
+  std::atomic<LogLevel> threshold_{LogLevel::kInfo};
   std::mutex mutex_;
   std::optional<std::function<void(LogLevel, std::string)>> m_log_sink{
       std::nullopt};
@@ -180,15 +215,26 @@ inline void SetLogFile(const std::string& filepath) {
   Logger::Instance().SetLogFile(filepath);
 }
 
-inline void SetLogSink(std::function<void(LogLevel, std::string)> sink) {
-  Logger::Instance().SetLogSink(std::move(sink));
+inline void SetLogSink(std::function<void(LogLevel, std::string)> sink,
+                       LogLevel min_level = LogLevel::kTrace) {
+  Logger::Instance().SetLogSink(std::move(sink), min_level);
+}
+
+inline bool IsLogEnabled(LogLevel level) {
+  return Logger::Instance().IsEnabled(level);
 }
 
 }  // namespace assistant
 
 using OLogLevel = assistant::LogLevel;
 
-#define OLOG(level) assistant::LogStream(level)
+/// The level check happens before the stream is constructed: when the level
+/// is filtered out, none of the `<<` operands are evaluated. The "if/else"
+/// form keeps the macro safe to use as the body of an unbraced if statement.
+#define OLOG(level)                              \
+  if (!assistant::IsLogEnabled(level)) {         \
+  } else                                         \
+    assistant::LogStream(level)
 
 #define OLOG_DEBUG() OLOG(assistant::LogLevel::kDebug)
 #define OLOG_INFO() OLOG(assistant::LogLevel::kInfo)
@@ -8,6 +8,10 @@
 namespace assistant {
 
 namespace {
+/// The request timeouts used once the server is up (the cpp-mcp defaults).
+constexpr std::chrono::seconds kStdioRequestTimeout{60};
+constexpr int kSseTimeoutSeconds = 5;
+
 void WrapWithDoubleQuotes(std::string& s) {
   if (!s.empty()                             // not empty
       && (s.find(" ") != std::string::npos)  // contains space
@@ -34,6 +38,23 @@ void EscapeDoubleQuotes(std::string& str) {
   }
   str.swap(result);
 }
+
+/// Return the time left before `deadline`, throws if it already passed.
+std::chrono::milliseconds TimeLeft(
+    std::chrono::steady_clock::time_point deadline) {
+  auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+      deadline - std::chrono::steady_clock::now());
+  if (left.count() <= 0) {
+    throw std::runtime_error("MCP server startup deadline exceeded");
+  }
+  return left;
+}
+
+/// The SSE client timeouts are in whole seconds.
+int TimeLeftSeconds(std::chrono::steady_clock::time_point deadline) {
+  auto left = TimeLeft(deadline);
+  return static_cast<int>((left.count() + 999) / 1000);
+}
 }  // namespace
 
 MCPClient::MCPClient(const std::vector<std::string>& args,
@@ -55,22 +76,27 @@ MCPClient::MCPClient(const SSHLogin& ssh_login,
                      std::optional<assistant::json> env)
     : m_args(args), m_ssh_login(ssh_login), m_env(std::move(env)) {}
 
-bool MCPClient::InitialiseSSE() {
+bool MCPClient::InitialiseSSE(
+    std::chrono::steady_clock::time_point deadline) {
   try {
-    auto c = new mcp::sse_client(m_base_url, m_sse_endpoint);
+    auto c = std::make_unique<mcp::sse_client>(m_base_url, m_sse_endpoint);
     if (!m_auth_token.empty()) {
       c->set_auth_token(m_auth_token);
     }
     // For now set an **empty** json array for capabilities to avoid sending a
     // null one.
     c->set_capabilities(json({}));
+    c->set_timeout(TimeLeftSeconds(deadline));
     c->initialize("assistant", "1.0");
     for (const auto& [k, v] : m_headers) {
       c->set_header(k, v);
     }
+    c->set_timeout(TimeLeftSeconds(deadline));
     c->ping();
+    c->set_timeout(TimeLeftSeconds(deadline));
     m_tools = c->get_tools();
-    m_client.reset(c);
+    c->set_timeout(kSseTimeoutSeconds);
+    m_client = std::move(c);
     return true;
   } catch (std::exception& e) {
     OLOG(LogLevel::kWarning) << e.what();
@@ -78,7 +104,8 @@ bool MCPClient::InitialiseSSE() {
   }
 }
 
-bool MCPClient::InitialiseStdio() {
+bool MCPClient::InitialiseStdio(
+    std::chrono::steady_clock::time_point deadline) {
   try {
     std::stringstream ss;
     for (size_t i = 0; i < m_args.size(); ++i) {
@@ -121,10 +148,17 @@ bool MCPClient::InitialiseStdio() {
                    ? m_env.value()
                    : assistant::json::object();
 
-    m_client.reset(new mcp::stdio_client(command, env));
-    m_client->initialize("assistant", "1.0");
-    m_client->ping();
-    m_tools = m_client->get_tools();
+    auto c = std::make_unique<mcp::stdio_client>(command, env);
+    c->set_request_timeout(TimeLeft(deadline));
+    if (!c->initialize("assistant", "1.0")) {
+      throw std::runtime_error("MCP server failed to initialise: " + command);
+    }
+    c->set_request_timeout(TimeLeft(deadline));
+    c->ping();
+    c->set_request_timeout(TimeLeft(deadline));
+    m_tools = c->get_tools();
+    c->set_request_timeout(kStdioRequestTimeout);
+    m_client = std::move(c);
     OLOG(LogLevel::kInfo) << "Success!";
     return true;
   } catch (std::exception& e) {
@@ -133,11 +167,12 @@ bool MCPClient::InitialiseStdio() {
   }
 }
 
-bool MCPClient::Initialise() {
+bool MCPClient::Initialise(std::chrono::milliseconds timeout) {
+  auto deadline = std::chrono::steady_clock::now() + timeout;
   if (m_is_sse) {
-    return InitialiseSSE();
+    return InitialiseSSE(deadline);
   } else {
-    return InitialiseStdio();
+    return InitialiseStdio(deadline);
   }
 }
 
@@ -153,8 +188,10 @@ std::vector<std::shared_ptr<FunctionBase>> MCPClient::GetFunctions() const {
   std::vector<std::shared_ptr<FunctionBase>> result;
   result.reserve(m_tools.size());
   for (auto t : m_tools) {
+    // The functions share the ownership of the client, so an in-flight call
+    // keeps the server alive even if the table is reloaded meanwhile.
     std::shared_ptr<FunctionBase> f = std::make_shared<ExternalFunction>(
-        const_cast<MCPClient*>(this), std::move(t));
+        std::const_pointer_cast<MCPClient>(shared_from_this()), std::move(t));
     result.push_back(std::move(f));
   }
   return result;
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <chrono>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -9,6 +11,10 @@
 namespace assistant {
 class ExternalFunction;
 
+/// How long a server may take to start, answer "initialize", "ping" and
+/// "tools/list".
+constexpr std::chrono::milliseconds kMCPStartupTimeoutDefault{30000};
+
 struct SSHLogin {
   std::string ssh_program{"ssh"};
   std::string ssh_key;
@@ -17,7 +23,7 @@ struct SSHLogin {
   int port{22};
 };
 
-class MCPClient {
+class MCPClient : public std::enable_shared_from_this<MCPClient> {
  public:
   MCPClient(const std::vector<std::string>& args,
             std::optional<assistant::json> env = {});
@@ -29,15 +35,18 @@ class MCPClient {
             std::optional<assistant::json> env = {});
   ~MCPClient() = default;
 
-  bool Initialise();
+  /// Start the server and fetch its tools. Returns false if any step fails
+  /// or if the whole sequence takes longer than `timeout`.
+  bool Initialise(
+      std::chrono::milliseconds timeout = kMCPStartupTimeoutDefault);
   inline bool IsRemote() const { return m_ssh_login.has_value(); }
   inline const std::vector<mcp::tool>& GetTools() const { return m_tools; }
   FunctionResult Call(const mcp::tool& t, const json& args) const;
   std::vector<std::shared_ptr<FunctionBase>> GetFunctions() const;
 
  private:
-  bool InitialiseStdio();
-  bool InitialiseSSE();
+  bool InitialiseStdio(std::chrono::steady_clock::time_point deadline);
+  bool InitialiseSSE(std::chrono::steady_clock::time_point deadline);
 
   std::vector<std::string> m_args;
   std::vector<mcp::tool> m_tools;
@@ -0,0 +1,276 @@
+#include "assistant/model_cache.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <system_error>
+
+#include "assistant/logger.hpp"
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace assistant {
+
+namespace {
+constexpr int kModelCacheFileVersion = 1;
+
+/// A temporary file next to `path`, unique to this process and call: the
+/// processes sharing the cache file do not write the same temporary file.
+std::string MakeTempPath(const std::string& path) {
+#ifdef _WIN32
+  int pid = _getpid();
+#else
+  int pid = static_cast<int>(::getpid());
+#endif
+  thread_local std::mt19937_64 gen{std::random_device{}()};
+  std::ostringstream oss;
+  oss << path << "." << pid << "." << std::hex << gen() << ".tmp";
+  return oss.str();
+}
+}  // namespace
+
+bool ModelCapabilitiesCache::IsFresh(const Entry& entry,
+                                     Clock::time_point now) const {
+  auto ttl = entry.ok ? m_ttl : std::min(m_ttl, kModelCacheRetryDefault);
+  return now < entry.fetched_at + ttl;
+}
+
+ModelCapabilities ModelCapabilitiesCache::Get(const std::string& endpoint,
+                                              const std::string& model,
+                                              const Fetcher& fetch) {
+  Key key{endpoint, model};
+  std::promise<ModelCapabilities> promise;
+  std::shared_future<ModelCapabilities> pending;
+  {
+    std::scoped_lock lk{m_mutex};
+    auto iter = m_entries.find(key);
+    if (iter != m_entries.end() && IsFresh(iter->second, Clock::now())) {
+      return iter->second.flags;
+    }
+    auto fetch_iter = m_fetches.find(key);
+    if (fetch_iter != m_fetches.end()) {
+      pending = fetch_iter->second;
+    } else {
+      m_fetches.insert({key, promise.get_future().share()});
+    }
+  }
+  if (pending.valid()) {
+    // Another thread is fetching this model, wait for it without the lock.
+    return pending.get();
+  }
+
+  std::optional<ModelCapabilities> fetched;
+  try {
+    fetched = fetch(model);
+  } catch (const std::exception& e) {
+    OLOG(LogLevel::kWarning) << "Failed to fetch the capabilities of model "
+                             << model << ". " << e.what();
+  } catch (...) {
+    OLOG(LogLevel::kWarning) << "Failed to fetch the capabilities of model "
+                             << model;
+  }
+
+  ModelCapabilities flags{ModelCapabilities::kNone};
+  {
+    std::scoped_lock lk{m_mutex};
+    auto& entry = m_entries[key];
+    if (fetched.has_value()) {
+      entry = Entry{fetched.value(), Clock::now(), true};
+    } else {
+      // Keep the previous capabilities, if any, until the next attempt.
+      entry.fetched_at = Clock::now();
+      entry.ok = false;
+    }
+    flags = entry.flags;
+    m_fetches.erase(key);
+  }
+  promise.set_value(flags);
+
+  if (fetched.has_value()) {
+    Save();
+  }
+  return flags;
+}
+
+std::optional<ModelCapabilities> ModelCapabilitiesCache::Peek(
+    const std::string& endpoint, const std::string& model) const {
+  std::scoped_lock lk{m_mutex};
+  auto iter = m_entries.find({endpoint, model});
+  if (iter == m_entries.end()) {
+    return std::nullopt;
+  }
+  return iter->second.flags;
+}
+
+void ModelCapabilitiesCache::WarmUp(const std::string& endpoint,
+                                    std::vector<std::string> models,
+                                    Fetcher fetch) {
+  // The previous warm-up thread, which ran out of jobs.
+  std::thread finished;
+  {
+    std::scoped_lock lk{m_mutex};
+    auto now = Clock::now();
+    for (auto& model : models) {
+      auto iter = m_entries.find({endpoint, model});
+      if (model.empty() ||
+          (iter != m_entries.end() && IsFresh(iter->second, now))) {
+        continue;
+      }
+      m_warmup_jobs.push_back({endpoint, std::move(model), fetch});
+    }
+    if (m_warmup_running || m_warmup_jobs.empty()) {
+      return;
+    }
+    m_warmup_running = true;
+    finished = std::move(m_warmup);
+    m_warmup = std::thread{&ModelCapabilitiesCache::RunWarmUp, this};
+  }
+  if (finished.joinable()) {
+    finished.join();
+  }
+}
+
+void ModelCapabilitiesCache::RunWarmUp() {
+  while (true) {
+    WarmUpJob job;
+    {
+      std::scoped_lock lk{m_mutex};
+      if (m_warmup_jobs.empty()) {
+        m_warmup_running = false;
+        return;
+      }
+      job = std::move(m_warmup_jobs.front());
+      m_warmup_jobs.pop_front();
+    }
+    Get(job.endpoint, job.model, job.fetch);
+  }
+}
+
+void ModelCapabilitiesCache::CancelWarmUp() {
+  std::scoped_lock lk{m_mutex};
+  m_warmup_jobs.clear();
+}
+
+void ModelCapabilitiesCache::Wait() {
+  std::thread warmup;
+  {
+    std::scoped_lock lk{m_mutex};
+    warmup = std::move(m_warmup);
+  }
+  if (warmup.joinable()) {
+    warmup.join();
+  }
+}
+
+void ModelCapabilitiesCache::SetTTL(std::chrono::seconds ttl) {
+  std::scoped_lock lk{m_mutex};
+  m_ttl = ttl;
+}
+
+size_t ModelCapabilitiesCache::SetFile(const std::string& path) {
+  std::vector<std::pair<Key, Entry>> loaded;
+  if (!path.empty()) {
+    std::ifstream input{path};
+    auto content = json::parse(input, nullptr, false);
+    if (content.is_object() &&
+        content.value("version", 0) == kModelCacheFileVersion &&
+        content.contains("models") && content["models"].is_array()) {
+      for (const auto& item : content["models"]) {
+        try {
+          Entry entry{
+              static_cast<ModelCapabilities>(item["capabilities"].get<int>()),
+              Clock::time_point{
+                  std::chrono::seconds{item["fetched_at"].get<int64_t>()}},
+              true};
+          loaded.push_back({{item["endpoint"].get<std::string>(),
+                             item["model"].get<std::string>()},
+                            entry});
+        } catch (...) {
+          OLOG(LogLevel::kWarning)
+              << "Ignoring invalid model cache entry: " << item.dump();
+        }
+      }
+    }
+  }
+
+  std::scoped_lock lk{m_mutex};
+  m_file = path;
+  for (auto& [key, entry] : loaded) {
+    auto iter = m_entries.find(key);
+    if (iter == m_entries.end() ||
+        iter->second.fetched_at < entry.fetched_at) {
+      m_entries[key] = entry;
+    }
+  }
+  if (!loaded.empty()) {
+    OLOG(LogLevel::kInfo) << "Loaded the capabilities of " << loaded.size()
+                          << " models from " << path;
+  }
+  return loaded.size();
+}
+
+void ModelCapabilitiesCache::Clear() {
+  std::scoped_lock lk{m_mutex};
+  m_entries.clear();
+}
+
+void ModelCapabilitiesCache::Save() {
+  // Hold the file lock while taking the snapshot: the last write is always
+  // the most recent content.
+  std::scoped_lock file_lk{m_file_mutex};
+  std::string path;
+  json content = {{"version", kModelCacheFileVersion},
+                  {"models", json::array()}};
+  {
+    std::scoped_lock lk{m_mutex};
+    if (m_file.empty()) {
+      return;
+    }
+    path = m_file;
+    for (const auto& [key, entry] : m_entries) {
+      if (!entry.ok) {
+        continue;
+      }
+      content["models"].push_back(
+          {{"endpoint", key.first},
+           {"model", key.second},
+           {"capabilities", static_cast<int>(entry.flags)},
+           {"fetched_at", std::chrono::duration_cast<std::chrono::seconds>(
+                              entry.fetched_at.time_since_epoch())
+                              .count()}});
+    }
+  }
+
+  // Write a temporary file and rename it, so that a concurrent process never
+  // reads a partial file.
+  std::error_code ec;
+  std::filesystem::path file{path};
+  if (file.has_parent_path()) {
+    std::filesystem::create_directories(file.parent_path(), ec);
+  }
+  std::string tmp_path = MakeTempPath(path);
+  {
+    std::ofstream output{tmp_path, std::ios::trunc};
+    output << content.dump();
+    if (!output) {
+      OLOG(LogLevel::kWarning) << "Failed to write the model cache: " << path;
+      output.close();
+      std::filesystem::remove(tmp_path, ec);
+      return;
+    }
+  }
+  std::filesystem::rename(tmp_path, file, ec);
+  if (ec) {
+    OLOG(LogLevel::kWarning) << "Failed to write the model cache: " << path
+                             << ". " << ec.message();
+    std::filesystem::remove(tmp_path, ec);
+  }
+}
+
+}  // namespace assistant
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <future>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "assistant/attributes.hpp"
+#include "assistant/common.hpp"
+
+namespace assistant {
+
+/// How long the capabilities of a model are trusted before they are fetched
+/// again.
+constexpr std::chrono::seconds kModelCacheTTLDefault{24 * 60 * 60};
+/// How long a failed fetch is remembered before it is retried.
+constexpr std::chrono::seconds kModelCacheRetryDefault{30};
+
+/// The capabilities of the models, per endpoint. Lookups never hold the lock
+/// across a fetch: concurrent lookups of a model that is being fetched wait
+/// for that fetch, lookups of other models are not blocked by it. Entries
+/// expire after the TTL. The cache can be warmed up in the background and
+/// persisted to a file, so that a new process does not ask the server again.
+class ModelCapabilitiesCache {
+ public:
+  /// Ask the server for the capabilities of a model. Returns nullopt on
+  /// failure.
+  using Fetcher =
+      std::function<std::optional<ModelCapabilities>(const std::string&)>;
+
+  explicit ModelCapabilitiesCache(
+      std::chrono::seconds ttl = kModelCacheTTLDefault)
+      : m_ttl{ttl} {}
+  /// Cancels the warm-up and waits for the fetch in progress.
+  ~ModelCapabilitiesCache() {
+    CancelWarmUp();
+    Wait();
+  }
+
+  ModelCapabilitiesCache(const ModelCapabilitiesCache&) = delete;
+  ModelCapabilitiesCache& operator=(const ModelCapabilitiesCache&) = delete;
+
+  /// Return the capabilities of `model` at `endpoint`, fetching them when they
+  /// are missing or expired. A failed fetch returns kNone (or the expired
+  /// capabilities, if any) and is retried after `kModelCacheRetryDefault`.
+  ModelCapabilities Get(const std::string& endpoint, const std::string& model,
+                        const Fetcher& fetch) FUNCTION_LOCKS(m_mutex);
+
+  /// Return the cached capabilities of `model`, even if expired, without
+  /// fetching them.
+  std::optional<ModelCapabilities> Peek(const std::string& endpoint,
+                                        const std::string& model) const
+      FUNCTION_LOCKS(m_mutex);
+
+  /// Fetch the missing or expired capabilities of `models` on a background
+  /// thread. At most one warm-up thread runs at a time: when it is already
+  /// running, the models are queued to it. `fetch` must stay valid until
+  /// `Wait()` returns.
+  void WarmUp(const std::string& endpoint, std::vector<std::string> models,
+              Fetcher fetch) FUNCTION_LOCKS(m_mutex);
+
+  /// Drop the models waiting to be warmed up. Does not block: the fetch in
+  /// progress, if any, completes in the background.
+  void CancelWarmUp() FUNCTION_LOCKS(m_mutex);
+
+  /// Wait for the warm-up thread to complete.
+  void Wait() FUNCTION_LOCKS(m_mutex);
+
+  void SetTTL(std::chrono::seconds ttl) FUNCTION_LOCKS(m_mutex);
+
+  /// Load the entries persisted in `path`, and save the cache there after
+  /// every successful fetch. An empty path disables the persistence. Returns
+  /// the number of entries loaded.
+  size_t SetFile(const std::string& path) FUNCTION_LOCKS(m_mutex);
+
+  /// Drop all the entries (the file is left as-is).
+  void Clear() FUNCTION_LOCKS(m_mutex);
+
+ private:
+  using Clock = std::chrono::system_clock;
+  using Key = std::pair<std::string, std::string>;
+
+  struct Entry {
+    ModelCapabilities flags{ModelCapabilities::kNone};
+    Clock::time_point fetched_at;
+    /// False when the last fetch failed.
+    bool ok{false};
+  };
+
+  struct WarmUpJob {
+    std::string endpoint;
+    std::string model;
+    Fetcher fetch;
+  };
+
+  bool IsFresh(const Entry& entry, Clock::time_point now) const
+      CALLER_MUST_LOCK(m_mutex);
+  void Save() FUNCTION_LOCKS(m_mutex);
+  /// The warm-up thread: runs the queued jobs until there are none left.
+  void RunWarmUp() FUNCTION_LOCKS(m_mutex);
+
+  mutable std::mutex m_mutex;
+  std::map<Key, Entry> m_entries GUARDED_BY(m_mutex);
+  /// The fetches in progress.
+  std::map<Key, std::shared_future<ModelCapabilities>> m_fetches
+      GUARDED_BY(m_mutex);
+  std::deque<WarmUpJob> m_warmup_jobs GUARDED_BY(m_mutex);
+  /// True until the warm-up thread ran out of jobs.
+  bool m_warmup_running GUARDED_BY(m_mutex){false};
+  std::thread m_warmup GUARDED_BY(m_mutex);
+  std::chrono::seconds m_ttl GUARDED_BY(m_mutex);
+  std::string m_file GUARDED_BY(m_mutex);
+  /// Serializes the writes of the file.
+  std::mutex m_file_mutex;
+};
+
+}  // namespace assistant
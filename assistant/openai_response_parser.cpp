@@ -7,30 +7,45 @@
 
 namespace assistant {
 
-void OpenAIResponseParser::Parse(const std::string& data, OnParseCallback cb) {
-  // Append new data to buffer
-  m_line_buffer += data;
-
-  // Process complete lines
-  size_t pos = 0;
-  while ((pos = m_line_buffer.find('\n')) != std::string::npos) {
-    std::string line = m_line_buffer.substr(0, pos);
-    m_line_buffer = m_line_buffer.substr(pos + 1);
+bool OutputTextDeltaDecoder::DecodeContent(std::string_view data,
+                                           std::string& content) {
+  m_content = &content;
+  m_is_text_delta = false;
+  m_has_delta = false;
+  bool ok = Decode(data);
+  m_content = nullptr;
+  return ok && m_is_text_delta && m_has_delta;
+}
 
-    // Trim the line
-    line = assistant::trim(line);
+bool OutputTextDeltaDecoder::OnString(std::string& value) {
+  if (Depth() != 1) {
+    return true;
+  }
+  if (PathAt(0) == "type") {
+    m_is_text_delta = value == "response.output_text.delta";
+    return m_is_text_delta;
+  }
+  if (PathAt(0) == "delta") {
+    *m_content = std::move(value);
+    m_has_delta = true;
+  }
+  return true;
+}
 
-    // Skip empty lines
-    if (line.empty()) {
-      continue;
-    }
+bool OutputTextDeltaDecoder::OnKey() {
+  // The usage is read from the "response" object: use the DOM.
+  return Depth() != 1 || PathAt(0) != "response";
+}
 
-    ParseLine(line, cb);
+void OpenAIResponseParser::Parse(const std::string& data, OnParseCallback cb) {
+  m_framer.Append(data);
+  while (auto event = m_framer.Next()) {
+    ParseEvent(event.value(), cb);
   }
 
   // If buffer is getting too large without finding a newline, might be
   // incomplete
-  if (m_line_buffer.size() > 10000) {
+  if (m_framer.GetPendingBytes() > 10000) {
     OLOG(LogLevel::kWarning)
         << "OpenAI response parser: line buffer exceeded 10KB without "
            "finding newline";
@@ -38,20 +53,16 @@ void OpenAIResponseParser::Parse(const std::string& data, OnParseCallback cb) {
   }
 }
 
-void OpenAIResponseParser::ParseLine(const std::string& line,
-                                     OnParseCallback cb) {
+void OpenAIResponseParser::ParseEvent(const SseEvent& event,
+                                      OnParseCallback cb) {
   // OpenAI Responses API SSE format uses "event:" and "data:" lines
-  OLOG(LogLevel::kDebug) << line;
-  if (line.find("event: ") == 0) {
-    m_current_event = line.substr(7);
-    return;
-  }
-
-  if (line.find("data: ") != 0) {
-    return;
+  OLOG(LogLevel::kDebug) << "event: " << event.event << ", data: "
+                         << event.data;
+  if (!event.event.empty()) {
+    m_current_event = assistant::trim(event.event);
   }
 
-  std::string data_content = line.substr(6);  // Remove "data: " prefix
+  std::string_view data_content = assistant::trim(event.data);
 
   // Check for stream end marker
   if (data_content == "[DONE]") {
@@ -59,6 +70,15 @@ void OpenAIResponseParser::ParseLine(const std::string& line,
     return;
   }
 
+  if (m_current_event == "response.output_text.delta") {
+    // The bulk of the stream: decode it without building a DOM.
+    ParseResult result;
+    if (m_delta_decoder.DecodeContent(data_content, result.content)) {
+      cb(std::move(result));
+      return;
+    }
+  }
+
   try {
     auto json_obj = json::parse(data_content);
     // Determine the type
@@ -7,11 +7,31 @@
 
 #include "assistant/common.hpp"
 #include "assistant/common/json.hpp"
+#include "assistant/helpers.hpp"
 
 namespace assistant {
 
 using json = nlohmann::ordered_json;
 
+/// Decodes a `response.output_text.delta` event without building a DOM:
+/// {"type":"response.output_text.delta","item_id":"msg_1","delta":"Hi",...}
+/// An event that carries a "response" object is rejected.
+class OutputTextDeltaDecoder : public JsonPathSax {
+ public:
+  /// Moves the delta text into `content` and returns true if `data` is a
+  /// text delta.
+  bool DecodeContent(std::string_view data, std::string& content);
+
+ protected:
+  bool OnString(std::string& value) override;
+  bool OnKey() override;
+
+ private:
+  std::string* m_content{nullptr};
+  bool m_is_text_delta{false};
+  bool m_has_delta{false};
+};
+
 /// OpenAI streaming response parser for Server-Sent Events (SSE) format.
 /// OpenAI /v1/responses returns streaming responses in the following format:
 /// event: response.output_text.delta
@@ -75,10 +95,10 @@ class OpenAIResponseParser {
   void Parse(const std::string& data, OnParseCallback cb);
 
  private:
-  /// Parse a single SSE event line
-  /// @param line The SSE line to parse
+  /// Parse a single SSE event
+  /// @param event The SSE event to parse
   /// @param cb Callback function to invoke for parsed content
-  void ParseLine(const std::string& line, OnParseCallback cb);
+  void ParseEvent(const SseEvent& event, OnParseCallback cb);
 
   /// Extract content from OpenAI delta response
   /// @param json_obj The parsed JSON object
@@ -102,8 +122,10 @@ class OpenAIResponseParser {
 
   std::optional<std::vector<json>> ExtractOutput(const json& json_obj);
 
-  /// Buffer for incomplete lines
-  std::string m_line_buffer;
+  /// Splits the stream into events. Lenient framing also accepts
+  /// "event:"/"data:" pairs that are not separated by a blank line.
+  SseFramer m_framer{SseFraming::kLenient};
+  OutputTextDeltaDecoder m_delta_decoder;
   /// Current SSE event type (from "event:" line)
   std::string m_current_event;
 };
@@ -0,0 +1,69 @@
+#include "assistant/parallel.hpp"
+
+#include <thread>
+
+#include "assistant/logger.hpp"
+
+namespace assistant {
+
+namespace {
+/// The pool keeps at least this many threads available, whatever the number
+/// of cores: MCP server startups and tool calls mostly wait.
+constexpr size_t kMinPoolThreads = 16;
+}  // namespace
+
+WorkerPool& WorkerPool::Instance() {
+  // Never destroyed: its threads may still run during the process shutdown.
+  static WorkerPool* pool = new WorkerPool();
+  return *pool;
+}
+
+WorkerPool::WorkerPool()
+    : m_max_threads{std::max<size_t>(kMinPoolThreads,
+                                     2 * std::thread::hardware_concurrency())} {
+}
+
+void WorkerPool::Submit(std::function<void()> task) {
+  bool start_thread{false};
+  {
+    std::scoped_lock lk{m_mutex};
+    m_tasks.push_back(std::move(task));
+    if (m_idle < m_tasks.size() && m_threads < m_max_threads) {
+      ++m_threads;
+      start_thread = true;
+    }
+  }
+  if (start_thread) {
+    std::thread{&WorkerPool::Run, this}.detach();
+  } else {
+    m_cv.notify_one();
+  }
+}
+
+size_t WorkerPool::GetThreadsCount() const {
+  std::scoped_lock lk{m_mutex};
+  return m_threads;
+}
+
+void WorkerPool::Run() {
+  while (true) {
+    std::function<void()> task;
+    {
+      std::unique_lock lk{m_mutex};
+      ++m_idle;
+      m_cv.wait(lk, [this]() { return !m_tasks.empty(); });
+      --m_idle;
+      task = std::move(m_tasks.front());
+      m_tasks.pop_front();
+    }
+    try {
+      task();
+    } catch (const std::exception& e) {
+      OLOG(LogLevel::kError) << "Worker pool task failed. " << e.what();
+    } catch (...) {
+      OLOG(LogLevel::kError) << "Worker pool task failed.";
+    }
+  }
+}
+
+}  // namespace assistant
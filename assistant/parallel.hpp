@@ -0,0 +1,122 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+#include "assistant/attributes.hpp"
+
+namespace assistant {
+
+/// The threads shared by all the `ParallelFor` calls. A thread is started when
+/// a task is queued while all the threads are busy, up to `GetMaxThreads()`,
+/// and is kept for the next tasks, so repeated calls reuse the same threads.
+/// Idle threads sleep until a task is queued.
+class WorkerPool {
+ public:
+  /// Get the process wide pool.
+  static WorkerPool& Instance();
+
+  /// Queue `task`, it runs on a pool thread once one is free.
+  void Submit(std::function<void()> task) FUNCTION_LOCKS(m_mutex);
+
+  /// Number of threads started so far.
+  size_t GetThreadsCount() const FUNCTION_LOCKS(m_mutex);
+  size_t GetMaxThreads() const { return m_max_threads; }
+
+  WorkerPool(const WorkerPool&) = delete;
+  WorkerPool& operator=(const WorkerPool&) = delete;
+
+ private:
+  WorkerPool();
+  ~WorkerPool() = default;
+
+  void Run() FUNCTION_LOCKS(m_mutex);
+
+  const size_t m_max_threads;
+  mutable std::mutex m_mutex;
+  std::condition_variable m_cv;
+  std::deque<std::function<void()>> m_tasks GUARDED_BY(m_mutex);
+  size_t m_threads GUARDED_BY(m_mutex){0};
+  size_t m_idle GUARDED_BY(m_mutex){0};
+};
+
+/// Run `func(i)` for every `i` in `[0, count)` using at most `max_workers`
+/// threads: the calling thread and threads of the `WorkerPool`. Work items are
+/// handed out in order, one at a time, so a slow item does not hold back the
+/// others. Returns once all the items are done. If an item throws, the
+/// remaining items still run and the first exception is re-thrown in the
+/// calling thread.
+///
+/// The calling thread never waits for a pool thread to become free: when the
+/// pool is busy, it runs the items itself.
+template <typename Func>
+void ParallelFor(size_t count, size_t max_workers, Func&& func) {
+  size_t workers_count = std::min(count, std::max<size_t>(max_workers, 1));
+  if (workers_count <= 1) {
+    for (size_t i = 0; i < count; ++i) {
+      func(i);
+    }
+    return;
+  }
+
+  std::atomic_size_t next{0};
+  std::exception_ptr first_error{nullptr};
+  std::mutex error_mutex;
+  auto worker = [&]() {
+    for (size_t i = next.fetch_add(1); i < count; i = next.fetch_add(1)) {
+      try {
+        func(i);
+      } catch (...) {
+        std::scoped_lock lk{error_mutex};
+        if (!first_error) {
+          first_error = std::current_exception();
+        }
+      }
+    }
+  };
+
+  // The helpers that did not start before the calling thread ran out of items
+  // are dropped: they may not touch the (stack) state of this call anymore.
+  struct Helpers {
+    std::mutex mutex;
+    std::condition_variable cv;
+    size_t active{0};
+    bool closed{false};
+  };
+  auto helpers = std::make_shared<Helpers>();
+  for (size_t i = 0; i + 1 < workers_count; ++i) {
+    WorkerPool::Instance().Submit([helpers, &worker]() {
+      {
+        std::scoped_lock lk{helpers->mutex};
+        if (helpers->closed) {
+          return;
+        }
+        ++helpers->active;
+      }
+      worker();
+      {
+        std::scoped_lock lk{helpers->mutex};
+        --helpers->active;
+      }
+      helpers->cv.notify_all();
+    });
+  }
+  worker();
+  {
+    std::unique_lock lk{helpers->mutex};
+    helpers->closed = true;
+    helpers->cv.wait(lk, [&helpers]() { return helpers->active == 0; });
+  }
+
+  if (first_error) {
+    std::rethrow_exception(first_error);
+  }
+}
+
+}  // namespace assistant
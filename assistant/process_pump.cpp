@@ -0,0 +1,367 @@
+#include "assistant/process_pump.hpp"
+
+#ifdef __linux__
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/epoll.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+#include "assistant/logger.hpp"
+
+namespace assistant {
+
+struct ProcessPump::Entry {
+  struct Input {
+    int fd{-1};
+    std::string_view data;
+    size_t offset{0};
+  };
+
+  pid_t pid{-1};
+  int pidfd{-1};
+  int stdout_fd{-1};
+  int stderr_fd{-1};
+  std::vector<Input> inputs;
+  OutputCallback on_output;
+  ExitCallback on_exit;
+  /// The output callback asked to stop: the output is read and dropped.
+  bool output_dropped{false};
+  bool reaped{false};
+  bool completed{false};
+  int exit_code{-1};
+};
+
+namespace {
+constexpr int kMaxEvents = 64;
+constexpr int kLingerPollMs = 10;
+/// How long the pump waits before retrying a failed epoll_wait, at most.
+constexpr int kMaxRetryDelayMs = 1000;
+
+void SetNonBlocking(int fd) {
+  int flags = fcntl(fd, F_GETFL, 0);
+  if (flags != -1) {
+    fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+  }
+}
+
+int OpenPidFd([[maybe_unused]] pid_t pid) {
+#ifdef SYS_pidfd_open
+  return static_cast<int>(::syscall(SYS_pidfd_open, pid, 0));
+#else
+  return -1;
+#endif
+}
+
+int ExitCode(int status) {
+  if (WIFEXITED(status)) {
+    return WEXITSTATUS(status);
+  } else if (WIFSIGNALED(status)) {
+    return 128 + WTERMSIG(status);
+  }
+  return -1;
+}
+}  // namespace
+
+ProcessPump& ProcessPump::Instance() {
+  // Never destroyed: children may still complete during the process shutdown.
+  static ProcessPump* pump = new ProcessPump();
+  return *pump;
+}
+
+ProcessPump::ProcessPump() : m_read_buffer(64 * 1024) {
+  m_epoll_fd = ::epoll_create1(EPOLL_CLOEXEC);
+  if (m_epoll_fd == -1) {
+    OLOG(LogLevel::kError) << "Failed to create the process pump epoll: "
+                           << strerror(errno) << ", using select() instead";
+    return;
+  }
+  m_available.store(true);
+  std::thread{&ProcessPump::Run, this}.detach();
+}
+
+bool ProcessPump::Add(Child child, OutputCallback on_output,
+                      ExitCallback on_exit) {
+  if (m_epoll_fd == -1) {
+    return false;
+  }
+  auto entry = std::make_shared<Entry>();
+  entry->pid = child.pid;
+  entry->pidfd = OpenPidFd(child.pid);
+  entry->stdout_fd = child.stdout_fd;
+  entry->stderr_fd = child.stderr_fd;
+  entry->on_output = std::move(on_output);
+  entry->on_exit = std::move(on_exit);
+  for (const auto& [fd, data] : child.inputs) {
+    if (data.empty()) {
+      ::close(fd);
+      continue;
+    }
+    SetNonBlocking(fd);
+    entry->inputs.push_back({fd, data});
+  }
+  SetNonBlocking(entry->stdout_fd);
+  SetNonBlocking(entry->stderr_fd);
+
+  std::scoped_lock lk{m_mutex};
+  m_children.insert({entry->pid, entry});
+  Watch(entry->stdout_fd, EPOLLIN, {entry, Kind::kStdout});
+  Watch(entry->stderr_fd, EPOLLIN, {entry, Kind::kStderr});
+  for (size_t i = 0; i < entry->inputs.size(); ++i) {
+    Watch(entry->inputs[i].fd, EPOLLOUT, {entry, Kind::kInput, i});
+  }
+  if (entry->pidfd != -1) {
+    Watch(entry->pidfd, EPOLLIN, {entry, Kind::kExit});
+  }
+  return true;
+}
+
+bool ProcessPump::Signal(pid_t pid, int sig) {
+  std::scoped_lock lk{m_mutex};
+  auto iter = m_children.find(pid);
+  if (iter == m_children.end() || iter->second->reaped) {
+    return false;
+  }
+  return ::kill(pid, sig) == 0;
+}
+
+size_t ProcessPump::size() const {
+  std::scoped_lock lk{m_mutex};
+  return m_children.size();
+}
+
+void ProcessPump::Watch(int fd, uint32_t events, Target target) {
+  uint64_t token = m_next_token++;
+  target.fd = fd;
+  m_targets.insert({token, std::move(target)});
+  m_tokens.insert_or_assign(fd, token);
+  epoll_event event{};
+  event.events = events;
+  event.data.u64 = token;
+  if (::epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, fd, &event) == -1) {
+    OLOG(LogLevel::kError) << "Failed to watch fd " << fd << ": "
+                           << strerror(errno);
+  }
+}
+
+void ProcessPump::Unwatch(int fd) {
+  ::epoll_ctl(m_epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+  auto iter = m_tokens.find(fd);
+  if (iter != m_tokens.end()) {
+    m_targets.erase(iter->second);
+    m_tokens.erase(iter);
+  }
+}
+
+bool ProcessPump::TryReap(Entry& entry) {
+  if (entry.reaped) {
+    return true;
+  }
+  int status = 0;
+  pid_t res = ::waitpid(entry.pid, &status, WNOHANG);
+  if (res == 0) {
+    return false;
+  }
+  if (res == -1 && errno == EINTR) {
+    return false;
+  }
+  // -1 is ECHILD: someone else reaped it, the exit code is unknown.
+  entry.exit_code = res == entry.pid ? ExitCode(status) : -1;
+  entry.reaped = true;
+  return true;
+}
+
+void ProcessPump::Handle(const Target& target) {
+  Entry& entry = *target.entry;
+  int fd = target.fd;
+  switch (target.kind) {
+    case Kind::kStdout:
+    case Kind::kStderr: {
+      ssize_t n = ::read(fd, m_read_buffer.data(), m_read_buffer.size());
+      if (n < 0 && (errno == EINTR || errno == EAGAIN)) {
+        return;
+      }
+      if (n > 0) {
+        if (entry.output_dropped) {
+          return;
+        }
+        std::string_view data{m_read_buffer.data(), static_cast<size_t>(n)};
+        bool keep_going = target.kind == Kind::kStdout
+                              ? entry.on_output(data, {})
+                              : entry.on_output({}, data);
+        if (!keep_going) {
+          entry.output_dropped = true;
+          Signal(entry.pid, SIGKILL);
+        }
+        return;
+      }
+      {
+        std::scoped_lock lk{m_mutex};
+        Unwatch(fd);
+      }
+      ::close(fd);
+      (target.kind == Kind::kStdout ? entry.stdout_fd : entry.stderr_fd) = -1;
+      CompleteIfDone(target.entry);
+      return;
+    }
+    case Kind::kInput: {
+      auto& input = entry.inputs[target.input_index];
+      bool open = true;
+      while (input.offset < input.data.size()) {
+        ssize_t n = ::write(fd, input.data.data() + input.offset,
+                            input.data.size() - input.offset);
+        if (n > 0) {
+          input.offset += static_cast<size_t>(n);
+        } else if (n < 0 && errno == EINTR) {
+          continue;
+        } else {
+          open = n < 0 && errno == EAGAIN;
+          if (n < 0 && errno == EPIPE) {
+            // SIGPIPE is blocked on this thread, consume it.
+            sigset_t pipe_set;
+            sigemptyset(&pipe_set);
+            sigaddset(&pipe_set, SIGPIPE);
+            timespec no_wait{};
+            ::sigtimedwait(&pipe_set, nullptr, &no_wait);
+          }
+          break;
+        }
+      }
+      if (open && input.offset < input.data.size()) {
+        return;
+      }
+      {
+        std::scoped_lock lk{m_mutex};
+        Unwatch(fd);
+      }
+      ::close(fd);
+      input.fd = -1;
+      return;
+    }
+    case Kind::kExit: {
+      {
+        std::scoped_lock lk{m_mutex};
+        if (!TryReap(entry)) {
+          // Interrupted: the pidfd stays readable and reports it again.
+          return;
+        }
+        Unwatch(fd);
+      }
+      ::close(fd);
+      entry.pidfd = -1;
+      CompleteIfDone(target.entry);
+      return;
+    }
+  }
+}
+
+void ProcessPump::CompleteIfDone(const std::shared_ptr<Entry>& entry) {
+  if (entry->completed || entry->stdout_fd != -1 || entry->stderr_fd != -1) {
+    return;
+  }
+  {
+    std::scoped_lock lk{m_mutex};
+    if (!entry->reaped) {
+      if (entry->pidfd == -1 && !TryReap(*entry)) {
+        if (std::find(m_lingering.begin(), m_lingering.end(), entry) ==
+            m_lingering.end()) {
+          m_lingering.push_back(entry);
+        }
+      }
+      if (!entry->reaped) {
+        // The pidfd reports the exit.
+        return;
+      }
+    }
+    std::erase(m_lingering, entry);
+    m_children.erase(entry->pid);
+    for (auto& input : entry->inputs) {
+      if (input.fd != -1) {
+        Unwatch(input.fd);
+        ::close(input.fd);
+        input.fd = -1;
+      }
+    }
+    if (entry->pidfd != -1) {
+      Unwatch(entry->pidfd);
+      ::close(entry->pidfd);
+      entry->pidfd = -1;
+    }
+  }
+  entry->completed = true;
+  if (entry->on_exit) {
+    entry->on_exit(entry->exit_code);
+  }
+}
+
+void ProcessPump::Run() {
+  // Writing to the input of a child that exited raises SIGPIPE on this
+  // thread: keep it blocked, the write fails with EPIPE instead.
+  sigset_t pipe_set;
+  sigemptyset(&pipe_set);
+  sigaddset(&pipe_set, SIGPIPE);
+  ::pthread_sigmask(SIG_BLOCK, &pipe_set, nullptr);
+
+  epoll_event events[kMaxEvents];
+  std::vector<std::shared_ptr<Entry>> lingering;
+  int retry_delay_ms = 0;
+  while (true) {
+    int timeout = -1;
+    {
+      std::scoped_lock lk{m_mutex};
+      if (!m_lingering.empty()) {
+        timeout = kLingerPollMs;
+      }
+    }
+
+    int n = ::epoll_wait(m_epoll_fd, events, kMaxEvents, timeout);
+    ++m_wakeups;
+    if (n == -1 && errno != EINTR) {
+      // The epoll instance is broken: the next children use select(). Keep
+      // serving the current ones, without spinning on the failure.
+      if (m_available.exchange(false)) {
+        OLOG(LogLevel::kError) << "epoll_wait failed: " << strerror(errno)
+                               << ", using select() for the next processes";
+      }
+      retry_delay_ms = std::clamp(retry_delay_ms * 2, kLingerPollMs,
+                                  kMaxRetryDelayMs);
+      std::this_thread::sleep_for(std::chrono::milliseconds(retry_delay_ms));
+    } else {
+      retry_delay_ms = 0;
+    }
+
+    for (int i = 0; i < n; ++i) {
+      Target target;
+      {
+        std::scoped_lock lk{m_mutex};
+        auto iter = m_targets.find(events[i].data.u64);
+        if (iter == m_targets.end()) {
+          continue;
+        }
+        target = iter->second;
+      }
+      Handle(target);
+    }
+
+    {
+      std::scoped_lock lk{m_mutex};
+      lingering = m_lingering;
+    }
+    for (const auto& entry : lingering) {
+      CompleteIfDone(entry);
+    }
+    lingering.clear();
+  }
+}
+
+}  // namespace assistant
+
+#endif
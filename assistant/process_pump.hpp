@@ -0,0 +1,113 @@
+#pragma once
+
+#ifdef __linux__
+
+#include <sys/types.h>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace assistant {
+
+/// A thread shared by all the child processes started by `Process`: it writes
+/// their input, reads their output and reaps them when they exit. It sleeps in
+/// `epoll_wait` while no child does anything: an idle child costs no wakeup.
+///
+/// The exit of a child is noticed through its pidfd. On kernels without
+/// pidfds, a child that closed its output but did not exit yet is checked for
+/// every 10 ms.
+///
+/// The callbacks run on the pump thread and must not block (in particular,
+/// they must not wait for another child to complete).
+class ProcessPump {
+ public:
+  /// Called with the output read from a child, one of `out` and `err` is
+  /// empty. Returning false kills the child and drops the rest of its output.
+  using OutputCallback =
+      std::function<bool(std::string_view out, std::string_view err)>;
+  /// Called once, after the output of the child was read until EOF and the
+  /// child was reaped.
+  using ExitCallback = std::function<void(int exit_code)>;
+
+  struct Child {
+    pid_t pid{-1};
+    int stdout_fd{-1};
+    int stderr_fd{-1};
+    /// Input pipes and what to write to them. Each pipe is closed once its
+    /// data was written, the data must stay valid until then.
+    std::vector<std::pair<int, std::string_view>> inputs;
+  };
+
+  /// Get the process wide pump.
+  static ProcessPump& Instance();
+
+  /// False if the pump could not create its epoll instance, or if waiting on
+  /// it failed: `Process` then falls back to its select() loops.
+  bool IsAvailable() const { return m_available.load(); }
+
+  /// Starts pumping `child`. The pump owns its file descriptors from now on.
+  /// Returns false, leaving the file descriptors to the caller, if the pump
+  /// could not create its epoll instance. A child added after a failed wait
+  /// is still served, by the retries of the pump.
+  bool Add(Child child, OutputCallback on_output, ExitCallback on_exit);
+
+  /// Sends `sig` to the child `pid`. Returns false if `pid` is not a child of
+  /// the pump or was already reaped (its pid may have been reused).
+  bool Signal(pid_t pid, int sig);
+
+  /// Number of children not reaped yet.
+  size_t size() const;
+
+  /// Number of times the pump thread woke up.
+  uint64_t Wakeups() const { return m_wakeups.load(); }
+
+  ProcessPump(const ProcessPump&) = delete;
+  ProcessPump& operator=(const ProcessPump&) = delete;
+
+ private:
+  struct Entry;
+  enum class Kind { kStdout, kStderr, kInput, kExit };
+  struct Target {
+    std::shared_ptr<Entry> entry;
+    Kind kind{Kind::kStdout};
+    size_t input_index{0};
+    int fd{-1};
+  };
+
+  ProcessPump();
+  ~ProcessPump() = default;
+
+  void Run();
+  void Watch(int fd, uint32_t events, Target target);
+  void Unwatch(int fd);
+  /// Handles an event on `target.fd`.
+  void Handle(const Target& target);
+  /// Reaps the child if it exited, never blocks. Call with `m_mutex` held.
+  bool TryReap(Entry& entry);
+  /// Calls `on_exit` if the child exited and its output is closed.
+  void CompleteIfDone(const std::shared_ptr<Entry>& entry);
+
+  mutable std::mutex m_mutex;
+  int m_epoll_fd{-1};
+  std::atomic_bool m_available{false};
+  /// The events carry a token rather than the fd: an event still queued for
+  /// a closed fd whose number was reused does not match the new target.
+  std::unordered_map<uint64_t, Target> m_targets;
+  std::unordered_map<int, uint64_t> m_tokens;
+  uint64_t m_next_token{1};
+  std::unordered_map<pid_t, std::shared_ptr<Entry>> m_children;
+  /// Children with a closed output that have no pidfd and did not exit yet.
+  std::vector<std::shared_ptr<Entry>> m_lingering;
+  std::vector<char> m_read_buffer;
+  std::atomic<uint64_t> m_wakeups{0};
+};
+
+}  // namespace assistant
+
+#endif
@@ -2,6 +2,7 @@
 
 #include <optional>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "assistant/function.hpp"
@@ -12,6 +13,10 @@ class ResponseParser {
  public:
   static std::optional<std::vector<FunctionCall>> GetTools(
       const assistant::response& resp) {
+    if (resp.get_chat_chunk().has_value()) {
+      // A decoded chunk has no tool calls.
+      return std::nullopt;
+    }
     try {
       json j = resp.as_json();
       std::vector<FunctionCall> calls;
@@ -44,18 +49,35 @@ class ResponseParser {
   }
 
   static std::optional<std::string> GetContent(const assistant::response& resp) {
+    auto content = GetContentView(resp);
+    if (!content.has_value()) {
+      return std::nullopt;
+    }
+    return std::string{content.value()};
+  }
+
+  /// Same as `GetContent`, without copying: the view is valid as long as
+  /// `resp` is.
+  static std::optional<std::string_view> GetContentView(
+      const assistant::response& resp) {
+    if (resp.get_chat_chunk().has_value()) {
+      return resp.as_simple_string();
+    }
     try {
-      json j = resp.as_json();
-      return j["message"]["content"];
+      const json& j = resp.as_json();
+      return j.at("message").at("content").get_ref<const std::string&>();
     } catch (std::exception& e) {
       return std::nullopt;
     }
   }
 
   static bool IsDone(const assistant::response& resp) {
+    if (resp.get_chat_chunk().has_value()) {
+      return resp.get_chat_chunk()->done;
+    }
     try {
-      json j = resp.as_json();
-      return j["done"];
+      const json& j = resp.as_json();
+      return j.at("done").get<bool>();
     } catch (std::exception&) {
     }
     return false;
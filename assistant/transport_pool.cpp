@@ -0,0 +1,125 @@
+#include "assistant/transport_pool.hpp"
+
+#include <exception>
+
+namespace assistant {
+
+TransportPool::Lease::~Lease() { Release(); }
+
+TransportPool::Lease::Lease(Lease&& other) noexcept {
+  *this = std::move(other);
+}
+
+TransportPool::Lease& TransportPool::Lease::operator=(Lease&& other) noexcept {
+  if (this == &other) {
+    return *this;
+  }
+  Release();
+  m_pool = std::move(other.m_pool);
+  m_key = std::move(other.m_key);
+  m_transport = std::move(other.m_transport);
+  m_connections = std::move(other.m_connections);
+  m_connections_at_acquire = other.m_connections_at_acquire;
+  m_uncaught_exceptions = other.m_uncaught_exceptions;
+  m_discard = other.m_discard;
+  return *this;
+}
+
+void TransportPool::Lease::Release() {
+  if (m_transport == nullptr) {
+    return;
+  }
+  // A lease released during stack unwinding means the request failed midway:
+  // the connection state is unknown, so never hand it to the next request.
+  if (std::uncaught_exceptions() > m_uncaught_exceptions) {
+    m_discard = true;
+  }
+  if (m_pool) {
+    m_pool->Return(*this);
+  }
+  m_transport.reset();
+  m_pool.reset();
+}
+
+TransportPool::Lease TransportPool::Acquire(const std::string& key,
+                                            const Factory& factory) {
+  Lease lease;
+  lease.m_key = key;
+  lease.m_uncaught_exceptions = std::uncaught_exceptions();
+  {
+    std::scoped_lock lk{m_mutex};
+    auto iter = m_idle.find(key);
+    if (iter != m_idle.end() && !iter->second.empty()) {
+      auto& idle = iter->second.back();
+      lease.m_transport = std::move(idle.transport);
+      lease.m_connections = std::move(idle.connections);
+      iter->second.pop_back();
+      ++m_stats.transports_reused;
+    }
+  }
+
+  if (lease.m_transport == nullptr) {
+    lease.m_transport = factory();
+    lease.m_connections = std::make_shared<std::atomic_size_t>(0);
+    lease.m_transport->setOnNewConnection(
+        [counter = lease.m_connections]() { counter->fetch_add(1); });
+    std::scoped_lock lk{m_mutex};
+    ++m_stats.transports_created;
+  }
+  lease.m_connections_at_acquire = lease.m_connections->load();
+  lease.m_pool = shared_from_this();
+  return lease;
+}
+
+TransportPool::Lease TransportPool::Unpooled(
+    std::unique_ptr<ITransport> transport) {
+  Lease lease;
+  lease.m_transport = std::move(transport);
+  return lease;
+}
+
+void TransportPool::Return(Lease& lease) {
+  bool opened_connection =
+      lease.m_connections->load() != lease.m_connections_at_acquire;
+  bool discard = lease.m_discard || lease.m_transport->wasInterrupted();
+
+  std::scoped_lock lk{m_mutex};
+  if (opened_connection) {
+    ++m_stats.connections_opened;
+  } else {
+    ++m_stats.connections_reused;
+  }
+
+  auto& idle = m_idle[lease.m_key];
+  if (discard || idle.size() >= m_max_idle_per_key) {
+    ++m_stats.transports_discarded;
+    return;
+  }
+  idle.push_back(IdleTransport{.transport = std::move(lease.m_transport),
+                               .connections = std::move(lease.m_connections)});
+}
+
+void TransportPool::Clear() {
+  std::unordered_map<std::string, std::vector<IdleTransport>> idle;
+  {
+    std::scoped_lock lk{m_mutex};
+    idle.swap(m_idle);
+  }
+  // Connections are closed here, outside of the lock.
+}
+
+size_t TransportPool::GetIdleCount() const {
+  std::scoped_lock lk{m_mutex};
+  size_t count{0};
+  for (const auto& [_, v] : m_idle) {
+    count += v.size();
+  }
+  return count;
+}
+
+TransportPoolStats TransportPool::GetStats() const {
+  std::scoped_lock lk{m_mutex};
+  return m_stats;
+}
+
+}  // namespace assistant
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "assistant/assistantlib.hpp"
+#include "assistant/attributes.hpp"
+
+namespace assistant {
+
+/// Counters collected by the TransportPool.
+struct TransportPoolStats {
+  /// Number of transports constructed because no idle one was available.
+  size_t transports_created{0};
+  /// Number of times an idle transport was handed out again.
+  size_t transports_reused{0};
+  /// Number of leases that opened at least one new connection to the server.
+  size_t connections_opened{0};
+  /// Number of leases that were served entirely over an already open
+  /// connection (no new TCP/TLS handshake).
+  size_t connections_reused{0};
+  /// Number of transports dropped instead of being returned to the pool
+  /// (interrupted, failed with an exception or the pool was full).
+  size_t transports_discarded{0};
+};
+
+/// A pool of warm transports, keyed by endpoint. Transports are handed out as
+/// `Lease` objects: when the lease goes out of scope, the transport is placed
+/// back in the pool so the next request to the same endpoint can re-use its
+/// open (keep-alive) connection.
+class TransportPool : public std::enable_shared_from_this<TransportPool> {
+ public:
+  using Factory = std::function<std::unique_ptr<ITransport>()>;
+
+  class Lease {
+   public:
+    Lease() = default;
+    ~Lease();
+
+    Lease(const Lease&) = delete;
+    Lease& operator=(const Lease&) = delete;
+    Lease(Lease&& other) noexcept;
+    Lease& operator=(Lease&& other) noexcept;
+
+    inline ITransport* get() const { return m_transport.get(); }
+    inline ITransport* operator->() const { return m_transport.get(); }
+    inline explicit operator bool() const { return m_transport != nullptr; }
+
+    /// Do not return the transport to the pool when this lease is released.
+    inline void Discard() { m_discard = true; }
+
+   private:
+    friend class TransportPool;
+    void Release();
+
+    std::shared_ptr<TransportPool> m_pool{nullptr};
+    std::string m_key;
+    std::unique_ptr<ITransport> m_transport{nullptr};
+    std::shared_ptr<std::atomic_size_t> m_connections{nullptr};
+    size_t m_connections_at_acquire{0};
+    int m_uncaught_exceptions{0};
+    bool m_discard{false};
+  };
+
+  static std::shared_ptr<TransportPool> Create(size_t max_idle_per_key = 4) {
+    return std::shared_ptr<TransportPool>(new TransportPool(max_idle_per_key));
+  }
+
+  /// Return an idle transport for `key`, or build a new one using `factory`.
+  Lease Acquire(const std::string& key, const Factory& factory)
+      FUNCTION_LOCKS(m_mutex);
+
+  /// Build a transport that is never returned to the pool.
+  static Lease Unpooled(std::unique_ptr<ITransport> transport);
+
+  /// Drop all idle transports (closing their connections).
+  void Clear() FUNCTION_LOCKS(m_mutex);
+
+  /// Number of idle transports currently held by the pool.
+  size_t GetIdleCount() const FUNCTION_LOCKS(m_mutex);
+
+  TransportPoolStats GetStats() const FUNCTION_LOCKS(m_mutex);
+
+ private:
+  explicit TransportPool(size_t max_idle_per_key)
+      : m_max_idle_per_key{max_idle_per_key} {}
+
+  struct IdleTransport {
+    std::unique_ptr<ITransport> transport;
+    std::shared_ptr<std::atomic_size_t> connections;
+  };
+
+  void Return(Lease& lease) FUNCTION_LOCKS(m_mutex);
+
+  mutable std::mutex m_mutex;
+  std::unordered_map<std::string, std::vector<IdleTransport>> m_idle
+      GUARDED_BY(m_mutex);
+  TransportPoolStats m_stats GUARDED_BY(m_mutex);
+  size_t m_max_idle_per_key{4};
+};
+
+}  // namespace assistant
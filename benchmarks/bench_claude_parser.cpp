@@ -0,0 +1,133 @@
+/// Replays a recorded-like Anthropic transcript (thinking, text and tool_use
+/// blocks, with a ping every 100 events) through claude::ResponseParser and
+/// reports the total and per-token cost.
+///
+/// Usage: bench_claude_parser [tokens] [iterations]
+
+#include <vector>
+
+#include "assistant/claude_response_parser.hpp"
+#include "benchmarks/bench_common.hpp"
+
+namespace {
+
+void AddEvent(std::string& stream, std::string_view event,
+              const std::string& data) {
+  stream.append("event: ").append(event).append("\n");
+  stream.append("data: ").append(data).append("\n\n");
+}
+
+void AddDelta(std::string& stream, size_t index, std::string_view type,
+              std::string_view field, const std::string& value) {
+  AddEvent(stream, "content_block_delta",
+           "{\"type\":\"content_block_delta\",\"index\":" +
+               std::to_string(index) + ",\"delta\":{\"type\":\"" +
+               std::string{type} + "\",\"" + std::string{field} + "\":\"" +
+               value + "\"}}");
+}
+
+/// Build a transcript with `tokens` deltas: 20% thinking, 75% text and 5%
+/// tool input.
+std::string BuildTranscript(size_t tokens) {
+  std::string stream;
+  AddEvent(stream, "message_start",
+           "{\"type\":\"message_start\",\"message\":{\"id\":\"msg_1\","
+           "\"type\":\"message\",\"role\":\"assistant\",\"content\":[],"
+           "\"model\":\"claude\",\"stop_reason\":null,\"usage\":{"
+           "\"input_tokens\":2048,\"output_tokens\":1}}}");
+
+  size_t thinking = tokens / 5;
+  size_t tool = tokens / 20;
+  size_t text = tokens - thinking - tool;
+  size_t events{0};
+  auto maybe_ping = [&stream, &events]() {
+    if (++events % 100 == 0) {
+      AddEvent(stream, "ping", "{\"type\": \"ping\"}");
+    }
+  };
+
+  AddEvent(stream, "content_block_start",
+           "{\"type\":\"content_block_start\",\"index\":0,\"content_block\":{"
+           "\"type\":\"thinking\",\"thinking\":\"\"}}");
+  for (size_t i = 0; i < thinking; ++i) {
+    AddDelta(stream, 0, "thinking_delta", "thinking",
+             "step " + std::to_string(i) + " ");
+    maybe_ping();
+  }
+  AddDelta(stream, 0, "signature_delta", "signature", "EqQBCgIYAhIM1gbcDa9G");
+  AddEvent(stream, "content_block_stop",
+           "{\"type\":\"content_block_stop\",\"index\":0}");
+
+  AddEvent(stream, "content_block_start",
+           "{\"type\":\"content_block_start\",\"index\":1,\"content_block\":{"
+           "\"type\":\"text\",\"text\":\"\"}}");
+  for (size_t i = 0; i < text; ++i) {
+    AddDelta(stream, 1, "text_delta", "text",
+             "token_" + std::to_string(i) + " ");
+    maybe_ping();
+  }
+  AddEvent(stream, "content_block_stop",
+           "{\"type\":\"content_block_stop\",\"index\":1}");
+
+  AddEvent(stream, "content_block_start",
+           "{\"type\":\"content_block_start\",\"index\":2,\"content_block\":{"
+           "\"type\":\"tool_use\",\"id\":\"toolu_1\",\"name\":\"write_file\","
+           "\"input\":{}}}");
+  AddDelta(stream, 2, "input_json_delta", "partial_json",
+           "{\\\"content\\\": \\\"");
+  for (size_t i = 0; i < tool; ++i) {
+    AddDelta(stream, 2, "input_json_delta", "partial_json",
+             "line " + std::to_string(i) + "\\\\n");
+    maybe_ping();
+  }
+  AddDelta(stream, 2, "input_json_delta", "partial_json", "\\\"}");
+  AddEvent(stream, "content_block_stop",
+           "{\"type\":\"content_block_stop\",\"index\":2}");
+
+  AddEvent(stream, "message_delta",
+           "{\"type\":\"message_delta\",\"delta\":{\"stop_reason\":"
+           "\"tool_use\",\"stop_sequence\":null},\"usage\":{"
+           "\"output_tokens\":" +
+               std::to_string(tokens) + "}}");
+  AddEvent(stream, "message_stop", "{\"type\":\"message_stop\"}");
+  return stream;
+}
+
+std::vector<std::string> Chunk(const std::string& stream, size_t chunk_size) {
+  std::vector<std::string> chunks;
+  for (size_t pos = 0; pos < stream.size(); pos += chunk_size) {
+    chunks.push_back(stream.substr(pos, chunk_size));
+  }
+  return chunks;
+}
+
+size_t Parse(const std::vector<std::string>& chunks) {
+  size_t bytes{0};
+  assistant::claude::ResponseParser parser;
+  for (const auto& chunk : chunks) {
+    parser.Parse(chunk, [&bytes](assistant::claude::ParseResult result) {
+      bytes += result.content.size() + result.tool_call.json_str.size();
+    });
+  }
+  return bytes;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  size_t tokens = bench::ArgOr(argc, argv, 1, 50000);
+  size_t iterations = bench::ArgOr(argc, argv, 2, 5);
+  assistant::SetLogLevel(assistant::LogLevel::kWarning);
+
+  auto transcript = BuildTranscript(tokens);
+  auto chunks = Chunk(transcript, 1400);
+  std::cout << "Transcript: " << tokens << " tokens, " << transcript.size()
+            << " bytes" << std::endl;
+
+  double ms = bench::Measure(
+      iterations, [&chunks]() { bench::DoNotOptimize(Parse(chunks)); });
+  bench::Report("claude::ResponseParser (total)", ms);
+  bench::Report("claude::ResponseParser (per 1k tokens)",
+                ms * 1000.0 / static_cast<double>(tokens));
+  return 0;
+}
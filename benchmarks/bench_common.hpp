@@ -0,0 +1,44 @@
+#pragma once
+
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+namespace bench {
+
+/// Run `func` `iterations` times and return the average wall time in
+/// milliseconds.
+inline double Measure(size_t iterations, const std::function<void()>& func) {
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < iterations; ++i) {
+    func();
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  return std::chrono::duration<double, std::milli>(elapsed).count() /
+         static_cast<double>(iterations);
+}
+
+inline void Report(const std::string& name, double ms) {
+  std::cout << std::left << std::setw(48) << name << std::right
+            << std::setw(12) << std::fixed << std::setprecision(3) << ms
+            << " ms" << std::endl;
+}
+
+/// Read an optional numeric argument from the command line.
+inline size_t ArgOr(int argc, char** argv, int index, size_t default_value) {
+  if (argc > index) {
+    return static_cast<size_t>(std::strtoull(argv[index], nullptr, 10));
+  }
+  return default_value;
+}
+
+/// Prevent the compiler from optimizing away a computed value.
+template <typename T>
+inline void DoNotOptimize(const T& value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+}  // namespace bench
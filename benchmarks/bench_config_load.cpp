@@ -0,0 +1,66 @@
+/// Loads a config with many MCP servers (each with an env block referencing
+/// environment variables) against a large environment, and reports the time
+/// spent in ConfigBuilder::FromContent and in the variable expansion alone.
+///
+/// Usage: bench_config_load [servers] [env_size] [iterations]
+
+#include <string>
+
+#include "assistant/config.hpp"
+#include "benchmarks/bench_common.hpp"
+
+int main(int argc, char** argv) {
+  size_t servers = bench::ArgOr(argc, argv, 1, 500);
+  size_t env_size = bench::ArgOr(argc, argv, 2, 2000);
+  size_t iterations = bench::ArgOr(argc, argv, 3, 5);
+  assistant::SetLogLevel(assistant::LogLevel::kWarning);
+  std::cout << servers << " MCP servers, " << env_size
+            << " environment variables, " << iterations << " iterations"
+            << std::endl;
+
+  assistant::EnvMap env;
+  for (size_t i = 0; i < env_size; ++i) {
+    env["VARIABLE_" + std::to_string(i)] = "value of variable " +
+                                           std::to_string(i);
+  }
+  env["HOME"] = "/home/user";
+  env["API_TOKEN"] = "secret";
+
+  assistant::json mcp_servers = assistant::json::object();
+  for (size_t i = 0; i < servers; ++i) {
+    std::string name = "server_" + std::to_string(i);
+    assistant::json server_env = assistant::json::object();
+    for (size_t k = 0; k < 10; ++k) {
+      server_env["SETTING_" + std::to_string(k)] =
+          "a plain value without any reference " + std::to_string(k);
+    }
+    server_env["TOKEN"] = "${API_TOKEN}";
+    server_env["DATA_DIR"] = "$HOME/.local/share/" + name;
+    mcp_servers[name] = {
+        {"type", "stdio"},
+        {"command",
+         {"$HOME/bin/mcp-server", "--name", name, "--verbose", "--port",
+          std::to_string(8000 + i)}},
+        {"env", server_env}};
+  }
+  std::string content =
+      assistant::json{{"mcp_servers", mcp_servers}}.dump();
+  assistant::json parsed = assistant::json::parse(content);
+
+  assistant::EnvExpander expander;
+  double expand_ms = bench::Measure(iterations, [&]() {
+    auto result = expander.ExpandWithResult(parsed, env);
+    bench::DoNotOptimize(result.IsSuccess());
+  });
+
+  size_t loaded = 0;
+  double load_ms = bench::Measure(iterations, [&]() {
+    auto result = assistant::ConfigBuilder::FromContent(content, env);
+    loaded = result.ok() ? result.config_->GetServers().size() : 0;
+  });
+
+  std::cout << loaded << " servers loaded" << std::endl;
+  bench::Report("expand the environment variables", expand_ms);
+  bench::Report("load the config", load_ms);
+  return 0;
+}
@@ -0,0 +1,81 @@
+/// Compares the byte-at-a-time token estimator (CountTokensScalar) against
+/// CountTokens on multi-MB tool outputs of different shapes, and counts a
+/// batch of tool outputs with the batch API.
+///
+/// Usage: bench_count_tokens [megabytes] [iterations]
+
+#include <string>
+#include <vector>
+
+#include "assistant/common/tokens.hpp"
+#include "benchmarks/bench_common.hpp"
+
+namespace {
+
+std::string Repeat(std::string_view pattern, size_t bytes) {
+  std::string text;
+  text.reserve(bytes + pattern.size());
+  while (text.size() < bytes) {
+    text.append(pattern);
+  }
+  return text;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  size_t megabytes = bench::ArgOr(argc, argv, 1, 8);
+  size_t iterations = bench::ArgOr(argc, argv, 2, 5);
+  size_t bytes = megabytes * 1024 * 1024;
+  std::cout << megabytes << " MB per input, " << iterations << " iterations"
+            << std::endl;
+
+  std::vector<std::pair<std::string, std::string>> inputs = {
+      {"prose",
+       Repeat("The quick brown fox jumps over the lazy dog, again and "
+              "again. ",
+              bytes)},
+      {"source code",
+       Repeat("    for (size_t i = 0; i < items.size(); ++i) {\n"
+              "      total += items[i].value_42 * 3;\n    }\n",
+              bytes)},
+      {"grep output",
+       Repeat("src/module/file_name.cpp:1234:  auto result = "
+              "ComputeSomething(arg1, arg2);\n",
+              bytes)},
+      {"indented json",
+       Repeat("        {\n            \"id\": 123456789,\n            "
+              "\"name\": \"value\"\n        },\n",
+              bytes)},
+      {"non-ascii", Repeat("Grüße aus Köln — テキスト 12345 ", bytes)},
+  };
+
+  size_t total = 0;
+  for (const auto& [name, text] : inputs) {
+    bench::Report(name + ": scalar", bench::Measure(iterations, [&]() {
+                    total += assistant::CountTokensScalar(text);
+                  }));
+    bench::Report(name + ": blocks", bench::Measure(iterations, [&]() {
+                    total += assistant::CountTokens(text);
+                  }));
+  }
+
+  std::vector<std::string_view> batch;
+  for (const auto& [name, text] : inputs) {
+    batch.push_back(text);
+  }
+  bench::Report("batch of all the inputs: one by one, scalar",
+                bench::Measure(iterations, [&]() {
+                  for (auto text : batch) {
+                    total += assistant::CountTokensScalar(text);
+                  }
+                }));
+  bench::Report("batch of all the inputs: batch API",
+                bench::Measure(iterations, [&]() {
+                  for (size_t count : assistant::CountTokens(batch)) {
+                    total += count;
+                  }
+                }));
+  bench::DoNotOptimize(total);
+  return 0;
+}
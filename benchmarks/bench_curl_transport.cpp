@@ -0,0 +1,98 @@
+/// Runs chat turns through the curl transport against a local server that
+/// streams an NDJSON response, from a process holding `ballast_mb` of
+/// resident memory (a large client process), and reports the latency per
+/// turn and the peak resident memory of the process and of its children.
+///
+/// Usage: bench_curl_transport [turns] [ballast_mb] [history_kb]
+
+#include <sys/resource.h>
+
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "assistant/Curl.hpp"
+#include "assistant/helpers.hpp"
+#include "benchmarks/bench_common.hpp"
+
+namespace {
+
+/// Peak resident memory, kB.
+long MaxRss(int who) {
+  rusage usage{};
+  getrusage(who, &usage);
+  return usage.ru_maxrss;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  size_t turns = bench::ArgOr(argc, argv, 1, 50);
+  size_t ballast_mb = bench::ArgOr(argc, argv, 2, 512);
+  size_t history_kb = bench::ArgOr(argc, argv, 3, 256);
+  assistant::SetLogLevel(assistant::LogLevel::kWarning);
+
+  auto curl_exe = assistant::Which("curl");
+  if (!curl_exe.has_value()) {
+    std::cerr << "curl is not in the PATH" << std::endl;
+    return 1;
+  }
+
+  // The response: 100 streamed tokens
+  std::string response_body;
+  for (int i = 0; i < 100; ++i) {
+    response_body +=
+        R"({"model":"llama","message":{"role":"assistant","content":"token "},"done":false})"
+        "\n";
+  }
+  response_body +=
+      R"({"model":"llama","message":{"role":"assistant","content":""},"done":true})"
+      "\n";
+
+  httplib::Server server;
+  server.Post("/api/chat",
+              [&](const httplib::Request&, httplib::Response& res) {
+                res.set_content(response_body, "application/x-ndjson");
+              });
+  int port = server.bind_to_any_port("127.0.0.1");
+  std::thread server_thread{[&server]() { server.listen_after_bind(); }};
+  server.wait_until_ready();
+
+  std::vector<char> ballast(ballast_mb * 1024 * 1024);
+  std::memset(ballast.data(), 1, ballast.size());
+
+  assistant::json messages = assistant::json::array();
+  messages.push_back({{"role", "system"}, {"content", "be nice"}});
+  messages.push_back(
+      {{"role", "user"}, {"content", std::string(history_kb * 1024, 'x')}});
+
+  assistant::Curl curl{curl_exe.value()};
+  curl.setServerURL("http://127.0.0.1:" + std::to_string(port));
+  size_t tokens = 0;
+  auto on_response = [](const assistant::response&, void* user_data) {
+    ++*static_cast<size_t*>(user_data);
+    return true;
+  };
+
+  long rss_before = MaxRss(RUSAGE_SELF);
+  double ms = bench::Measure(turns, [&]() {
+    assistant::request req{assistant::message_type::chat};
+    req["model"] = "llama";
+    req["messages"] = messages;
+    curl.chat(req, on_response, &tokens);
+  });
+
+  std::cout << turns << " turns, " << ballast_mb << " MB resident, "
+            << history_kb << " KB of history, " << tokens << " tokens"
+            << std::endl;
+  bench::Report("latency per turn", ms);
+  std::cout << "peak RSS of the process: " << rss_before << " kB -> "
+            << MaxRss(RUSAGE_SELF) << " kB" << std::endl;
+  std::cout << "peak RSS of a child process: " << MaxRss(RUSAGE_CHILDREN)
+            << " kB" << std::endl;
+
+  server.stop();
+  server_thread.join();
+  bench::DoNotOptimize(ballast.data());
+  return 0;
+}
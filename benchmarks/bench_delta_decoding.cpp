@@ -0,0 +1,103 @@
+/// Compares reading the content of a streamed delta from an ordered_json DOM
+/// (legacy) against the SAX decoders, for the four delta shapes: Ollama chat
+/// chunk, Anthropic content_block_delta, OpenAI Responses
+/// response.output_text.delta and Chat Completions choices[0].delta.
+///
+/// Usage: bench_delta_decoding [deltas] [iterations]
+
+#include "assistant/assistantlib.hpp"
+#include "assistant/chat_completions_response_parser.hpp"
+#include "assistant/claude_response_parser.hpp"
+#include "assistant/openai_response_parser.hpp"
+#include "benchmarks/bench_common.hpp"
+
+namespace {
+
+using json = nlohmann::ordered_json;
+
+constexpr std::string_view kOllama =
+    R"({"model":"qwen3:30b","created_at":"2025-01-01T00:00:00.000000Z","message":{"role":"assistant","content":"token_12345 "},"done":false})";
+constexpr std::string_view kClaude =
+    R"({"type":"content_block_delta","index":1,"delta":{"type":"text_delta","text":"token_12345 "}})";
+constexpr std::string_view kOpenAI =
+    R"({"type":"response.output_text.delta","sequence_number":42,"item_id":"msg_1","output_index":0,"content_index":0,"delta":"token_12345 ","logprobs":[]})";
+constexpr std::string_view kChatCompletions =
+    R"({"id":"chatcmpl-1","object":"chat.completion.chunk","created":1735689600,"model":"gpt-4o","system_fingerprint":"fp_1","choices":[{"index":0,"delta":{"content":"token_12345 "},"logprobs":null,"finish_reason":null}]})";
+
+template <typename Func>
+void Compare(const std::string& name, size_t deltas, size_t iterations,
+             Func&& dom, auto&& sax) {
+  bench::Report(name + ": ordered_json DOM",
+                bench::Measure(iterations, [&]() {
+                  for (size_t i = 0; i < deltas; ++i) {
+                    bench::DoNotOptimize(dom());
+                  }
+                }));
+  bench::Report(name + ": SAX decoder", bench::Measure(iterations, [&]() {
+                  for (size_t i = 0; i < deltas; ++i) {
+                    bench::DoNotOptimize(sax());
+                  }
+                }));
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  size_t deltas = bench::ArgOr(argc, argv, 1, 100000);
+  size_t iterations = bench::ArgOr(argc, argv, 2, 3);
+  std::cout << "Decoding " << deltas << " deltas per shape" << std::endl;
+
+  assistant::chat_chunk_decoder ollama_decoder;
+  Compare(
+      "ollama", deltas, iterations,
+      []() {
+        auto j = json::parse(kOllama);
+        return j["message"]["content"].get<std::string>().size();
+      },
+      [&ollama_decoder]() {
+        std::string content;
+        bool done{false};
+        ollama_decoder.decode(kOllama, content, done);
+        return content.size();
+      });
+
+  assistant::claude::ContentBlockDeltaDecoder claude_decoder;
+  Compare(
+      "claude", deltas, iterations,
+      []() {
+        auto j = json::parse(kClaude);
+        return j["delta"]["text"].get<std::string>().size();
+      },
+      [&claude_decoder]() {
+        return claude_decoder.DecodeContent(kClaude).value_or("").size();
+      });
+
+  assistant::OutputTextDeltaDecoder openai_decoder;
+  Compare(
+      "openai", deltas, iterations,
+      []() {
+        auto j = json::parse(kOpenAI);
+        return j["delta"].get<std::string>().size();
+      },
+      [&openai_decoder]() {
+        std::string content;
+        openai_decoder.DecodeContent(kOpenAI, content);
+        return content.size();
+      });
+
+  assistant::chat_completions::ChunkDecoder chat_completions_decoder;
+  Compare(
+      "chat completions", deltas, iterations,
+      []() {
+        auto j = json::parse(kChatCompletions);
+        return j["choices"][0]["delta"]["content"].get<std::string>().size();
+      },
+      [&chat_completions_decoder]() {
+        assistant::chat_completions::ParseResult result;
+        std::string finish_reason;
+        chat_completions_decoder.DecodeInto(kChatCompletions, result,
+                                            finish_reason);
+        return result.content.size();
+      });
+  return 0;
+}
@@ -0,0 +1,78 @@
+/// Reads the endpoint settings a client needs to build each chat request
+/// (transport key, URL, headers, model, token limits, thinking) from one
+/// thread and from several threads sharing the client, the way sessions
+/// running in parallel do.
+///
+/// Usage: bench_endpoint_reads [requests] [threads]
+
+#include <thread>
+#include <vector>
+
+#include "assistant/client/ollama_client.hpp"
+#include "benchmarks/bench_common.hpp"
+
+namespace {
+
+class Client : public assistant::OllamaClient {
+ public:
+  explicit Client(const assistant::Endpoint& endpoint)
+      : assistant::OllamaClient(endpoint) {}
+
+  /// The endpoint reads of one request
+  size_t ReadSettings() const {
+    size_t total = GetTransportKey().size();
+    total += GetUrl().size();
+    total += static_cast<size_t>(GetEndpointKind());
+    total += GetHttpHeaders().size();
+    total += GetModel().size();
+    total += GetMaxTokens() + GetContextSize();
+    total += IsThinking().value_or(false);
+    return total;
+  }
+};
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  size_t requests = bench::ArgOr(argc, argv, 1, 200000);
+  size_t threads = bench::ArgOr(argc, argv, 2, 4);
+  assistant::SetLogLevel(assistant::LogLevel::kWarning);
+
+  assistant::Endpoint endpoint;
+  endpoint.url_ = "https://api.example.com/v1/some/long/path/to/the/service";
+  endpoint.model_ = "a-model-with-a-long-enough-name:latest";
+  endpoint.models_ = {"model-a", "model-b", "model-c", "model-d"};
+  for (int i = 0; i < 8; ++i) {
+    endpoint.headers_["x-custom-header-" + std::to_string(i)] =
+        "a value that does not fit in the small string buffer";
+  }
+  Client client{endpoint};
+  std::cout << requests << " requests, " << threads << " threads"
+            << std::endl;
+
+  size_t total = 0;
+  bench::Report("1 thread", bench::Measure(1, [&]() {
+                  for (size_t i = 0; i < requests; ++i) {
+                    total += client.ReadSettings();
+                  }
+                }));
+
+  bench::Report(std::to_string(threads) + " threads",
+                bench::Measure(1, [&]() {
+                  std::vector<std::thread> workers;
+                  for (size_t t = 0; t < threads; ++t) {
+                    workers.emplace_back([&client, requests, threads]() {
+                      size_t sum = 0;
+                      for (size_t i = 0; i < requests / threads; ++i) {
+                        sum += client.ReadSettings();
+                      }
+                      bench::DoNotOptimize(sum);
+                    });
+                  }
+                  for (auto& worker : workers) {
+                    worker.join();
+                  }
+                }));
+  bench::DoNotOptimize(total);
+  return 0;
+}
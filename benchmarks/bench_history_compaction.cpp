@@ -0,0 +1,58 @@
+/// Runs a tool-heavy conversation and, after every turn, checks the number of
+/// tool responses and compacts the history the way the clients do, keeping
+/// the last 3 tool responses.
+///
+/// Usage: bench_history_compaction [turns] [tool_output_bytes]
+
+#include "assistant/client/client_base.hpp"
+#include "benchmarks/bench_common.hpp"
+
+using namespace assistant;
+
+int main(int argc, char** argv) {
+  size_t turns = bench::ArgOr(argc, argv, 1, 2000);
+  size_t tool_output_bytes = bench::ArgOr(argc, argv, 2, 4 * 1024);
+
+  std::string tool_output;
+  while (tool_output.size() < tool_output_bytes) {
+    tool_output += "result_line 12345 of the tool output;\n";
+  }
+  std::cout << turns << " turns, " << tool_output.size()
+            << " bytes per tool output" << std::endl;
+
+  // The trimming function of OllamaClient::Compact
+  auto trim = [](assistant::message& msg) {
+    size_t tokens_trimmed{0};
+    if (msg.contains("content") && msg["content"].is_string()) {
+      size_t count = CountTokens(msg["content"].get<std::string>());
+      if (count > kTrimMessageTokensCount) {
+        msg["content"] = kTrimMessage;
+        tokens_trimmed += (count - kTrimMessageTokensCount);
+      }
+    }
+    return tokens_trimmed;
+  };
+
+  History history;
+  double add_ms{0};
+  double compact_ms{0};
+  size_t trimmed{0};
+  for (size_t turn = 0; turn < turns; ++turn) {
+    add_ms += bench::Measure(1, [&]() {
+      history.AddMessage(assistant::message{"user", "run the tool again"},
+                         MessageType::kNormal);
+      history.AddMessage(assistant::message{"assistant", "calling the tool"},
+                         MessageType::kToolRequest);
+      history.AddMessage(assistant::message{"tool", tool_output},
+                         MessageType::kToolResponse);
+    });
+    compact_ms += bench::Measure(1, [&]() {
+      bench::DoNotOptimize(history.GetToolResponseCount());
+      trimmed += history.Compact(trim);
+    });
+  }
+  bench::Report("add the messages of all the turns", add_ms);
+  bench::Report("count + compact after every turn", compact_ms);
+  bench::DoNotOptimize(trimmed);
+  return 0;
+}
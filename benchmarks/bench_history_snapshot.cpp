@@ -0,0 +1,59 @@
+/// Compares building a chat request from a deep copy of the history (legacy)
+/// against building it from a structurally shared snapshot.
+///
+/// Usage: bench_history_snapshot [messages] [tool_output_bytes] [iterations]
+
+#include "assistant/client/client_base.hpp"
+#include "benchmarks/bench_common.hpp"
+
+using namespace assistant;
+
+int main(int argc, char** argv) {
+  size_t messages_count = bench::ArgOr(argc, argv, 1, 250);
+  size_t tool_output_bytes = bench::ArgOr(argc, argv, 2, 16 * 1024);
+  size_t iterations = bench::ArgOr(argc, argv, 3, 20);
+
+  History history;
+  std::string tool_output(tool_output_bytes, 'x');
+  for (size_t i = 0; i < messages_count; ++i) {
+    if (i % 2 == 0) {
+      history.AddMessage(assistant::message{"assistant", "calling a tool"},
+                         MessageType::kToolRequest);
+    } else {
+      history.AddMessage(assistant::message{"tool", tool_output},
+                         MessageType::kToolResponse);
+    }
+  }
+  std::cout << "History: " << messages_count << " messages, "
+            << tool_output_bytes << " bytes per tool output" << std::endl;
+
+  bench::Report("legacy: copy history + to_json + copy request",
+                bench::Measure(iterations, [&history]() {
+                  assistant::messages history_copy = history.GetMessages();
+                  assistant::request req{assistant::message_type::chat};
+                  req["messages"] = history_copy.to_json();
+                  ChatRequest ctx = {.callback_ = {},
+                                     .request_ = req,
+                                     .model_ = {},
+                                     .finaliser_ = nullptr,
+                                     .func_calls_ = {},
+                                     .messages_ = {}};
+                  auto shared = std::make_shared<ChatRequest>(ctx);
+                  bench::DoNotOptimize(shared);
+                }));
+
+  bench::Report("snapshot: share history + attach (streamed)",
+                bench::Measure(iterations, [&history]() {
+                  assistant::request req{assistant::message_type::chat};
+                  ChatRequest ctx = {.callback_ = {},
+                                     .request_ = std::move(req),
+                                     .model_ = {},
+                                     .finaliser_ = nullptr,
+                                     .func_calls_ = {},
+                                     .messages_ = history.GetSnapshot()};
+                  auto shared = std::make_shared<ChatRequest>(std::move(ctx));
+                  shared->AttachMessages();
+                  bench::DoNotOptimize(shared);
+                }));
+  return 0;
+}
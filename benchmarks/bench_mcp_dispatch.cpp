@@ -0,0 +1,219 @@
+/// Loads one mcp::server SSE session with many concurrent tools/call
+/// requests (far more than the thread pool has workers) and reports how long
+/// it takes to answer all of them, and how long a ping sent in the middle of
+/// the load waits for its response, with and without a concurrency limit on
+/// tools/call.
+///
+/// Usage: bench_mcp_dispatch [calls] [tool_us]
+
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "assistant/cpp-mcp/mcp_server.h"
+#include "assistant/helpers.hpp"
+#include "benchmarks/bench_common.hpp"
+
+namespace {
+
+using namespace std::chrono_literals;
+using json = mcp::json;
+using Clock = std::chrono::steady_clock;
+
+struct LoadResult {
+  double total_ms{0};
+  double ping_ms{0};
+};
+
+class Session {
+ public:
+  Session(int port, size_t tool_us, size_t limit)
+      : m_port{port}, m_server{"127.0.0.1", port} {
+    m_server.register_tool(
+        mcp::tool_builder("work").build(),
+        [tool_us](const json&, const std::string&) -> json {
+          // An I/O bound tool
+          std::this_thread::sleep_for(std::chrono::microseconds(tool_us));
+          return json::array({{{"type", "text"}, {"text", "done"}}});
+        });
+    if (limit > 0) {
+      m_server.set_method_concurrency("tools/call", limit);
+    }
+    m_server_thread = std::thread([this]() { m_server.start(true); });
+    m_sse_thread = std::thread([this]() { ReadEvents(); });
+  }
+
+  ~Session() {
+    m_stop = true;
+    // Close the keep-alive connection first: the server waits for it to end
+    m_ping_client.stop();
+    m_server.stop();
+    m_server_thread.join();
+    m_sse_thread.join();
+  }
+
+  bool Initialize() {
+    {
+      std::unique_lock lock{m_mutex};
+      if (!m_cv.wait_for(lock, 10s,
+                         [this]() { return !m_endpoint.empty(); })) {
+        return false;
+      }
+    }
+    Post({{"jsonrpc", "2.0"},
+          {"id", -1},
+          {"method", "initialize"},
+          {"params",
+           {{"protocolVersion", mcp::MCP_VERSION},
+            {"capabilities", json::object()},
+            {"clientInfo", {{"name", "bench"}}}}}});
+    if (!WaitFor(-1, 10s)) {
+      return false;
+    }
+    Post({{"jsonrpc", "2.0"}, {"method", "notifications/initialized"}});
+    std::this_thread::sleep_for(100ms);
+    return true;
+  }
+
+  LoadResult Load(int calls) {
+    LoadResult result;
+    m_ping_client.set_keep_alive(true);
+    m_ping_client.Post(m_endpoint,
+                       json{{"jsonrpc", "2.0"}, {"id", -2}, {"method", "ping"}}
+                           .dump(),
+                       "application/json");
+    WaitFor(-2, 10s);
+
+    auto start = Clock::now();
+    std::vector<std::thread> clients;
+    constexpr int kThreads = 16;
+    for (int t = 0; t < kThreads; ++t) {
+      clients.emplace_back([this, t, calls]() {
+        for (int i = t; i < calls; i += kThreads) {
+          Post({{"jsonrpc", "2.0"},
+                {"id", i},
+                {"method", "tools/call"},
+                {"params", {{"name", "work"}, {"arguments", json::object()}}}});
+        }
+      });
+    }
+
+    // Ping once the load is queued up, on a connection opened beforehand so
+    // that only the dispatch is measured
+    std::this_thread::sleep_for(50ms);
+    auto ping_start = Clock::now();
+    m_ping_client.Post(m_endpoint,
+                       json{{"jsonrpc", "2.0"}, {"id", calls}, {"method", "ping"}}
+                           .dump(),
+                       "application/json");
+    if (WaitFor(calls, 120s)) {
+      result.ping_ms =
+          std::chrono::duration<double, std::milli>(Clock::now() - ping_start)
+              .count();
+    }
+
+    for (auto& client : clients) {
+      client.join();
+    }
+    {
+      std::unique_lock lock{m_mutex};
+      m_cv.wait_for(lock, 120s, [this, calls]() {
+        return m_received >= static_cast<size_t>(calls) + 3;
+      });
+    }
+    result.total_ms =
+        std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    return result;
+  }
+
+ private:
+  void Post(const json& message) {
+    // Retry when the connection is refused: 16 clients connecting at once
+    // can overflow the listen backlog of the server.
+    for (int attempt = 0; attempt < 5; ++attempt) {
+      httplib::Client cli("127.0.0.1", m_port);
+      if (cli.Post(m_endpoint, message.dump(), "application/json")) {
+        return;
+      }
+    }
+  }
+
+  bool WaitFor(int id, std::chrono::seconds timeout) {
+    std::unique_lock lock{m_mutex};
+    return m_cv.wait_for(lock, timeout,
+                         [this, id]() { return m_ids.count(id) > 0; });
+  }
+
+  void ReadEvents() {
+    assistant::SseFramer framer;
+    for (int attempt = 0; attempt < 100 && !m_stop; ++attempt) {
+      httplib::Client cli("127.0.0.1", m_port);
+      cli.set_read_timeout(120, 0);
+      auto res = cli.Get("/sse", [this, &framer](const char* data, size_t len) {
+        framer.Append({data, len});
+        while (auto event = framer.Next()) {
+          std::lock_guard lock{m_mutex};
+          if (event->event == "endpoint") {
+            m_endpoint = std::string{event->data};
+          } else if (event->event == "message") {
+            auto j = json::parse(event->data, nullptr, false);
+            if (j.contains("id") && j["id"].is_number()) {
+              m_ids[j["id"].get<int>()] = true;
+              ++m_received;
+            }
+          }
+          m_cv.notify_all();
+        }
+        return !m_stop;
+      });
+      if (res || !m_endpoint.empty()) {
+        break;
+      }
+      std::this_thread::sleep_for(50ms);
+    }
+  }
+
+  int m_port;
+  mcp::server m_server;
+  httplib::Client m_ping_client{"127.0.0.1", m_port};
+  std::thread m_server_thread;
+  std::thread m_sse_thread;
+  std::atomic_bool m_stop{false};
+
+  std::mutex m_mutex;
+  std::condition_variable m_cv;
+  std::string m_endpoint;
+  std::map<int, bool> m_ids;
+  size_t m_received{0};
+};
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  int calls = static_cast<int>(bench::ArgOr(argc, argv, 1, 2000));
+  size_t tool_us = bench::ArgOr(argc, argv, 2, 500);
+  assistant::SetLogLevel(assistant::LogLevel::kWarning);
+  mcp::set_log_level(mcp::log_level::warning);
+  std::cout << calls << " concurrent tools/call of " << tool_us << " us, "
+            << std::max(1u, std::thread::hardware_concurrency())
+            << " thread pool workers" << std::endl;
+
+  int port = 20000 + static_cast<int>(Clock::now().time_since_epoch().count() %
+                                      20000);
+  for (size_t limit : {0, 1}) {
+    Session session{port++, tool_us, limit};
+    if (!session.Initialize()) {
+      std::cerr << "Failed to open the MCP session" << std::endl;
+      return 1;
+    }
+    auto result = session.Load(calls);
+    std::string name = limit == 0 ? "no limit" : "tools/call limit 1";
+    bench::Report(name + ": all responses", result.total_ms);
+    bench::Report(name + ": ping under load", result.ping_ms);
+  }
+  return 0;
+}
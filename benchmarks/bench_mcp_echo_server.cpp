@@ -0,0 +1,46 @@
+/// A minimal MCP stdio server used by the MCP benchmarks. It answers
+/// "initialize", "ping", "tools/list" and echoes the "text" argument of
+/// "tools/call".
+
+#include <iostream>
+#include <string>
+
+#include "assistant/common/json.hpp"
+
+using json = nlohmann::ordered_json;
+
+int main() {
+  std::ios::sync_with_stdio(false);
+  std::string line;
+  while (std::getline(std::cin, line)) {
+    json req = json::parse(line, nullptr, false);
+    if (req.is_discarded() || !req.contains("id")) {
+      // Notifications do not get a reply.
+      continue;
+    }
+
+    std::string method = req.value("method", "");
+    json result = json::object();
+    if (method == "initialize") {
+      result = {{"protocolVersion", "2024-11-05"},
+                {"capabilities", {{"tools", json::object()}}},
+                {"serverInfo", {{"name", "echo"}, {"version", "1.0"}}}};
+    } else if (method == "tools/list") {
+      result["tools"] = json::array(
+          {{{"name", "echo"},
+            {"description", "echo the text back"},
+            {"inputSchema",
+             {{"type", "object"},
+              {"properties", {{"text", {{"type", "string"}}}}},
+              {"required", {"text"}}}}}});
+    } else if (method == "tools/call") {
+      std::string text = req["params"]["arguments"].value("text", "");
+      result = {{"content", {{{"type", "text"}, {"text", text}}}},
+                {"isError", false}};
+    }
+
+    json reply = {{"jsonrpc", "2.0"}, {"id", req["id"]}, {"result", result}};
+    std::cout << reply.dump() << "\n" << std::flush;
+  }
+  return 0;
+}
@@ -0,0 +1,119 @@
+/// Connects many SSE sessions to an embedded mcp::server and reports the
+/// threads and the resident memory of the process once they are all open.
+///
+/// Usage: bench_mcp_sse_sessions [sessions]
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <thread>
+#include <vector>
+
+#include "assistant/cpp-mcp/mcp_server.h"
+#include "benchmarks/bench_common.hpp"
+
+namespace {
+
+/// Read a field of /proc/self/status ("Threads", "VmRSS").
+size_t ProcStatus(const std::string& field) {
+  std::ifstream status{"/proc/self/status"};
+  std::string line;
+  while (std::getline(status, line)) {
+    if (line.rfind(field + ":", 0) == 0) {
+      return std::strtoull(line.c_str() + field.size() + 1, nullptr, 10);
+    }
+  }
+  return 0;
+}
+
+/// Open an SSE session with a plain socket (so that the clients add no
+/// thread) and wait for its endpoint event. Returns the socket, or -1.
+int OpenSession(int port) {
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (fd == -1) {
+    return -1;
+  }
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  timeval timeout{10, 0};
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+  std::string request = "GET /sse HTTP/1.1\r\nHost: 127.0.0.1\r\n\r\n";
+  if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+      send(fd, request.data(), request.size(), 0) !=
+          static_cast<ssize_t>(request.size())) {
+    close(fd);
+    return -1;
+  }
+
+  std::string response;
+  char buffer[4096];
+  while (response.find("event: endpoint") == std::string::npos) {
+    ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+    if (n <= 0) {
+      close(fd);
+      return -1;
+    }
+    response.append(buffer, n);
+  }
+  return fd;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  size_t sessions = bench::ArgOr(argc, argv, 1, 1000);
+  assistant::SetLogLevel(assistant::LogLevel::kWarning);
+  mcp::set_log_level(mcp::log_level::error);
+
+  // Two sockets per session in this process
+  rlimit limit{};
+  getrlimit(RLIMIT_NOFILE, &limit);
+  limit.rlim_cur = limit.rlim_max;
+  setrlimit(RLIMIT_NOFILE, &limit);
+
+  int port = 20000 + static_cast<int>(getpid() % 20000);
+  mcp::server server{"127.0.0.1", port};
+  std::thread server_thread([&server]() { server.start(true); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+  size_t threads_before = ProcStatus("Threads");
+  size_t rss_before = ProcStatus("VmRSS");
+
+  std::vector<int> fds;
+  double ms = bench::Measure(1, [&]() {
+    for (size_t i = 0; i < sessions; ++i) {
+      int fd = OpenSession(port);
+      if (fd == -1) {
+        break;
+      }
+      fds.push_back(fd);
+    }
+  });
+
+  size_t threads = ProcStatus("Threads");
+  size_t rss = ProcStatus("VmRSS");
+  std::cout << fds.size() << "/" << sessions << " SSE sessions open" << std::endl;
+  bench::Report("open all the sessions", ms);
+  std::cout << "threads: " << threads_before << " -> " << threads << " ("
+            << static_cast<double>(threads - threads_before) /
+                   static_cast<double>(std::max<size_t>(fds.size(), 1))
+            << " per session)" << std::endl;
+  std::cout << "VmRSS: " << rss_before << " kB -> " << rss << " kB ("
+            << static_cast<double>(rss - rss_before) /
+                   static_cast<double>(std::max<size_t>(fds.size(), 1))
+            << " kB per session)" << std::endl;
+
+  for (int fd : fds) {
+    close(fd);
+  }
+  server.stop();
+  server_thread.join();
+  return 0;
+}
@@ -0,0 +1,46 @@
+/// Measures the round trip of MCP stdio requests against a local echo server.
+///
+/// Usage: bench_mcp_stdio_latency [calls] [idle_servers]
+///
+/// `idle_servers` additional servers are started (and left idle) before the
+/// measurement, to show the cost of many connected stdio MCP servers.
+
+#include <memory>
+#include <vector>
+
+#include "assistant/cpp-mcp/mcp_stdio_client.h"
+#include "benchmarks/bench_common.hpp"
+
+int main(int argc, char** argv) {
+  size_t calls = bench::ArgOr(argc, argv, 1, 500);
+  size_t idle_servers = bench::ArgOr(argc, argv, 2, 0);
+  assistant::Logger::Instance().SetLogLevel(assistant::LogLevel::kWarning);
+
+  std::vector<std::unique_ptr<mcp::stdio_client>> idle;
+  for (size_t i = 0; i < idle_servers; ++i) {
+    auto client = std::make_unique<mcp::stdio_client>(MCP_ECHO_SERVER);
+    if (!client->initialize("bench", "1.0")) {
+      std::cerr << "Failed to start the echo server" << std::endl;
+      return 1;
+    }
+    idle.push_back(std::move(client));
+  }
+
+  mcp::stdio_client client{MCP_ECHO_SERVER};
+  if (!client.initialize("bench", "1.0")) {
+    std::cerr << "Failed to start the echo server" << std::endl;
+    return 1;
+  }
+
+  std::cout << "Echo server round trips: " << calls << " calls, "
+            << idle_servers << " idle servers" << std::endl;
+  bench::Report("ping (ms per call)", bench::Measure(calls, [&client]() {
+                  bench::DoNotOptimize(client.ping());
+                }));
+  bench::Report("tools/call (ms per call)",
+                bench::Measure(calls, [&client]() {
+                  bench::DoNotOptimize(
+                      client.call_tool("echo", {{"text", "hello"}}));
+                }));
+  return 0;
+}
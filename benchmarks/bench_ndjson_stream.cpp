@@ -0,0 +1,106 @@
+/// Compares the legacy NDJSON chat stream decoding (accumulate +
+/// try_read_jsons_from_string + dump + re-parse) against JsonStreamDecoder.
+///
+/// Usage: bench_ndjson_stream [tokens] [iterations]
+
+#include <vector>
+
+#include "assistant/assistantlib.hpp"
+#include "benchmarks/bench_common.hpp"
+
+namespace {
+
+/// Build an Ollama-like streamed completion of `tokens` messages.
+std::string BuildStream(size_t tokens) {
+  std::string stream;
+  for (size_t i = 0; i < tokens; ++i) {
+    assistant::json j;
+    j["model"] = "qwen3:30b";
+    j["created_at"] = "2025-01-01T00:00:00.000000Z";
+    j["message"] = {{"role", "assistant"},
+                    {"content", "token_" + std::to_string(i) + " "}};
+    j["done"] = false;
+    stream += j.dump();
+    stream += "\n";
+  }
+  assistant::json last;
+  last["model"] = "qwen3:30b";
+  last["message"] = {{"role", "assistant"}, {"content", ""}};
+  last["done"] = true;
+  last["eval_count"] = tokens;
+  stream += last.dump();
+  stream += "\n";
+  return stream;
+}
+
+/// Split the stream into network chunks of `chunk_size` bytes.
+std::vector<std::string_view> Chunk(const std::string& stream,
+                                    size_t chunk_size) {
+  std::vector<std::string_view> chunks;
+  for (size_t pos = 0; pos < stream.size(); pos += chunk_size) {
+    chunks.push_back(std::string_view{stream}.substr(pos, chunk_size));
+  }
+  return chunks;
+}
+
+size_t DecodeLegacy(const std::vector<std::string_view>& chunks) {
+  size_t count{0};
+  std::string partial_messages;
+  for (auto chunk : chunks) {
+    partial_messages.append(chunk);
+    auto result = assistant::try_read_jsons_from_string(partial_messages);
+    if (result.first.empty()) {
+      continue;
+    }
+    partial_messages.swap(result.second);
+    for (const auto& j : result.first) {
+      assistant::response response(j.dump(), assistant::message_type::chat);
+      count += response.as_simple_string().size();
+    }
+  }
+  return count;
+}
+
+size_t DecodeIncremental(const std::vector<std::string_view>& chunks) {
+  size_t count{0};
+  assistant::JsonStreamDecoder decoder;
+  for (auto chunk : chunks) {
+    decoder.Feed(chunk, [&count](assistant::json j) {
+      auto response = assistant::response::from_json(
+          std::move(j), assistant::message_type::chat);
+      count += response.as_simple_string().size();
+      return true;
+    });
+  }
+  return count;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  size_t tokens = bench::ArgOr(argc, argv, 1, 20000);
+  size_t iterations = bench::ArgOr(argc, argv, 2, 3);
+
+  auto stream = BuildStream(tokens);
+  std::cout << "Streamed completion: " << tokens << " tokens, "
+            << stream.size() << " bytes" << std::endl;
+
+  for (size_t chunk_size : {32, 256, 4096}) {
+    auto chunks = Chunk(stream, chunk_size);
+    if (DecodeLegacy(chunks) != DecodeIncremental(chunks)) {
+      std::cerr << "Decoders disagree!" << std::endl;
+      return 1;
+    }
+
+    std::string suffix = " (chunk=" + std::to_string(chunk_size) + ")";
+    bench::Report("legacy try_read_jsons_from_string" + suffix,
+                  bench::Measure(iterations, [&chunks]() {
+                    bench::DoNotOptimize(DecodeLegacy(chunks));
+                  }));
+    bench::Report("JsonStreamDecoder" + suffix,
+                  bench::Measure(iterations, [&chunks]() {
+                    bench::DoNotOptimize(DecodeIncremental(chunks));
+                  }));
+  }
+  return 0;
+}
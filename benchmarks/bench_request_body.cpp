@@ -0,0 +1,68 @@
+/// Compares sending a chat request body built with `dump()` (legacy) against
+/// writing it straight into the transport with `request::write`.
+///
+/// The "sink" stands for the socket: it only counts the bytes it receives.
+///
+/// Usage: bench_request_body [messages] [tool_output_bytes] [iterations]
+
+#include "assistant/client/client_base.hpp"
+#include "benchmarks/bench_common.hpp"
+
+using namespace assistant;
+
+int main(int argc, char** argv) {
+  size_t messages_count = bench::ArgOr(argc, argv, 1, 250);
+  size_t tool_output_bytes = bench::ArgOr(argc, argv, 2, 16 * 1024);
+  size_t iterations = bench::ArgOr(argc, argv, 3, 20);
+
+  History history;
+  std::string tool_output(tool_output_bytes, 'x');
+  for (size_t i = 0; i < messages_count; ++i) {
+    if (i % 2 == 0) {
+      history.AddMessage(assistant::message{"assistant", "calling a tool"},
+                         MessageType::kToolRequest);
+    } else {
+      history.AddMessage(assistant::message{"tool", tool_output},
+                         MessageType::kToolResponse);
+    }
+  }
+
+  size_t sent{0};
+  auto sink = [&sent](const char*, size_t len) {
+    sent += len;
+    return true;
+  };
+
+  size_t body_size{0};
+  bench::Report("legacy: copy messages into the request + dump()",
+                bench::Measure(iterations, [&history, &sink, &body_size]() {
+                  assistant::request req{assistant::message_type::chat};
+                  req["model"] = "model";
+                  req["messages"] = history.GetSnapshot().to_json();
+                  std::string body = req.dump();
+                  body_size = body.size();
+                  sink(body.data(), body.size());
+                }));
+
+  bench::Report("streamed: write the body into the sink",
+                bench::Measure(iterations, [&history, &sink]() {
+                  ChatRequest ctx = {.callback_ = {},
+                                     .request_ = {},
+                                     .model_ = {},
+                                     .finaliser_ = nullptr,
+                                     .func_calls_ = {},
+                                     .messages_ = history.GetSnapshot()};
+                  ctx.request_["model"] = "model";
+                  ctx.AttachMessages();
+                  CallbackStreamBuf buffer(sink);
+                  std::ostream os(&buffer);
+                  ctx.request_.write(os);
+                }));
+
+  std::cout << "Body: " << body_size << " bytes. Extra memory per request: "
+            << "legacy ~" << 2 * body_size << " bytes (request JSON + body "
+            << "string), streamed " << 64 * 1024 << " bytes (one chunk)"
+            << std::endl;
+  bench::DoNotOptimize(sent);
+  return 0;
+}
@@ -0,0 +1,87 @@
+/// Delivers streamed tokens and tool log messages to a response callback the
+/// way the clients used to (a std::string copy of each delta, handed to a
+/// callback taking its text by value) and through a ResponseCallback holding
+/// a std::string_view callback.
+///
+/// Usage: bench_response_callback [tokens] [iterations]
+
+#include <sstream>
+#include <vector>
+
+#include "assistant/common.hpp"
+#include "benchmarks/bench_common.hpp"
+
+namespace {
+
+using assistant::Reason;
+
+/// Mostly short tokens, with a few long ones (code blocks, tool arguments)
+/// that do not fit the small string buffer.
+std::vector<std::string> MakeTokens(size_t count) {
+  std::vector<std::string> tokens;
+  tokens.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    size_t len = i % 16 == 0 ? 120 : 2 + i % 7;
+    tokens.emplace_back(len, static_cast<char>('a' + i % 26));
+  }
+  return tokens;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  size_t count = bench::ArgOr(argc, argv, 1, 100000);
+  size_t iterations = bench::ArgOr(argc, argv, 2, 20);
+  auto tokens = MakeTokens(count);
+  std::cout << count << " tokens, " << iterations << " iterations"
+            << std::endl;
+
+  size_t total = 0;
+  assistant::OnResponseCallback by_value =
+      [&total](std::string text, Reason, bool) {
+        total += text.size();
+        return true;
+      };
+  assistant::ResponseCallback legacy{by_value};
+  bench::Report("tokens: std::string copy, by value callback",
+                bench::Measure(iterations, [&]() {
+                  for (const auto& token : tokens) {
+                    std::string content = token;
+                    legacy(content, Reason::kPartialResult, false);
+                  }
+                }));
+
+  assistant::ResponseCallback view{[&total](std::string_view text, Reason,
+                                            bool) {
+    total += text.size();
+    return true;
+  }};
+  bench::Report("tokens: string_view callback",
+                bench::Measure(iterations, [&]() {
+                  for (const auto& token : tokens) {
+                    view(std::string_view{token}, Reason::kPartialResult,
+                         false);
+                  }
+                }));
+
+  // The tool calls messages are formatted with a std::stringstream
+  size_t messages = count / 10;
+  bench::Report("tool messages: ss.str(), by value callback",
+                bench::Measure(iterations, [&]() {
+                  for (size_t i = 0; i < messages; ++i) {
+                    std::stringstream ss;
+                    ss << "Invoking tool: '" << tokens[i] << "'";
+                    legacy(ss.str(), Reason::kLogDebug, false);
+                  }
+                }));
+  bench::Report("tool messages: ss.view(), string_view callback",
+                bench::Measure(iterations, [&]() {
+                  for (size_t i = 0; i < messages; ++i) {
+                    std::stringstream ss;
+                    ss << "Invoking tool: '" << tokens[i] << "'";
+                    view(ss.view(), Reason::kLogDebug, false);
+                  }
+                }));
+  bench::DoNotOptimize(total);
+  return 0;
+}
@@ -0,0 +1,222 @@
+/// Compares the legacy SSE line splitting of the Claude and OpenAI response
+/// parsers (copy the line char by char / substr the rest of the buffer for
+/// every line) against SseFramer, then replays the same streams through the
+/// response parsers.
+///
+/// Usage: bench_sse_stream [events] [iterations]
+
+#include <vector>
+
+#include "assistant/claude_response_parser.hpp"
+#include "assistant/helpers.hpp"
+#include "assistant/openai_response_parser.hpp"
+#include "benchmarks/bench_common.hpp"
+
+namespace {
+
+/// Build an Anthropic-like stream with `events` text deltas.
+std::string BuildClaudeStream(size_t events) {
+  std::string stream =
+      "event: message_start\n"
+      "data: {\"type\":\"message_start\",\"message\":{\"id\":\"msg_1\"}}\n\n"
+      "event: content_block_start\n"
+      "data: {\"type\":\"content_block_start\",\"index\":0,"
+      "\"content_block\":{\"type\":\"text\",\"text\":\"\"}}\n\n";
+  for (size_t i = 0; i < events; ++i) {
+    stream +=
+        "event: content_block_delta\n"
+        "data: {\"type\":\"content_block_delta\",\"index\":0,\"delta\":"
+        "{\"type\":\"text_delta\",\"text\":\"token_" +
+        std::to_string(i) + " \"}}\n\n";
+  }
+  stream +=
+      "event: content_block_stop\n"
+      "data: {\"type\":\"content_block_stop\",\"index\":0}\n\n"
+      "event: message_delta\n"
+      "data: {\"type\":\"message_delta\",\"delta\":{\"stop_reason\":"
+      "\"end_turn\"},\"usage\":{\"output_tokens\":10}}\n\n"
+      "event: message_stop\n"
+      "data: {\"type\":\"message_stop\"}\n\n";
+  return stream;
+}
+
+/// Build an OpenAI /v1/responses-like stream with `events` text deltas.
+std::string BuildOpenAIStream(size_t events) {
+  std::string stream;
+  for (size_t i = 0; i < events; ++i) {
+    stream +=
+        "event: response.output_text.delta\n"
+        "data: {\"type\":\"response.output_text.delta\",\"item_id\":\"msg_1\","
+        "\"output_index\":0,\"content_index\":0,\"delta\":\"token_" +
+        std::to_string(i) + " \"}\n\n";
+  }
+  stream +=
+      "event: response.completed\n"
+      "data: {\"type\":\"response.completed\",\"response\":{\"status\":"
+      "\"completed\",\"usage\":{\"input_tokens\":10,\"output_tokens\":" +
+      std::to_string(events) + "}}}\n\n";
+  return stream;
+}
+
+/// Split the stream into network chunks of `chunk_size` bytes.
+std::vector<std::string> Chunk(const std::string& stream, size_t chunk_size) {
+  std::vector<std::string> chunks;
+  for (size_t pos = 0; pos < stream.size(); pos += chunk_size) {
+    chunks.push_back(stream.substr(pos, chunk_size));
+  }
+  return chunks;
+}
+
+/// The former `claude::ResponseParser::PopLine`.
+std::optional<std::string> LegacyPopLine(std::string& content) {
+  std::string current_line;
+  enum class State { kStart, kCollect } state = State::kStart;
+  for (size_t pos = 0; pos < content.size(); ++pos) {
+    char c = content[pos];
+    switch (state) {
+      case State::kStart:
+        if (c != '\n') {
+          current_line += c;
+          state = State::kCollect;
+        }
+        break;
+      case State::kCollect:
+        if (c == '\n') {
+          content.erase(0, pos + 1);
+          return current_line;
+        }
+        current_line += c;
+        break;
+    }
+  }
+  return std::nullopt;
+}
+
+/// The former Claude framing: pop "event:" and "data:" line pairs, pushing
+/// the event line back when its data line is incomplete.
+size_t FrameClaudeLegacy(const std::vector<std::string>& chunks) {
+  size_t bytes{0};
+  std::string content;
+  for (const auto& chunk : chunks) {
+    content.append(chunk);
+    while (true) {
+      auto event_line = LegacyPopLine(content);
+      if (!event_line.has_value()) {
+        break;
+      }
+      auto data_line = LegacyPopLine(content);
+      if (!data_line.has_value()) {
+        content = event_line.value() + "\n" + content;
+        break;
+      }
+      bytes += assistant::after_first(data_line.value(), ":").size();
+    }
+  }
+  return bytes;
+}
+
+/// The former `OpenAIResponseParser::Parse` line splitting.
+size_t FrameOpenAILegacy(const std::vector<std::string>& chunks) {
+  size_t bytes{0};
+  std::string line_buffer;
+  for (const auto& chunk : chunks) {
+    line_buffer += chunk;
+    size_t pos = 0;
+    while ((pos = line_buffer.find('\n')) != std::string::npos) {
+      std::string line = line_buffer.substr(0, pos);
+      line_buffer = line_buffer.substr(pos + 1);
+      line = assistant::trim(line);
+      if (line.find("data: ") == 0) {
+        bytes += line.size() - 5;
+      }
+    }
+  }
+  return bytes;
+}
+
+size_t FrameSse(const std::vector<std::string>& chunks) {
+  size_t bytes{0};
+  assistant::SseFramer framer;
+  for (const auto& chunk : chunks) {
+    framer.Append(chunk);
+    while (auto event = framer.Next()) {
+      // +1 for the space the legacy framing keeps after "data:".
+      bytes += event->data.size() + 1;
+    }
+  }
+  return bytes;
+}
+
+size_t ParseClaude(const std::vector<std::string>& chunks) {
+  size_t bytes{0};
+  assistant::claude::ResponseParser parser;
+  for (const auto& chunk : chunks) {
+    parser.Parse(chunk, [&bytes](assistant::claude::ParseResult result) {
+      bytes += result.content.size();
+    });
+  }
+  return bytes;
+}
+
+size_t ParseOpenAI(const std::vector<std::string>& chunks) {
+  size_t bytes{0};
+  assistant::OpenAIResponseParser parser;
+  for (const auto& chunk : chunks) {
+    parser.Parse(chunk,
+                 [&bytes](assistant::OpenAIResponseParser::ParseResult result) {
+                   bytes += result.content.size();
+                 });
+  }
+  return bytes;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  size_t events = bench::ArgOr(argc, argv, 1, 20000);
+  size_t iterations = bench::ArgOr(argc, argv, 2, 5);
+  assistant::SetLogLevel(assistant::LogLevel::kWarning);
+
+  auto claude_stream = BuildClaudeStream(events);
+  auto openai_stream = BuildOpenAIStream(events);
+  std::cout << "Streams: " << events << " events, Claude "
+            << claude_stream.size() << " bytes, OpenAI " << openai_stream.size()
+            << " bytes" << std::endl;
+
+  for (size_t chunk_size : {256, 1400, 16384}) {
+    auto claude_chunks = Chunk(claude_stream, chunk_size);
+    auto openai_chunks = Chunk(openai_stream, chunk_size);
+    if (FrameClaudeLegacy(claude_chunks) != FrameSse(claude_chunks) ||
+        FrameOpenAILegacy(openai_chunks) != FrameSse(openai_chunks)) {
+      std::cerr << "Framers disagree!" << std::endl;
+      return 1;
+    }
+
+    std::string suffix = " (chunk=" + std::to_string(chunk_size) + ")";
+    bench::Report("claude: legacy PopLine framing" + suffix,
+                  bench::Measure(iterations, [&claude_chunks]() {
+                    bench::DoNotOptimize(FrameClaudeLegacy(claude_chunks));
+                  }));
+    bench::Report("claude: SseFramer" + suffix,
+                  bench::Measure(iterations, [&claude_chunks]() {
+                    bench::DoNotOptimize(FrameSse(claude_chunks));
+                  }));
+    bench::Report("openai: legacy substr framing" + suffix,
+                  bench::Measure(iterations, [&openai_chunks]() {
+                    bench::DoNotOptimize(FrameOpenAILegacy(openai_chunks));
+                  }));
+    bench::Report("openai: SseFramer" + suffix,
+                  bench::Measure(iterations, [&openai_chunks]() {
+                    bench::DoNotOptimize(FrameSse(openai_chunks));
+                  }));
+    bench::Report("claude::ResponseParser" + suffix,
+                  bench::Measure(iterations, [&claude_chunks]() {
+                    bench::DoNotOptimize(ParseClaude(claude_chunks));
+                  }));
+    bench::Report("OpenAIResponseParser" + suffix,
+                  bench::Measure(iterations, [&openai_chunks]() {
+                    bench::DoNotOptimize(ParseOpenAI(openai_chunks));
+                  }));
+  }
+  return 0;
+}
@@ -221,7 +221,7 @@ void HandlePrompt(std::shared_ptr<assistant::ClientBase> cli,
     cli->Chat(
         current_prompt,
         [&done, &saved_thinking_state, &max_tokens_reached](
-            std::string output, assistant::Reason reason,
+            std::string_view output, assistant::Reason reason,
             bool thinking) -> bool {
           if (saved_thinking_state != thinking) {
             // we switched state
@@ -463,7 +463,9 @@ int main(int argc, char** argv) {
       std::cout << ">> Number of tool responses: "
                 << cli->GetToolResponseCount() << std::endl;
       cli->Compact(1);
-      std::cout << ">> Client side compaction completed" << std::endl;
+      std::cout << ">> Client side compaction completed. Estimated history "
+                   "tokens: "
+                << cli->GetHistoryTokenCount() << std::endl;
       PrintPrompt();
       continue;
     } else if (prompt == "/cache_static") {
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+
+#include "assistant/client/ollama_client.hpp"
+
+namespace assistant {
+
+/// What the test controls and observes of the `FakeTransport`s of a client.
+struct FakeTransportState {
+  /// Makes the next chat request throw, then resets itself.
+  std::atomic_bool fail{false};
+  /// Number of chat requests sent.
+  std::atomic_size_t sent{0};
+};
+
+/// A transport that accepts every request without replying. It reports its
+/// first `is_running()` as a new connection.
+class FakeTransport : public ITransport {
+ public:
+  FakeTransport() : m_state{std::make_shared<FakeTransportState>()} {}
+  explicit FakeTransport(std::shared_ptr<FakeTransportState> state)
+      : m_state{std::move(state)} {}
+
+  bool chat_raw_output(assistant::request&, on_raw_respons_callback,
+                       void*) override {
+    return true;
+  }
+  bool chat(assistant::request&, on_respons_callback, void*) override {
+    ++m_state->sent;
+    if (m_state->fail.exchange(false)) {
+      throw std::runtime_error("connection reset");
+    }
+    return true;
+  }
+  json list_model_json() override { return json::object(); }
+  void setReadTimeout(const int, const int = 0) override {}
+  void setWriteTimeout(const int, const int = 0) override {}
+  void setConnectTimeout(const int, const int = 0) override {}
+  void interrupt() override { interrupted_.store(true); }
+  json show_model_info(const std::string&, bool = false) override {
+    return json::object();
+  }
+  bool is_running() override {
+    if (!m_connected) {
+      m_connected = true;
+      if (m_on_new_connection) {
+        m_on_new_connection();
+      }
+    }
+    return true;
+  }
+#if CPPHTTPLIB_OPENSSL_SUPPORT
+  void verifySSLCertificate(bool) override {}
+#endif
+  void setOnNewConnection(std::function<void()> cb) override {
+    m_on_new_connection = std::move(cb);
+  }
+
+ private:
+  std::shared_ptr<FakeTransportState> m_state;
+  bool m_connected{false};
+  std::function<void()> m_on_new_connection;
+};
+
+/// An Ollama client that sends its requests with `FakeTransport`s and asks
+/// no server for the model capabilities.
+class FakeClient : public OllamaClient {
+ public:
+  FakeClient() : OllamaClient(OllamaLocalEndpoint{}) {}
+
+  std::optional<ModelCapabilities> GetModelCapabilities(
+      const std::string&) override {
+    return ModelCapabilities::kNone;
+  }
+
+  /// Shared by all the transports of the client.
+  std::shared_ptr<FakeTransportState> m_transport_state{
+      std::make_shared<FakeTransportState>()};
+
+ protected:
+  std::unique_ptr<ITransport> CreateClient() override {
+    return std::make_unique<FakeTransport>(m_transport_state);
+  }
+};
+
+}  // namespace assistant
@@ -0,0 +1,52 @@
+/// A minimal MCP stdio server used by the tests. It exports a single tool
+/// named after its first argument, and waits the number of milliseconds given
+/// by its second argument before answering "initialize".
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "assistant/common/json.hpp"
+
+using json = nlohmann::ordered_json;
+
+int main(int argc, char** argv) {
+  std::string tool_name = argc > 1 ? argv[1] : "echo";
+  int startup_delay_ms = argc > 2 ? std::stoi(argv[2]) : 0;
+
+  std::ios::sync_with_stdio(false);
+  std::string line;
+  while (std::getline(std::cin, line)) {
+    json req = json::parse(line, nullptr, false);
+    if (req.is_discarded() || !req.contains("id")) {
+      // Notifications do not get a reply.
+      continue;
+    }
+
+    std::string method = req.value("method", "");
+    json result = json::object();
+    if (method == "initialize") {
+      std::this_thread::sleep_for(std::chrono::milliseconds(startup_delay_ms));
+      result = {{"protocolVersion", "2024-11-05"},
+                {"capabilities", {{"tools", json::object()}}},
+                {"serverInfo", {{"name", tool_name}, {"version", "1.0"}}}};
+    } else if (method == "tools/list") {
+      result["tools"] = json::array(
+          {{{"name", tool_name},
+            {"description", "echo the text back"},
+            {"inputSchema",
+             {{"type", "object"},
+              {"properties", {{"text", {{"type", "string"}}}}},
+              {"required", {"text"}}}}}});
+    } else if (method == "tools/call") {
+      std::string text = req["params"]["arguments"].value("text", "");
+      result = {{"content", {{{"type", "text"}, {"text", text}}}},
+                {"isError", false}};
+    }
+
+    json reply = {{"jsonrpc", "2.0"}, {"id", req["id"]}, {"result", result}};
+    std::cout << reply.dump() << "\n" << std::flush;
+  }
+  return 0;
+}
@@ -0,0 +1,70 @@
+#include <gtest/gtest.h>
+
+#include "assistant/chat_completions_response_parser.hpp"
+
+namespace assistant::chat_completions {
+
+namespace {
+std::vector<ParseResult> ParseAll(ResponseParser& parser,
+                                  const std::string& message) {
+  std::vector<ParseResult> tokens;
+  parser.Parse(message, [&tokens](ParseResult result) {
+    tokens.push_back(std::move(result));
+  });
+  return tokens;
+}
+}  // namespace
+
+TEST(ChatCompletionsResponseParserTest, ContentChunks) {
+  ResponseParser parser;
+  std::string message =
+      R"(data: {"id":"1","object":"chat.completion.chunk","choices":[{"index":0,"delta":{"role":"assistant","content":"Hel"},"logprobs":null,"finish_reason":null}]})"
+      "\n\n"
+      R"(data: {"id":"1","object":"chat.completion.chunk","choices":[{"index":0,"delta":{"content":"lo \"x\""},"finish_reason":null}]})"
+      "\n\n"
+      R"(data: {"id":"1","object":"chat.completion.chunk","choices":[{"index":0,"delta":{},"finish_reason":"stop"}]})"
+      "\n\n";
+
+  auto tokens = ParseAll(parser, message);
+  ASSERT_EQ(tokens.size(), 3);
+  EXPECT_EQ(tokens[0].content, "Hel");
+  EXPECT_FALSE(tokens[0].IsDone());
+  EXPECT_EQ(tokens[1].content, "lo \"x\"");
+  EXPECT_TRUE(tokens[2].IsDone());
+  ASSERT_TRUE(tokens[2].finish_reason.has_value());
+  EXPECT_EQ(tokens[2].finish_reason.value(), FinishReason::stop);
+}
+
+TEST(ChatCompletionsResponseParserTest, StreamedToolCalls) {
+  ResponseParser parser;
+  std::string message =
+      R"(data: {"choices":[{"index":0,"delta":{"tool_calls":[{"index":0,"id":"call_1","type":"function","function":{"name":"add","arguments":"{\"a\":"}}]},"finish_reason":null}]})"
+      "\n\n"
+      R"(data: {"choices":[{"index":0,"delta":{"tool_calls":[{"index":0,"function":{"arguments":"1}"}}]},"finish_reason":null}]})"
+      "\n\n"
+      R"(data: {"choices":[{"index":0,"delta":{},"finish_reason":"tool_calls"}]})"
+      "\n\n";
+
+  auto tokens = ParseAll(parser, message);
+  ASSERT_EQ(tokens.size(), 3);
+  EXPECT_TRUE(tokens[2].IsDone());
+  ASSERT_EQ(tokens[2].tool_calls.size(), 1);
+  EXPECT_EQ(tokens[2].tool_calls[0].id, "call_1");
+  EXPECT_EQ(tokens[2].tool_calls[0].name, "add");
+  EXPECT_EQ(tokens[2].tool_calls[0].arguments_json, "{\"a\":1}");
+}
+
+TEST(ChatCompletionsResponseParserTest, ErrorAndDone) {
+  ResponseParser parser;
+  auto tokens =
+      ParseAll(parser, "data: {\"error\":{\"message\":\"Overloaded\"}}\n\n");
+  ASSERT_EQ(tokens.size(), 1);
+  EXPECT_TRUE(tokens[0].IsError());
+  EXPECT_EQ(tokens[0].error_message, "Overloaded");
+
+  tokens = ParseAll(parser, "data: [DONE]\n\n");
+  ASSERT_EQ(tokens.size(), 1);
+  EXPECT_TRUE(tokens[0].IsDone());
+}
+
+}  // namespace assistant::chat_completions
@@ -0,0 +1,230 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <thread>
+
+#include "assistant/client/chat_scheduler.hpp"
+#include "assistant/client/ollama_client.hpp"
+#include "tests/fake_transport.hpp"
+
+using namespace assistant;
+
+namespace {
+
+/// Records the prompt in the current history and "streams" for `delay_ms`
+/// instead of sending the request to a server.
+class SessionsClient : public OllamaClient {
+ public:
+  explicit SessionsClient(int delay_ms = 20)
+      : OllamaClient(OllamaLocalEndpoint{}), m_delay_ms{delay_ms} {}
+
+  void Chat(std::string msg, ResponseCallback cb,
+            ChatOptions chat_options) override {
+    (void)chat_options;
+    size_t now = m_running.fetch_add(1) + 1;
+    size_t prev = m_max_running.load();
+    while (now > prev && !m_max_running.compare_exchange_weak(prev, now)) {
+    }
+    AddMessage(assistant::message{"user", msg}, MessageType::kNormal);
+    auto deadline = std::chrono::steady_clock::now() +
+                    std::chrono::milliseconds(m_delay_ms);
+    bool cancelled{false};
+    while (std::chrono::steady_clock::now() < deadline) {
+      if (IsInterrupted()) {
+        cancelled = true;
+        break;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    m_running.fetch_sub(1);
+    if (cancelled) {
+      cb("Request cancelled by user", Reason::kCancelled, false);
+      return;
+    }
+    AddMessage(assistant::message{"assistant", "re: " + msg},
+               MessageType::kNormal);
+    cb("re: " + msg, Reason::kDone, false);
+  }
+
+  std::atomic_size_t m_running{0};
+  std::atomic_size_t m_max_running{0};
+  std::atomic_int m_delay_ms{20};
+};
+
+std::vector<std::string> Contents(const ChatSession& session) {
+  std::vector<std::string> contents;
+  for (const auto& msg : session.GetHistory().GetMessages()) {
+    contents.push_back(msg["content"].get<std::string>());
+  }
+  return contents;
+}
+
+}  // namespace
+
+TEST(ChatScheduler, SessionsHaveSeparateHistories) {
+  auto client = std::make_shared<SessionsClient>();
+  ChatScheduler scheduler{client, 4};
+  auto a = scheduler.CreateSession("a");
+  auto b = scheduler.CreateSession("b");
+
+  auto noop = [](const std::string&, Reason, bool) { return true; };
+  auto fa = scheduler.Submit(a, "hello a", noop);
+  auto fb = scheduler.Submit(b, "hello b", noop);
+  fa.get();
+  fb.get();
+
+  EXPECT_EQ(Contents(*a),
+            (std::vector<std::string>{"hello a", "re: hello a"}));
+  EXPECT_EQ(Contents(*b),
+            (std::vector<std::string>{"hello b", "re: hello b"}));
+  // The default history of the client is untouched.
+  EXPECT_TRUE(client->GetHistory().empty());
+}
+
+TEST(ChatScheduler, InFlightIsBounded) {
+  auto client = std::make_shared<SessionsClient>(30);
+  ChatScheduler scheduler{client, 2};
+  EXPECT_EQ(scheduler.GetMaxInFlight(), 2);
+
+  std::vector<std::shared_ptr<ChatSession>> sessions;
+  std::vector<std::future<void>> futures;
+  std::atomic_size_t done{0};
+  for (size_t i = 0; i < 6; ++i) {
+    sessions.push_back(scheduler.CreateSession(std::to_string(i)));
+    futures.push_back(scheduler.Submit(
+        sessions.back(), "prompt",
+        [&done](const std::string&, Reason reason, bool) {
+          if (reason == Reason::kDone) {
+            ++done;
+          }
+          return true;
+        }));
+  }
+  for (auto& future : futures) {
+    future.get();
+  }
+  EXPECT_EQ(done.load(), 6);
+  EXPECT_EQ(client->m_max_running.load(), 2);
+  EXPECT_EQ(scheduler.GetInFlight(), 0);
+  EXPECT_EQ(scheduler.GetPending(), 0);
+}
+
+TEST(ChatScheduler, TurnsOfASessionRunInOrder) {
+  auto client = std::make_shared<SessionsClient>(5);
+  ChatScheduler scheduler{client, 4};
+  auto session = scheduler.CreateSession();
+
+  std::vector<std::future<void>> futures;
+  auto noop = [](const std::string&, Reason, bool) { return true; };
+  for (size_t i = 0; i < 5; ++i) {
+    futures.push_back(scheduler.Submit(session, std::to_string(i), noop));
+  }
+  for (auto& future : futures) {
+    future.get();
+  }
+  // One turn at a time, so the max concurrency is 1 despite 4 workers.
+  EXPECT_EQ(client->m_max_running.load(), 1);
+  std::vector<std::string> expected;
+  for (size_t i = 0; i < 5; ++i) {
+    expected.push_back(std::to_string(i));
+    expected.push_back("re: " + std::to_string(i));
+  }
+  EXPECT_EQ(Contents(*session), expected);
+}
+
+TEST(ChatScheduler, CancelDropsPendingTurnsOfOneSession) {
+  auto client = std::make_shared<SessionsClient>(200);
+  ChatScheduler scheduler{client, 2};
+  auto a = scheduler.CreateSession("a");
+  auto b = scheduler.CreateSession("b");
+
+  std::mutex mutex;
+  std::vector<std::pair<std::string, Reason>> replies_a;
+  auto record_a = [&](const std::string& text, Reason reason, bool) {
+    std::scoped_lock lk{mutex};
+    replies_a.push_back({text, reason});
+    return true;
+  };
+  Reason reason_b{Reason::kPartialResult};
+  auto record_b = [&reason_b](const std::string&, Reason reason, bool) {
+    reason_b = reason;
+    return true;
+  };
+
+  auto fa1 = scheduler.Submit(a, "first", record_a);
+  auto fa2 = scheduler.Submit(a, "second", record_a);
+  auto fb = scheduler.Submit(b, "other", record_b);
+  while (scheduler.GetInFlight() < 2) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  scheduler.Cancel(a);
+  fa1.get();
+  fa2.get();
+  EXPECT_LT(std::chrono::steady_clock::now() - start,
+            std::chrono::milliseconds(150));
+  ASSERT_EQ(replies_a.size(), 2);
+  EXPECT_EQ(replies_a[0].second, Reason::kCancelled);
+  EXPECT_EQ(replies_a[1].second, Reason::kCancelled);
+
+  // The other session is not affected.
+  fb.get();
+  EXPECT_EQ(reason_b, Reason::kDone);
+
+  // A new turn of the cancelled session runs normally.
+  client->m_delay_ms = 1;
+  Reason reason_a{Reason::kPartialResult};
+  scheduler
+      .Submit(a, "third",
+              [&reason_a](const std::string&, Reason reason, bool) {
+                reason_a = reason;
+                return true;
+              })
+      .get();
+  EXPECT_EQ(reason_a, Reason::kDone);
+}
+
+TEST(ChatScheduler, FatalErrorFailsOnlyItsSession) {
+  auto client = std::make_shared<FakeClient>();
+  client->AddSystemMessage("system");
+  client->GetFunctionTable().Add(FunctionBuilder("tool")
+                                     .SetDescription("a tool")
+                                     .SetCallback([](const json&) {
+                                       return FunctionResult{.text = "ok"};
+                                     })
+                                     .Build());
+  ChatScheduler scheduler{client, 2};
+  auto a = scheduler.CreateSession("a");
+  auto b = scheduler.CreateSession("b");
+
+  Reason reason_a{Reason::kPartialResult};
+  auto record_a = [&reason_a](const std::string&, Reason reason, bool) {
+    reason_a = reason;
+    return true;
+  };
+  Reason reason_b{Reason::kPartialResult};
+  auto record_b = [&reason_b](const std::string&, Reason reason, bool) {
+    reason_b = reason;
+    return true;
+  };
+
+  client->m_transport_state->fail = true;
+  scheduler.Submit(a, "boom", record_a).get();
+  EXPECT_EQ(reason_a, Reason::kFatalError);
+  EXPECT_TRUE(a->IsFailed());
+
+  // The client is not torn down: the other sessions keep working.
+  size_t sent = client->m_transport_state->sent.load();
+  scheduler.Submit(b, "hello", record_b).get();
+  EXPECT_EQ(client->m_transport_state->sent.load(), sent + 1);
+  EXPECT_NE(reason_b, Reason::kFatalError);
+  EXPECT_FALSE(b->IsFailed());
+  EXPECT_FALSE(client->IsInterrupted());
+  EXPECT_EQ(client->GetFunctionTable().GetFunctionsCount(), 1);
+
+  // The next turn of the failed session runs normally.
+  scheduler.Submit(a, "again", record_a).get();
+  EXPECT_EQ(client->m_transport_state->sent.load(), sent + 2);
+  EXPECT_FALSE(a->IsFailed());
+}
@@ -277,6 +277,47 @@ data: {"type":"message_delta","delta":{},"usage":{"output_tokens":10}}
   EXPECT_TRUE(tokens[0].usage.has_value());
 }
 
+TEST(ResponseParserTest, MessageDeltaMaxTokensWithUsage) {
+  ResponseParser parser;
+  std::string message = R"(
+event: message_delta
+data: {"type":"message_delta","delta":{"stop_reason":"max_tokens","stop_sequence":null},"usage":{"output_tokens":10}}
+)";
+
+  std::vector<ParseResult> tokens;
+  parser.Parse(message, [&tokens](ParseResult result) {
+    tokens.push_back(std::move(result));
+  });
+
+  EXPECT_EQ(tokens.size(), 2);
+  EXPECT_TRUE(tokens[0].is_done);
+  ASSERT_TRUE(tokens[0].stop_reason.has_value());
+  EXPECT_EQ(tokens[0].stop_reason.value(), StopReason::max_tokens);
+  ASSERT_TRUE(tokens[0].usage.has_value());
+  EXPECT_EQ(tokens[0].GetReason(), Reason::kMaxTokensReached);
+}
+
+TEST(ResponseParserTest, DeltaWithUnknownMemberFallsBackToDom) {
+  ResponseParser parser;
+  std::string message = R"(
+event: content_block_start
+data: {"type":"content_block_start","index":0,"content_block":{"type":"text","text":""}}
+event: content_block_delta
+data: {"type":"content_block_delta","index":0,"delta":{"type":"text_delta","text":"Hello \"World\"","citation":null}}
+event: content_block_delta
+data: {"type":"content_block_delta","index":0,"delta":{"type":"text_delta","text":"!"}}
+)";
+
+  std::vector<ParseResult> tokens;
+  parser.Parse(message, [&tokens](ParseResult result) {
+    tokens.push_back(std::move(result));
+  });
+
+  ASSERT_EQ(tokens.size(), 3);
+  EXPECT_EQ(tokens[0].content, "Hello \"World\"");
+  EXPECT_EQ(tokens[1].content, "!");
+}
+
 TEST(ResponseParserTest, PingEvent) {
   ResponseParser parser;
   std::string message = R"(
@@ -532,6 +532,7 @@ TEST(ConfigBuilderTest, FromContent_GlobalOptions) {
     "log_level": "debug",
     "keep_alive": "10m",
     "stream": false,
+    "max_parallel_tool_calls": 8,
     "endpoints": {
       "http://localhost:11434": {
         "model": "test"
@@ -547,6 +548,35 @@ TEST(ConfigBuilderTest, FromContent_GlobalOptions) {
   EXPECT_EQ(config.GetLogLevel(), LogLevel::kDebug);
   EXPECT_EQ(config.GetKeepAlive(), "10m");
   EXPECT_FALSE(config.IsStream());
+  EXPECT_EQ(config.GetMaxParallelToolCalls(), 8);
+}
+
+// Test the model capabilities cache settings
+TEST(ConfigBuilderTest, FromContent_ModelCache) {
+  std::string json_content = R"({
+    "model_cache": {
+      "file": "/tmp/models.json",
+      "ttl_secs": 600
+    },
+    "endpoints": {
+      "http://localhost:11434": {
+        "model": "test"
+      }
+    }
+  })";
+
+  auto result = ConfigBuilder::FromContent(json_content);
+
+  ASSERT_TRUE(result.ok());
+  const auto& settings = result.config_->GetModelCacheSettings();
+  EXPECT_EQ(settings.file_, "/tmp/models.json");
+  EXPECT_EQ(settings.ttl_, std::chrono::seconds(600));
+
+  auto defaults = ConfigBuilder::FromContent(R"({"endpoints": {}})");
+  ASSERT_TRUE(defaults.ok());
+  EXPECT_TRUE(defaults.config_->GetModelCacheSettings().file_.empty());
+  EXPECT_EQ(defaults.config_->GetModelCacheSettings().ttl_,
+            kModelCacheTTLDefault);
 }
 
 // Test default history size
@@ -746,6 +776,7 @@ TEST(ConfigTest, DefaultValues) {
   EXPECT_EQ(config.GetLogLevel(), LogLevel::kInfo);
   EXPECT_EQ(config.GetKeepAlive(), "5m");
   EXPECT_TRUE(config.IsStream());
+  EXPECT_EQ(config.GetMaxParallelToolCalls(), 1);
   EXPECT_EQ(config.GetServers().size(), 0);
   EXPECT_EQ(config.GetEndpoints().size(), 0);
 }
@@ -900,3 +931,24 @@ TEST(ConfigBuilderTest, FromContent_ComplexConfiguration) {
   EXPECT_EQ(config.GetKeepAlive(), "8m");
   EXPECT_TRUE(config.IsStream());
 }
+
+TEST(ConfigBuilderTest, FromContent_ServerStartupTimeout) {
+  std::string json_content = R"({
+    "mcp_servers": {
+      "fast": {
+        "command": ["server"],
+        "startup_timeout_msecs": 1500
+      },
+      "default": {
+        "command": ["server"]
+      }
+    }
+  })";
+
+  auto result = ConfigBuilder::FromContent(json_content);
+  ASSERT_TRUE(result.ok());
+  const auto& servers = result.config_.value().GetServers();
+  ASSERT_EQ(servers.size(), 2);
+  EXPECT_EQ(servers[0].startup_timeout, std::chrono::milliseconds(1500));
+  EXPECT_EQ(servers[1].startup_timeout, kMCPStartupTimeoutDefault);
+}
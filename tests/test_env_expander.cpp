@@ -794,6 +794,39 @@ TEST(EnvExpanderTest, ErrorMessage_VariableNameOnly) {
   EXPECT_NE(result2.GetErrorMessage().find("ANOTHER_VAR"), std::string::npos);
 }
 
+// Test that object keys are expanded and the member order is kept
+TEST(EnvExpanderTest, JsonExpansion_KeysKeepOrder) {
+  EnvExpander expander;
+  EnvMap env_map = {{"NAME", "server"}, {"HOST", "localhost"}};
+
+  json input = {{"z", "$HOST"}, {"${NAME}_port", 8080}, {"a", "plain"}};
+  ExpandResult result = expander.ExpandWithResult(input, env_map);
+
+  EXPECT_TRUE(result.IsSuccess());
+  EXPECT_EQ(result.GetJson().dump(),
+            R"({"z":"localhost","server_port":8080,"a":"plain"})");
+}
+
+// Test that every failure is reported, in document order, keys first
+TEST(EnvExpanderTest, ErrorMessage_AllFailuresInJson) {
+  EnvExpander expander;
+  EnvMap env_map = {{"HOST", "localhost"}};
+
+  json input = {{"servers",
+                 {{{"host", "$HOST"}, {"user", "$MISSING1"}},
+                  {{"${MISSING2}", "${MISSING3}"}}}},
+                {"args", {"--port", "$MISSING4"}}};
+  ExpandResult result = expander.ExpandWithResult(input, env_map);
+
+  EXPECT_FALSE(result.IsSuccess());
+  EXPECT_EQ(result.GetJson()["servers"][0]["host"], "localhost");
+  EXPECT_EQ(result.GetJson()["servers"][1]["${MISSING2}"], "${MISSING3}");
+  EXPECT_EQ(result.GetErrorMessage(),
+            "Failed to expand variable: MISSING1; Failed to expand variable: "
+            "MISSING2; Failed to expand variable: MISSING3; Failed to expand "
+            "variable: MISSING4");
+}
+
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
@@ -0,0 +1,84 @@
+#include <gtest/gtest.h>
+
+#include "assistant/function.hpp"
+
+using namespace assistant;
+
+namespace {
+std::shared_ptr<FunctionBase> MakeTool(const std::string& name) {
+  return FunctionBuilder(name)
+      .SetDescription("a tool named " + name)
+      .AddRequiredParam("arg", "an argument", "string")
+      .SetCallback([](const json&) { return FunctionResult{.text = "ok"}; })
+      .Build();
+}
+
+size_t ToolsCount(const FunctionTable& table, EndpointKind kind) {
+  return table.GetToolsSchema(kind, CachePolicy::kNone)->tools.size();
+}
+}  // namespace
+
+TEST(FunctionTableTest, SchemaIsCachedPerKindAndPolicy) {
+  FunctionTable table;
+  table.Add(MakeTool("a"));
+  table.Add(MakeTool("b"));
+
+  auto schema =
+      table.GetToolsSchema(EndpointKind::anthropic, CachePolicy::kNone);
+  EXPECT_EQ(schema->tools.size(), 2);
+  EXPECT_EQ(schema->serialized, schema->tools.dump());
+  EXPECT_EQ(schema,
+            table.GetToolsSchema(EndpointKind::anthropic, CachePolicy::kNone));
+
+  auto cached =
+      table.GetToolsSchema(EndpointKind::anthropic, CachePolicy::kStatic);
+  EXPECT_NE(schema, cached);
+  EXPECT_FALSE(schema->tools.back().contains("cache_control"));
+  EXPECT_TRUE(cached->tools.back().contains("cache_control"));
+
+  auto ollama = table.GetToolsSchema(EndpointKind::ollama, CachePolicy::kNone);
+  EXPECT_EQ(ollama->tools[0]["type"], "function");
+  EXPECT_EQ(table.ToJSON(EndpointKind::ollama, CachePolicy::kNone),
+            ollama->tools);
+}
+
+TEST(FunctionTableTest, ChangesInvalidateTheSchema) {
+  FunctionTable table;
+  table.Add(MakeTool("a"));
+  auto version = table.GetVersion();
+  auto schema = table.GetToolsSchema(EndpointKind::openai, CachePolicy::kNone);
+  EXPECT_EQ(schema->version, version);
+
+  table.Add(MakeTool("b"));
+  EXPECT_NE(table.GetVersion(), version);
+  auto updated = table.GetToolsSchema(EndpointKind::openai, CachePolicy::kNone);
+  EXPECT_EQ(updated->tools.size(), 2);
+  // A schema already handed out is not modified.
+  EXPECT_EQ(schema->tools.size(), 1);
+
+  EXPECT_TRUE(table.EnableFunction("a", false));
+  EXPECT_EQ(ToolsCount(table, EndpointKind::openai), 1);
+
+  table.EnableAll(true);
+  EXPECT_EQ(ToolsCount(table, EndpointKind::openai), 2);
+
+  FunctionTable other;
+  other.Add(MakeTool("c"));
+  table.Merge(other);
+  EXPECT_EQ(ToolsCount(table, EndpointKind::openai), 3);
+
+  table.Clear();
+  EXPECT_EQ(ToolsCount(table, EndpointKind::openai), 0);
+}
+
+TEST(FunctionTableTest, SharedFunctionDisabledElsewhere) {
+  FunctionTable table;
+  FunctionTable other;
+  other.Add(MakeTool("a"));
+  table.Merge(other);
+  EXPECT_EQ(ToolsCount(table, EndpointKind::ollama), 1);
+
+  // The function is shared: disabling it in `other` affects `table` too.
+  EXPECT_TRUE(other.EnableFunction("a", false));
+  EXPECT_EQ(ToolsCount(table, EndpointKind::ollama), 0);
+}
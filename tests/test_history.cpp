@@ -9,6 +9,7 @@
 #include "assistant/client/ollama_client.hpp"
 #include "assistant/client/openai_client.hpp"
 #include "assistant/client/openai_messages_client.hpp"
+#include "tests/fake_transport.hpp"
 
 using namespace assistant;
 
@@ -355,6 +356,48 @@ TEST_F(HistoryTest, ThreadSafetyConcurrentReads) {
   SUCCEED();
 }
 
+// Test: Snapshots share the messages with the history
+TEST_F(HistoryTest, SnapshotSharesMessages) {
+  history_->AddMessage(assistant::message{"user", "Message 1"});
+  auto snapshot = history_->GetSnapshot();
+  auto again = history_->GetSnapshot();
+  ASSERT_EQ(snapshot.size(), 1);
+  EXPECT_EQ(snapshot.begin()->get(), again.begin()->get());
+
+  // Later messages are not part of an existing snapshot
+  history_->AddMessage(assistant::message{"assistant", "Message 2"});
+  EXPECT_EQ(snapshot.size(), 1);
+  EXPECT_EQ(history_->GetSnapshot().size(), 2);
+  EXPECT_EQ(snapshot[0]["content"], "Message 1");
+
+  json arr = history_->GetSnapshot().to_json();
+  ASSERT_TRUE(arr.is_array());
+  ASSERT_EQ(arr.size(), 2);
+  EXPECT_EQ(arr[1]["content"], "Message 2");
+}
+
+// Test: Compaction does not modify messages held by a snapshot
+TEST_F(HistoryTest, CompactKeepsSnapshotsIntact) {
+  for (int i = 0; i < 4; ++i) {
+    history_->AddMessage(assistant::message{"tool", "response"},
+                         MessageType::kToolResponse);
+  }
+  auto snapshot = history_->GetSnapshot();
+  history_->Compact(
+      [](assistant::message& msg) {
+        msg["content"] = "trimmed";
+        return size_t{1};
+      },
+      1);
+
+  auto messages = history_->GetMessages();
+  EXPECT_EQ(messages[0]["content"], "trimmed");
+  EXPECT_EQ(messages[3]["content"], "response");
+  for (const auto& node : snapshot) {
+    EXPECT_EQ((*node)["content"], "response");
+  }
+}
+
 // Test: SetMessages with empty vector
 TEST_F(HistoryTest, SetMessagesEmpty) {
   history_->AddMessage(assistant::message{"user", "Message 1"});
@@ -645,6 +688,77 @@ TEST_F(HistoryTest, ThreadSafetyConcurrentCompactAndAdd) {
   SUCCEED();
 }
 
+// Test: the token estimates follow the added and the trimmed messages
+TEST_F(HistoryTest, TokenCountIsKeptUpToDate) {
+  EXPECT_EQ(history_->GetTokenCount(), 0);
+  history_->AddMessage(assistant::message{"user", "Hello there"},
+                       MessageType::kNormal);
+  for (int i = 0; i < 4; ++i) {
+    history_->AddMessage(
+        assistant::message{"tool", "A long tool response " + std::to_string(i)},
+        MessageType::kToolResponse);
+  }
+  EXPECT_EQ(history_->GetToolResponseCount(), 4);
+
+  size_t expected{0};
+  for (const auto& msg : history_->GetMessages()) {
+    expected += CountMessageTokens(msg);
+  }
+  EXPECT_EQ(history_->GetTokenCount(), expected);
+  size_t normal = CountMessageTokens(assistant::message{"user", "Hello there"});
+  EXPECT_EQ(history_->GetTokenCount(MessageType::kNormal), normal);
+  EXPECT_EQ(history_->GetTokenCount(MessageType::kToolResponse),
+            expected - normal);
+
+  history_->Compact(
+      [](assistant::message& msg) {
+        msg["content"] = "x";
+        return 0;
+      },
+      1);
+  expected = 0;
+  for (const auto& msg : history_->GetMessages()) {
+    expected += CountMessageTokens(msg);
+  }
+  EXPECT_EQ(history_->GetTokenCount(), expected);
+  EXPECT_EQ(history_->GetToolResponseCount(), 4);
+
+  history_->Clear();
+  EXPECT_EQ(history_->GetTokenCount(), 0);
+  EXPECT_EQ(history_->GetToolResponseCount(), 0);
+}
+
+// Test: Compact does not visit the tool responses it already trimmed
+TEST_F(HistoryTest, CompactOnlyVisitsNewResponses) {
+  size_t calls{0};
+  auto trim = [&calls](assistant::message& msg) {
+    ++calls;
+    msg["content"] = "[TRIMMED]";
+    return 0;
+  };
+  for (int i = 0; i < 5; ++i) {
+    history_->AddMessage(
+        assistant::message{"tool", "Tool response " + std::to_string(i)},
+        MessageType::kToolResponse);
+  }
+  history_->Compact(trim);
+  EXPECT_EQ(calls, 2);
+  history_->Compact(trim);
+  EXPECT_EQ(calls, 2);
+
+  history_->AddMessage(assistant::message{"tool", "Tool response 5"},
+                       MessageType::kToolResponse);
+  history_->Compact(trim);
+  EXPECT_EQ(calls, 3);
+
+  // Keeping fewer responses trims the ones kept so far
+  history_->Compact(trim, 1);
+  EXPECT_EQ(calls, 5);
+  auto messages = history_->GetMessages();
+  EXPECT_EQ(messages[4]["content"].get<std::string>(), "[TRIMMED]");
+  EXPECT_EQ(messages[5]["content"].get<std::string>(), "Tool response 5");
+}
+
 //============================================================
 // Client-specific Compact() tests
 //============================================================
@@ -902,3 +1016,89 @@ TEST(OpenAIMessagesClientCompact, TrimsStringContent) {
   EXPECT_EQ(history[5]["content"].get<std::string>(), "Tool response 4");
   EXPECT_EQ(history[6]["content"].get<std::string>(), "Tool response 5");
 }
+
+namespace {
+/// Sets the client_compact_threshold of the (Ollama) endpoint of `client`.
+void SetClientCompactThreshold(ClientBase& client, size_t threshold) {
+  auto result = ConfigBuilder::FromContent(R"({
+    "endpoints": {
+      "http://127.0.0.1:11434": {
+        "model": "llama2",
+        "type": "ollama",
+        "active": true,
+        "client_compact_threshold": )" + std::to_string(threshold) + R"(
+      }
+    }
+  })");
+  ASSERT_TRUE(result.ok());
+  client.ApplyConfig(&result.config_.value());
+}
+}  // namespace
+
+// Test: CompactIfNeeded only compacts above the client compact threshold
+TEST(OllamaClientCompact, CompactIfNeeded) {
+  FakeClient client;
+  Messages msgs;
+  for (int i = 0; i < 4; ++i) {
+    msgs.push_back(assistant::message{"tool", LONG_RESPONSE},
+                   MessageType::kToolResponse);
+  }
+  client.SetHistory(msgs);
+  SetClientCompactThreshold(client, 10000);
+  ASSERT_LT(client.GetHistoryTokenCount(), client.GetClientCompactThreshold());
+  EXPECT_EQ(client.CompactIfNeeded(), 0);
+
+  while (client.GetHistoryTokenCount() <= client.GetClientCompactThreshold()) {
+    msgs.push_back(assistant::message{"tool", LONG_RESPONSE},
+                   MessageType::kToolResponse);
+    client.SetHistory(msgs);
+  }
+  EXPECT_GT(client.CompactIfNeeded(), 0);
+  EXPECT_LT(client.GetHistoryTokenCount(), client.GetClientCompactThreshold());
+}
+
+// Test: client-side compaction is off unless the endpoint opts in
+TEST(OllamaClientCompact, CompactIfNeededIsOffByDefault) {
+  FakeClient client;
+  EXPECT_EQ(client.GetClientCompactThreshold(), 0);
+  Messages msgs;
+  while (client.GetHistoryTokenCount() <= kDefaultAutoCompactThreshold) {
+    msgs.push_back(assistant::message{"tool", LONG_RESPONSE},
+                   MessageType::kToolResponse);
+    client.SetHistory(msgs);
+  }
+  EXPECT_EQ(client.CompactIfNeeded(), 0);
+  client.Chat("above", [](std::string_view, Reason, bool) { return true; },
+              ChatOptions::kDefault);
+  EXPECT_EQ(client.GetHistory()[0]["content"].get<std::string>(),
+            LONG_RESPONSE);
+}
+
+// Test: a chat turn compacts the history once it crossed the client compact
+// threshold
+TEST(OllamaClientCompact, ChatCompactsAboveThreshold) {
+  FakeClient client;
+  SetClientCompactThreshold(client, 10000);
+  auto noop = [](std::string_view, Reason, bool) { return true; };
+  Messages msgs;
+  for (int i = 0; i < 4; ++i) {
+    msgs.push_back(assistant::message{"tool", LONG_RESPONSE},
+                   MessageType::kToolResponse);
+  }
+  client.SetHistory(msgs);
+  client.Chat("below", noop, ChatOptions::kDefault);
+  auto history = client.GetHistory();
+  ASSERT_EQ(history.size(), 5);
+  EXPECT_EQ(history[0]["content"].get<std::string>(), LONG_RESPONSE);
+
+  while (client.GetHistoryTokenCount() <= client.GetClientCompactThreshold()) {
+    msgs.push_back(assistant::message{"tool", LONG_RESPONSE},
+                   MessageType::kToolResponse);
+    client.SetHistory(msgs);
+  }
+  client.Chat("above", noop, ChatOptions::kDefault);
+  history = client.GetHistory();
+  EXPECT_EQ(history[0]["content"].get<std::string>(), kTrimMessage);
+  EXPECT_EQ(history.back()["content"].get<std::string>(), "above");
+  EXPECT_LT(client.GetHistoryTokenCount(), client.GetClientCompactThreshold());
+}
@@ -0,0 +1,147 @@
+#include <gtest/gtest.h>
+
+#include "assistant/assistantlib.hpp"
+#include "assistant/helpers.hpp"
+#include "assistant/tool.hpp"
+
+using namespace assistant;
+
+namespace {
+std::vector<json> FeedAll(JsonStreamDecoder& decoder, std::string_view data,
+                          size_t chunk_size) {
+  std::vector<json> values;
+  for (size_t pos = 0; pos < data.size(); pos += chunk_size) {
+    decoder.Feed(data.substr(pos, chunk_size), [&values](json j) {
+      values.push_back(std::move(j));
+      return true;
+    });
+  }
+  return values;
+}
+}  // namespace
+
+TEST(JsonStreamDecoderTest, DecodesNdjsonInAnyChunkSize) {
+  std::string stream =
+      R"({"message":{"content":"a"},"done":false})"
+      "\n"
+      R"({"message":{"content":"b"},"done":false})"
+      "\n"
+      R"({"message":{"content":""},"done":true})"
+      "\n";
+  for (size_t chunk_size : {1, 2, 7, 64, 4096}) {
+    JsonStreamDecoder decoder;
+    auto values = FeedAll(decoder, stream, chunk_size);
+    ASSERT_EQ(values.size(), 3) << "chunk_size=" << chunk_size;
+    EXPECT_EQ(values[0]["message"]["content"], "a");
+    EXPECT_EQ(values[1]["message"]["content"], "b");
+    EXPECT_TRUE(values[2]["done"].get<bool>());
+    EXPECT_TRUE(decoder.Pending().empty());
+    EXPECT_FALSE(decoder.IsStalled());
+  }
+}
+
+TEST(JsonStreamDecoderTest, BracesAndEscapesInsideStrings) {
+  std::string stream = R"({"a":"}{]["})"
+                       R"({"b":"quote \" and backslash \\"})"
+                       R"([1,{"c":"\\\""}])";
+  for (size_t chunk_size : {1, 3, 100}) {
+    JsonStreamDecoder decoder;
+    auto values = FeedAll(decoder, stream, chunk_size);
+    ASSERT_EQ(values.size(), 3) << "chunk_size=" << chunk_size;
+    EXPECT_EQ(values[0]["a"], "}{][");
+    EXPECT_EQ(values[1]["b"], "quote \" and backslash \\");
+    EXPECT_EQ(values[2][1]["c"], "\\\"");
+  }
+}
+
+TEST(JsonStreamDecoderTest, KeepsPartialValue) {
+  JsonStreamDecoder decoder;
+  auto values = FeedAll(decoder, R"({"a":1}{"b":)", 100);
+  ASSERT_EQ(values.size(), 1);
+  EXPECT_EQ(decoder.Pending(), R"({"b":)");
+
+  values = FeedAll(decoder, "2}", 100);
+  ASSERT_EQ(values.size(), 1);
+  EXPECT_EQ(values[0]["b"], 2);
+  EXPECT_TRUE(decoder.Pending().empty());
+}
+
+TEST(JsonStreamDecoderTest, StallsOnNonJsonBody) {
+  JsonStreamDecoder decoder;
+  auto values = FeedAll(decoder, "404 page not found", 4);
+  EXPECT_TRUE(values.empty());
+  EXPECT_TRUE(decoder.IsStalled());
+  EXPECT_EQ(decoder.Pending(), "404 page not found");
+
+  decoder.Reset();
+  EXPECT_FALSE(decoder.IsStalled());
+  EXPECT_TRUE(decoder.Pending().empty());
+}
+
+TEST(JsonStreamDecoderTest, CallbackCanStopDecoding) {
+  JsonStreamDecoder decoder;
+  size_t calls{0};
+  bool result = decoder.Feed("{\"a\":1}\n{\"a\":2}\n", [&calls](json) {
+    ++calls;
+    return false;
+  });
+  EXPECT_FALSE(result);
+  EXPECT_EQ(calls, 1);
+}
+
+TEST(JsonStreamDecoderTest, FeedFramesHandsOutRawValues) {
+  using FrameAction = JsonStreamDecoder::FrameAction;
+  JsonStreamDecoder decoder;
+  std::vector<std::string> frames;
+  auto on_frame = [&frames](std::string_view frame) {
+    if (frame == "{oops}") {
+      return FrameAction::kInvalid;
+    }
+    frames.emplace_back(frame);
+    return FrameAction::kContinue;
+  };
+  EXPECT_TRUE(decoder.FeedFrames("{\"a\":1}\n{\"b\":", on_frame));
+  ASSERT_EQ(frames.size(), 1);
+  EXPECT_EQ(frames[0], "{\"a\":1}");
+
+  // An invalid frame stalls the decoder and is kept for error reporting.
+  EXPECT_TRUE(decoder.FeedFrames("[2]}\n{oops}", on_frame));
+  ASSERT_EQ(frames.size(), 2);
+  EXPECT_EQ(frames[1], "{\"b\":[2]}");
+  EXPECT_TRUE(decoder.IsStalled());
+  EXPECT_EQ(decoder.Pending(), "{oops}");
+}
+
+TEST(JsonStreamDecoderTest, ChatChunkDecodedWithoutDom) {
+  chat_chunk_decoder chunk_decoder;
+  auto resp = response::from_chat_chunk(
+      R"({"model":"m","message":{"role":"assistant","content":"Hi \"there\""},"done":false})",
+      chunk_decoder);
+  ASSERT_TRUE(resp.get_chat_chunk().has_value());
+  EXPECT_FALSE(resp.get_chat_chunk()->done);
+  EXPECT_EQ(resp.as_simple_string(), "Hi \"there\"");
+  EXPECT_FALSE(resp.has_error());
+  EXPECT_EQ(ResponseParser::GetContent(resp), "Hi \"there\"");
+  EXPECT_FALSE(ResponseParser::GetTools(resp).has_value());
+  // The DOM is still available on demand.
+  EXPECT_EQ(resp.as_json()["model"], "m");
+
+  auto done = response::from_chat_chunk(
+      R"({"message":{"role":"assistant","content":""},"done":true,"eval_count":3})",
+      chunk_decoder);
+  ASSERT_TRUE(done.get_chat_chunk().has_value());
+  EXPECT_TRUE(ResponseParser::IsDone(done));
+
+  // Tool calls are not decoded by the SAX pass: a DOM is built.
+  auto tools = response::from_chat_chunk(
+      R"({"message":{"role":"assistant","content":"","tool_calls":[{"function":{"name":"f","arguments":{"x":1}}}]},"done":false})",
+      chunk_decoder);
+  EXPECT_FALSE(tools.get_chat_chunk().has_value());
+  auto calls = ResponseParser::GetTools(tools);
+  ASSERT_TRUE(calls.has_value());
+  ASSERT_EQ(calls->size(), 1);
+  EXPECT_EQ(calls->at(0).name, "f");
+
+  EXPECT_THROW(response::from_chat_chunk("{\"message\":", chunk_decoder),
+               json::exception);
+}
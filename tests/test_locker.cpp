@@ -0,0 +1,80 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "assistant/common.hpp"
+
+using namespace assistant;
+
+namespace {
+struct Settings {
+  std::string url;
+  size_t max_tokens{0};
+};
+}  // namespace
+
+TEST(LockerTest, CallbacksReturnTheirResult) {
+  Locker<Settings> locker{Settings{"http://a", 10}};
+  EXPECT_EQ(locker.with([](const Settings& s) { return s.max_tokens; }), 10u);
+  EXPECT_EQ(locker.with_mut([](Settings& s) { return ++s.max_tokens; }), 11u);
+  EXPECT_EQ(locker.get_value().max_tokens, 11u);
+}
+
+TEST(SnapshotLockerTest, ReadersKeepTheirSnapshot) {
+  SnapshotLocker<Settings> locker{Settings{"http://a", 10}};
+  auto before = locker.load();
+  locker.with_mut([](Settings& s) { s.url = "http://b"; });
+
+  EXPECT_EQ(before->url, "http://a");
+  EXPECT_EQ(locker.load()->url, "http://b");
+  EXPECT_EQ(locker.load()->max_tokens, 10u);
+  EXPECT_EQ(locker.with([](const Settings& s) { return s.url; }), "http://b");
+}
+
+TEST(SnapshotLockerTest, ThrowingWriterPublishesNothing) {
+  SnapshotLocker<Settings> locker{Settings{"http://a", 10}};
+  EXPECT_THROW(locker.with_mut([](Settings& s) {
+    s.url = "http://b";
+    throw std::runtime_error("failed");
+  }),
+               std::runtime_error);
+  EXPECT_EQ(locker.load()->url, "http://a");
+}
+
+TEST(SnapshotLockerTest, ConcurrentWritersAreSerialised) {
+  SnapshotLocker<Settings> locker{Settings{"0", 0}};
+  std::atomic_bool stop{false};
+  std::atomic_size_t torn{0};
+  std::thread reader([&]() {
+    while (!stop) {
+      // Each write keeps the url and the counter in sync
+      auto value = locker.load();
+      if (value->url != std::to_string(value->max_tokens)) {
+        ++torn;
+      }
+    }
+  });
+
+  std::vector<std::thread> writers;
+  for (int t = 0; t < 4; ++t) {
+    writers.emplace_back([&locker]() {
+      for (int i = 0; i < 1000; ++i) {
+        locker.with_mut([](Settings& s) {
+          ++s.max_tokens;
+          s.url = std::to_string(s.max_tokens);
+        });
+      }
+    });
+  }
+  for (auto& writer : writers) {
+    writer.join();
+  }
+  stop = true;
+  reader.join();
+
+  EXPECT_EQ(locker.load()->max_tokens, 4000u);
+  EXPECT_EQ(torn, 0u);
+}
@@ -0,0 +1,79 @@
+#include <gtest/gtest.h>
+
+#include "assistant/logger.hpp"
+
+using namespace assistant;
+
+namespace {
+std::string Expensive(size_t& calls) {
+  ++calls;
+  return "expensive";
+}
+
+class LoggerTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    SetLogSink([this](LogLevel level, std::string msg) {
+      received_.push_back({level, std::move(msg)});
+    });
+  }
+
+  void TearDown() override {
+    Logger::Instance().SetLogLevel(LogLevel::kInfo);
+    // Restore the default logging system.
+    SetLogSink(nullptr);
+  }
+
+  std::vector<std::pair<LogLevel, std::string>> received_;
+};
+}  // namespace
+
+TEST_F(LoggerTest, FilteredMessageArgumentsAreNotEvaluated) {
+  SetLogSink(
+      [this](LogLevel level, std::string msg) {
+        received_.push_back({level, std::move(msg)});
+      },
+      LogLevel::kInfo);
+
+  size_t calls{0};
+  OLOG_TRACE() << Expensive(calls);
+  OLOG_DEBUG() << Expensive(calls);
+  EXPECT_EQ(calls, 0);
+  EXPECT_TRUE(received_.empty());
+
+  OLOG_INFO() << Expensive(calls);
+  EXPECT_EQ(calls, 1);
+  ASSERT_EQ(received_.size(), 1);
+  EXPECT_EQ(received_[0].first, LogLevel::kInfo);
+  EXPECT_EQ(received_[0].second, "expensive");
+}
+
+TEST_F(LoggerTest, SinkReceivesAllLevelsByDefault) {
+  OLOG_TRACE() << "trace";
+  OLOG_ERROR() << "error";
+  ASSERT_EQ(received_.size(), 2);
+  EXPECT_EQ(received_[0].first, LogLevel::kTrace);
+  EXPECT_EQ(received_[1].first, LogLevel::kError);
+}
+
+TEST_F(LoggerTest, IsEnabledFollowsLogLevelWithoutSink) {
+  SetLogSink(nullptr);
+  Logger::Instance().SetLogLevel(LogLevel::kWarning);
+  EXPECT_EQ(Logger::Instance().GetLogLevel(), LogLevel::kWarning);
+  EXPECT_FALSE(IsLogEnabled(LogLevel::kInfo));
+  EXPECT_TRUE(IsLogEnabled(LogLevel::kWarning));
+  EXPECT_TRUE(IsLogEnabled(LogLevel::kError));
+
+  Logger::Instance().SetLogLevel(LogLevel::kTrace);
+  EXPECT_TRUE(IsLogEnabled(LogLevel::kTrace));
+}
+
+TEST_F(LoggerTest, SafeInsideUnbracedIf) {
+  size_t calls{0};
+  bool flag{false};
+  if (flag)
+    OLOG_INFO() << Expensive(calls);
+  else
+    ++calls;
+  EXPECT_EQ(calls, 1);
+}
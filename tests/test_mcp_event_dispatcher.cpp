@@ -0,0 +1,381 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "assistant/cpp-mcp/mcp_server.h"
+#include "assistant/helpers.hpp"
+
+using namespace mcp;
+using namespace std::chrono_literals;
+
+namespace {
+std::string MakeEvent(int i) {
+  return "event: message\r\ndata: " + std::to_string(i) + "\r\n\r\n";
+}
+
+/// A sink that records every write.
+struct RecordingSink {
+  RecordingSink() {
+    sink.write = [this](const char* data, size_t len) {
+      writes.emplace_back(data, len);
+      return true;
+    };
+  }
+  httplib::DataSink sink;
+  std::vector<std::string> writes;
+};
+}  // namespace
+
+TEST(EventDispatcherTest, WritesPendingEventsAsOneBatch) {
+  event_dispatcher dispatcher;
+  std::string expected;
+  for (int i = 0; i < 5; ++i) {
+    ASSERT_TRUE(dispatcher.send_event(MakeEvent(i)));
+    expected += MakeEvent(i);
+  }
+  EXPECT_EQ(dispatcher.pending_events(), 5u);
+
+  RecordingSink recorder;
+  ASSERT_TRUE(dispatcher.wait_event(&recorder.sink, 100ms));
+  ASSERT_EQ(recorder.writes.size(), 1u);
+  EXPECT_EQ(recorder.writes[0], expected);
+  EXPECT_EQ(dispatcher.pending_events(), 0u);
+}
+
+TEST(EventDispatcherTest, KeepsOrderAcrossTheRingBoundary) {
+  event_dispatcher dispatcher{3};
+  RecordingSink recorder;
+  std::string expected;
+  for (int i = 0; i < 10; ++i) {
+    ASSERT_TRUE(dispatcher.send_event(MakeEvent(i)));
+    expected += MakeEvent(i);
+    if (i % 2 == 1) {
+      ASSERT_TRUE(dispatcher.wait_event(&recorder.sink, 100ms));
+    }
+  }
+
+  std::string written;
+  for (const auto& write : recorder.writes) {
+    written += write;
+  }
+  EXPECT_EQ(written, expected);
+}
+
+TEST(EventDispatcherTest, ReportsBackpressureWhenFull) {
+  event_dispatcher dispatcher{2, 10ms};
+  EXPECT_TRUE(dispatcher.send_event(MakeEvent(0)));
+  EXPECT_TRUE(dispatcher.send_event(MakeEvent(1)));
+  EXPECT_FALSE(dispatcher.send_event(MakeEvent(2)));
+  EXPECT_EQ(dispatcher.dropped_events(), 1u);
+  EXPECT_EQ(dispatcher.pending_events(), 2u);
+
+  // A producer blocked on a full queue resumes once the consumer drains it.
+  event_dispatcher slow{1, 5000ms};
+  ASSERT_TRUE(slow.send_event(MakeEvent(0)));
+  std::thread producer([&slow]() { EXPECT_TRUE(slow.send_event(MakeEvent(1))); });
+  RecordingSink recorder;
+  ASSERT_TRUE(slow.wait_event(&recorder.sink, 100ms));
+  producer.join();
+  EXPECT_EQ(slow.pending_events(), 1u);
+  EXPECT_EQ(slow.dropped_events(), 0u);
+}
+
+TEST(EventDispatcherTest, CloseWakesWaiters) {
+  event_dispatcher dispatcher;
+  RecordingSink recorder;
+  std::thread closer([&dispatcher]() {
+    std::this_thread::sleep_for(20ms);
+    dispatcher.close();
+  });
+  auto start = std::chrono::steady_clock::now();
+  EXPECT_FALSE(dispatcher.wait_event(&recorder.sink, 10000ms));
+  EXPECT_TRUE(dispatcher.wait_closed(10000ms));
+  EXPECT_LT(std::chrono::steady_clock::now() - start, 5s);
+  closer.join();
+
+  EXPECT_FALSE(dispatcher.send_event(MakeEvent(0)));
+  EXPECT_TRUE(recorder.writes.empty());
+}
+
+TEST(EventDispatcherTest, ConcurrentProducersOnOneSession) {
+  // Thousands of responses racing into one session, as concurrent tools/call
+  // requests do, with a queue small enough to exercise the backpressure wait.
+  constexpr int kProducers = 16;
+  constexpr int kEventsPerProducer = 250;
+  event_dispatcher dispatcher{64, 10000ms};
+
+  std::string stream;
+  size_t writes{0};
+  httplib::DataSink sink;
+  sink.write = [&stream, &writes](const char* data, size_t len) {
+    stream.append(data, len);
+    ++writes;
+    return true;
+  };
+  std::thread consumer([&]() {
+    while (dispatcher.wait_event(&sink, 1000ms)) {
+    }
+  });
+
+  std::vector<std::thread> producers;
+  for (int p = 0; p < kProducers; ++p) {
+    producers.emplace_back([&dispatcher, p]() {
+      for (int i = 0; i < kEventsPerProducer; ++i) {
+        EXPECT_TRUE(
+            dispatcher.send_event(MakeEvent(p * kEventsPerProducer + i)));
+      }
+    });
+  }
+  for (auto& producer : producers) {
+    producer.join();
+  }
+  consumer.join();
+
+  std::set<int> received;
+  assistant::SseFramer framer;
+  framer.Append(stream);
+  while (auto event = framer.Next()) {
+    received.insert(std::stoi(std::string{event->data}));
+  }
+  EXPECT_EQ(received.size(),
+            static_cast<size_t>(kProducers * kEventsPerProducer));
+  EXPECT_EQ(dispatcher.dropped_events(), 0u);
+  EXPECT_LE(writes, received.size());
+}
+
+namespace {
+/// An mcp::server on a local port, with one initialized SSE session whose
+/// JSON-RPC responses are collected by id.
+class McpServerSession : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    assistant::SetLogLevel(assistant::LogLevel::kWarning);
+    set_log_level(log_level::warning);
+
+    port_ = 20000 + static_cast<int>(
+                        std::hash<std::thread::id>{}(std::this_thread::get_id()) %
+                        20000);
+    server_ = std::make_unique<server>("127.0.0.1", port_);
+    server_->set_capabilities({{"tools", json::object()}});
+    server_->register_tool(
+        tool_builder("echo").with_number_param("n", "").build(),
+        [this](const json& params, const std::string&) -> json {
+          int running = ++running_;
+          int max = max_running_;
+          while (running > max &&
+                 !max_running_.compare_exchange_weak(max, running)) {
+          }
+          --running_;
+          return json::array(
+              {{{"type", "text"},
+                {"text", std::to_string(params["n"].get<int>())}}});
+        });
+  }
+
+  void TearDown() override {
+    stop_ = true;
+    if (server_thread_.joinable()) {
+      server_->stop();
+      server_thread_.join();
+    }
+    if (sse_thread_.joinable()) {
+      sse_thread_.join();
+    }
+  }
+
+  /// Start the server, open the SSE session and initialize it.
+  void Start() {
+    server_thread_ = std::thread([this]() { server_->start(true); });
+    sse_thread_ = std::thread([this]() { ReadEvents(); });
+    {
+      std::unique_lock lock{m_};
+      ASSERT_TRUE(
+          cv_.wait_for(lock, 10s, [this]() { return !endpoint_.empty(); }));
+    }
+    ASSERT_TRUE(Post({{"jsonrpc", "2.0"},
+                      {"id", 0},
+                      {"method", "initialize"},
+                      {"params",
+                       {{"protocolVersion", MCP_VERSION},
+                        {"capabilities", json::object()},
+                        {"clientInfo", {{"name", "test"}}}}}}));
+    ASSERT_TRUE(WaitForResponses(1, 10s));
+    ASSERT_TRUE(
+        Post({{"jsonrpc", "2.0"}, {"method", "notifications/initialized"}}));
+    // The notification is processed asynchronously: wait for a tool call
+    // to succeed.
+    for (int i = 0; i < 100; ++i) {
+      ASSERT_TRUE(Post(MakeCall(-1 - i, 0)));
+      if (WaitForResponses(i + 2, 10s) && received_[-1 - i].contains("result")) {
+        break;
+      }
+    }
+    std::lock_guard lock{m_};
+    received_.clear();
+  }
+
+  static json MakeCall(int id, int n) {
+    return {{"jsonrpc", "2.0"},
+            {"id", id},
+            {"method", "tools/call"},
+            {"params", {{"name", "echo"}, {"arguments", {{"n", n}}}}}};
+  }
+
+  bool Post(const json& message) {
+    httplib::Client cli("127.0.0.1", port_);
+    auto res = cli.Post(endpoint_, message.dump(), "application/json");
+    return res && res->status == 202;
+  }
+
+  /// Post `calls` tools/call requests from `threads` clients at once.
+  int PostCalls(int calls, int threads) {
+    std::atomic_int accepted{0};
+    std::vector<std::thread> clients;
+    for (int t = 0; t < threads; ++t) {
+      clients.emplace_back([this, &accepted, t, calls, threads]() {
+        httplib::Client cli("127.0.0.1", port_);
+        for (int i = t; i < calls; i += threads) {
+          // Retry when the connection is refused: many clients connecting at
+          // once can overflow the listen backlog of the server.
+          for (int attempt = 0; attempt < 5; ++attempt) {
+            auto res = cli.Post(endpoint_, MakeCall(i, i).dump(),
+                                "application/json");
+            if (res) {
+              accepted += res->status == 202;
+              break;
+            }
+          }
+        }
+      });
+    }
+    for (auto& client : clients) {
+      client.join();
+    }
+    return accepted;
+  }
+
+  bool WaitForResponses(size_t count, std::chrono::seconds timeout) {
+    std::unique_lock lock{m_};
+    return cv_.wait_for(lock, timeout,
+                        [this, count]() { return received_.size() >= count; });
+  }
+
+  void ReadEvents() {
+    assistant::SseFramer framer;
+    // Retry until the server listens
+    for (int attempt = 0; attempt < 100 && !stop_; ++attempt) {
+      httplib::Client cli("127.0.0.1", port_);
+      cli.set_read_timeout(30, 0);
+      auto res = cli.Get("/sse", [this, &framer](const char* data, size_t len) {
+        framer.Append({data, len});
+        while (auto event = framer.Next()) {
+          std::lock_guard lock{m_};
+          if (event->event == "endpoint") {
+            endpoint_ = std::string{event->data};
+          } else if (event->event == "message") {
+            auto j = json::parse(event->data, nullptr, false);
+            if (j.contains("id") && j["id"].is_number()) {
+              int id = j["id"].get<int>();
+              received_[id] = std::move(j);
+            }
+          }
+          cv_.notify_all();
+        }
+        return !stop_;
+      });
+      if (res || !endpoint_.empty()) {
+        break;
+      }
+      std::this_thread::sleep_for(50ms);
+    }
+  }
+
+  int port_{0};
+  std::unique_ptr<server> server_;
+  std::thread server_thread_;
+  std::thread sse_thread_;
+  std::atomic_bool stop_{false};
+  std::atomic_int running_{0};
+  std::atomic_int max_running_{0};
+
+  std::mutex m_;
+  std::condition_variable cv_;
+  std::string endpoint_;
+  std::map<int, json> received_;
+};
+}  // namespace
+
+TEST_F(McpServerSession, ConcurrentToolCallsOnOneSession) {
+  constexpr int kCalls = 2000;
+  ASSERT_NO_FATAL_FAILURE(Start());
+
+  EXPECT_EQ(PostCalls(kCalls, 16), kCalls);
+  ASSERT_TRUE(WaitForResponses(kCalls, 30s));
+
+  std::lock_guard lock{m_};
+  for (int i = 0; i < kCalls; ++i) {
+    ASSERT_TRUE(received_.count(i)) << "missing response " << i;
+    EXPECT_EQ(received_[i]["result"]["content"][0]["text"], std::to_string(i));
+  }
+}
+
+TEST_F(McpServerSession, MethodConcurrencyLimit) {
+  constexpr int kCalls = 500;
+  server_->set_method_concurrency("tools/call", 1);
+  ASSERT_NO_FATAL_FAILURE(Start());
+
+  EXPECT_EQ(PostCalls(kCalls, 8), kCalls);
+  ASSERT_TRUE(WaitForResponses(kCalls, 30s));
+  EXPECT_EQ(max_running_, 1);
+
+  // Other methods are not held back by the queued tool calls
+  ASSERT_TRUE(Post({{"jsonrpc", "2.0"}, {"id", kCalls}, {"method", "ping"}}));
+  ASSERT_TRUE(WaitForResponses(kCalls + 1, 10s));
+}
+
+TEST_F(McpServerSession, MoreSessionsThanDefaultWorkers) {
+  // Every SSE session holds an HTTP worker while it is connected
+  constexpr int kSessions = 50;
+  server_thread_ = std::thread([this]() { server_->start(true); });
+
+  std::atomic_int connected{0};
+  std::vector<std::thread> sessions;
+  for (int i = 0; i < kSessions; ++i) {
+    sessions.emplace_back([this, &connected]() {
+      for (int attempt = 0; attempt < 100; ++attempt) {
+        httplib::Client cli("127.0.0.1", port_);
+        bool has_endpoint = false;
+        cli.Get("/sse", [&](const char* data, size_t len) {
+          if (!has_endpoint &&
+              std::string_view{data, len}.find("event: endpoint") !=
+                  std::string_view::npos) {
+            has_endpoint = true;
+            ++connected;
+          }
+          return true;
+        });
+        if (has_endpoint) {
+          break;
+        }
+        std::this_thread::sleep_for(50ms);
+      }
+    });
+  }
+
+  auto deadline = std::chrono::steady_clock::now() + 10s;
+  while (connected < kSessions && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(10ms);
+  }
+  EXPECT_EQ(connected, kSessions);
+
+  // Stopping the server ends every session
+  server_->stop();
+  for (auto& session : sessions) {
+    session.join();
+  }
+}
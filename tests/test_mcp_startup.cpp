@@ -0,0 +1,184 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <sstream>
+
+#include "assistant/config.hpp"
+#include "assistant/function.hpp"
+
+using namespace assistant;
+
+#if !defined(_WIN32)
+namespace {
+
+struct TestServer {
+  std::string name;
+  int startup_delay_ms{0};
+  int startup_timeout_ms{10000};
+  /// The name of the tool, defaults to the name of the server.
+  std::string tool{};
+};
+
+Config MakeConfig(const std::vector<TestServer>& servers) {
+  json mcp_servers = json::object();
+  for (const auto& s : servers) {
+    mcp_servers[s.name] = {
+        {"type", "stdio"},
+        {"command",
+         {MCP_TEST_SERVER, s.tool.empty() ? s.name : s.tool,
+          std::to_string(s.startup_delay_ms)}},
+        {"startup_timeout_msecs", s.startup_timeout_ms}};
+  }
+  json content = {{"mcp_servers", mcp_servers}};
+  auto result = ConfigBuilder::FromContent(content.dump());
+  EXPECT_TRUE(result.ok()) << result.errmsg_;
+  return result.config_.value();
+}
+
+bool HasFunction(FunctionTable& table, const std::string& name) {
+  for (const auto& [funcname, _] : table.GetAllFunctions()) {
+    if (funcname == name) {
+      return true;
+    }
+  }
+  return false;
+}
+
+std::chrono::milliseconds ElapsedSince(
+    std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - start);
+}
+
+}  // namespace
+
+TEST(MCPStartupTest, ServersStartConcurrently) {
+  Config config = MakeConfig({{"alpha", 400},
+                              {"beta", 400},
+                              {"gamma", 400},
+                              {"delta", 400}});
+  FunctionTable table;
+  auto start = std::chrono::steady_clock::now();
+  auto report = table.ReloadMCPServers(&config);
+  auto elapsed = ElapsedSince(start);
+
+  // One at a time, this takes at least 4 x 400ms.
+  EXPECT_LT(elapsed, std::chrono::milliseconds(1400));
+  ASSERT_EQ(report.size(), 4);
+  for (const auto& server : report) {
+    EXPECT_TRUE(server.ok) << server.name;
+    EXPECT_EQ(server.tools_count, 1) << server.name;
+    EXPECT_GE(server.elapsed, std::chrono::milliseconds(400)) << server.name;
+  }
+  EXPECT_EQ(table.GetFunctionsCount(), 4);
+  for (const auto& name : {"alpha", "beta", "gamma", "delta"}) {
+    EXPECT_TRUE(HasFunction(table, name)) << name;
+  }
+}
+
+TEST(MCPStartupTest, SlowServerIsDroppedAfterItsDeadline) {
+  Config config = MakeConfig({{"fast", 0}, {"slow", 10000, 500}});
+  FunctionTable table;
+  auto start = std::chrono::steady_clock::now();
+  auto report = table.ReloadMCPServers(&config);
+  auto elapsed = ElapsedSince(start);
+
+  EXPECT_LT(elapsed, std::chrono::milliseconds(3000));
+  ASSERT_EQ(report.size(), 2);
+  // The report follows the config order ("fast" < "slow").
+  EXPECT_EQ(report[0].name, "fast");
+  EXPECT_TRUE(report[0].ok);
+  EXPECT_EQ(report[1].name, "slow");
+  EXPECT_FALSE(report[1].ok);
+  EXPECT_EQ(table.GetFunctionsCount(), 1);
+  EXPECT_TRUE(HasFunction(table, "fast"));
+  EXPECT_FALSE(HasFunction(table, "slow"));
+}
+
+TEST(MCPStartupTest, ReloadReplacesTheServers) {
+  FunctionTable table;
+  Config first = MakeConfig({{"one", 0}});
+  table.ReloadMCPServers(&first);
+  EXPECT_TRUE(HasFunction(table, "one"));
+
+  Config second = MakeConfig({{"two", 0}});
+  table.ReloadMCPServers(&second);
+  EXPECT_FALSE(HasFunction(table, "one"));
+  EXPECT_TRUE(HasFunction(table, "two"));
+  EXPECT_EQ(table.GetFunctionsCount(), 1);
+}
+
+TEST(MCPStartupTest, ReloadKeepsUnchangedServers) {
+  FunctionTable table;
+  Config first = MakeConfig({{"stable", 800}, {"removed", 0}});
+  auto report = table.ReloadMCPServers(&first);
+  ASSERT_EQ(report.size(), 2);
+  EXPECT_FALSE(report[0].reused);
+
+  // "stable" is not started again: the reload does not wait for it.
+  Config second = MakeConfig({{"added", 0}, {"stable", 800}});
+  auto start = std::chrono::steady_clock::now();
+  report = table.ReloadMCPServers(&second);
+  EXPECT_LT(ElapsedSince(start), std::chrono::milliseconds(700));
+
+  ASSERT_EQ(report.size(), 2);
+  EXPECT_EQ(report[0].name, "added");
+  EXPECT_TRUE(report[0].ok);
+  EXPECT_FALSE(report[0].reused);
+  EXPECT_EQ(report[1].name, "stable");
+  EXPECT_TRUE(report[1].ok);
+  EXPECT_TRUE(report[1].reused);
+  EXPECT_EQ(report[1].tools_count, 1);
+
+  EXPECT_EQ(table.GetFunctionsCount(), 2);
+  EXPECT_TRUE(HasFunction(table, "stable"));
+  EXPECT_TRUE(HasFunction(table, "added"));
+  EXPECT_FALSE(HasFunction(table, "removed"));
+}
+
+TEST(MCPStartupTest, ReloadRestartsChangedServers) {
+  FunctionTable table;
+  Config first = MakeConfig({{"server", 0}});
+  table.ReloadMCPServers(&first);
+
+  // A different command line is a different server.
+  Config second = MakeConfig({{"server", 300}});
+  auto report = table.ReloadMCPServers(&second);
+  ASSERT_EQ(report.size(), 1);
+  EXPECT_TRUE(report[0].ok);
+  EXPECT_FALSE(report[0].reused);
+  EXPECT_GE(report[0].elapsed, std::chrono::milliseconds(300));
+  EXPECT_EQ(table.GetFunctionsCount(), 1);
+  EXPECT_TRUE(HasFunction(table, "server"));
+
+  // Only the startup timeout changed: the server is kept.
+  Config third = MakeConfig({{"server", 300, 5000}});
+  report = table.ReloadMCPServers(&third);
+  ASSERT_EQ(report.size(), 1);
+  EXPECT_TRUE(report[0].reused);
+  EXPECT_TRUE(HasFunction(table, "server"));
+}
+
+TEST(MCPStartupTest, ReloadRestoresToolsShadowedByRemovedServers) {
+  FunctionTable table;
+  // Both servers export "shared": "owner" is ready first and registers it.
+  Config first = MakeConfig({{"owner", 0, 10000, "shared"},
+                             {"kept", 300, 10000, "shared"}});
+  table.ReloadMCPServers(&first);
+  EXPECT_EQ(table.GetFunctionsCount(), 1);
+
+  // "owner" is removed: the tool of "kept" takes its place.
+  Config second = MakeConfig({{"kept", 300, 10000, "shared"}});
+  auto report = table.ReloadMCPServers(&second);
+  ASSERT_EQ(report.size(), 1);
+  EXPECT_TRUE(report[0].reused);
+  EXPECT_EQ(table.GetFunctionsCount(), 1);
+  EXPECT_TRUE(HasFunction(table, "shared"));
+
+  // The tool now belongs to "kept", and goes away with it.
+  Config third = MakeConfig({{"other", 0}});
+  table.ReloadMCPServers(&third);
+  EXPECT_FALSE(HasFunction(table, "shared"));
+  EXPECT_TRUE(HasFunction(table, "other"));
+}
+#endif
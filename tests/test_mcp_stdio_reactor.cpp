@@ -0,0 +1,111 @@
+#include <gtest/gtest.h>
+
+#include "assistant/cpp-mcp/mcp_stdio_reactor.h"
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#endif
+
+using namespace mcp;
+
+TEST(LineSplitterTest, SplitsLinesAcrossChunks) {
+  std::string stream = "first\nsecond line\n\nthird";
+  for (size_t chunk_size : {1, 3, 100}) {
+    line_splitter splitter;
+    std::vector<std::string> lines;
+    for (size_t pos = 0; pos < stream.size(); pos += chunk_size) {
+      auto chunk = stream.substr(pos, chunk_size);
+      splitter.feed(chunk.data(), chunk.size(), [&lines](std::string_view l) {
+        lines.emplace_back(l);
+      });
+    }
+    EXPECT_EQ(lines, (std::vector<std::string>{"first", "second line", ""}))
+        << "chunk_size=" << chunk_size;
+    EXPECT_EQ(splitter.pending(), "third");
+  }
+}
+
+#if !defined(_WIN32)
+namespace {
+struct Pipe {
+  Pipe() {
+    EXPECT_EQ(pipe(fds), 0);
+    fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL, 0) | O_NONBLOCK);
+  }
+  ~Pipe() {
+    CloseWrite();
+    close(fds[0]);
+  }
+  void Write(const std::string& s) {
+    EXPECT_EQ(write(fds[1], s.data(), s.size()),
+              static_cast<ssize_t>(s.size()));
+  }
+  void CloseWrite() {
+    if (fds[1] != -1) {
+      close(fds[1]);
+      fds[1] = -1;
+    }
+  }
+  int fds[2] = {-1, -1};
+};
+
+template <typename Pred>
+bool WaitFor(Pred pred) {
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (!pred()) {
+    if (std::chrono::steady_clock::now() > deadline) {
+      return false;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return true;
+}
+}  // namespace
+
+TEST(StdioReactorTest, DispatchesDataAndClose) {
+  Pipe p;
+  std::mutex mutex;
+  std::string received;
+  std::atomic_bool closed{false};
+  auto& reactor = stdio_reactor::instance();
+  ASSERT_TRUE(reactor.add(
+      p.fds[0],
+      [&](const char* data, size_t len) {
+        std::lock_guard<std::mutex> lock(mutex);
+        received.append(data, len);
+      },
+      [&closed]() { closed = true; }));
+  EXPECT_FALSE(reactor.add(p.fds[0], nullptr, nullptr));
+
+  p.Write("hello ");
+  p.Write("world");
+  EXPECT_TRUE(WaitFor([&]() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return received == "hello world";
+  }));
+
+  p.CloseWrite();
+  EXPECT_TRUE(WaitFor([&closed]() { return closed.load(); }));
+  reactor.remove(p.fds[0]);
+}
+
+TEST(StdioReactorTest, NoCallbackAfterRemove) {
+  Pipe p;
+  std::atomic_size_t calls{0};
+  auto& reactor = stdio_reactor::instance();
+  size_t watched = reactor.size();
+  ASSERT_TRUE(reactor.add(
+      p.fds[0], [&calls](const char*, size_t) { ++calls; }, nullptr));
+  EXPECT_EQ(reactor.size(), watched + 1);
+  reactor.remove(p.fds[0]);
+  EXPECT_EQ(reactor.size(), watched);
+
+  p.Write("ignored");
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_EQ(calls.load(), 0);
+}
+#endif
@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "assistant/cpp-mcp/mcp_timer_wheel.h"
+
+using namespace mcp;
+using namespace std::chrono_literals;
+
+namespace {
+template <typename Predicate>
+bool WaitUntil(Predicate&& predicate, std::chrono::milliseconds timeout) {
+  auto deadline = std::chrono::steady_clock::now() + timeout;
+  while (!predicate()) {
+    if (std::chrono::steady_clock::now() > deadline) {
+      return false;
+    }
+    std::this_thread::sleep_for(1ms);
+  }
+  return true;
+}
+}  // namespace
+
+TEST(TimerWheelTest, FiresInDeadlineOrder) {
+  timer_wheel wheel{5ms, 8};
+  std::mutex m;
+  std::vector<int> fired;
+  // 100ms is more than a turn of the wheel (8 * 5ms)
+  for (int delay : {100, 10, 50, 1}) {
+    ASSERT_TRUE(wheel.schedule(std::chrono::milliseconds(delay), [&, delay]() {
+      std::lock_guard lock{m};
+      fired.push_back(delay);
+    }));
+  }
+  EXPECT_EQ(wheel.size(), 4u);
+
+  ASSERT_TRUE(WaitUntil(
+      [&]() {
+        std::lock_guard lock{m};
+        return fired.size() == 4;
+      },
+      5s));
+  std::lock_guard lock{m};
+  EXPECT_EQ(fired, (std::vector<int>{1, 10, 50, 100}));
+  EXPECT_EQ(wheel.size(), 0u);
+}
+
+TEST(TimerWheelTest, DoesNotFireEarly) {
+  timer_wheel wheel{5ms, 4};
+  auto start = std::chrono::steady_clock::now();
+  std::atomic<std::chrono::steady_clock::duration> elapsed{};
+  std::atomic_bool done{false};
+  wheel.schedule(60ms, [&]() {
+    elapsed = std::chrono::steady_clock::now() - start;
+    done = true;
+  });
+  ASSERT_TRUE(WaitUntil([&]() { return done.load(); }, 5s));
+  EXPECT_GE(elapsed.load(), 60ms);
+}
+
+TEST(TimerWheelTest, CallbacksCanReschedule) {
+  timer_wheel wheel{1ms, 16};
+  std::atomic_int count{0};
+  std::function<void()> tick = [&]() {
+    if (++count < 5) {
+      wheel.schedule(2ms, tick);
+    }
+  };
+  wheel.schedule(2ms, tick);
+  ASSERT_TRUE(WaitUntil([&]() { return count == 5; }, 5s));
+}
+
+TEST(TimerWheelTest, StopDropsPendingTimers) {
+  timer_wheel wheel{1ms, 16};
+  std::atomic_int count{0};
+  for (int i = 0; i < 1000; ++i) {
+    wheel.schedule(10s, [&]() { ++count; });
+  }
+  EXPECT_EQ(wheel.size(), 1000u);
+
+  wheel.stop();
+  EXPECT_EQ(wheel.size(), 0u);
+  EXPECT_FALSE(wheel.schedule(1ms, [&]() { ++count; }));
+  EXPECT_EQ(count, 0);
+}
+
+TEST(TimerWheelTest, RestartsAfterStop) {
+  timer_wheel wheel{1ms, 16};
+  std::atomic_int count{0};
+  ASSERT_TRUE(wheel.schedule(1ms, [&]() { ++count; }));
+  ASSERT_TRUE(WaitUntil([&]() { return count == 1; }, 5s));
+
+  wheel.stop();
+  EXPECT_FALSE(wheel.schedule(1ms, [&]() { ++count; }));
+
+  wheel.start();
+  ASSERT_TRUE(wheel.schedule(1ms, [&]() { ++count; }));
+  ASSERT_TRUE(WaitUntil([&]() { return count == 2; }, 5s));
+}
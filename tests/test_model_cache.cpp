@@ -0,0 +1,250 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <future>
+#include <thread>
+
+#include "assistant/config.hpp"
+#include "assistant/model_cache.hpp"
+#include "tests/fake_transport.hpp"
+
+using namespace assistant;
+using namespace std::chrono_literals;
+
+namespace {
+
+constexpr std::string_view kEndpoint = "http://127.0.0.1:11434";
+
+ModelCapabilities ToolsAndThinking() {
+  ModelCapabilities flags{ModelCapabilities::kNone};
+  AddFlagSet(flags, ModelCapabilities::kTools);
+  AddFlagSet(flags, ModelCapabilities::kThinking);
+  return flags;
+}
+
+/// A fetcher that counts its calls.
+struct CountingFetcher {
+  std::atomic_int calls{0};
+  std::chrono::milliseconds delay{0};
+  bool fail{false};
+
+  ModelCapabilitiesCache::Fetcher Get() {
+    return [this](const std::string&) -> std::optional<ModelCapabilities> {
+      ++calls;
+      std::this_thread::sleep_for(delay);
+      if (fail) {
+        return std::nullopt;
+      }
+      return ToolsAndThinking();
+    };
+  }
+};
+
+std::string TempFile(const std::string& name) {
+  auto path = std::filesystem::temp_directory_path() /
+              (name + "." + std::to_string(::getpid()) + ".json");
+  std::filesystem::remove(path);
+  return path.string();
+}
+
+/// Counts the calls of the virtual `GetModelCapabilities`.
+class CountingClient : public FakeClient {
+ public:
+  explicit CountingClient(std::atomic_int& calls) : m_calls{calls} {}
+
+  std::optional<ModelCapabilities> GetModelCapabilities(
+      const std::string&) override {
+    ++m_calls;
+    return ModelCapabilities::kNone;
+  }
+
+ private:
+  std::atomic_int& m_calls;
+};
+
+}  // namespace
+
+TEST(ModelCapabilitiesCacheTest, FetchesOnce) {
+  ModelCapabilitiesCache cache;
+  CountingFetcher fetcher;
+  auto fetch = fetcher.Get();
+  std::string endpoint{kEndpoint};
+
+  EXPECT_EQ(cache.Get(endpoint, "llama", fetch), ToolsAndThinking());
+  EXPECT_EQ(cache.Get(endpoint, "llama", fetch), ToolsAndThinking());
+  EXPECT_EQ(fetcher.calls, 1);
+
+  // Another endpoint is another model
+  cache.Get("http://other:11434", "llama", fetch);
+  EXPECT_EQ(fetcher.calls, 2);
+}
+
+TEST(ModelCapabilitiesCacheTest, ConcurrentLookupsShareTheFetch) {
+  ModelCapabilitiesCache cache;
+  CountingFetcher slow;
+  slow.delay = 300ms;
+  auto slow_fetch = slow.Get();
+  CountingFetcher fast;
+  auto fast_fetch = fast.Get();
+  std::string endpoint{kEndpoint};
+  cache.Get(endpoint, "cached", fast_fetch);
+
+  std::vector<std::future<ModelCapabilities>> lookups;
+  for (int i = 0; i < 4; ++i) {
+    lookups.push_back(std::async(std::launch::async, [&]() {
+      return cache.Get(endpoint, "slow", slow_fetch);
+    }));
+  }
+  std::this_thread::sleep_for(50ms);
+
+  // The fetch in progress does not block the lookups of other models
+  auto start = std::chrono::steady_clock::now();
+  EXPECT_EQ(cache.Get(endpoint, "cached", fast_fetch), ToolsAndThinking());
+  EXPECT_LT(std::chrono::steady_clock::now() - start, 100ms);
+
+  for (auto& lookup : lookups) {
+    EXPECT_EQ(lookup.get(), ToolsAndThinking());
+  }
+  EXPECT_EQ(slow.calls, 1);
+}
+
+TEST(ModelCapabilitiesCacheTest, ExpiredEntriesAreFetchedAgain) {
+  ModelCapabilitiesCache cache{0s};
+  CountingFetcher fetcher;
+  auto fetch = fetcher.Get();
+  cache.Get(std::string{kEndpoint}, "llama", fetch);
+  cache.Get(std::string{kEndpoint}, "llama", fetch);
+  EXPECT_EQ(fetcher.calls, 2);
+
+  cache.SetTTL(1h);
+  cache.Get(std::string{kEndpoint}, "llama", fetch);
+  EXPECT_EQ(fetcher.calls, 2);
+}
+
+TEST(ModelCapabilitiesCacheTest, FailuresAreNotRetriedImmediately) {
+  ModelCapabilitiesCache cache;
+  CountingFetcher fetcher;
+  fetcher.fail = true;
+  auto fetch = fetcher.Get();
+  EXPECT_EQ(cache.Get(std::string{kEndpoint}, "llama", fetch),
+            ModelCapabilities::kNone);
+  EXPECT_EQ(cache.Get(std::string{kEndpoint}, "llama", fetch),
+            ModelCapabilities::kNone);
+  EXPECT_EQ(fetcher.calls, 1);
+}
+
+TEST(ModelCapabilitiesCacheTest, WarmUpFetchesInTheBackground) {
+  ModelCapabilitiesCache cache;
+  CountingFetcher fetcher;
+  fetcher.delay = 100ms;
+  std::string endpoint{kEndpoint};
+
+  auto start = std::chrono::steady_clock::now();
+  cache.WarmUp(endpoint, {"one", "two"}, fetcher.Get());
+  EXPECT_LT(std::chrono::steady_clock::now() - start, 50ms);
+  cache.Wait();
+  EXPECT_EQ(fetcher.calls, 2);
+  EXPECT_EQ(cache.Peek(endpoint, "two"), ToolsAndThinking());
+
+  // Nothing left to fetch
+  cache.WarmUp(endpoint, {"one", "two"}, fetcher.Get());
+  cache.Wait();
+  EXPECT_EQ(fetcher.calls, 2);
+}
+
+TEST(ModelCapabilitiesCacheTest, WarmUpsShareOneThread) {
+  ModelCapabilitiesCache cache;
+  CountingFetcher fetcher;
+  fetcher.delay = 100ms;
+  std::string endpoint{kEndpoint};
+
+  // The second warm-up is queued to the thread of the first one.
+  cache.WarmUp(endpoint, {"one"}, fetcher.Get());
+  cache.WarmUp(endpoint, {"two"}, fetcher.Get());
+  cache.Wait();
+  EXPECT_EQ(fetcher.calls, 2);
+  EXPECT_EQ(cache.Peek(endpoint, "two"), ToolsAndThinking());
+}
+
+TEST(ModelCapabilitiesCacheTest, CancelWarmUpDropsTheQueuedModels) {
+  ModelCapabilitiesCache cache;
+  CountingFetcher fetcher;
+  fetcher.delay = 200ms;
+  std::string endpoint{kEndpoint};
+
+  cache.WarmUp(endpoint, {"one", "two", "three"}, fetcher.Get());
+  std::this_thread::sleep_for(50ms);
+  auto start = std::chrono::steady_clock::now();
+  cache.CancelWarmUp();
+  EXPECT_LT(std::chrono::steady_clock::now() - start, 100ms);
+  cache.Wait();
+  // Only the fetch in progress completed.
+  EXPECT_EQ(fetcher.calls, 1);
+  EXPECT_FALSE(cache.Peek(endpoint, "three").has_value());
+}
+
+TEST(ModelCapabilitiesCacheTest, PersistsBetweenRuns) {
+  std::string path = TempFile("model_cache_test");
+  std::string endpoint{kEndpoint};
+  {
+    ModelCapabilitiesCache cache;
+    EXPECT_EQ(cache.SetFile(path), 0);
+    CountingFetcher fetcher;
+    cache.Get(endpoint, "llama", fetcher.Get());
+  }
+
+  ModelCapabilitiesCache cache;
+  EXPECT_EQ(cache.SetFile(path), 1);
+  CountingFetcher fetcher;
+  EXPECT_EQ(cache.Get(endpoint, "llama", fetcher.Get()), ToolsAndThinking());
+  EXPECT_EQ(fetcher.calls, 0);
+
+  // The persisted entries expire too
+  cache.SetTTL(0s);
+  cache.Get(endpoint, "llama", fetcher.Get());
+  EXPECT_EQ(fetcher.calls, 1);
+  std::filesystem::remove(path);
+}
+
+TEST(ModelCapabilitiesCacheTest, SaveUsesAPrivateTempFile) {
+  std::string path = TempFile("model_cache_tmp_test");
+  std::string endpoint{kEndpoint};
+  // Another process writing the cache: a fixed temporary file is taken.
+  std::filesystem::create_directory(path + ".tmp");
+  {
+    ModelCapabilitiesCache cache;
+    cache.SetFile(path);
+    CountingFetcher fetcher;
+    cache.Get(endpoint, "llama", fetcher.Get());
+  }
+
+  ModelCapabilitiesCache cache;
+  EXPECT_EQ(cache.SetFile(path), 1);
+  std::filesystem::remove(path + ".tmp");
+  std::filesystem::remove(path);
+}
+
+TEST(ModelCapabilitiesCacheTest, ClientWarmUpDoesNotCallTheClient) {
+  auto result = ConfigBuilder::FromContent(R"({
+    "endpoints": {
+      "http://127.0.0.1:11434": {
+        "model": "llama",
+        "models": ["one", "two"],
+        "type": "ollama",
+        "active": true
+      }
+    }
+  })");
+  ASSERT_TRUE(result.ok());
+
+  // The warm-up may still run while the client is destroyed: it must not
+  // call the (virtual) methods of the client.
+  std::atomic_int calls{0};
+  auto client = std::make_unique<CountingClient>(calls);
+  client->ApplyConfig(&result.config_.value());
+  client.reset();
+  EXPECT_EQ(calls, 0);
+}
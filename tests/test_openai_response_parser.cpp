@@ -307,3 +307,25 @@ TEST(OpenAIResponseParserTest, CarriageReturnHandling) {
   ASSERT_EQ(tokens.size(), 1);
   EXPECT_EQ(tokens[0].content, "Hello");
 }
+
+TEST(OpenAIResponseParserTest, DeltaWithEscapesAndUsage) {
+  OpenAIResponseParser parser;
+  std::string message =
+      DeltaEvent("line\\n\\\"quoted\\\" \\u00e9") +
+      "event: response.output_text.delta\ndata: "
+      "{\"type\":\"response.output_text.delta\",\"delta\":\"!\","
+      "\"response\":{\"usage\":{\"input_tokens\":3,\"output_tokens\":4}}}\n";
+
+  std::vector<OpenAIResponseParser::ParseResult> tokens;
+  parser.Parse(message, [&tokens](OpenAIResponseParser::ParseResult result) {
+    tokens.push_back(std::move(result));
+  });
+
+  ASSERT_EQ(tokens.size(), 2);
+  EXPECT_EQ(tokens[0].content, "line\n\"quoted\" \xc3\xa9");
+  EXPECT_FALSE(tokens[0].usage.has_value());
+  // The "response" object is read from the DOM.
+  EXPECT_EQ(tokens[1].content, "!");
+  ASSERT_TRUE(tokens[1].usage.has_value());
+  EXPECT_EQ(tokens[1].usage->output_tokens, 4);
+}
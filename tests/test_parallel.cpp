@@ -0,0 +1,59 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "assistant/parallel.hpp"
+
+using namespace assistant;
+
+TEST(ParallelForTest, RunsEveryItemOnce) {
+  std::vector<std::atomic_int> runs(100);
+  ParallelFor(runs.size(), 8, [&runs](size_t i) { ++runs[i]; });
+  for (const auto& count : runs) {
+    EXPECT_EQ(count, 1);
+  }
+}
+
+TEST(ParallelForTest, RethrowsTheFirstError) {
+  std::atomic_int runs{0};
+  EXPECT_THROW(ParallelFor(10, 4,
+                           [&runs](size_t i) {
+                             ++runs;
+                             if (i == 3) {
+                               throw std::runtime_error("item failed");
+                             }
+                           }),
+               std::runtime_error);
+  EXPECT_EQ(runs, 10);
+}
+
+TEST(ParallelForTest, ReusesThePoolThreads) {
+  auto work = [](size_t) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  };
+  // 100 calls with 3 helpers each: a thread per helper would be 300 threads.
+  // A helper that just completed may not be back to idle when the next call
+  // submits, so the pool may hold a few more threads than one call needs.
+  for (int i = 0; i < 100; ++i) {
+    ParallelFor(16, 4, work);
+  }
+  EXPECT_LE(WorkerPool::Instance().GetThreadsCount(), 8);
+}
+
+TEST(ParallelForTest, DoesNotWaitForABusyPool) {
+  // Every pool thread runs an item that waits, and each item runs a nested
+  // ParallelFor: the nested calls run their items on their own thread.
+  size_t count = WorkerPool::Instance().GetMaxThreads() + 4;
+  std::atomic_size_t nested{0};
+  ParallelFor(count, count, [&nested](size_t) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    ParallelFor(4, 4, [&nested](size_t) { ++nested; });
+  });
+  EXPECT_EQ(nested, count * 4);
+  EXPECT_LE(WorkerPool::Instance().GetThreadsCount(),
+            WorkerPool::Instance().GetMaxThreads());
+}
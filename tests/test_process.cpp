@@ -607,6 +607,47 @@ TEST(ProcessTest, Interactive_NullOnBadCommand) {
   EXPECT_EQ(proc, nullptr);
 }
 
+// Test feeding an input larger than a pipe buffer to the child's stdin
+TEST(ProcessTest, RunProcessWithInput_LargeInput) {
+#ifdef _WIN32
+  GTEST_SKIP() << "cat not available on Windows without shell";
+#else
+  std::string input(1024 * 1024, 'x');
+  input += "END";
+  auto result = Process::RunProcessWithInput({"cat"}, {input});
+
+  EXPECT_TRUE(result.ok);
+  EXPECT_EQ(result.out, input);
+#endif
+}
+
+// Test feeding the child's stdin and its fd 3 at the same time
+TEST(ProcessTest, RunProcessWithInput_ExtraInput) {
+#ifdef _WIN32
+  GTEST_SKIP() << "extra inputs are not supported on Windows";
+#else
+  std::string extra(256 * 1024, 'y');
+  auto result = Process::RunProcessWithInput(
+      {"sh", "-c", "cat /dev/fd/3; cat"}, {"from stdin", extra});
+
+  EXPECT_TRUE(result.ok);
+  EXPECT_EQ(result.out, extra + "from stdin");
+#endif
+}
+
+// Test a child that exits without reading its input
+TEST(ProcessTest, RunProcessWithInput_ChildIgnoresInput) {
+#ifdef _WIN32
+  GTEST_SKIP() << "sh not available on Windows";
+#else
+  std::string input(1024 * 1024, 'x');
+  auto result = Process::RunProcessWithInput({"sh", "-c", "exit 3"}, {input});
+
+  EXPECT_FALSE(result.ok);
+  EXPECT_TRUE(result.out.empty());
+#endif
+}
+
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
@@ -0,0 +1,98 @@
+#include <gtest/gtest.h>
+
+#ifdef __linux__
+#include <signal.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "assistant/Process.hpp"
+#include "assistant/process_pump.hpp"
+
+using namespace assistant;
+
+TEST(ProcessPumpTest, IdleChildrenCauseNoWakeups) {
+  std::vector<std::shared_ptr<Process>> procs;
+  for (int i = 0; i < 10; ++i) {
+    procs.push_back(Process::StartInteractive(
+        {"sleep", "100"},
+        [](const std::string&, const std::string&) { return true; }));
+    ASSERT_NE(procs.back(), nullptr);
+  }
+
+  // Let the pump settle, then count its wakeups while the children idle.
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  uint64_t wakeups = ProcessPump::Instance().Wakeups();
+  std::this_thread::sleep_for(std::chrono::milliseconds(300));
+  EXPECT_EQ(ProcessPump::Instance().Wakeups(), wakeups);
+
+  for (auto& proc : procs) {
+    EXPECT_EQ(proc->Stop(), 128 + SIGTERM);
+  }
+}
+
+TEST(ProcessPumpTest, RunsManyChildrenConcurrently) {
+  constexpr int kNumProcesses = 20;
+  std::mutex mutex;
+  std::condition_variable cv;
+  int completed = 0;
+  std::vector<std::string> outputs(kNumProcesses);
+
+  for (int i = 0; i < kNumProcesses; ++i) {
+    ASSERT_TRUE(Process::RunProcessAsync(
+        {"sh", "-c", "sleep 0.1; echo child " + std::to_string(i)},
+        [&mutex, &outputs, i](const std::string& out, const std::string&) {
+          std::scoped_lock lk{mutex};
+          outputs[i] += out;
+          return true;
+        },
+        [&mutex, &cv, &completed](int exit_code) {
+          EXPECT_EQ(exit_code, 0);
+          std::scoped_lock lk{mutex};
+          ++completed;
+          cv.notify_all();
+        }));
+  }
+
+  std::unique_lock lk{mutex};
+  ASSERT_TRUE(cv.wait_for(lk, std::chrono::seconds(5), [&completed]() {
+    return completed == kNumProcesses;
+  }));
+  for (int i = 0; i < kNumProcesses; ++i) {
+    EXPECT_EQ(outputs[i], "child " + std::to_string(i) + "\n");
+  }
+}
+
+TEST(ProcessPumpTest, ReusedFdsGetTheirOwnOutput) {
+  ASSERT_TRUE(ProcessPump::Instance().IsAvailable());
+  // Each child reuses the fd numbers of the previous one.
+  for (int i = 0; i < 100; ++i) {
+    std::string output;
+    int exit_code = Process::RunProcessAndWait(
+        {"sh", "-c", "echo " + std::to_string(i) + "; exit 3"},
+        [&output](const std::string& out, const std::string&) {
+          output += out;
+          return true;
+        });
+    EXPECT_EQ(exit_code, 3);
+    EXPECT_EQ(output, std::to_string(i) + "\n");
+  }
+}
+
+TEST(ProcessPumpTest, DoesNotSignalReapedChildren) {
+  auto proc = Process::StartInteractive(
+      {"sh", "-c", "exit 0"},
+      [](const std::string&, const std::string&) { return true; });
+  ASSERT_NE(proc, nullptr);
+  pid_t pid = proc->GetPid();
+
+  for (int i = 0; i < 100 && proc->IsRunning(); ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  EXPECT_FALSE(proc->IsRunning());
+  EXPECT_FALSE(ProcessPump::Instance().Signal(pid, SIGTERM));
+}
+#endif
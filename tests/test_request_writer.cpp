@@ -0,0 +1,131 @@
+#include <gtest/gtest.h>
+
+#include <thread>
+
+#include "assistant/assistantlib.hpp"
+
+using namespace assistant;
+
+namespace {
+assistant::request MakeRequest() {
+  assistant::request req{assistant::message_type::chat};
+  req["model"] = "llama";
+  req["stream"] = true;
+  req["options"]["num_ctx"] = 4096;
+  return req;
+}
+
+json MakeMessages() {
+  json messages = json::array();
+  messages.push_back({{"role", "system"}, {"content", "be \"nice\"\n"}});
+  messages.push_back({{"role", "user"}, {"content", "héllo"}});
+  return messages;
+}
+}  // namespace
+
+TEST(RequestWriterTest, SerializeMatchesDump) {
+  auto req = MakeRequest();
+  EXPECT_EQ(req.serialize(), req.dump());
+
+  auto messages = MakeMessages();
+  req.set_streamed("messages",
+                   [&messages](std::ostream& os) { os << messages; });
+  auto base = MakeRequest();
+  json expected = static_cast<const json&>(base);
+  expected["messages"] = messages;
+  EXPECT_EQ(req.serialize(), expected.dump());
+  EXPECT_FALSE(req.contains("messages"));
+  EXPECT_TRUE(req.has_member("messages"));
+}
+
+TEST(RequestWriterTest, StreamedMemberReplacesValue) {
+  auto req = MakeRequest();
+  req["tools"] = json::array();
+  req.set_streamed("tools", [](std::ostream& os) { os << "[1]"; });
+  req.set_streamed("tools", [](std::ostream& os) { os << "[2]"; });
+  EXPECT_EQ(json::parse(req.serialize())["tools"], json::array({2}));
+
+  req.erase_member("tools");
+  EXPECT_FALSE(req.has_member("tools"));
+  EXPECT_EQ(req.serialize(), MakeRequest().dump());
+
+  // Only streamed members.
+  assistant::request empty;
+  empty.set_streamed("a", [](std::ostream& os) { os << "1"; });
+  EXPECT_EQ(empty.serialize(), R"({"a":1})");
+}
+
+TEST(RequestWriterTest, CallbackStreamBufChunks) {
+  std::vector<std::string> chunks;
+  {
+    CallbackStreamBuf buffer(
+        [&chunks](const char* data, size_t len) {
+          chunks.emplace_back(data, len);
+          return true;
+        },
+        4);
+    std::ostream os(&buffer);
+    os << "abcdefghij";
+    os << 'k';
+  }
+  std::string joined;
+  for (const auto& chunk : chunks) {
+    EXPECT_LE(chunk.size(), 10);
+    joined += chunk;
+  }
+  EXPECT_EQ(joined, "abcdefghijk");
+}
+
+TEST(RequestWriterTest, CallbackStreamBufFailure) {
+  size_t calls{0};
+  CallbackStreamBuf buffer(
+      [&calls](const char*, size_t) {
+        ++calls;
+        return false;
+      },
+      4);
+  std::ostream os(&buffer);
+  os << "abcdefghij" << std::flush;
+  EXPECT_TRUE(os.bad());
+  EXPECT_EQ(calls, 1);
+}
+
+TEST(RequestWriterTest, ChatPostsChunkedBody) {
+  httplib::Server server;
+  std::string received_body;
+  std::string transfer_encoding;
+  server.Post("/api/chat", [&](const httplib::Request& req,
+                               httplib::Response& res) {
+    received_body = req.body;
+    transfer_encoding = req.get_header_value("Transfer-Encoding");
+    res.set_content(
+        R"({"model":"llama","message":{"role":"assistant","content":"hi"},"done":true})"
+        "\n",
+        "application/x-ndjson");
+  });
+  int port = server.bind_to_any_port("127.0.0.1");
+  ASSERT_GT(port, 0);
+  std::thread server_thread{[&server]() { server.listen_after_bind(); }};
+  server.wait_until_ready();
+
+  // Large enough to be sent in several chunks.
+  json messages = MakeMessages();
+  messages.push_back({{"role", "user"}, {"content", std::string(300000, 'x')}});
+  auto req = MakeRequest();
+  req.set_streamed("messages",
+                   [&messages](std::ostream& os) { os << messages; });
+
+  ClientImpl client{"http://127.0.0.1:" + std::to_string(port)};
+  std::string content;
+  auto on_response = [](const assistant::response& r, void* user_data) {
+    *static_cast<std::string*>(user_data) += r.as_json()["message"]["content"];
+    return true;
+  };
+  EXPECT_TRUE(client.chat(req, on_response, &content));
+  EXPECT_EQ(content, "hi");
+  EXPECT_EQ(transfer_encoding, "chunked");
+  EXPECT_EQ(received_body, req.serialize());
+
+  server.stop();
+  server_thread.join();
+}
@@ -0,0 +1,114 @@
+#include <gtest/gtest.h>
+
+#include "assistant/helpers.hpp"
+
+using namespace assistant;
+
+namespace {
+using Events = std::vector<std::pair<std::string, std::string>>;
+
+Events FeedAll(SseFramer& framer, std::string_view data, size_t chunk_size) {
+  Events events;
+  for (size_t pos = 0; pos < data.size(); pos += chunk_size) {
+    framer.Append(data.substr(pos, chunk_size));
+    while (auto event = framer.Next()) {
+      events.push_back({std::string{event->event}, std::string{event->data}});
+    }
+  }
+  return events;
+}
+}  // namespace
+
+TEST(SseFramerTest, FramesEventsInAnyChunkSize) {
+  std::string stream =
+      "event: message_start\n"
+      "data: {\"type\":\"message_start\"}\n"
+      "\n"
+      "event: content_block_delta\r\n"
+      "data: {\"text\":\"a\"}\r\n"
+      "\r\n"
+      ": a comment\n"
+      "id: 42\n"
+      "data: no event name\n"
+      "\n";
+  for (size_t chunk_size : {1, 2, 7, 64, 4096}) {
+    SseFramer framer;
+    auto events = FeedAll(framer, stream, chunk_size);
+    ASSERT_EQ(events.size(), 3) << "chunk_size=" << chunk_size;
+    EXPECT_EQ(events[0], (std::pair<std::string, std::string>{
+                             "message_start", "{\"type\":\"message_start\"}"}));
+    EXPECT_EQ(events[1], (std::pair<std::string, std::string>{
+                             "content_block_delta", "{\"text\":\"a\"}"}));
+    EXPECT_EQ(events[2], (std::pair<std::string, std::string>{
+                             "", "no event name"}));
+    EXPECT_EQ(framer.GetPendingBytes(), 0);
+  }
+}
+
+TEST(SseFramerTest, JoinsMultiLineData) {
+  std::string stream =
+      "event: multi\n"
+      "data: {\n"
+      "data:\"a\": 1\n"
+      "data: }\n"
+      "\n";
+  for (size_t chunk_size : {1, 5, 4096}) {
+    SseFramer framer;
+    auto events = FeedAll(framer, stream, chunk_size);
+    ASSERT_EQ(events.size(), 1) << "chunk_size=" << chunk_size;
+    EXPECT_EQ(events[0].first, "multi");
+    EXPECT_EQ(events[0].second, "{\n\"a\": 1\n}");
+  }
+}
+
+TEST(SseFramerTest, StrictFramingWaitsForTheBlankLine) {
+  SseFramer framer;
+  framer.Append("event: a\ndata: 1\n");
+  EXPECT_FALSE(framer.Next().has_value());
+  framer.Append("\nevent: b\n");
+  auto event = framer.Next();
+  ASSERT_TRUE(event.has_value());
+  EXPECT_EQ(event->event, "a");
+  EXPECT_EQ(event->data, "1");
+  EXPECT_FALSE(framer.Next().has_value());
+}
+
+TEST(SseFramerTest, EventsWithoutDataAreDropped) {
+  SseFramer framer;
+  framer.Append("event: ping\n\nevent: a\ndata: 1\n\n");
+  auto event = framer.Next();
+  ASSERT_TRUE(event.has_value());
+  EXPECT_EQ(event->event, "a");
+  EXPECT_FALSE(framer.Next().has_value());
+}
+
+TEST(SseFramerTest, LenientFramingWithoutBlankLines) {
+  std::string stream =
+      "event: a\n"
+      "data: 1\n"
+      "event: b\n"
+      "data: 2\n";
+  for (size_t chunk_size : {1, 3, 4096}) {
+    SseFramer framer{SseFraming::kLenient};
+    auto events = FeedAll(framer, stream, chunk_size);
+    ASSERT_EQ(events.size(), 2) << "chunk_size=" << chunk_size;
+    EXPECT_EQ(events[0], (std::pair<std::string, std::string>{"a", "1"}));
+    EXPECT_EQ(events[1], (std::pair<std::string, std::string>{"b", "2"}));
+  }
+}
+
+TEST(SseFramerTest, PartialLineIsKept) {
+  SseFramer framer{SseFraming::kLenient};
+  framer.Append("event: a\ndata: {\"text\":\"Hel");
+  EXPECT_FALSE(framer.Next().has_value());
+  EXPECT_EQ(framer.GetPendingBytes(),
+            std::string_view{"data: {\"text\":\"Hel"}.size());
+  framer.Append("lo\"}\n");
+  auto event = framer.Next();
+  ASSERT_TRUE(event.has_value());
+  EXPECT_EQ(event->data, "{\"text\":\"Hello\"}");
+
+  framer.Reset();
+  EXPECT_EQ(framer.GetPendingBytes(), 0);
+  EXPECT_FALSE(framer.Next().has_value());
+}
@@ -0,0 +1,93 @@
+#include <gtest/gtest.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "assistant/common/tokens.hpp"
+
+using namespace assistant;
+
+namespace {
+
+/// Random texts mixing every class of bytes, so that runs of all the kinds
+/// cross the 64 bytes blocks.
+std::vector<std::string> RandomTexts(size_t count, size_t max_len) {
+  const std::string alphabet =
+      "abcXYZ_019 \t\n\r.,;{}\v\f\xc3\xa9\x80\xff";
+  std::mt19937 rng{42};
+  std::vector<std::string> texts;
+  for (size_t i = 0; i < count; ++i) {
+    std::string text(rng() % max_len, ' ');
+    // Long runs of the same class are more likely with a narrow alphabet
+    size_t width = 1 + rng() % alphabet.size();
+    size_t first = rng() % (alphabet.size() - width + 1);
+    for (auto& c : text) {
+      c = alphabet[first + rng() % width];
+    }
+    texts.push_back(std::move(text));
+  }
+  return texts;
+}
+
+size_t CountTokensPortable(std::string_view text) {
+  return detail::ApplyMergeCorrection(detail::CountTokensInBlocks(
+      text, [](const char* data) { return detail::ClassifyBytes(data, 64); }));
+}
+
+}  // namespace
+
+TEST(CountTokensTest, EmptyAndShortTexts) {
+  EXPECT_EQ(CountTokens(""), 0);
+  EXPECT_EQ(CountTokens("hello"), CountTokensScalar("hello"));
+  EXPECT_EQ(CountTokens("."), 1);
+}
+
+TEST(CountTokensTest, RunsAcrossBlocks) {
+  for (std::string text : {
+           std::string(63, 'a') + "1234567890" + std::string(70, 'b'),
+           std::string(62, ' ') + "12345" + std::string(64, 'x'),
+           std::string(65, '7') + "abc" + std::string(129, '\t'),
+           std::string(63, '.') + "\xc3\xa9\xc3\xa9\xc3\xa9" +
+               std::string(64, '_'),
+           std::string(128, 'z'),
+           std::string(192, '9'),
+       }) {
+    EXPECT_EQ(CountTokens(text), CountTokensScalar(text)) << text;
+    EXPECT_EQ(CountTokensPortable(text), CountTokensScalar(text)) << text;
+  }
+}
+
+TEST(CountTokensTest, MatchesScalarOnRandomTexts) {
+  for (const auto& text : RandomTexts(20000, 400)) {
+    size_t expected = CountTokensScalar(text);
+    ASSERT_EQ(CountTokens(text), expected) << text;
+    if (text.empty()) {
+      continue;
+    }
+    ASSERT_EQ(CountTokensPortable(text), expected) << text;
+#ifdef ASSISTANT_TOKENS_X86
+    ASSERT_EQ(detail::ApplyMergeCorrection(detail::CountTokensSse2(text)),
+              expected)
+        << text;
+    if (__builtin_cpu_supports("avx2")) {
+      ASSERT_EQ(detail::ApplyMergeCorrection(detail::CountTokensAvx2(text)),
+                expected)
+          << text;
+    }
+#endif
+  }
+}
+
+TEST(CountTokensTest, BatchMatchesSingleTexts) {
+  // Large enough to be counted on several threads
+  auto texts = RandomTexts(64, 128 * 1024);
+  std::vector<std::string_view> views{texts.begin(), texts.end()};
+
+  auto counts = CountTokens(views, 4);
+  ASSERT_EQ(counts.size(), texts.size());
+  for (size_t i = 0; i < texts.size(); ++i) {
+    EXPECT_EQ(counts[i], CountTokensScalar(texts[i]));
+  }
+  EXPECT_TRUE(CountTokens(std::span<const std::string_view>{}).empty());
+}
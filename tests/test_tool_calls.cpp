@@ -0,0 +1,179 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <thread>
+
+#include "assistant/client/ollama_client.hpp"
+
+using namespace assistant;
+
+namespace {
+
+/// Captures the tool results instead of sending them to a server.
+class ToolCallsClient : public OllamaClient {
+ public:
+  ToolCallsClient() : OllamaClient(OllamaLocalEndpoint{}) {}
+
+  void CreateAndPushChatRequest(std::optional<assistant::message>,
+                                ResponseCallback, std::string, ChatOptions,
+                                std::shared_ptr<ChatRequestFinaliser>) override {
+    ++m_follow_up_requests;
+  }
+
+  void AddToolsResult(
+      std::vector<std::pair<FunctionCall, FunctionResult>> result) override {
+    m_results.insert(m_results.end(), result.begin(), result.end());
+  }
+
+  std::vector<std::pair<FunctionCall, FunctionResult>> m_results;
+  size_t m_follow_up_requests{0};
+};
+
+/// A tool that sleeps `delay_ms` milliseconds and echoes its "id" argument.
+std::shared_ptr<FunctionBase> SleepyTool(std::atomic_size_t& running,
+                                         std::atomic_size_t& max_running) {
+  return FunctionBuilder("sleepy")
+      .SetDescription("sleeps and echoes")
+      .AddRequiredParam("id", "the id to echo", "string")
+      .AddRequiredParam("delay_ms", "how long to sleep", "number")
+      .SetCallback([&running, &max_running](const json& args) {
+        size_t now = running.fetch_add(1) + 1;
+        size_t prev = max_running.load();
+        while (now > prev && !max_running.compare_exchange_weak(prev, now)) {
+        }
+        std::this_thread::sleep_for(
+            std::chrono::milliseconds(args["delay_ms"].get<int>()));
+        running.fetch_sub(1);
+        return FunctionResult{.text = args["id"].get<std::string>()};
+      })
+      .Build();
+}
+
+std::shared_ptr<ChatRequest> MakeRequest(
+    const std::vector<std::pair<std::string, int>>& calls) {
+  auto request = std::make_shared<ChatRequest>();
+  request->callback_ = [](const std::string&, Reason, bool) { return true; };
+  std::vector<FunctionCall> func_calls;
+  for (const auto& [id, delay_ms] : calls) {
+    func_calls.push_back(FunctionCall{
+        .name = "sleepy", .args = {{"id", id}, {"delay_ms", delay_ms}}});
+  }
+  assistant::message msg{"assistant", ""};
+  request->func_calls_.push_back({msg, std::move(func_calls)});
+  return request;
+}
+
+}  // namespace
+
+TEST(ToolCallsTest, SequentialByDefault) {
+  std::atomic_size_t running{0};
+  std::atomic_size_t max_running{0};
+  ToolCallsClient client;
+  client.GetFunctionTable().Add(SleepyTool(running, max_running));
+  EXPECT_EQ(client.GetMaxParallelToolCalls(), 1);
+
+  client.InvokeTools(MakeRequest({{"a", 10}, {"b", 10}, {"c", 10}}));
+  EXPECT_EQ(max_running.load(), 1);
+  ASSERT_EQ(client.m_results.size(), 3);
+  EXPECT_EQ(client.m_follow_up_requests, 1);
+}
+
+TEST(ToolCallsTest, ParallelCallsKeepTheirOrder) {
+  std::atomic_size_t running{0};
+  std::atomic_size_t max_running{0};
+  ToolCallsClient client;
+  client.GetFunctionTable().Add(SleepyTool(running, max_running));
+  client.SetMaxParallelToolCalls(4);
+
+  // The first call is the slowest, so it completes last.
+  auto start = std::chrono::steady_clock::now();
+  client.InvokeTools(
+      MakeRequest({{"a", 200}, {"b", 50}, {"c", 50}, {"d", 50}}));
+  auto elapsed = std::chrono::steady_clock::now() - start;
+
+  EXPECT_GT(max_running.load(), 1);
+  EXPECT_LE(max_running.load(), 4);
+  EXPECT_LT(elapsed, std::chrono::milliseconds(350));
+  ASSERT_EQ(client.m_results.size(), 4);
+  std::vector<std::string> ids;
+  for (const auto& [call, result] : client.m_results) {
+    EXPECT_FALSE(result.isError);
+    EXPECT_EQ(result.text, call.args["id"].get<std::string>());
+    ids.push_back(result.text);
+  }
+  EXPECT_EQ(ids, (std::vector<std::string>{"a", "b", "c", "d"}));
+}
+
+TEST(ToolCallsTest, ParallelCallsAreBounded) {
+  std::atomic_size_t running{0};
+  std::atomic_size_t max_running{0};
+  ToolCallsClient client;
+  client.GetFunctionTable().Add(SleepyTool(running, max_running));
+  client.SetMaxParallelToolCalls(2);
+
+  client.InvokeTools(
+      MakeRequest({{"a", 20}, {"b", 20}, {"c", 20}, {"d", 20}, {"e", 20}}));
+  EXPECT_LE(max_running.load(), 2);
+  EXPECT_EQ(client.m_results.size(), 5);
+}
+
+TEST(ToolCallsTest, DeniedCallIsReportedInPlace) {
+  std::atomic_size_t running{0};
+  std::atomic_size_t max_running{0};
+  ToolCallsClient client;
+  client.GetFunctionTable().Add(SleepyTool(running, max_running));
+  client.SetMaxParallelToolCalls(4);
+  client.SetToolInvokeCallback([](const std::string&, const json& args) {
+    CanInvokeToolResult result{.can_invoke = args["id"] != "b",
+                               .reason = "denied"};
+    return result;
+  });
+
+  client.InvokeTools(MakeRequest({{"a", 1}, {"b", 1}, {"c", 1}}));
+  ASSERT_EQ(client.m_results.size(), 3);
+  EXPECT_FALSE(client.m_results[0].second.isError);
+  EXPECT_TRUE(client.m_results[1].second.isError);
+  EXPECT_EQ(client.m_results[1].second.text, "denied");
+  EXPECT_EQ(client.m_results[2].second.text, "c");
+}
+
+TEST(ToolCallsTest, UnknownToolIsAnError) {
+  FunctionTable table;
+  auto result = table.Call(FunctionCall{.name = "missing"});
+  EXPECT_TRUE(result.isError);
+}
+
+TEST(ToolCallsTest, ViewAndStringCallbacksSeeTheSameMessages) {
+  std::atomic_size_t running{0};
+  std::atomic_size_t max_running{0};
+  ToolCallsClient client;
+  client.GetFunctionTable().Add(SleepyTool(running, max_running));
+
+  std::vector<std::pair<std::string, Reason>> from_string;
+  auto request = MakeRequest({{"a", 1}, {"b", 1}});
+  request->callback_ = [&from_string](const std::string& text, Reason reason,
+                                      bool) {
+    from_string.push_back({text, reason});
+    return true;
+  };
+  client.InvokeTools(request);
+
+  std::vector<std::pair<std::string, Reason>> from_view;
+  request = MakeRequest({{"a", 1}, {"b", 1}});
+  request->callback_ = [&from_view](std::string_view text, Reason reason,
+                                    bool) {
+    from_view.push_back({std::string{text}, reason});
+    return true;
+  };
+  client.InvokeTools(request);
+
+  EXPECT_FALSE(from_view.empty());
+  EXPECT_EQ(from_view, from_string);
+}
+
+TEST(ToolCallsTest, EmptyResponseCallbackContinues) {
+  ResponseCallback callback;
+  EXPECT_FALSE(callback);
+  EXPECT_TRUE(callback("text", Reason::kPartialResult, false));
+  EXPECT_TRUE(callback(std::string{"text"}, Reason::kPartialResult, false));
+}
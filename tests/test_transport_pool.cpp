@@ -0,0 +1,122 @@
+#include <gtest/gtest.h>
+
+#include <thread>
+
+#include "assistant/client/ollama_client.hpp"
+#include "assistant/transport_pool.hpp"
+#include "tests/fake_transport.hpp"
+
+using namespace assistant;
+
+namespace {
+
+TransportPool::Factory FakeFactory() {
+  return []() { return std::make_unique<FakeTransport>(); };
+}
+
+}  // namespace
+
+TEST(TransportPoolTest, ReusesIdleTransport) {
+  auto pool = TransportPool::Create();
+  ITransport* first{nullptr};
+  {
+    auto lease = pool->Acquire("a", FakeFactory());
+    first = lease.get();
+    lease->is_running();
+  }
+  EXPECT_EQ(pool->GetIdleCount(), 1);
+  {
+    auto lease = pool->Acquire("a", FakeFactory());
+    EXPECT_EQ(lease.get(), first);
+    lease->is_running();
+  }
+
+  auto stats = pool->GetStats();
+  EXPECT_EQ(stats.transports_created, 1);
+  EXPECT_EQ(stats.transports_reused, 1);
+  EXPECT_EQ(stats.connections_opened, 1);
+  EXPECT_EQ(stats.connections_reused, 1);
+}
+
+TEST(TransportPoolTest, KeysAreIsolated) {
+  auto pool = TransportPool::Create();
+  { auto lease = pool->Acquire("a", FakeFactory()); }
+  { auto lease = pool->Acquire("b", FakeFactory()); }
+  auto stats = pool->GetStats();
+  EXPECT_EQ(stats.transports_created, 2);
+  EXPECT_EQ(stats.transports_reused, 0);
+  EXPECT_EQ(pool->GetIdleCount(), 2);
+}
+
+TEST(TransportPoolTest, ConcurrentLeasesGetDistinctTransports) {
+  auto pool = TransportPool::Create();
+  auto lease1 = pool->Acquire("a", FakeFactory());
+  auto lease2 = pool->Acquire("a", FakeFactory());
+  EXPECT_NE(lease1.get(), lease2.get());
+  EXPECT_EQ(pool->GetStats().transports_created, 2);
+}
+
+TEST(TransportPoolTest, InterruptedTransportIsDiscarded) {
+  auto pool = TransportPool::Create();
+  {
+    auto lease = pool->Acquire("a", FakeFactory());
+    lease->interrupt();
+  }
+  EXPECT_EQ(pool->GetIdleCount(), 0);
+  EXPECT_EQ(pool->GetStats().transports_discarded, 1);
+}
+
+TEST(TransportPoolTest, TransportIsDiscardedOnException) {
+  auto pool = TransportPool::Create();
+  try {
+    auto lease = pool->Acquire("a", FakeFactory());
+    throw std::runtime_error("request failed");
+  } catch (const std::exception&) {
+  }
+  EXPECT_EQ(pool->GetIdleCount(), 0);
+  EXPECT_EQ(pool->GetStats().transports_discarded, 1);
+}
+
+TEST(TransportPoolTest, MaxIdlePerKey) {
+  auto pool = TransportPool::Create(1);
+  {
+    auto lease1 = pool->Acquire("a", FakeFactory());
+    auto lease2 = pool->Acquire("a", FakeFactory());
+  }
+  EXPECT_EQ(pool->GetIdleCount(), 1);
+  EXPECT_EQ(pool->GetStats().transports_discarded, 1);
+}
+
+TEST(TransportPoolTest, UnpooledLease) {
+  auto lease = TransportPool::Unpooled(std::make_unique<FakeTransport>());
+  ASSERT_TRUE(lease);
+  EXPECT_TRUE(lease->is_running());
+}
+
+TEST(TransportPoolTest, OllamaClientReusesConnection) {
+  httplib::Server server;
+  server.Get("/", [](const httplib::Request&, httplib::Response& res) {
+    res.set_content("Ollama is running", "text/plain");
+  });
+  int port = server.bind_to_any_port("127.0.0.1");
+  ASSERT_GT(port, 0);
+  std::thread server_thread{[&server]() { server.listen_after_bind(); }};
+  server.wait_until_ready();
+
+  OllamaLocalEndpoint endpoint;
+  endpoint.url_ = "http://127.0.0.1:" + std::to_string(port);
+  OllamaClient client{endpoint};
+  for (size_t i = 0; i < 5; ++i) {
+    EXPECT_TRUE(client.IsRunning());
+  }
+
+  auto stats = client.GetTransportPoolStats();
+  EXPECT_EQ(stats.transports_created, 1);
+  EXPECT_EQ(stats.transports_reused, 4);
+  EXPECT_EQ(stats.connections_opened, 1);
+  EXPECT_EQ(stats.connections_reused, 4);
+
+  client.ClearTransportPool();
+  server.stop();
+  server_thread.join();
+}